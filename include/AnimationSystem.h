@@ -0,0 +1,196 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "cinder/Matrix.h"
+
+#include "glm/gtc/quaternion.hpp"
+
+#include "Node2d.h"
+#include "Node3d.h"
+
+namespace scene {
+
+class AnimationSystem;
+typedef std::shared_ptr<AnimationSystem> AnimationSystemRef;	//!< A shared pointer to an AnimationSystem instance
+
+/**
+ * @brief Keyframe animation of Node3d and Node2d transformations
+ *
+ * Keys of all channels are stored in structure-of-arrays form (one array per
+ * component). Channels that drive the same property of the same node type with the
+ * same kernel share a batch, whose per-channel arrays are sized when channels are
+ * added and hold the key segment each channel is currently in. Every frame, the
+ * fraction within the segment is computed four channels at a time; only channels
+ * whose time left their segment look up the next one, using a cursor that only moves
+ * forward during regular playback. The kernels then evaluate each batch in place with
+ * SSE, and the results are written into the nodes with one bulk setter call per batch,
+ * which marks their transformations dirty.
+ *
+ * Rotations of Node3d channels use a normalized lerp with a correction term that
+ * closely approximates slerp at a fraction of the cost. Rotations of Node2d
+ * channels are angles in radians and are interpolated like any other scalar.
+ */
+class AnimationSystem {
+public:
+	typedef uint32_t ChannelId;		//!< Identifies a channel of the system
+
+	//! Type that describes the transformation property driven by a channel
+	typedef enum Property_t {
+		POSITION = 0, ROTATION = 1, SCALE = 2
+	} Property;
+
+	//! Type that describes how values between keys are computed
+	typedef enum Interpolation_t {
+		LINEAR = 0,	//!< component-wise linear interpolation
+		BEZIER = 1,	//!< cubic bezier interpolation using an out and an in control value per segment
+		SLERP = 2	//!< spherical interpolation of rotations (linear for anything else)
+	} Interpolation;
+
+	//! creates AnimationSystem instance wrapped by STL shared pointer
+	static AnimationSystemRef create() { return AnimationSystemRef( new AnimationSystem() ); }
+
+	AnimationSystem();
+
+	//! adds a position channel to a Node3d, the key times must be ascending
+	ChannelId addPositionChannel(const Node3dRef& node, const std::vector<float>& times, const std::vector<ci::vec3>& values, Interpolation mode = LINEAR);
+	//! adds a scale channel to a Node3d, the key times must be ascending
+	ChannelId addScaleChannel(const Node3dRef& node, const std::vector<float>& times, const std::vector<ci::vec3>& values, Interpolation mode = LINEAR);
+	//! adds a rotation channel to a Node3d, the key times must be ascending
+	ChannelId addRotationChannel(const Node3dRef& node, const std::vector<float>& times, const std::vector<ci::quat>& values);
+
+	//! adds a position channel to a Node2d, the key times must be ascending
+	ChannelId addPositionChannel(const Node2dRef& node, const std::vector<float>& times, const std::vector<ci::vec2>& values, Interpolation mode = LINEAR);
+	//! adds a scale channel to a Node2d, the key times must be ascending
+	ChannelId addScaleChannel(const Node2dRef& node, const std::vector<float>& times, const std::vector<ci::vec2>& values, Interpolation mode = LINEAR);
+	//! adds a rotation channel (in radians) to a Node2d, the key times must be ascending
+	ChannelId addRotationChannel(const Node2dRef& node, const std::vector<float>& times, const std::vector<float>& values, Interpolation mode = LINEAR);
+
+	/**
+	 * Assigns the bezier control values of a channel. Segment i goes from key i to key i+1
+	 * using out_controls[i] and in_controls[i+1]. Without control values, a bezier channel
+	 * behaves like a linear one.
+	 */
+	void setControls(ChannelId channel, const std::vector<ci::vec4>& out_controls, const std::vector<ci::vec4>& in_controls);
+
+	//! makes a channel repeat its keys instead of holding the last one
+	void setLooping(ChannelId channel, bool looping = true);
+
+	//! pauses or resumes a channel, paused channels leave their node untouched
+	void setEnabled(ChannelId channel, bool enabled = true);
+
+	//! assigns the system time at which a channel starts playing its first key
+	void setStartTime(ChannelId channel, float time);
+
+	//! advances the clock and evaluates every channel
+	void update(double elapsed);
+
+	//! evaluates every channel at an absolute time and writes the results into the nodes
+	void evaluate(float time);
+
+	//! returns the current time of the system clock
+	float getTime() const { return mTime; }
+
+	//! returns the number of channels
+	size_t getChannelCount() const { return mChannels.size(); }
+
+	//! removes all channels and keys
+	void clear();
+
+	// kernels working on arrays of count values, count is padded to a multiple of four by the caller
+
+	//! out[i] = a[i] + (b[i] - a[i]) * u[i]
+	static void lerp(const float* u, const float* a, const float* b, float* out, size_t count);
+
+	//! cubic bezier from a to b with the control values c (after a) and d (before b)
+	static void bezier(const float* u, const float* a, const float* c, const float* d, const float* b, float* out, size_t count);
+
+	//! corrected normalized lerp between two arrays of quaternions stored as x, y, z and w arrays
+	static void nlerp(const float* u, const float* const a[4], const float* const b[4], float* const out[4], size_t count);
+
+protected:
+	typedef enum Target_t {
+		TARGET_NODE3D = 0, TARGET_NODE2D = 1
+	} Target;
+
+	static const uint32_t NO_SLOT = ~0u;	//!< the slot of channels that are not evaluated
+
+	struct Channel {
+		NodeWeakRef		mNodeRef;		//!< the animated node
+		uint32_t		mBatch;			//!< the index of the batch of the channel
+		uint32_t		mSlot;			//!< the position of the channel in its batch, NO_SLOT while paused or expired
+		bool			mIsLooping;
+		bool			mIsEnabled;
+		uint32_t		mFirstKey;		//!< the index of the first key in the key arrays
+		uint32_t		mKeyCount;		//!< the number of keys
+		uint32_t		mCursor;		//!< the start key of the segment that was evaluated last
+		float			mStartTime;		//!< the system time at which the first key plays
+	};
+
+	//! persistent storage of the channels evaluated by one kernel and written by one setter, arrays are padded to a multiple of four
+	struct Batch {
+		uint8_t					mTarget;		//!< the Target type of the nodes
+		uint8_t					mProperty;		//!< the animated Property
+		uint8_t					mInterpolation;	//!< the Interpolation kernel
+		uint8_t					mComponents;	//!< the number of components of the property
+		size_t					mCount;			//!< the number of channels in the batch
+		std::vector<uint32_t>	mChannels;		//!< the channel of each slot
+		std::vector<NodeWeakRef>	mNodeRefs;	//!< guards the node of each slot
+		std::vector<Node3d*>	mNodes3d;		//!< the node of each slot of Node3d batches
+		std::vector<Node2d*>	mNodes2d;		//!< the node of each slot of Node2d batches
+		std::vector<float>		mStart;			//!< the system time at which the channel starts
+		std::vector<float>		mFirst;			//!< the time of the first key, where loops start
+		std::vector<float>		mPeriod;		//!< the length of a loop, zero for channels that do not loop
+		std::vector<float>		mInvPeriod;		//!< the reciprocal of the loop length, zero for channels that do not loop
+		std::vector<float>		mLow;			//!< the local time at which the current segment begins
+		std::vector<float>		mHigh;			//!< the local time at which the current segment ends
+		std::vector<float>		mBase;			//!< the local time of the start key of the current segment
+		std::vector<float>		mInvLength;		//!< the reciprocal of the segment length, zero when holding a key
+		std::vector<float>		mU;				//!< the fraction within the segment
+		std::vector<float>		mA[4];			//!< the start key
+		std::vector<float>		mB[4];			//!< the end key
+		std::vector<float>		mC[4];			//!< the out control value of the start key (bezier only)
+		std::vector<float>		mD[4];			//!< the in control value of the end key (bezier only)
+		std::vector<float>		mOut[4];		//!< the interpolated values
+
+		//! grows the arrays by four padding slots
+		void grow();
+		//! copies a slot over another one
+		void move(size_t from, size_t to);
+	};
+
+	//! appends the keys of a channel and returns its id
+	ChannelId addChannel(const NodeRef& node, Target target, Property property, Interpolation mode,
+						 const std::vector<float>& times, const std::vector<ci::vec4>& values);
+
+	//! adds an enabled channel to its batch
+	void insert(ChannelId id);
+	//! takes a channel out of its batch, moving the last channel of the batch into its slot
+	void remove(ChannelId id);
+
+	//! copies the loop range of a channel into its slot and makes it look up its segment again
+	void reset(const Channel& channel);
+
+	//! computes the fraction within the segment of every channel of a batch, looking up the segments of channels that left theirs
+	void locate(Batch& batch, float time);
+
+	//! looks up the segment of the channel in a slot at a local time and copies its keys into the slot
+	void seek(Batch& batch, size_t slot, float local);
+
+	//! runs the kernel of a batch on all its slots
+	void interpolate(Batch& batch);
+
+	//! writes the results of a batch into the nodes
+	void write(const Batch& batch);
+
+	float					mTime;			//!< the system clock
+	std::vector<Channel>	mChannels;		//!< the channels
+	std::vector<float>		mKeyTimes;		//!< the times of all keys, relative to the channel start
+	std::vector<float>		mKeyValues[4];	//!< the values of all keys, one array per component
+	std::vector<float>		mKeyOut[4];		//!< the out control values of all keys
+	std::vector<float>		mKeyIn[4];		//!< the in control values of all keys
+	std::vector<Batch>		mBatches;		//!< the batches, one per target, property and kernel
+};
+
+}
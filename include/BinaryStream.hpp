@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace scene {
+
+/**
+ * @brief Appends plain values to a byte buffer
+ *
+ * Values are stored in the byte order of the machine, which is little endian on every
+ * platform the scene graph targets. The writer does not own the buffer, so a caller may
+ * reuse the same storage for many writes.
+ *
+ * @see scene::BinaryReader
+ */
+class BinaryWriter {
+public:
+	explicit BinaryWriter(std::vector<uint8_t>& buffer) : mBuffer(buffer) {}
+
+	//! appends an arithmetic or enum value
+	template<typename T>
+	void write(const T value)
+	{
+		static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "only plain values can be written");
+		writeBytes(&value, sizeof(T));
+	}
+
+	//! appends a string prefixed by its length
+	void writeString(const std::string& str)
+	{
+		write(static_cast<uint32_t>(str.size()));
+		writeBytes(str.data(), str.size());
+	}
+
+	//! appends raw bytes
+	void writeBytes(const void* data, size_t size)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		mBuffer.insert(mBuffer.end(), bytes, bytes + size);
+	}
+
+	//! returns the number of bytes in the buffer
+	size_t size() const { return mBuffer.size(); }
+
+protected:
+	std::vector<uint8_t>&	mBuffer;	//!< the buffer that receives the bytes
+};
+
+/**
+ * @brief Reads plain values from a byte range written by a BinaryWriter
+ *
+ * Every read is bounds checked. A read past the end fails and leaves the reader in a
+ * failed state, so a sequence of reads can be validated once by checking good().
+ */
+class BinaryReader {
+public:
+	BinaryReader(const uint8_t* data, size_t size) : mData(data), mSize(size), mPosition(0), mFailed(false) {}
+
+	//! reads an arithmetic or enum value, returns false if the data is exhausted
+	template<typename T>
+	bool read(T& value)
+	{
+		static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "only plain values can be read");
+		return readBytes(&value, sizeof(T));
+	}
+
+	//! reads a string written by BinaryWriter::writeString, returns false if the data is exhausted
+	bool readString(std::string& str)
+	{
+		uint32_t size = 0;
+		if (!read(size)) return false;
+
+		const uint8_t* bytes = skip(size);
+		if (!bytes) return false;
+		str.assign(reinterpret_cast<const char*>(bytes), size);
+		return true;
+	}
+
+	//! copies raw bytes, returns false if the data is exhausted
+	bool readBytes(void* data, size_t size)
+	{
+		const uint8_t* bytes = skip(size);
+		if (!bytes) return false;
+		std::memcpy(data, bytes, size);
+		return true;
+	}
+
+	//! advances past a number of bytes and returns a pointer to them, or nullptr if the data is exhausted
+	const uint8_t* skip(size_t size)
+	{
+		if (mFailed || size > mSize - mPosition) {
+			mFailed = true;
+			return nullptr;
+		}
+
+		const uint8_t* bytes = mData + mPosition;
+		mPosition += size;
+		return bytes;
+	}
+
+	//! returns the number of bytes that were read
+	size_t getPosition() const { return mPosition; }
+
+	//! returns the number of bytes left to read
+	size_t getRemaining() const { return mSize - mPosition; }
+
+	//! returns false once a read failed
+	bool good() const { return !mFailed; }
+
+protected:
+	const uint8_t*	mData;		//!< the bytes to read from, owned by the caller
+	size_t			mSize;		//!< the number of bytes in mData
+	size_t			mPosition;	//!< the offset of the next read
+	bool			mFailed;	//!< flag set once a read went past the end
+};
+
+}
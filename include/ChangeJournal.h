@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+namespace scene {
+
+class NodeBase;
+
+/**
+ * @brief Per-frame record of the changes made to the nodes of a scene
+ *
+ * Subsystems that mirror the scene graph (spatial indices, renderers, serializers) read
+ * the journal once per frame instead of polling the whole tree or overriding callbacks.
+ * Each node appears at most once per frame; repeated changes are merged into its record
+ * as a bit mask, so a node that moves a thousand times still costs one entry.
+ *
+ * Records are appended in the order in which nodes were first changed and must be read
+ * in that order: a node that is removed and added again within a frame gets a record
+ * with CHANGE_REMOVED followed by a new record with CHANGE_ADDED. The node pointer of a
+ * record is reset once the node leaves the scene, since it may be destroyed at any time
+ * after that; the id identifies it instead.
+ *
+ * Recording is disabled by default, since the records accumulate until clear() is called.
+ * The frame loop enables it when a consumer exists and clears it after all consumers ran.
+ */
+class ChangeJournal {
+public:
+	//! Type that describes the changes made to a node, combined as a bit mask
+	typedef enum Change_t {
+		CHANGE_ADDED = 1 << 0,		//!< the node entered the scene
+		CHANGE_REMOVED = 1 << 1,	//!< the node left the scene
+		CHANGE_CHILDREN = 1 << 2,	//!< children were added, removed or reordered
+		CHANGE_TRANSFORM = 1 << 3,	//!< the local transformation changed
+		CHANGE_ACTIVE = 1 << 4,		//!< the node was activated or deactivated
+		CHANGE_CONTENT = 1 << 5,	//!< the size or the type specific state changed (see SceneObject::serialize)
+		CHANGE_INTERACTIVE = 1 << 6	//!< pointer input was enabled or disabled
+	} Change;
+
+	struct Record {
+		NodeBase*	mNode;		//!< the changed node, nullptr once it left the scene
+		uint64_t	mId;		//!< the id of the changed node (see SceneObject::getId)
+		uint32_t	mChanges;	//!< the Change bits accumulated this frame
+	};
+
+	ChangeJournal();
+
+	//! resets the records of the nodes that are still referenced
+	~ChangeJournal();
+
+	//! enables or disables recording, disabling clears the records
+	void setEnabled(bool enabled = true);
+	//! returns wether changes are recorded
+	bool isEnabled() const { return mIsEnabled; }
+
+	//! merges changes into the record of a node, appending the record if needed
+	void record(NodeBase& node, uint32_t changes);
+
+	//! returns the records of the current frame in the order of the first change
+	const std::vector<Record>& getRecords() const { return mRecords; }
+
+	//! returns the number of changed nodes
+	size_t size() const { return mRecords.size(); }
+
+	//! returns wether no change was recorded
+	bool empty() const { return mRecords.empty(); }
+
+	//! removes all records, called once per frame after the consumers read them
+	void clear();
+
+protected:
+	bool				mIsEnabled;		//!< flag set when changes are recorded
+	std::vector<Record>	mRecords;		//!< the records of the current frame
+};
+
+}
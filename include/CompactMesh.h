@@ -0,0 +1,139 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "cinder/AxisAlignedBox.h"
+#include "cinder/Matrix.h"
+#include "cinder/Ray.h"
+#include "cinder/TriMesh.h"
+
+namespace scene {
+
+class CompactMesh;
+typedef std::shared_ptr<CompactMesh> CompactMeshRef;			//!< A shared pointer to a CompactMesh instance
+typedef std::shared_ptr<const CompactMesh> CompactMeshConstRef;	//!< A shared pointer to a constant CompactMesh instance
+
+/**
+ * @brief Quantized, read-only copy of a TriMesh that takes less than half of its memory
+ *
+ * Per vertex, a TriMesh keeps 32 bytes of positions, normals and texture coordinates; a
+ * CompactMesh keeps 12:
+ *
+ *   positions    3 x 16 bit fixed point relative to the bounding box (stored per axis)
+ *   normals      2 x 8 bit octahedral encoding, at most about 1 degree off
+ *   tex coords   2 x 16 bit half floats
+ *
+ * Indices take 16 bits whenever the mesh has at most 65536 vertices. The bounding box is
+ * kept exactly, so bounds queries need no decoding at all.
+ *
+ * Positions are stored as one array per axis so that the bounds and picking queries can
+ * decode four vertices at a time with SSE2. Ray picking works on the quantized positions
+ * directly: the parameter of an intersection does not change under the affine mapping
+ * from the quantized space, so only the ray is transformed.
+ *
+ * @see scene::NodeMesh
+ */
+class CompactMesh {
+public:
+	//! creates CompactMesh instance wrapped by STL shared pointer
+	static CompactMeshRef create(const ci::TriMesh& mesh) { return CompactMeshRef( new CompactMesh(mesh) ); }
+
+	//! quantizes a mesh, normals and texture coordinates are kept if there is one per vertex
+	CompactMesh(const ci::TriMesh& mesh);
+
+	//! returns an id that no other mesh has, so backends can keep uploaded copies of the mesh
+	uint64_t getId() const { return mId; }
+
+	//! returns the number of vertices
+	size_t getNumVertices() const { return mPositions[0].size(); }
+	//! returns the number of indices
+	size_t getNumIndices() const { return mShortIndices.size() + mIndices.size(); }
+	//! returns the number of triangles
+	size_t getNumTriangles() const { return getNumIndices() / 3; }
+
+	//! returns true if the mesh has a normal per vertex
+	bool hasNormals() const { return !mNormals.empty(); }
+	//! returns true if the mesh has texture coordinates per vertex
+	bool hasTexCoords0() const { return !mTexCoords.empty(); }
+	//! returns true if the indices take 16 bits
+	bool hasShortIndices() const { return mIndices.empty(); }
+
+	//! returns the bounding box of the positions in object space
+	const ci::AxisAlignedBox& getBounds() const { return mBounds; }
+
+	//! returns the quantization step of the positions along each axis
+	ci::vec3 getPositionStep() const { return mStep; }
+	//! returns the position of the quantized value 0
+	ci::vec3 getPositionOffset() const { return mOffset; }
+
+	//! returns the decoded position of a vertex
+	ci::vec3 getPosition(size_t vertex) const { return mOffset + mStep * ci::vec3(mPositions[0][vertex], mPositions[1][vertex], mPositions[2][vertex]); }
+	//! returns the decoded normal of a vertex, which must exist
+	ci::vec3 getNormal(size_t vertex) const;
+	//! returns the decoded texture coordinates of a vertex, which must exist
+	ci::vec2 getTexCoord0(size_t vertex) const;
+	//! returns an index
+	uint32_t getIndex(size_t index) const { return mIndices.empty()? mShortIndices[index]: mIndices[index]; }
+
+	// the encoded data, for backends that upload it without decoding
+
+	//! returns the quantized position components along an axis, a position is getPositionOffset() + getPositionStep() * quantized
+	const std::vector<uint16_t>& getQuantizedPositions(size_t axis) const { return mPositions[axis]; }
+	//! returns the texture coordinates as half floats, two per vertex, empty if the mesh has none
+	const std::vector<uint16_t>& getHalfTexCoords() const { return mTexCoords; }
+	//! returns the indices if hasShortIndices(), empty otherwise
+	const std::vector<uint16_t>& getShortIndices() const { return mShortIndices; }
+	//! returns the indices unless hasShortIndices(), empty otherwise
+	const std::vector<uint32_t>& getIndices() const { return mIndices; }
+
+	//! decodes the positions of a range of vertices
+	void decodePositions(size_t first, size_t count, ci::vec3* out) const;
+
+	//! returns the bounding box of the positions after a transformation, tighter than transforming getBounds()
+	ci::AxisAlignedBox calcBounds(const ci::mat4& transform) const;
+
+	/**
+	 * Finds the nearest triangle hit by a ray, from either side.
+	 *
+	 * @param ray the ray in object space
+	 * @param distance receives the ray parameter of the nearest hit, may be nullptr
+	 * @return true if a triangle was hit in front of the origin of the ray
+	 */
+	bool intersect(const ci::Ray& ray, float* distance = nullptr) const;
+
+	//! decodes the whole mesh, replacing the contents of a TriMesh
+	void decode(ci::TriMesh& mesh) const;
+
+	//! returns the number of bytes taken by the vertices and indices
+	size_t getMemorySize() const;
+
+	//! returns the number of bytes taken by the vertices and indices of a TriMesh, for comparison
+	static size_t calcMemorySize(const ci::TriMesh& mesh);
+
+	//! encodes a unit vector in 16 bits, choosing the rounding that restores it best
+	static uint16_t encodeNormal(const ci::vec3& normal);
+	//! decodes a unit vector encoded by encodeNormal
+	static ci::vec3 decodeNormal(uint16_t encoded);
+
+	//! converts a float to a half float, rounding to nearest even
+	static uint16_t encodeHalf(float value);
+	//! converts a half float to a float
+	static float decodeHalf(uint16_t value);
+
+protected:
+	static std::atomic<uint64_t> sNextId;		//!< the id of the next mesh, shared by all threads
+
+	uint64_t				mId;				//!< the id of the mesh
+	ci::AxisAlignedBox		mBounds;			//!< the bounding box of the positions
+	ci::vec3				mOffset;			//!< the position of the quantized value 0
+	ci::vec3				mStep;				//!< the distance between two quantized values along each axis
+	std::vector<uint16_t>	mPositions[3];		//!< the quantized position components, one array per axis
+	std::vector<uint16_t>	mNormals;			//!< the octahedral normals, empty if the mesh has none
+	std::vector<uint16_t>	mTexCoords;			//!< the half float texture coordinates, two per vertex
+	std::vector<uint16_t>	mShortIndices;		//!< the indices if they fit in 16 bits
+	std::vector<uint32_t>	mIndices;			//!< the indices otherwise
+};
+
+}
@@ -3,8 +3,11 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <unordered_map>
 
 #include "ComponentBase.hpp"
+#include "ComponentPool.hpp"
+#include "SlotMap.hpp"
 
 namespace scene {
 
@@ -13,12 +16,23 @@ typedef std::shared_ptr<ComponentFactory> ComponentFactoryRef;				//!< A shared
 typedef std::shared_ptr<const ComponentFactory> ComponentFactoryConstRef;	//!< A shared pointer to a constant ComponentFactory instance
 typedef std::weak_ptr<ComponentFactory> ComponentFactoryWeakRef;			//!< A weak pointer to a ComponentFactory instance
 
+typedef SlotHandle ComponentHandle;		//!< A generational handle to a component owned by a ComponentFactory
+
 /**
  * @brief ComponentFactory is an abstract base class for creating components
  *
  * The only way that components should be created is through a factory class.
  * This allows for simple, centralized management and upkeep for each component type.
  *
+ * Polymorphic ComponentBase instances are owned by the factory and referenced by
+ * generational handles, so creating, destroying and looking up a component (by
+ * handle or by name) are constant time, and stale handles are detected.
+ *
+ * Besides polymorphic ComponentBase instances, the factory owns one ComponentPool
+ * per component type. Pooled components are plain values attached to an entity id
+ * (see SceneObject::getId), stored contiguously and updated in a linear sweep with
+ * one virtual call per pool.
+ *
  * @see scene::Component
  */
 class ComponentFactory : public scene::SceneObject {
@@ -30,7 +44,81 @@ public:
 	
 	virtual void update( double elapsed );
 	
-	ComponentRef instantiate(const std::string& name);
+	//! creates a bare component and returns its handle
+	ComponentHandle instantiate(const std::string& name);
+	
+	//! creates a component of a type derived from ComponentBase and returns its handle
+	template<typename T>
+	ComponentHandle instantiate(const std::string& name)
+	{
+		return addComponent(std::unique_ptr<ComponentBase>(new T(name)));
+	}
+	
+	//! returns the component of a handle, or nullptr if the component was destroyed
+	ComponentBase* getComponent(const ComponentHandle& handle) const;
+	
+	//! returns the component of a handle cast to a derived type, or nullptr if it was destroyed or has another type
+	template<typename T>
+	T* getComponent(const ComponentHandle& handle) const
+	{
+		return dynamic_cast<T*>(getComponent(handle));
+	}
+	
+	//! returns the handle of a component using its unique name, or a null handle
+	ComponentHandle getComponentByName(const std::string& name) const;
+	
+	//! destroys the component of a handle, returns false if the handle is stale
+	bool destroyComponent(const ComponentHandle& handle);
+	
+	//! returns wether a handle refers to a live component
+	bool isValid(const ComponentHandle& handle) const { return mComponents.contains(handle); }
+	
+	//! returns the number of polymorphic components
+	size_t getComponentCount() const { return mComponents.size(); }
+	
+	//! destroys all polymorphic components
+	void clearComponents();
+	
+	/**
+	 * Attaches a pooled component to an entity, constructing it in place from the
+	 * remaining arguments. An existing component of the same type is replaced.
+	 *
+	 * @param entity the id of the owning entity, typically SceneObject::getId()
+	 * @return the component, valid until the next attach or detach of the same type
+	 */
+	template<typename T, typename... Args>
+	T* attach(uint64_t entity, Args&&... args)
+	{
+		return getPool<T>().attach(entity, std::forward<Args>(args)...);
+	}
+	
+	//! returns the pooled component of an entity, or nullptr
+	template<typename T>
+	T* get(uint64_t entity)
+	{
+		return getPool<T>().get(entity);
+	}
+	
+	//! removes the pooled component of an entity, returns false if there was none
+	template<typename T>
+	bool detach(uint64_t entity)
+	{
+		return getPool<T>().remove(entity);
+	}
+	
+	//! removes the pooled components of all types from an entity
+	void detachAll(uint64_t entity);
+	
+	//! returns the pool that stores all components of a type
+	template<typename T>
+	ComponentPool<T>& getPool()
+	{
+		size_t index = getTypeIndex<T>();
+		if (index >= mPools.size()) mPools.resize(index + 1);
+		if (!mPools[index]) mPools[index].reset(new ComponentPool<T>());
+		
+		return static_cast<ComponentPool<T>&>(*mPools[index]);
+	}
 	
 	static ComponentFactoryWeakRef get()
 	{
@@ -41,15 +129,24 @@ public:
 	}
 	
 protected:
-	bool addComponent(ComponentRef comp);
-	bool removeComponent(ComponentRef comp);
-	ComponentRef getComponentByName(const std::string& name) const;
-	bool clearComponents();
+	//! takes ownership of a component and indexes it by name
+	ComponentHandle addComponent(std::unique_ptr<ComponentBase> comp);
+	
+	//! returns a dense index that is unique for every pooled component type
+	template<typename T>
+	static size_t getTypeIndex()
+	{
+		static const size_t index = sNextTypeIndex++;
+		return index;
+	}
 	
 private:
 	static ComponentFactoryRef sInstance;
+	static size_t sNextTypeIndex;
 	
-	std::vector<ComponentRef> mComponents;
+	SlotMap<std::unique_ptr<ComponentBase>> mComponents;
+	std::unordered_map<std::string, ComponentHandle> mComponentNames;
+	std::vector<std::unique_ptr<ComponentPoolBase>> mPools;
 	
 };
 	
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+#include <memory>
+#include <utility>
+
+namespace scene {
+
+/**
+ * @brief Maps sparse 64-bit entity ids to dense indices
+ *
+ * The sparse side is split into fixed size pages that are allocated on first use,
+ * so ids that were never used cost one null page pointer per page.
+ */
+class SparseIndex {
+public:
+	static const uint32_t INVALID_INDEX = 0xffffffff;
+	static const uint32_t PAGE_BITS = 12;
+	static const uint32_t PAGE_SIZE = 1 << PAGE_BITS;
+	static const uint32_t PAGE_MASK = PAGE_SIZE - 1;
+
+	//! returns the dense index of an entity, or INVALID_INDEX if the entity has none
+	uint32_t find(uint64_t entity) const
+	{
+		uint64_t page = entity >> PAGE_BITS;
+		if (page >= mPages.size() || !mPages[page]) return INVALID_INDEX;
+		return mPages[page][entity & PAGE_MASK];
+	}
+
+	//! assigns the dense index of an entity
+	void set(uint64_t entity, uint32_t index)
+	{
+		uint64_t page = entity >> PAGE_BITS;
+		if (page >= mPages.size()) mPages.resize(page + 1);
+		if (!mPages[page]) {
+			// std::fill takes the value by reference, pass a copy so INVALID_INDEX needs no definition
+			const uint32_t invalid = INVALID_INDEX;
+			mPages[page].reset(new uint32_t[PAGE_SIZE]);
+			std::fill(mPages[page].get(), mPages[page].get() + PAGE_SIZE, invalid);
+		}
+		mPages[page][entity & PAGE_MASK] = index;
+	}
+
+	//! forgets the dense index of an entity
+	void erase(uint64_t entity)
+	{
+		uint64_t page = entity >> PAGE_BITS;
+		if (page < mPages.size() && mPages[page]) mPages[page][entity & PAGE_MASK] = INVALID_INDEX;
+	}
+
+	//! releases all pages
+	void clear() { mPages.clear(); }
+
+protected:
+	std::vector<std::unique_ptr<uint32_t[]>>	mPages;		//!< the lazily allocated pages of dense indices
+};
+
+/**
+ * @brief Type erased interface of a component pool, used by the ComponentFactory
+ *
+ * The factory makes one virtual call per pool, never per component.
+ */
+class ComponentPoolBase {
+public:
+	virtual ~ComponentPoolBase() {}
+
+	//! updates every component in the pool
+	virtual void update(double elapsed) = 0;
+
+	//! removes the component of an entity, returns false if the entity has none
+	virtual bool remove(uint64_t entity) = 0;
+
+	//! returns wether an entity has a component in this pool
+	virtual bool contains(uint64_t entity) const = 0;
+
+	//! returns the number of components in the pool
+	virtual size_t size() const = 0;
+
+	//! removes all components
+	virtual void clear() = 0;
+};
+
+/**
+ * @brief Contiguous, by-value storage of all components of one type
+ *
+ * Components are packed densely in the order they were attached, with a parallel
+ * array of owning entity ids. Removal moves the last component into the gap, so
+ * the storage never has holes. Pointers and references to components are only
+ * valid until the next call to attach or remove.
+ *
+ * The component type has to provide a non-virtual update(double) method, which is
+ * called directly (and can be inlined) while iterating the pool.
+ *
+ * @see scene::ComponentFactory
+ */
+template<typename T>
+class ComponentPool : public ComponentPoolBase {
+public:
+	typedef typename std::vector<T>::iterator iterator;
+	typedef typename std::vector<T>::const_iterator const_iterator;
+
+	/**
+	 * Attaches a component to an entity, constructing it in place. If the entity
+	 * already has a component of this type it is replaced.
+	 *
+	 * @return the component stored in the pool
+	 */
+	template<typename... Args>
+	T* attach(uint64_t entity, Args&&... args)
+	{
+		uint32_t index = mIndex.find(entity);
+		if (index != SparseIndex::INVALID_INDEX) {
+			mComponents[index] = T(std::forward<Args>(args)...);
+			return &mComponents[index];
+		}
+
+		index = static_cast<uint32_t>(mComponents.size());
+		mComponents.emplace_back(std::forward<Args>(args)...);
+		mEntities.push_back(entity);
+		mIndex.set(entity, index);
+		return &mComponents[index];
+	}
+
+	//! returns the component of an entity, or nullptr
+	T* get(uint64_t entity)
+	{
+		uint32_t index = mIndex.find(entity);
+		return (index != SparseIndex::INVALID_INDEX)? &mComponents[index]: nullptr;
+	}
+
+	//! returns the component of an entity, or nullptr
+	const T* get(uint64_t entity) const
+	{
+		uint32_t index = mIndex.find(entity);
+		return (index != SparseIndex::INVALID_INDEX)? &mComponents[index]: nullptr;
+	}
+
+	//! @inherit
+	virtual bool remove(uint64_t entity)
+	{
+		uint32_t index = mIndex.find(entity);
+		if (index == SparseIndex::INVALID_INDEX) return false;
+
+		// move the last component into the gap
+		uint32_t last = static_cast<uint32_t>(mComponents.size() - 1);
+		if (index != last) {
+			mComponents[index] = std::move(mComponents[last]);
+			mEntities[index] = mEntities[last];
+			mIndex.set(mEntities[index], index);
+		}
+		mComponents.pop_back();
+		mEntities.pop_back();
+		mIndex.erase(entity);
+
+		return true;
+	}
+
+	//! @inherit
+	virtual bool contains(uint64_t entity) const { return mIndex.find(entity) != SparseIndex::INVALID_INDEX; }
+
+	//! @inherit
+	virtual size_t size() const { return mComponents.size(); }
+
+	//! @inherit
+	virtual void clear()
+	{
+		mComponents.clear();
+		mEntities.clear();
+		mIndex.clear();
+	}
+
+	//! @inherit
+	virtual void update(double elapsed)
+	{
+		T* components = mComponents.data();
+		const size_t count = mComponents.size();
+		for (size_t i = 0; i < count; ++i) {
+			components[i].update(elapsed);
+		}
+	}
+
+	//! returns the packed components
+	T* data() { return mComponents.data(); }
+	//! returns the packed components
+	const T* data() const { return mComponents.data(); }
+
+	//! returns the entity ids that own the components, in the same order as the components
+	const std::vector<uint64_t>& getEntities() const { return mEntities; }
+
+	iterator begin() { return mComponents.begin(); }
+	iterator end() { return mComponents.end(); }
+	const_iterator begin() const { return mComponents.begin(); }
+	const_iterator end() const { return mComponents.end(); }
+
+protected:
+	std::vector<T>			mComponents;	//!< the densely packed components
+	std::vector<uint64_t>	mEntities;		//!< the owning entity of each component
+	SparseIndex				mIndex;			//!< maps entity ids to indices in mComponents
+};
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "cinder/Rect.h"
+
+namespace scene {
+
+class DamageTracker;
+typedef std::shared_ptr<DamageTracker> DamageTrackerRef;	//!< A shared pointer to a DamageTracker instance
+
+/**
+ * @brief Accumulates the screen regions that changed since the last frame
+ *
+ * Rectangles that overlap are merged as they are added. When the number of
+ * rectangles exceeds the configured maximum, the pair whose union wastes the
+ * least area is merged, so the result stays a small set of regions that can
+ * be cleared and redrawn individually (e.g. with a scissor rect each).
+ *
+ * @see Node2d::deepCollectDamage
+ */
+class DamageTracker {
+public:
+	//! creates DamageTracker instance wrapped by STL shared pointer
+	static DamageTrackerRef create(size_t max_rects = 8) { return DamageTrackerRef( new DamageTracker(max_rects) ); }
+
+	DamageTracker(size_t max_rects = 8);
+
+	//! adds a damaged region in screen space, empty rectangles are ignored
+	void add(const ci::Rectf& rect);
+
+	//! returns the merged damage rectangles
+	const std::vector<ci::Rectf>& getRects() const { return mRects; }
+
+	//! returns the union of all damage rectangles
+	ci::Rectf getBounds() const;
+
+	//! returns wether nothing was damaged
+	bool isEmpty() const { return mRects.empty(); }
+
+	//! returns wether the input rectangle overlaps any of the damage rectangles
+	bool intersects(const ci::Rectf& rect) const;
+
+	//! returns the maximum number of rectangles that are kept apart
+	size_t getMaxRects() const { return mMaxRects; }
+	//! assigns the maximum number of rectangles that are kept apart (at least one)
+	void setMaxRects(size_t max_rects);
+
+	//! removes all damage, typically called once the damaged regions were redrawn
+	void clear() { mRects.clear(); }
+
+	//! returns wether a rectangle has no area
+	static bool isEmpty(const ci::Rectf& rect) { return rect.getWidth() <= 0.0f || rect.getHeight() <= 0.0f; }
+
+	//! returns wether two rectangles share a region with a positive area
+	static bool overlaps(const ci::Rectf& lhs, const ci::Rectf& rhs);
+
+protected:
+	//! merges pairs of rectangles until the maximum count is respected
+	void reduce();
+
+	size_t					mMaxRects;	//!< the maximum number of rectangles
+	std::vector<ci::Rectf>	mRects;		//!< the disjoint damage rectangles
+};
+
+}
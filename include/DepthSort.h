@@ -0,0 +1,86 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "cinder/Matrix.h"
+
+#include "NodeBase.h"
+
+namespace scene {
+
+class SceneSnapshot;
+
+class DepthSorter;
+typedef std::shared_ptr<DepthSorter> DepthSorterRef;	//!< A shared pointer to a DepthSorter instance
+
+/**
+ * @brief View-dependent depth ordering of draw lists using a stable radix sort
+ *
+ * The sorter computes the view-space depth of every item once, converts it into
+ * an order preserving 32-bit key and sorts the keys with an LSD radix sort. Items
+ * with equal depth keep their input order. The result is a permutation of input
+ * indices, so the caller's draw list is never copied or reordered.
+ *
+ * All scratch storage is owned by the sorter and reused across frames.
+ *
+ * @see Node3d::sortPositionZ
+ */
+class DepthSorter {
+public:
+	//! Type that describes the direction of the depth ordering
+	typedef enum SortOrder_t {
+		BACK_TO_FRONT = 0,	//!< farthest first, used for transparent items
+		FRONT_TO_BACK = 1	//!< nearest first, used for opaque items to maximize early depth rejection
+	} SortOrder;
+
+	//! creates DepthSorter instance wrapped by STL shared pointer
+	static DepthSorterRef create() { return DepthSorterRef( new DepthSorter() ); }
+
+	DepthSorter() {}
+
+	/**
+	 * Sorts world space positions by their depth along the view direction.
+	 *
+	 * @param view the world to eye transformation of the camera
+	 * @param positions the world space positions to sort
+	 * @param count the number of positions
+	 * @param order the direction of the ordering
+	 * @return the indices of the input positions in sorted order
+	 */
+	const std::vector<uint32_t>& sort(const ci::mat4& view, const ci::vec3* positions, size_t count, SortOrder order);
+
+	//! sorts Node3d instances by the translation of their world transformation (non Node3d entries sort last)
+	const std::vector<uint32_t>& sort(const ci::mat4& view, const NodeDeque& nodes, SortOrder order);
+
+	//! sorts the visible items of a snapshot, the result contains snapshot item indices
+	const std::vector<uint32_t>& sort(const ci::mat4& view, const SceneSnapshot& snapshot, SortOrder order);
+
+	//! returns the result of the last sort
+	const std::vector<uint32_t>& getOrder() const { return mOrder; }
+
+	//! converts a floating point value into an unsigned key with the same ordering
+	static uint32_t toSortableKey(float value);
+
+	/**
+	 * Stable LSD radix sort of 32-bit keys. On return order contains the indices
+	 * of the keys in ascending order. The key vector is used as scratch space.
+	 */
+	static void radixSort(std::vector<uint32_t>& keys, std::vector<uint32_t>& order,
+						  std::vector<uint32_t>& key_scratch, std::vector<uint32_t>& order_scratch);
+
+protected:
+	//! appends the key of a view space depth value
+	void pushDepth(float view_z, SortOrder order);
+
+	//! sorts the keys pushed by pushDepth() and returns the resulting order
+	const std::vector<uint32_t>& finish();
+
+	std::vector<uint32_t>	mKeys;			//!< the depth keys of the items
+	std::vector<uint32_t>	mKeyScratch;	//!< ping-pong buffer for the keys
+	std::vector<uint32_t>	mOrder;			//!< the sorted item indices
+	std::vector<uint32_t>	mOrderScratch;	//!< ping-pong buffer for the item indices
+	std::vector<uint32_t>	mMapping;		//!< maps sorted positions back to snapshot item indices
+};
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "cinder/Rect.h"
+
+#include "ChangeJournal.h"
+#include "Node2d.h"
+#include "PointerEvent.h"
+
+namespace scene {
+
+class EventDispatcher;
+typedef std::shared_ptr<EventDispatcher> EventDispatcherRef;	//!< A shared pointer to an EventDispatcher instance
+
+/**
+ * @brief Routes pointer input to the nodes of a Node2d scene graph
+ *
+ * Instead of offering every event to every node, the dispatcher hit-tests the pointer
+ * once against a bounding volume hierarchy of the world space content bounds of all
+ * active, interactive nodes. The topmost node in draw order whose hitTest accepts the
+ * point becomes the target, and the event is delivered along its ancestor path (see
+ * PointerEvent). The cost per event is O(log n + depth).
+ *
+ * When a node consumes POINTER_DOWN it captures the pointer: the following drag and up
+ * events go straight to it, even if the pointer leaves its bounds, until POINTER_UP.
+ *
+ * The hierarchy reflects the world transformations at the time it was built. When the
+ * root belongs to a SceneContext, update() reads the ChangeJournal of the context and
+ * keeps the hierarchy up to date by itself: nodes that were added, removed, reordered,
+ * activated, deactivated or made (non-)interactive rebuild it, while nodes that only
+ * moved or changed their size refit the bounds of the existing hierarchy. The dispatcher
+ * enables the journal, the frame loop clears it once per frame after update(). Without
+ * a context, call invalidate() after deepTransform when nodes moved, or were added or
+ * removed; the next event rebuilds the hierarchy.
+ *
+ * The node under the pointer is cached as the hover target. Hit testing only runs again
+ * when the pointer moved or the scene changed, and a change of the hover target
+ * sends POINTER_LEAVE to the previous node and POINTER_ENTER to the new one. Input that
+ * arrives faster than the frame rate can be queued with post(): moves and drags are
+ * coalesced to the latest position and delivered by update() once per frame.
+ */
+class EventDispatcher {
+public:
+	//! creates EventDispatcher instance wrapped by STL shared pointer
+	static EventDispatcherRef create(const Node2dRef& root = Node2dRef()) { return EventDispatcherRef( new EventDispatcher(root) ); }
+
+	EventDispatcher(const Node2dRef& root = Node2dRef());
+
+	//! assigns the root of the scene graph that receives the events
+	void setRoot(const Node2dRef& root);
+	//! returns the root of the scene graph that receives the events
+	Node2dRef getRoot() const { return mRoot.lock(); }
+
+	/**
+	 * Delivers a pointer event to the scene graph.
+	 *
+	 * @param type the kind of input
+	 * @param position the pointer position in world (screen) coordinates
+	 * @param button the button that changed, application defined
+	 * @return the node that consumed the event, or an empty reference
+	 */
+	NodeRef dispatch(PointerEvent::Type type, const ci::vec2& position, int button = 0);
+
+	/**
+	 * Queues a pointer event. Moves and drags replace the pending motion, so only the latest
+	 * position is delivered by the next update(). Presses and releases deliver the pending
+	 * motion first, then themselves, immediately.
+	 *
+	 * @param type the kind of input
+	 * @param position the pointer position in world (screen) coordinates
+	 * @param button the button that changed, application defined
+	 */
+	void post(PointerEvent::Type type, const ci::vec2& position, int button = 0);
+
+	/**
+	 * Reads the journal of the context of the root, if any, and delivers the pending motion
+	 * queued by post(). Without pending motion, the hover target is refreshed if the scene
+	 * changed, since nodes may have moved under a still pointer. Call once per frame after
+	 * deepTransform and before the journal is cleared.
+	 */
+	void update();
+
+	//! returns the node under the pointer as of the last event, or an empty reference
+	NodeRef getHover() const { return mHover.lock(); }
+
+	//! returns the topmost interactive node at a position in world coordinates, or an empty reference
+	Node2dRef hitTest(const ci::vec2& position);
+
+	//! marks the bounding volume hierarchy out of date, it is rebuilt before the next hit test; only needed without a SceneContext
+	void invalidate() { mIsDirty = true; }
+
+	//! rebuilds the bounding volume hierarchy from the current world transformations
+	void rebuild();
+
+	//! updates the bounds of the bounding volume hierarchy to the current world transformations, keeping its structure
+	void refit();
+
+	//! returns the node that captured the pointer, or an empty reference
+	NodeRef getCapture() const { return mCapture.lock(); }
+
+	//! ends the pointer capture, the next events are hit-tested again
+	void releaseCapture() { mCapture.reset(); }
+
+	//! returns the number of interactive nodes in the hierarchy
+	size_t getItemCount() const { return mItems.size(); }
+
+	//! returns the number of bounds tested by the last hit test
+	size_t getLastTestCount() const { return mLastTestCount; }
+
+	//! returns the number of hit tests run so far
+	size_t getHitTestCount() const { return mHitTestCount; }
+
+	//! returns the number of times the hierarchy was rebuilt so far
+	size_t getRebuildCount() const { return mRebuildCount; }
+
+protected:
+	struct Item {
+		NodeWeakRef		mNode;		//!< the interactive node
+		ci::Rectf		mBounds;	//!< the world space content bounds
+		uint32_t		mOrder;		//!< the draw order, higher is on top
+	};
+
+	struct BvhNode {
+		ci::Rectf		mBounds;	//!< the bounds of all items below
+		uint32_t		mMaxOrder;	//!< the highest draw order of all items below
+		uint32_t		mFirst;		//!< leaves: the first item, inner nodes: the left child (the right one follows it)
+		uint32_t		mCount;		//!< leaves: the number of items, inner nodes: zero
+	};
+
+	static const uint32_t LEAF_SIZE = 4;
+
+	//! appends the interactive nodes of a subtree in draw order
+	void collect(const NodeRef& node, uint32_t& order);
+
+	//! builds the hierarchy over a range of items below the node at index
+	void build(uint32_t index, uint32_t first, uint32_t count);
+
+	//! marks the hierarchy for a rebuild or a refit by the changes recorded in a journal, enabling it if needed
+	void readJournal(ChangeJournal& journal);
+
+	//! delivers an event along the ancestor path of its target, returns the consumer
+	NodeRef deliver(PointerEvent& event, const NodeRef& target);
+
+	//! returns the node at a position, reusing the hover target if neither pointer nor scene changed
+	NodeRef pick(const ci::vec2& position);
+
+	//! makes a node the hover target, sending leave and enter events if it changed
+	void setHover(const NodeRef& node, const ci::vec2& position);
+
+	Node2dWeakRef			mRoot;			//!< the root of the scene graph
+	NodeWeakRef				mCapture;		//!< the node that captured the pointer
+	std::vector<Item>		mItems;			//!< the interactive nodes, sorted by the hierarchy
+	std::vector<BvhNode>	mNodes;			//!< the hierarchy, the first node is the top
+	bool					mIsDirty;		//!< flag set when the hierarchy must be rebuilt
+	bool					mNeedsRefit;	//!< flag set when the bounds of the hierarchy must be updated
+	size_t					mRebuildCount;	//!< the number of rebuilds so far
+	size_t					mLastTestCount;	//!< the number of bounds tested by the last hit test
+	size_t					mHitTestCount;	//!< the number of hit tests run so far
+	NodeWeakRef				mHover;			//!< the node under the pointer
+	ci::vec2				mHoverPosition;	//!< the pointer position of the last hover test
+	bool					mHasHover;		//!< flag set once the hover target was tested
+	bool					mHasMotion;		//!< flag set when post() queued motion
+	PointerEvent::Type		mMotionType;	//!< the type of the queued motion
+	ci::vec2				mMotionPosition;	//!< the position of the queued motion
+	int						mMotionButton;	//!< the button of the queued motion
+};
+
+}
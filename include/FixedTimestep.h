@@ -0,0 +1,79 @@
+#pragma once
+
+#include <memory>
+
+#include "NodeBase.h"
+
+namespace scene {
+
+class SceneContext;
+
+class FixedTimestep;
+typedef std::shared_ptr<FixedTimestep> FixedTimestepRef;	//!< A shared pointer to a FixedTimestep instance
+
+/**
+ * @brief Clock that runs the simulation of a scene graph at a fixed rate
+ *
+ * The frame time is accumulated and consumed in steps of constant duration, so update()
+ * functions always see the same elapsed time regardless of the display rate. When a frame
+ * takes too long, at most getMaxSteps() steps are run and the remaining time is dropped,
+ * which keeps the simulation cost bounded instead of spiralling after a spike.
+ *
+ * Before each step the local transformations are saved with deepSaveTransform. The
+ * render pass presents the scene with deepTransformInterpolated, blending the saved and
+ * current states by getAlpha(), the fraction of a step left in the accumulator.
+ */
+class FixedTimestep {
+public:
+	//! creates FixedTimestep instance wrapped by STL shared pointer
+	static FixedTimestepRef create(double step = 1.0 / 60.0, uint32_t max_steps = 5) { return FixedTimestepRef( new FixedTimestep(step, max_steps) ); }
+
+	FixedTimestep(double step = 1.0 / 60.0, uint32_t max_steps = 5);
+
+	/**
+	 * Adds the frame time to the accumulator and returns the number of steps that are due,
+	 * at most getMaxSteps(). The caller is expected to run that many steps of getStep() seconds.
+	 *
+	 * @param elapsed the wall-clock time since the previous frame in seconds
+	 * @return the number of steps to run
+	 */
+	uint32_t advance(double elapsed);
+
+	//! advances the clock and runs the due steps with deepSaveTransform and deepUpdate, returns the number of steps
+	uint32_t update(NodeBase& root, double elapsed);
+
+	//! advances the clock and runs the due steps with deepSaveTransform on the root and SceneContext::update, returns the number of steps
+	uint32_t update(SceneContext& context, double elapsed);
+
+	//! returns the blend factor between the previous and current simulation state for rendering
+	float getAlpha() const { return static_cast<float>(mAccumulator / mStep); }
+
+	//! assigns the duration of a step in seconds
+	void setStep(double step) { mStep = (step > 0)? step: mStep; }
+	//! returns the duration of a step in seconds
+	double getStep() const { return mStep; }
+
+	//! assigns the maximum number of steps run in a single frame
+	void setMaxSteps(uint32_t max_steps) { mMaxSteps = (max_steps > 0)? max_steps: 1; }
+	//! returns the maximum number of steps run in a single frame
+	uint32_t getMaxSteps() const { return mMaxSteps; }
+
+	//! returns the total simulated time in seconds
+	double getTime() const { return mStepCount * mStep; }
+	//! returns the number of steps run so far
+	uint64_t getStepCount() const { return mStepCount; }
+	//! returns the total frame time that was dropped to respect the catch-up limit
+	double getDroppedTime() const { return mDroppedTime; }
+
+	//! clears the accumulator and statistics
+	void reset();
+
+protected:
+	double		mStep;			//!< the duration of a step
+	uint32_t	mMaxSteps;		//!< the catch-up limit
+	double		mAccumulator;	//!< the frame time not consumed by steps yet, always less than mStep
+	uint64_t	mStepCount;		//!< the number of steps run so far
+	double		mDroppedTime;	//!< the frame time dropped by the catch-up limit
+};
+
+}
@@ -0,0 +1,201 @@
+#pragma once
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "EventDispatcher.h"
+#include "PointerEvent.h"
+#include "SceneContext.h"
+#include "SceneDelta.h"
+
+namespace scene {
+
+/**
+ * @brief Header of a frame recording
+ *
+ * The header is followed by one FrameRecord per recorded frame until the end of the
+ * file. Each record is followed by its pointer events and by a scene delta (see
+ * SceneDeltaHeader) that holds the changes made during the frame; the delta of the first
+ * frame is a full snapshot. A frame that changed nothing has no delta. All values are
+ * little endian.
+ */
+struct FrameFileHeader {
+	static const uint32_t MAGIC = 0x524e4353;	//!< "SCNR"
+	static const uint16_t VERSION = 1;			//!< the version written by FrameRecorder
+
+	uint32_t	mMagic;		//!< MAGIC, also rejects files of the wrong byte order
+	uint16_t	mVersion;	//!< the version of the format
+	uint16_t	mReserved;	//!< 0
+};
+
+//! A recorded frame, followed by mEventCount FrameEventRecords and mDeltaSize bytes of delta
+struct FrameRecord {
+	uint32_t	mFrame;			//!< the index of the frame, counting from 0
+	uint32_t	mEventCount;	//!< the number of pointer events
+	uint32_t	mDeltaSize;		//!< the size of the delta in bytes, 0 if nothing changed
+	uint32_t	mReserved;		//!< 0
+	double		mElapsed;		//!< the time step of the frame in seconds
+};
+
+//! A pointer event as stored in a frame recording
+struct FrameEventRecord {
+	uint32_t	mType;			//!< the PointerEvent::Type
+	int32_t		mButton;		//!< the button that changed
+	float		mPosition[2];	//!< the pointer position in world (screen) coordinates
+};
+
+/**
+ * @brief Records what a scene did, frame by frame, into a compact file
+ *
+ * Node creation and destruction, property changes and structural changes are taken from
+ * the ChangeJournal of the context by a SceneDeltaEncoder, so a frame costs as much as
+ * the nodes it changed. The application reports the pointer input it received with
+ * recordEvent() and calls endFrame() once per frame, before the journal is cleared.
+ *
+ * The recording is replayed by a FrameReplayer, headless and deterministically, to
+ * reproduce the cost of the traversals on another machine.
+ *
+ * @see scene::FrameReplayer
+ */
+class FrameRecorder {
+public:
+	/**
+	 * Starts tracking a scene, its current state becomes the first frame.
+	 *
+	 * @param context the context whose journal is read, must outlive the recorder
+	 * @param registry the ids of the node types, must outlive the recorder
+	 */
+	FrameRecorder(SceneContext& context, const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault());
+
+	//! starts writing a recording to a stream that must stay valid until end(), returns false if the header could not be written
+	bool begin(std::ostream& stream);
+
+	//! starts writing a recording to a file, returns false if it could not be created
+	bool begin(const std::string& path);
+
+	//! records a pointer event of the current frame
+	void recordEvent(PointerEvent::Type type, const ci::vec2& position, int button = 0);
+
+	/**
+	 * Writes the current frame: its time step, the recorded events and the changes made
+	 * to the scene. Must be called once per frame before the journal is cleared.
+	 *
+	 * @param elapsed the time step of the frame in seconds
+	 * @return false if no recording was begun or the stream failed
+	 */
+	bool endFrame(double elapsed);
+
+	//! flushes the recording and stops writing, the file is closed if begin() opened it
+	bool end();
+
+	//! returns true between begin() and end()
+	bool isRecording() const { return mStream != nullptr; }
+
+	//! returns the number of frames written since begin()
+	uint32_t getFrameCount() const { return mFrameCount; }
+
+	//! returns the number of bytes written since begin()
+	uint64_t getByteCount() const { return mByteCount; }
+
+	//! returns the encoder of the changes, to adjust its quantization step
+	SceneDeltaEncoder& getEncoder() { return mEncoder; }
+
+protected:
+	//! writes bytes to the stream and counts them
+	bool write(const void* data, size_t size);
+
+	SceneDeltaEncoder				mEncoder;		//!< encodes the changes of each frame
+	std::ostream*					mStream;		//!< the stream being written, nullptr if not recording
+	std::unique_ptr<std::ofstream>	mFile;			//!< the file opened by begin(path)
+	uint32_t						mSent;			//!< the version of the scene written last, 0 before the first frame
+	uint32_t						mFrameCount;	//!< the number of frames written
+	uint64_t						mByteCount;		//!< the number of bytes written
+	std::vector<FrameEventRecord>	mEvents;		//!< the events of the current frame
+	std::vector<uint8_t>			mDelta;			//!< the delta of the current frame
+};
+
+/**
+ * @brief Replays a frame recording headless and measures the phases of every frame
+ *
+ * Each frame of the recording is replayed in the order the application went through it:
+ * the recorded pointer events are dispatched against the previous frame, the recorded
+ * changes are applied to a replica of the scene, then the replica runs deepUpdate and
+ * deepTransform. The time spent in each phase is kept per frame (see getTimings).
+ *
+ * The replica is built from the types of the SceneTypeRegistry, so it has the structure,
+ * transformations and contents of the recorded scene but not the behavior of application
+ * types that were not registered.
+ *
+ * @see scene::FrameRecorder
+ */
+class FrameReplayer {
+public:
+	//! Type that describes the phases of a replayed frame
+	typedef enum Phase_t {
+		PHASE_INPUT = 0,		//!< dispatching the recorded pointer events
+		PHASE_APPLY = 1,		//!< applying the recorded changes to the replica
+		PHASE_UPDATE = 2,		//!< NodeBase::deepUpdate
+		PHASE_TRANSFORM = 3,	//!< Node2d::deepTransform or Node3d::deepTransform
+		PHASE_COUNT = 4
+	} Phase;
+
+	//! The measurements of a replayed frame
+	struct FrameTiming {
+		uint32_t	mFrame;							//!< the index of the frame
+		uint32_t	mNodeCount;						//!< the number of nodes in the replica
+		uint32_t	mEventCount;					//!< the number of dispatched events
+		uint32_t	mDeltaSize;						//!< the size of the applied delta in bytes
+		double		mMicroseconds[PHASE_COUNT];		//!< the time spent in each phase
+	};
+
+	FrameReplayer(const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault());
+
+	//! starts replaying a recording from a stream that must stay valid, returns false if it is not a recording
+	bool open(std::istream& stream);
+
+	//! starts replaying a recording from a file, returns false if it can not be read
+	bool open(const std::string& path);
+
+	/**
+	 * Replays the next frame.
+	 *
+	 * @return false at the end of the recording, or if the frame is malformed (see isComplete)
+	 */
+	bool step();
+
+	//! replays the remaining frames, returns the number of replayed frames
+	size_t run();
+
+	//! returns true once the whole recording was replayed without error
+	bool isComplete() const { return mIsComplete; }
+
+	//! returns the root of the replica, or nullptr
+	const NodeRef& getRoot() const { return mApplier.getRoot(); }
+
+	//! returns the replica of the recorded scene
+	const SceneDeltaApplier& getApplier() const { return mApplier; }
+
+	//! returns the dispatcher of the recorded events
+	EventDispatcher& getDispatcher() { return mDispatcher; }
+
+	//! returns the measurements of the replayed frames
+	const std::vector<FrameTiming>& getTimings() const { return mTimings; }
+
+protected:
+	//! reads bytes from the stream into mBuffer, growing it as data arrives so a corrupt size can not exhaust memory
+	bool read(size_t size);
+
+	SceneDeltaApplier				mApplier;		//!< the replica of the scene
+	EventDispatcher					mDispatcher;	//!< delivers the recorded events to the replica
+	std::istream*					mStream;		//!< the stream being replayed, nullptr if none
+	std::unique_ptr<std::ifstream>	mFile;			//!< the file opened by open(path)
+	uint32_t						mNextFrame;		//!< the index of the next frame
+	bool							mIsComplete;	//!< set once the end of the recording was reached
+	std::vector<uint8_t>			mBuffer;		//!< the events and delta of the frame being replayed
+	std::vector<FrameTiming>		mTimings;		//!< the measurements of the replayed frames
+};
+
+}
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "cinder/AxisAlignedBox.h"
+#include "cinder/TriMesh.h"
+
+#include "MpscQueue.hpp"
+#include "NodeMesh.h"
+#include "ThreadPool.h"
+
+namespace scene {
+
+/**
+ * @brief Header of a binary mesh file
+ *
+ * The header is followed by the positions (3 floats per vertex), the normals and the
+ * texture coordinates (2 floats per vertex) if the matching Attribute bits are set, and
+ * the indices (uint32, 3 per triangle). All values are little endian.
+ */
+struct MeshFileHeader {
+	static const uint32_t MAGIC = 0x4d4e4353;	//!< "SCNM"
+	static const uint16_t VERSION = 1;			//!< the version written by MeshLoader::encodeBinary
+
+	//! Type that describes the optional vertex attributes
+	typedef enum Attribute_t {
+		ATTRIBUTE_NORMALS = 1 << 0,		//!< a normal follows every position
+		ATTRIBUTE_TEXCOORDS = 1 << 1	//!< texture coordinates follow the normals
+	} Attribute;
+
+	uint32_t	mMagic;			//!< MAGIC, also rejects files of the wrong byte order
+	uint16_t	mVersion;		//!< the version of the format
+	uint16_t	mAttributes;	//!< the Attribute bits
+	uint32_t	mVertexCount;	//!< the number of vertices
+	uint32_t	mIndexCount;	//!< the number of indices, a multiple of 3
+	float		mMin[3];		//!< the minimum corner of the bounding box
+	float		mMax[3];		//!< the maximum corner of the bounding box
+};
+
+class MeshLoader;
+typedef std::shared_ptr<MeshLoader> MeshLoaderRef;	//!< A shared pointer to a MeshLoader instance
+
+/**
+ * @brief Loads meshes on a thread pool and swaps them into their nodes at a sync point
+ *
+ * load() returns a NodeMesh right away, showing a placeholder bounding box, and queues the
+ * file to be read and decoded by a worker. The main thread never touches the disk: the
+ * frame loop calls sync() once per frame, while nothing traverses the scene, and the
+ * decoded meshes are moved into their nodes there. Nodes that were released in the
+ * meantime are skipped.
+ *
+ * OBJ files (positions, normals, texture coordinates and polygonal faces, which are
+ * triangulated as fans) and the binary format described by MeshFileHeader are supported.
+ *
+ * The loader may be destroyed while decodes are queued or running; decodes that did not
+ * start yet are skipped and the results of the others are dropped.
+ */
+class MeshLoader {
+public:
+	//! Type that describes the format of a mesh file
+	typedef enum Format_t {
+		FORMAT_AUTO = 0,	//!< the binary format if the path ends with ".mesh", OBJ otherwise
+		FORMAT_OBJ = 1,		//!< Wavefront OBJ
+		FORMAT_BINARY = 2	//!< see MeshFileHeader
+	} Format;
+
+	//! Called by sync() once a mesh was swapped in, or with false if it could not be loaded
+	typedef std::function<void(const NodeMeshRef& node, bool loaded)> Callback;
+
+	//! creates MeshLoader instance wrapped by STL shared pointer, a pool with one thread is created if none is given
+	static MeshLoaderRef create(const ThreadPoolRef& pool = ThreadPoolRef()) { return MeshLoaderRef( new MeshLoader(pool) ); }
+
+	MeshLoader(const ThreadPoolRef& pool = ThreadPoolRef());
+
+	//! skips the queued decodes and drops the results of the running ones
+	~MeshLoader();
+
+	/**
+	 * Creates a node that shows a placeholder until its mesh was loaded.
+	 *
+	 * @param path the file to load
+	 * @param placeholder the bounding box that stands in for the mesh, in object space
+	 * @param format the format of the file
+	 * @param callback called by sync() once the node got its mesh, may be empty
+	 * @return the node, owned by the caller
+	 */
+	NodeMeshRef load(const std::string& path, const ci::AxisAlignedBox& placeholder = ci::AxisAlignedBox(ci::vec3(-0.5f), ci::vec3(0.5f)),
+					 Format format = FORMAT_AUTO, const Callback& callback = Callback());
+
+	//! loads the mesh of an existing node, which keeps its current mesh or placeholder until sync() swaps in the new one
+	void load(const NodeMeshRef& node, const std::string& path, Format format = FORMAT_AUTO, const Callback& callback = Callback());
+
+	/**
+	 * Swaps the decoded meshes into their nodes and invokes the callbacks. Must be called
+	 * from the thread that owns the scene graph while nothing traverses it. A node whose
+	 * mesh could not be loaded keeps what it showed before.
+	 *
+	 * @return the number of loads that completed, including the failed ones
+	 */
+	size_t sync();
+
+	//! returns the number of loads that did not reach sync() yet
+	size_t getPendingCount() const { return mShared->mPendingCount.load(std::memory_order_relaxed); }
+
+	//! returns the number of loads that failed since the loader was created
+	size_t getFailedCount() const { return mFailedCount; }
+
+	//! makes the following loads hand CompactMesh instances to their nodes, quantized on the pool
+	void setCompact(bool compact = true) { mIsCompact = compact; }
+	//! returns true if the loaded meshes are compacted
+	bool isCompact() const { return mIsCompact; }
+
+	//! decodes an OBJ document, returns false if it is malformed or refers to missing vertices
+	static bool decodeObj(std::istream& stream, ci::TriMesh& mesh);
+
+	//! decodes the binary mesh format, returns false if the data is malformed or of a newer version
+	static bool decodeBinary(const uint8_t* data, size_t size, ci::TriMesh& mesh);
+
+	//! encodes a mesh in the binary format, replacing the contents of the buffer
+	static void encodeBinary(const ci::TriMesh& mesh, std::vector<uint8_t>& buffer);
+
+	//! reads and decodes a mesh file on the calling thread, returns false if it can not be read
+	static bool loadFile(const std::string& path, Format format, ci::TriMesh& mesh);
+
+protected:
+	//! A decoded mesh on its way to its node
+	struct Result {
+		NodeMeshWeakRef		mNode;		//!< the node, expired if it was released meanwhile
+		ci::TriMeshRef		mMesh;			//!< the mesh, nullptr if it could not be loaded or was compacted
+		CompactMeshRef		mCompactMesh;	//!< the compacted mesh, nullptr if it could not be loaded or was not compacted
+		Callback			mCallback;	//!< the callback of the load
+	};
+
+	//! The state shared with the workers, which may outlive the loader
+	struct Shared {
+		MpscQueue<Result>	mResults;		//!< the decoded meshes, pushed by the workers
+		std::atomic<size_t>	mPendingCount;	//!< the number of loads that did not reach sync()
+		std::atomic<bool>	mIsCancelled;	//!< set once the loader is gone, so queued decodes are skipped
+	};
+
+	ThreadPoolRef				mPool;			//!< executes the decodes
+	std::shared_ptr<Shared>		mShared;		//!< the results of the decodes
+	size_t						mFailedCount;	//!< the number of failed loads
+	bool						mIsCompact;		//!< set if the loaded meshes are compacted
+};
+
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+namespace scene {
+
+/**
+ * @brief Unbounded lock-free queue with many producers and a single consumer
+ *
+ * Producers link a new node with a single atomic exchange, so push never blocks or
+ * retries. The consumer pops from the other end without any atomic read-modify-write.
+ * A pop that runs concurrently with a push may miss the element that is being linked;
+ * it is returned by a later pop. Elements pushed by one thread are popped in the order
+ * in which they were pushed.
+ *
+ * Based on the intrusive MPSC queue by Dmitry Vyukov.
+ */
+template<typename T>
+class MpscQueue {
+public:
+	MpscQueue() : mHead(&mStub), mTail(&mStub)
+	{
+		mStub.mNext.store(nullptr, std::memory_order_relaxed);
+	}
+
+	//! destroys the elements that were not popped, must not run concurrently with push
+	~MpscQueue()
+	{
+		T value;
+		while (pop(value)) {}
+	}
+
+	//! appends an element, may be called from any thread
+	void push(T value)
+	{
+		Node* node = new Node(std::move(value));
+		link(node);
+	}
+
+	//! removes the oldest element, returns false if the queue is empty, must only be called from the consumer thread
+	bool pop(T& value)
+	{
+		Node* tail = mTail;
+		Node* next = tail->mNext.load(std::memory_order_acquire);
+
+		// skip the stub node
+		if (tail == &mStub) {
+			if (!next) return false;
+			mTail = next;
+			tail = next;
+			next = next->mNext.load(std::memory_order_acquire);
+		}
+
+		if (next) {
+			mTail = next;
+			value = std::move(tail->mValue);
+			delete tail;
+			return true;
+		}
+
+		// tail is the last node, a producer may still be linking a new one
+		if (tail != mHead.load(std::memory_order_acquire)) return false;
+
+		// put the stub back behind the last node so it can be detached
+		link(&mStub);
+
+		next = tail->mNext.load(std::memory_order_acquire);
+		if (next) {
+			mTail = next;
+			value = std::move(tail->mValue);
+			delete tail;
+			return true;
+		}
+		return false;
+	}
+
+	//! returns true if no element is queued, only reliable on the consumer thread while producers are idle
+	bool empty() const
+	{
+		Node* tail = mTail;
+		return tail == &mStub && !tail->mNext.load(std::memory_order_acquire);
+	}
+
+private:
+	struct Node {
+		Node() {}
+		explicit Node(T&& value) : mValue(std::move(value)) { mNext.store(nullptr, std::memory_order_relaxed); }
+
+		std::atomic<Node*>	mNext;
+		T					mValue;
+	};
+
+	void link(Node* node)
+	{
+		node->mNext.store(nullptr, std::memory_order_relaxed);
+		Node* previous = mHead.exchange(node, std::memory_order_acq_rel);
+		previous->mNext.store(node, std::memory_order_release);
+	}
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue& operator=(const MpscQueue&) = delete;
+
+	std::atomic<Node*>	mHead;	//!< the most recently pushed node, shared by the producers
+	Node*				mTail;	//!< the oldest node, owned by the consumer
+	Node				mStub;	//!< placeholder that keeps the list non-empty
+};
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+
+#include "MpscQueue.hpp"
+#include "NodeBase.h"
+
+namespace scene {
+
+/**
+ * @brief Structural edits of a scene graph that are applied later, at a sync point
+ *
+ * Adding or removing children while a traversal (deepUpdate, an Iterator, a draw pass)
+ * walks the same NodeDeque invalidates its iterators, and threads other than the main
+ * thread can not touch the tree at all. Instead, edits are queued here from any thread
+ * and applied in order by the main thread with apply(), at points of the frame where
+ * nothing traverses the tree (see SceneContext::sync).
+ *
+ * A typical loader thread builds a detached subtree on its own and queues a single
+ * attach, so the scene sees the subtree appear at once.
+ */
+class MutationQueue {
+public:
+	//! Type that describes a queued edit
+	typedef enum Operation_t {
+		MUTATION_ATTACH = 0,		//!< adds the node to the children of the parent (see NodeBase::addChild)
+		MUTATION_DETACH = 1,		//!< removes the node from its parent (see NodeBase::removeFromParent)
+		MUTATION_MOVE_TO_TOP = 2,	//!< puts the node on top of its siblings
+		MUTATION_MOVE_TO_BOTTOM = 3,	//!< puts the node beneath its siblings
+		MUTATION_DESTROY = 4		//!< detaches the node and drops the references of the scene to it and its children
+	} Operation;
+
+	MutationQueue();
+
+	//! queues adding a node to the children of a parent, may be called from any thread
+	void attach(const NodeRef& parent, const NodeRef& node) { push(MUTATION_ATTACH, parent, node); }
+
+	//! queues removing a node from its parent, may be called from any thread
+	void detach(const NodeRef& node) { push(MUTATION_DETACH, NodeRef(), node); }
+
+	//! queues putting a node on top of its siblings, may be called from any thread
+	void moveToTop(const NodeRef& node) { push(MUTATION_MOVE_TO_TOP, NodeRef(), node); }
+
+	//! queues putting a node beneath its siblings, may be called from any thread
+	void moveToBottom(const NodeRef& node) { push(MUTATION_MOVE_TO_BOTTOM, NodeRef(), node); }
+
+	//! queues detaching a node and its children from the scene, which frees them once nothing else references them, may be called from any thread
+	void destroy(const NodeRef& node) { push(MUTATION_DESTROY, NodeRef(), node); }
+
+	/**
+	 * Applies the queued edits in order. Must be called from the thread that owns the scene
+	 * graph while nothing traverses it. Edits queued by the applied ones (for instance from
+	 * addedToScene) are applied as well.
+	 *
+	 * @return the number of applied edits
+	 */
+	size_t apply();
+
+	//! returns the approximate number of queued edits
+	size_t getPendingCount() const { return mPendingCount.load(std::memory_order_relaxed); }
+
+protected:
+	struct Mutation {
+		Operation	mOperation;
+		NodeRef		mParent;
+		NodeRef		mNode;
+	};
+
+	//! queues an edit
+	void push(Operation operation, const NodeRef& parent, const NodeRef& node);
+
+	MpscQueue<Mutation>		mQueue;			//!< the queued edits
+	std::atomic<size_t>		mPendingCount;	//!< the number of queued edits
+};
+
+}
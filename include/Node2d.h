@@ -3,6 +3,7 @@
 #include <string>
 #include <iostream>
 #include <deque>
+#include <vector>
 
 #include "cinder/app/App.h"
 #include "cinder/CinderMath.h"
@@ -14,6 +15,7 @@
 #include "glm/gtc/matrix_access.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 
+#include "DamageTracker.h"
 #include "NodeBase.h"
 
 namespace scene {
@@ -49,20 +51,20 @@ public:
 	//! returns the 2d position of the node
 	ci::vec2	getPosition() const { return mPosition; }
 	//! assigns the 2d position of the node using a 2D vector
-	void		setPosition(const ci::vec2& pt) { mPosition = pt; mTransformIsDirty = true; }
+	void		setPosition(const ci::vec2& pt) { mPosition = pt; setTransformDirty(); }
 	//! assigns the 2d position of the node using two floats
-	void		setPosition(const float x, const float y) { mPosition = ci::vec2(x,y); mTransformIsDirty = true; }
+	void		setPosition(const float x, const float y) { mPosition = ci::vec2(x,y); setTransformDirty(); }
 	
 	//! returns the 2d scale of the node as a mutable reference
 	ci::vec2&	scale() { return mScale; }
 	//! returns the 2d scale of the node
 	ci::vec2	getScale() const { return mScale; }
 	//! assigns the 2d uniform scale of the node using a single float
-	void		setScale(const float scale) { mScale = ci::vec2(scale,scale); mTransformIsDirty = true; }
+	void		setScale(const float scale) { mScale = ci::vec2(scale,scale); setTransformDirty(); }
 	//! assigns the 2d non-uniform scale of the node using a 2D vector
-	void		setScale(const ci::vec2& scale) { mScale = scale; mTransformIsDirty = true; }
+	void		setScale(const ci::vec2& scale) { mScale = scale; setTransformDirty(); }
 	//! assigns the 2d uniform scale of the node using two floats
-	void		setScale(const float w, const float h) { mScale = ci::vec2(w,h); mTransformIsDirty = true; }
+	void		setScale(const float w, const float h) { mScale = ci::vec2(w,h); setTransformDirty(); }
 	
 	//! returns the 2d rotation of the node as a mutable reference, expressed in radians
 	float&		rotation() { return mRotation; }
@@ -71,17 +73,24 @@ public:
 	//! assigns the 2d rotation of the node, expressed in radians by default
 	void		setRotation(const float radians, const bool use_degrees = false);
 	
+	//! assigns the positions of count nodes, reading the components from separate x and y arrays
+	static void	setPositions(Node2d* const* nodes, const float* const xy[2], size_t count);
+	//! assigns the scales of count nodes, reading the components from separate x and y arrays
+	static void	setScales(Node2d* const* nodes, const float* const xy[2], size_t count);
+	//! assigns the rotations of count nodes, expressed in radians
+	static void	setRotations(Node2d* const* nodes, const float* radians, size_t count);
+	
 	//! returns the 2d pivot point (or centroid) for the node as a mutable reference
 	ci::vec2&	getPivot() { return mPivot; }
 	//! returns the 2d pivot point (or centroid) for the node
 	ci::vec2	getPivot() const { return mPivot; }
 	//! assigns the 2d pivot point (or centroid) for the node using a 2D vector
-	void		setPivot(const ci::vec2& pt) { mPivot = pt; mTransformIsDirty = true; }
+	void		setPivot(const ci::vec2& pt) { mPivot = pt; setTransformDirty(); }
 	//! assigns the 2d pivot point (or centroid) for the node using two floats
-	void		setPivot(const float x, const float y) { mPivot = ci::vec2(x,y); mTransformIsDirty = true; }
+	void		setPivot(const float x, const float y) { mPivot = ci::vec2(x,y); setTransformDirty(); }
 	
 	//! assigns the 2d size of the node
-	virtual void		setSize(const ci::vec2& size) { mSize = size; };
+	virtual void		setSize(const ci::vec2& size) { mSize = size; setContentDirty(); };
 	//! returns the 2d size of the node (and it's contents --??)
 	virtual ci::vec2	getSize() const { return mSize; };
 	//! returns the rectangular boundary of the node (and it's contents --??)
@@ -90,7 +99,7 @@ public:
 	//! returns the 2d pivot (or centroid) of the node as percentage values computed based upon the node content size
 	virtual ci::vec2	getPivotPercentage() const;
 	//! assigns the 2d pivot point (or centroid) of the node as percentage values of the node's total size
-	virtual void		setPivotPercentage(const ci::vec2& pt) { mPivot = pt * mSize; mTransformIsDirty = true; }
+	virtual void		setPivotPercentage(const ci::vec2& pt) { mPivot = pt * mSize; setTransformDirty(); }
 	
 	
 	//! assigns the contents of an object to a bounded region defined in screen space
@@ -99,12 +108,60 @@ public:
 	//! returns the screen space boundary of the contens of the node
 	virtual ci::Rectf	getScreenRect(bool precise = true) const;
 	
+	//! returns the local boundary of what this node draws itself (children excluded)
+	virtual ci::Rectf	getContentBounds() const;
+	
+	//! returns wether a point in local coordinates lies on what this node draws itself, used for pointer input
+	virtual bool		hitTest(const ci::vec2& pt) const { return getContentBounds().contains(pt); }
+	
+	//! flags the contents of this node as changed, so that its region is reported as damaged and the change is journaled
+	void				setContentDirty() { mIsDamaged = true; if (mContext) journal(ChangeJournal::CHANGE_CONTENT); }
+	
+	//! returns the world space boundary of the contents as of the last call to deepCollectDamage
+	const ci::Rectf&	getDamageRect() const { return mDamageRect; }
+	
+	//! @inherit
+	virtual void setActive(bool active = true);
+	
 	//! @inherit
-	virtual void deepDraw();
+	virtual void deepDraw(RenderBackend& renderer);
+	
+	/**
+	 * Draws this node and its descendants, skipping the nodes whose contents do not
+	 * overlap any of the damaged regions. The caller is expected to clear (or clip to)
+	 * the damaged regions before drawing.
+	 *
+	 * @param renderer the render backend that receives the draw calls
+	 * @param damage the regions collected by deepCollectDamage
+	 */
+	virtual void deepDraw(RenderBackend& renderer, const DamageTracker& damage);
+	
+	/**
+	 * Performs a recursive tree traversal that reports the regions that changed since the
+	 * previous call. The previous and current world boundary of every node whose transform,
+	 * contents or visibility changed are added, along with the regions of removed or reordered
+	 * children. Must be called after deepTransform.
+	 *
+	 * @param damage the tracker that accumulates the damaged regions
+	 */
+	void deepCollectDamage(DamageTracker& damage);
 	
 	//! Performs a recursive tree traversal that computes the world transformation with respect to each node
 	virtual void deepTransform(const ci::mat3& world = ci::mat3(1));
 	
+	/**
+	 * Computes the world transformations like deepTransform, but blends the local position, scale
+	 * and rotation of each node between the state saved by deepSaveTransform and the current state.
+	 * Used to present a fixed rate simulation at the display rate (see FixedTimestep). The local
+	 * transformation returned by getTransform() keeps representing the current state. Since the
+	 * blended world transformations change without any setter being called, every node whose world
+	 * transformation changed records CHANGE_TRANSFORM in the journal of its context.
+	 *
+	 * @param world the world transformation of the parent node
+	 * @param alpha the blend factor, 0 for the previous state and 1 for the current state
+	 */
+	virtual void deepTransformInterpolated(const ci::mat3& world, float alpha);
+	
 	//! Stream operator provides support for convenient logging
 	friend std::ostream& operator<<(std::ostream& lhs, const Node2d& o) {
 		return lhs << "[Node2d name=" << o.getName() << ", position=" << o.mPosition << ", children=" << o.mChildren.size() << "]";
@@ -177,6 +234,7 @@ protected:
 	Node2d(const std::string& name = "", const bool active = true);
 
 	bool				mTransformIsDirty;	//!< flag used to manage transformation matrix cache
+	bool				mIsDamaged;			//!< flag set when the contents must be redrawn
 	ci::vec2			mPosition;			//!< the 2D or 3D position of the node
 	ci::vec2			mScale;				//!< the 2D or 3D scale applied to the node
 	ci::vec2			mPivot;				//!< the 2D or 3D location about which the node rotates
@@ -184,9 +242,33 @@ protected:
 	float				mRotation;			//!< the floating point rotation represented in radians
 	ci::mat3			mTransform;			//!< represents local transformation
 	ci::mat3			mWorldTransform;	//!< represents world transformation
+	ci::Rectf			mDamageRect;		//!< world space boundary of the contents when damage was last collected
+	std::vector<ci::Rectf>	mDetachedDamage;	//!< regions of removed or reordered children waiting to be reported
+	bool				mHasPreviousTransform;	//!< flag set once the previous simulation state was saved
+	ci::vec2			mPreviousPosition;	//!< the position as of the last call to deepSaveTransform
+	ci::vec2			mPreviousScale;		//!< the scale as of the last call to deepSaveTransform
+	float				mPreviousRotation;	//!< the rotation as of the last call to deepSaveTransform
 	
 	//! @inherit
 	virtual void transform();
+	
+	//! flags the local transformation for recalculation and records the change in the journal of the context
+	void setTransformDirty() { mTransformIsDirty = true; if (mContext) journal(ChangeJournal::CHANGE_TRANSFORM); }
+	
+	//! @inherit
+	virtual void saveTransform();
+	
+	//! @inherit
+	virtual void childRemoved(NodeRef node);
+	
+	//! @inherit
+	virtual void childReordered(NodeRef node);
+	
+	//! reports the damage of this node and its descendants, visible is false if an ancestor is inactive
+	void collectDamage(DamageTracker& damage, bool visible);
+	
+	//! appends the damage rects of this node and its descendants, optionally forgetting them
+	void gatherDamageRects(std::vector<ci::Rectf>& rects, bool reset);
 };
 		
 #pragma mark auxiliary functions
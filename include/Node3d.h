@@ -16,6 +16,7 @@
 #include "glm/gtc/matrix_transform.hpp"
 
 #include "NodeBase.h"
+#include "WorldMatrixBuffer.h"
 
 namespace scene {
 
@@ -50,45 +51,60 @@ public:
 	//! returns the 3d position of the node
 	ci::vec3	getPosition() const { return mPosition; }
 	//! assigns the 3d position of the node using a 3D vector
-	void		setPosition( const ci::vec3& pt ) { mPosition = pt; mTransformIsDirty = true; }
+	void		setPosition( const ci::vec3& pt ) { mPosition = pt; setTransformDirty(); }
 	//! assigns the 3d position of the node using three floats
-	void		setPosition( const float x, const float y, const float z ) { mPosition = ci::vec3(x,y,z); mTransformIsDirty = true; }
+	void		setPosition( const float x, const float y, const float z ) { mPosition = ci::vec3(x,y,z); setTransformDirty(); }
 	
 	//! returns the 3d scale of the node as a mutable reference
 	ci::vec3&	scale() { return mScale; }
 	//! returns the 3d scale of the node
 	ci::vec3	getScale() const { return mScale; }
 	//! assigns the 3d uniform scale of the node using a single float
-	void		setScale( const float scale ) { mScale = ci::vec3(scale, scale, scale); mTransformIsDirty = true; }
+	void		setScale( const float scale ) { mScale = ci::vec3(scale, scale, scale); setTransformDirty(); }
 	//! assigns the 3d scale of the node using a 3D vector
-	void		setScale( const ci::vec3& scale ) { mScale = scale; mTransformIsDirty = true; }
+	void		setScale( const ci::vec3& scale ) { mScale = scale; setTransformDirty(); }
 	//! assigns the 3d scale of the node using three floats
-	void		setScale( const float x, const float y, const float z ) { mScale = ci::vec3(x,y,z); mTransformIsDirty = true; }
+	void		setScale( const float x, const float y, const float z ) { mScale = ci::vec3(x,y,z); setTransformDirty(); }
 	
 	//! returns the rotation of the node represented as a mutable reference to a quaternion
 	ci::quat&	rotation() { return mRotation; }
 	//! returns the rotation of the node represented as a quaternion
 	ci::quat	getRotation() const { return mRotation; }
 	//! assigns the 3d rotation of the node using an axis angle representation
-	void		setRotation( float radians, const ci::vec3& axis = ci::vec3(0,0,1) ) { mRotation = glm::angleAxis(radians, axis); mTransformIsDirty = true; }
+	void		setRotation( float radians, const ci::vec3& axis = ci::vec3(0,0,1) ) { mRotation = glm::angleAxis(radians, axis); setTransformDirty(); }
 	//! assigns the 3d rotation of the node as a quaternion
-	void		setRotation( const ci::quat& rot ) { mRotation = rot; mTransformIsDirty = true; }
+	void		setRotation( const ci::quat& rot ) { mRotation = rot; setTransformDirty(); }
 	//! assigns the 3d rotation of the node using Euler angles
 	void		setRotation( float angle_x, float angle_y, float angle_z, bool use_degrees = false );
 	
+	//! assigns the positions of count nodes, reading the components from separate x, y and z arrays
+	static void	setPositions( Node3d* const* nodes, const float* const xyz[3], size_t count );
+	//! assigns the scales of count nodes, reading the components from separate x, y and z arrays
+	static void	setScales( Node3d* const* nodes, const float* const xyz[3], size_t count );
+	//! assigns the rotations of count nodes, reading the quaternions from separate x, y, z and w arrays
+	static void	setRotations( Node3d* const* nodes, const float* const xyzw[4], size_t count );
+	
 	//! returns the 3d pivot point of the node as a mutable reference
 	ci::vec3&	pivot() { return mPivot; }
 	//! returns the 3d pivot point of the node
 	ci::vec3	getPivot() const { return mPivot; }
 	//! assigns the 3d pivot point of the node using a 3D vector
-	void		setPivot( const ci::vec3& pt ) { mPivot = pt; mTransformIsDirty = true; }
+	void		setPivot( const ci::vec3& pt ) { mPivot = pt; setTransformDirty(); }
 	//! assigns the 3d pivot point of the node using three floats
-	void		setPivot( const float x, const float y, const float z ) { mPivot = ci::vec3(x,y,z); mTransformIsDirty = true; }
+	void		setPivot( const float x, const float y, const float z ) { mPivot = ci::vec3(x,y,z); setTransformDirty(); }
 	
 	//! returns the 3d anchor (centroid) of the node as percentage values computed based upon the node content size
 	virtual	ci::vec3	getPivotPercentage();
 	//! assigns a 3d anchor point (or centroid) of the node, expressed as a percentage of the node content size
-	virtual	void		setPivotPercentage(const ci::vec3& pt) { mPivot = pt * mSize; mTransformIsDirty = true; }
+	virtual	void		setPivotPercentage(const ci::vec3& pt) { mPivot = pt * mSize; setTransformDirty(); }
+	
+	//! assigns the 3d size of the node
+	virtual void		setSize(const ci::vec3& size) { mSize = size; setContentDirty(); }
+	//! returns the 3d size of the node
+	virtual ci::vec3	getSize() const { return mSize; }
+	
+	//! records in the journal of the context that the size or the type specific state of this node changed
+	void				setContentDirty() { if (mContext) journal(ChangeJournal::CHANGE_CONTENT); }
 	
 	//! returns the axis-aligned bounding box for the contents of the node
 	virtual ci::AxisAlignedBox getBounds() const;
@@ -120,8 +136,34 @@ public:
  	 */
 	virtual void deepTransform(const ci::mat4& world = ci::mat4(1));
 	
+	/**
+	 * Computes the world transformations like deepTransform and mirrors them into a matrix buffer.
+	 * Each node claims a slot the first time it is transformed with the buffer and keeps it until
+	 * the node is destroyed. Only the slots whose world transformation changed are written.
+	 *
+	 * @param world the world transformation of the parent node
+	 * @param buffer the buffer that receives the world transformations
+	 */
+	virtual void deepTransform(const ci::mat4& world, const WorldMatrixBufferRef& buffer);
+	
+	/**
+	 * Computes the world transformations like deepTransform, but blends the local position, scale
+	 * and rotation of each node between the state saved by deepSaveTransform and the current state.
+	 * Used to present a fixed rate simulation at the display rate (see FixedTimestep). The local
+	 * transformation returned by getTransform() keeps representing the current state. Since the
+	 * blended world transformations change without any setter being called, every node whose world
+	 * transformation changed records CHANGE_TRANSFORM in the journal of its context.
+	 *
+	 * @param world the world transformation of the parent node
+	 * @param alpha the blend factor, 0 for the previous state and 1 for the current state
+	 */
+	virtual void deepTransformInterpolated(const ci::mat4& world, float alpha);
+	
+	//! returns the slot of this node in its world matrix buffer, or WorldMatrixBuffer::INVALID_INDEX
+	uint32_t getMatrixIndex() const { return mMatrixIndex; }
+	
 	/** @inherit */
-	virtual void deepDraw();
+	virtual void deepDraw(RenderBackend& renderer);
 	
 	//! Stream operator provides support for convenient logging
 	friend std::ostream& operator<<(std::ostream& lhs, const Node3d& rhs) {
@@ -234,10 +276,23 @@ protected:
 	ci::quat			mRotation;			//!< the quaternion rotation applied to the node
 	ci::mat4			mTransform;			//!< represents local transformation
 	ci::mat4			mWorldTransform;	//!< represents world transformation
+	WorldMatrixBufferWeakRef	mMatrixBuffer;	//!< the buffer that mirrors the world transformation
+	uint32_t			mMatrixIndex;		//!< the slot of this node in mMatrixBuffer
+	bool				mMatrixIsStale;		//!< flag set when the world transformation changed without updating mMatrixBuffer
+	bool				mHasPreviousTransform;	//!< flag set once the previous simulation state was saved
+	ci::vec3			mPreviousPosition;	//!< the position as of the last call to deepSaveTransform
+	ci::vec3			mPreviousScale;		//!< the scale as of the last call to deepSaveTransform
+	ci::quat			mPreviousRotation;	//!< the rotation as of the last call to deepSaveTransform
 	
 	//! calculates the local transformation matrix using the current translation, scale, and rotation values.
 	virtual void transform();
 	
+	//! flags the local transformation for recalculation and records the change in the journal of the context
+	void setTransformDirty() { mTransformIsDirty = true; if (mContext) journal(ChangeJournal::CHANGE_TRANSFORM); }
+	
+	//! @inherit
+	virtual void saveTransform();
+	
 };
 		
 }
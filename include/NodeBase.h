@@ -9,10 +9,17 @@
 #include "cinder/app/App.h"
 #include "cinder/AxisAlignedBox.h"
 
+#include "ChangeJournal.h"
+#include "PointerEvent.h"
 #include "SceneObject.h"
+#include "WorkQueue.h"
 
 namespace scene {
 
+class RenderBackend;
+class SceneContext;
+struct SnapshotItem;
+
 class NodeBase;
 typedef std::shared_ptr<NodeBase> NodeRef;				//!< A shared pointer to a Node2d instance
 typedef std::shared_ptr<const NodeBase> NodeConstRef;	//!< A shared pointer to a constant Node2d instance
@@ -24,11 +31,21 @@ typedef std::deque<NodeRef> NodeDeque;					//!< A deque of shared pointers to No
  *
  * NodeBase abstract base class. It supports a hierarchical scene graph
  * system for coordinate transformations and rendering. Each concrete
- * node type can be parsed from an input XML node. Each node type 
- * can also be serialized to an XML node.
+ * node type that is registered with a SceneTypeRegistry can be saved
+ * to and restored from a binary scene file, or streamed to and from an
+ * XML document.
+ *
+ * @see scene::SceneWriter
+ * @see scene::XmlSceneWriter
  */
 class NodeBase : public scene::SceneObject {
 public:
+	//! Type that describes which data the update() function of a node may touch
+	typedef enum UpdateScope_t {
+		UPDATE_SERIAL = 0,	//!< update may touch anything, it runs in tree order on the calling thread
+		UPDATE_SUBTREE = 1	//!< update only touches this node and its descendants, it may run concurrently with disjoint subtrees
+	} UpdateScope;
+	
 	/**
 	 * Virtual destructor destroys children
 	 */
@@ -121,24 +138,64 @@ public:
 	void moveToBottom();
 
 	//! enables or disables visibility of this node (inactive nodes are not drawn and can not receive events, but they still receive updates)
-	virtual void setActive(bool active = true) { mIsActive = active; }
+	virtual void setActive(bool active = true);
 	
 	//! returns wether this node is active
 	virtual bool isActive() const { return mIsActive; }
 
+	//! enables or disables pointer input for this node, only interactive nodes can be hit by the EventDispatcher
+	void setInteractive(bool interactive = true) { if (interactive != mIsInteractive) { mIsInteractive = interactive; journal(ChangeJournal::CHANGE_INTERACTIVE); } }
+	
+	//! returns wether this node accepts pointer input
+	bool isInteractive() const { return mIsInteractive; }
+
 	//! calls the setup() function of this node and all its decendants
 	virtual void deepSetup();
 	//! calls the update() function of this node and all its decendants
 	virtual void deepUpdate(double elapsed);
-	//! calls the draw() function of this node and all its decendants
-	virtual void deepDraw() = 0;
+	//! stores the local transformation of this node and all its decendants as their previous simulation state
+	virtual void deepSaveTransform();
+	//! calls the draw() function of this node and all its decendants using the specified render backend
+	virtual void deepDraw(RenderBackend& renderer) = 0;
 
 	// base class has no impl for standard event loop
 	virtual void setup() { /* no-op */ }
 	virtual void update(double elapsed) { /* no-op */ }
-	virtual void draw() { /* no-op */ }
+	virtual void draw(RenderBackend& renderer) { /* no-op */ }
+	//! fills in what draw() would draw, so a render thread can draw the node from a SceneSnapshot; called on the simulation thread
+	virtual void snapshot(SnapshotItem& item) const { /* no-op */ }
 	virtual void addedToScene() { /* no-op */ }
 	virtual void removedFromScene() { /* no-op */ }
+	
+	//! handles pointer input routed by the EventDispatcher, returns true to consume the event and stop its delivery
+	virtual bool onPointerEvent(const PointerEvent& event) { return false; }
+	
+	//! declares the data touched by update(), nodes are serial unless they opt in to parallel updates
+	virtual UpdateScope getUpdateScope() const { return UPDATE_SERIAL; }
+	
+	/**
+	 * Enables or disables per-frame calls to update() from the SceneContext of this node.
+	 * Node types that override update() should enable it, typically in their constructor.
+	 * deepUpdate is not affected and still visits every node.
+	 */
+	void setUpdateEnabled(bool enabled = true);
+	
+	//! returns wether this node receives per-frame updates from its SceneContext
+	bool isUpdateEnabled() const { return mIsUpdateEnabled; }
+	
+	//! returns the context of the scene graph this node belongs to, or nullptr
+	SceneContext* getContext() const { return mContext; }
+	
+	/**
+	 * Submits expensive work to the WorkQueue of the context, so it runs within the per-frame
+	 * budget instead of immediately. The job is skipped if the node is destroyed before it runs.
+	 * Without a context there is no queue and the job runs immediately.
+	 *
+	 * @param job the work to perform
+	 * @param priority the urgency of the work
+	 * @return the id of the queued job, or WorkQueue::INVALID_JOB if the job already ran
+	 */
+	WorkQueue::JobId defer(const WorkQueue::Job& job, WorkQueue::Priority priority = WorkQueue::PRIORITY_NORMAL);
 		
 protected:
 	/**
@@ -151,8 +208,16 @@ protected:
 	NodeBase(const std::string& name = "", const bool active = true);
 	
 	bool			mIsActive;		//!< visibility flag when drawing the node
+	bool			mIsInteractive;	//!< flag set when the node accepts pointer input
 	NodeWeakRef		mParent;		//!< std::weak_ptr<class Node> parent
 	NodeDeque		mChildren;		//!< std::deque<std::shared_ptr<class Node> > children
+	SceneContext*	mContext;		//!< the context of the scene graph, owned by the application
+	
+	//! assigns the context to this node and all its descendants
+	void setContext(SceneContext* context);
+	
+	//! records changes of this node in the ChangeJournal of its context
+	void journal(uint32_t changes);
 
 	//! function that is called right before drawing this node
 	virtual void pre_draw() {}
@@ -160,9 +225,29 @@ protected:
 	//! function that is called right after drawing this node
 	virtual void post_draw() {}
 
+	//! function that stores the current local transformation as the previous simulation state
+	virtual void saveTransform() {}
+
+	//! function that is called after a child was detached from this node
+	virtual void childRemoved(NodeRef node) {}
+
+	//! function that is called after a child was moved within the draw order of this node
+	virtual void childReordered(NodeRef node) {}
+
 	//! required transform() function to compose the transformation matrix
 	virtual void transform() = 0;
 	
+private:
+	friend class SceneContext;
+	friend class ChangeJournal;
+	
+	static const uint32_t INVALID_UPDATE_INDEX = 0xffffffff;
+	static const uint32_t INVALID_JOURNAL_INDEX = 0xffffffff;
+	
+	bool			mIsUpdateEnabled;	//!< flag set when the node receives per-frame updates
+	uint32_t		mUpdateIndex;		//!< the position of the node in the update list of its context
+	uint32_t		mJournalIndex;		//!< the position of the node's record in the journal of its context
+	
 public:
 	/**
 	 * @brief Iterator type for the Node tree data structure
@@ -1,12 +1,13 @@
 #pragma once
 
-#include "cinder/app/AppBasic.h"
+#include "cinder/app/App.h"
 #include "cinder/AxisAlignedBox.h"
 #include "cinder/Color.h"
 #include "cinder/Camera.h"
 #include "cinder/Rect.h"
 #include "cinder/TriMesh.h"
 
+#include "CompactMesh.h"
 #include "Node3d.h"
 
 namespace scene {
@@ -18,7 +19,16 @@ typedef std::weak_ptr<NodeMesh> NodeMeshWeakRef;			//!< A weak pointer to a Node
 /**
  * @brief Node3d type that includes a TriMesh object
  *
+ * A mesh that is still being loaded (see MeshLoader) is represented by a placeholder
+ * bounding box, which getBounds() and getScreenRect() report until setMesh() swaps in
+ * the real mesh. Nothing is drawn in the meantime.
+ *
+ * The mesh can be kept as a CompactMesh instead (see compact()), which takes less than
+ * half of the memory and answers the bounds and picking queries without decoding.
+ *
  * @see scene::Node3d
+ * @see scene::MeshLoader
+ * @see scene::CompactMesh
  * @see ci::TriMesh
  */
 class NodeMesh : public scene::Node3d {
@@ -33,18 +43,51 @@ public:
 	virtual void update( double elapsed );
 	
 	/** @inherit */
-	virtual void draw();
+	virtual void draw(RenderBackend& renderer);
+	
+	/** @inherit */
+	virtual void snapshot(SnapshotItem& item) const;
 	
 	ci::CameraPersp mCamera;	// TEMPORARY
 	
 //	virtual void setScreenRect(const ci::Rectf& bounds, const float depth = 0.0);
-	virtual ci::Rectf getScreenRect(const ci::Matrix44f& MVP, const ci::Area& viewport, bool precise = true) const;
-	virtual ci::AxisAlignedBox3f getBounds() const;
-	virtual ci::AxisAlignedBox3f getMeshBounds() const;
+	virtual ci::Rectf getScreenRect(const ci::mat4& MVP, const ci::Area& viewport, bool precise = true) const;
+	virtual ci::AxisAlignedBox getBounds() const;
+	virtual ci::AxisAlignedBox getMeshBounds() const;
 	
 	inline void setMeshColor(const ci::ColorA& color) { mMeshColor = color; }
 	inline ci::ColorA getMeshColor() const { return mMeshColor; }
 	
+	//! returns the mesh, empty while it is loading or once it was compacted
+	const ci::TriMesh& getMesh() const { return mMesh; }
+	//! replaces the mesh and ends the loading state
+	void setMesh(const ci::TriMesh& mesh) { mMesh = mesh; mCompactMesh.reset(); meshChanged(); }
+	//! replaces the mesh without copying it and ends the loading state
+	void setMesh(ci::TriMesh&& mesh) { mMesh = std::move(mesh); mCompactMesh.reset(); meshChanged(); }
+	//! replaces the mesh by a compact one, which may be shared with other nodes, and ends the loading state
+	void setMesh(const CompactMeshRef& mesh) { mMesh = ci::TriMesh(); mCompactMesh = mesh; meshChanged(); }
+	
+	//! returns the compact mesh, or nullptr if the node keeps a TriMesh
+	const CompactMeshRef& getCompactMesh() const { return mCompactMesh; }
+	//! replaces the TriMesh by a CompactMesh and releases it, does nothing while loading
+	void compact();
+	
+	/**
+	 * Finds the nearest triangle of the mesh hit by a ray.
+	 *
+	 * @param ray the ray in the object space of the node
+	 * @param distance receives the ray parameter of the nearest hit, may be nullptr
+	 * @return true if a triangle was hit, always false while loading
+	 */
+	bool intersect(const ci::Ray& ray, float* distance = nullptr) const;
+	
+	//! enters the loading state, the bounding box (in object space) stands in for the mesh until setMesh() is called
+	void setPlaceholder(const ci::AxisAlignedBox& bounds) { mPlaceholder = bounds; mIsLoading = true; setContentDirty(); }
+	//! returns the bounding box that stands in for the mesh while it is loading
+	const ci::AxisAlignedBox& getPlaceholder() const { return mPlaceholder; }
+	//! returns true while the placeholder stands in for the mesh
+	bool isLoading() const { return mIsLoading; }
+	
 	virtual bool mouseMove( ci::app::MouseEvent event );
 	virtual bool mouseDown( ci::app::MouseEvent event );
 	virtual bool mouseDrag( ci::app::MouseEvent event );
@@ -56,12 +99,22 @@ public:
 	}
 	
 protected:
+	//! returns the bounding box of the mesh in object space, or the placeholder while loading
+	ci::AxisAlignedBox calcMeshBounds() const { return mIsLoading? mPlaceholder: mCompactMesh? mCompactMesh->getBounds(): mMesh.calcBoundingBox(); }
+	
+	//! ends the loading state after the mesh was replaced
+	void meshChanged() { mIsLoading = false; mSharedMesh.reset(); setContentDirty(); }
+	
 	bool			mIsDragged;
-	ci::Vec2f		mMouseOffset;
+	ci::vec2		mMouseOffset;
 	ci::Rectf		mScreenRect;	//!< The rect object that describes the node shape in screen space
 	ci::TriMesh		mMesh;			//!< The 3d triangle mesh object 
+	CompactMeshRef	mCompactMesh;	//!< Replaces mMesh once the node was compacted
 	ci::ColorA		mMeshColor;		//!< Color given to the mesh object
-	ci::Vec2f		mMousePos;		//!< Offset within the 3D object bounds
+	ci::vec2		mMousePos;		//!< Offset within the 3D object bounds
+	ci::AxisAlignedBox	mPlaceholder;	//!< Stands in for the mesh while it is loading
+	bool			mIsLoading;		//!< True until the loaded mesh was swapped in
+	mutable std::shared_ptr<const ci::TriMesh>	mSharedMesh;	//!< The copy of mMesh handed to snapshots, made on demand once per change
 };
 	
 }
@@ -29,26 +29,46 @@ public:
 	/** Cinder update method */
 	virtual void update( double elapsed );
 	/** Cinder draw method */
-	virtual void draw();
+	virtual void draw(RenderBackend& renderer);
+	/** @inherit */
+	virtual void snapshot(SnapshotItem& item) const;
 	
 //	virtual void		setScreenRect(const ci::Rectf& bounds, const float depth = 0.0);
 	virtual ci::Rectf	getScreenRect(bool precise = true) const;
 	virtual ci::Rectf	getBounds() const;
 	virtual ci::Rectf	getShapeBounds() const;
+	//! @inherit
+	virtual ci::Rectf	getContentBounds() const;
+	
+	//! @inherit
+	virtual bool		hitTest(const ci::vec2& pt) const { return mShape.contains(pt); }
+	
+	//! returns the shape that describes the node appearance
+	const ci::Shape2d&	getShape() const { return mShape; }
+	//! assigns the shape that describes the node appearance
+	virtual void		setShape(const ci::Shape2d& shape);
 	
 	virtual ci::Vec2f getAnchorPercentage();
 	
 	virtual ci::ColorA getFillColor(const ci::ColorA& color) { return mFillColor; }
-	virtual void setFillColor(const ci::ColorA& color) { mFillColor = color; }
+	virtual void setFillColor(const ci::ColorA& color) { if (color != mFillColor) { mFillColor = color; setContentDirty(); } }
 	
 	virtual ci::ColorA getStrokeColor() { return mStrokeColor; }
-	virtual void setStrokeColor(const ci::ColorA& color) { mStrokeColor = color; }
+	virtual void setStrokeColor(const ci::ColorA& color) { if (color != mStrokeColor) { mStrokeColor = color; setContentDirty(); } }
 	
 	virtual bool mouseMove( ci::app::MouseEvent event );
 	virtual bool mouseDown( ci::app::MouseEvent event );
 	virtual bool mouseDrag( ci::app::MouseEvent event );
 	virtual bool mouseUp( ci::app::MouseEvent event );
 	
+	//! highlights the shape under the pointer and drags it around, see EventDispatcher
+	virtual bool onPointerEvent(const PointerEvent& event);
+	
+	//! writes the colors and the contours of the shape
+	virtual void serialize(BinaryWriter& writer) const;
+	//! reads the colors and the contours of the shape
+	virtual bool deserialize(BinaryReader& reader);
+	
 	// stream logging support
 	friend std::ostream& operator<<(std::ostream& lhs, const NodeShape2d& rhs) {
 		return lhs << "[NodeShape2d name=" << rhs.mName << ", position=" << rhs.mPosition << ", children=" << rhs.mChildren.size() << "]";
@@ -63,6 +83,7 @@ protected:
 	ci::ColorA		mFillSelectedColor;		//!< Color given to the object's fill
 	ci::ColorA		mFillUnselectedColor;	//!< Color given to the object's fill
 	ci::ColorA		mStrokeColor;			//!< Color given to the object's stroke
+	mutable std::shared_ptr<const ci::Shape2d>	mSharedShape;	//!< The copy of mShape handed to snapshots, made on demand once per change
 };
 
 }
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "cinder/Vector.h"
+
+namespace scene {
+
+class NodeBase;
+
+/**
+ * @brief Pointer input delivered to nodes by the EventDispatcher
+ *
+ * The event travels along the ancestor path of the node that was hit: first from the
+ * root down to the parent of the target (capture phase), then to the target itself,
+ * then back up to the root (bubble phase). Delivery stops at the first node whose
+ * onPointerEvent returns true.
+ */
+struct PointerEvent {
+	//! Type that describes the kind of pointer input
+	typedef enum Type_t {
+		POINTER_MOVE = 0,	//!< the pointer moved without a pressed button
+		POINTER_DOWN = 1,	//!< a button was pressed
+		POINTER_DRAG = 2,	//!< the pointer moved with a pressed button
+		POINTER_UP = 3,		//!< a button was released
+		POINTER_ENTER = 4,	//!< the pointer moved onto the target, sent to the target only
+		POINTER_LEAVE = 5	//!< the pointer moved off the target, sent to the target only
+	} Type;
+
+	//! Type that describes where the receiving node lies on the path of the event
+	typedef enum Phase_t {
+		PHASE_CAPTURE = 0,	//!< the receiver is an ancestor, on the way down to the target
+		PHASE_TARGET = 1,	//!< the receiver is the target
+		PHASE_BUBBLE = 2	//!< the receiver is an ancestor, on the way back up from the target
+	} Phase;
+
+	PointerEvent(Type type = POINTER_MOVE, const ci::vec2& position = ci::vec2(0), int button = 0)
+	:	mType(type), mPhase(PHASE_TARGET), mPosition(position), mButton(button), mTarget(nullptr), mIsCaptured(false)
+	{
+	}
+
+	Type		mType;			//!< the kind of input
+	Phase		mPhase;			//!< the phase in which the receiver gets the event
+	ci::vec2	mPosition;		//!< the pointer position in world (screen) coordinates
+	int			mButton;		//!< the button that changed, application defined
+	NodeBase*	mTarget;		//!< the node that was hit, or that captured the pointer
+	bool		mIsCaptured;	//!< true if the event was routed to the capturing node without hit testing
+};
+
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <string>
+#include <iostream>
+#include <vector>
+#include <memory>
+
+#include "cinder/Color.h"
+#include "cinder/Matrix.h"
+#include "cinder/Shape2d.h"
+#include "cinder/TriMesh.h"
+
+namespace scene {
+
+class CompactMesh;
+class SceneSnapshot;
+class RenderBackend;
+typedef std::shared_ptr<RenderBackend> RenderBackendRef;			//!< A shared pointer to a RenderBackend instance
+typedef std::shared_ptr<const RenderBackend> RenderBackendConstRef;	//!< A shared pointer to a constant RenderBackend instance
+typedef std::weak_ptr<RenderBackend> RenderBackendWeakRef;			//!< A weak pointer to a RenderBackend instance
+
+/**
+ * @brief RenderBackend is the abstract interface targeted by the scene graph draw pass
+ *
+ * Nodes never talk to a graphics API directly. Instead NodeBase::deepDraw hands
+ * every node the backend for the current pass and nodes issue their commands
+ * against it. This keeps the draw traversal usable without a GPU context.
+ *
+ * Each node is drawn between a pushModelMatrix() and popModelMatrix() pair, which also
+ * scopes the color, so the colors set by a node never leak into the draw code of the
+ * app or of other nodes.
+ *
+ * @see scene::RenderBackendGl
+ * @see scene::RenderBackendNull
+ * @see scene::RenderBackendRecorder
+ */
+class RenderBackend {
+public:
+	virtual ~RenderBackend() {}
+
+	//! invoked once before the draw traversal of a frame
+	virtual void beginFrame() {}
+	//! invoked once after the draw traversal of a frame
+	virtual void endFrame() {}
+
+	//! clears the color (and depth) buffer of the render target
+	virtual void clear(const ci::ColorA& color) = 0;
+
+	//! saves the current model matrix and color and multiplies the matrix by the input transformation
+	virtual void pushModelMatrix(const ci::mat4& transform) = 0;
+	//! restores the model matrix and color saved by the last call to pushModelMatrix()
+	virtual void popModelMatrix() = 0;
+
+	//! assigns the color used by subsequent draw commands, until the enclosing popModelMatrix()
+	virtual void setColor(const ci::ColorA& color) = 0;
+
+	//! draws a triangle mesh using the current model matrix and color
+	virtual void drawMesh(const ci::TriMesh& mesh) = 0;
+	//! draws a quantized triangle mesh, the default decodes it and draws the TriMesh
+	virtual void drawMesh(const CompactMesh& mesh);
+	//! draws the outline of a 2d shape using the current model matrix and color
+	virtual void drawShape(const ci::Shape2d& shape) = 0;
+	//! draws a filled 2d shape using the current model matrix and color
+	virtual void drawSolidShape(const ci::Shape2d& shape) = 0;
+
+	//! draws the visible items of a snapshot with the commands above, so the render thread never touches the nodes
+	virtual void drawSnapshot(const SceneSnapshot& snapshot);
+
+	//! expands a 2d affine transformation into the 4x4 matrix accepted by pushModelMatrix()
+	static ci::mat4 toMat4(const ci::mat3& affine);
+
+protected:
+	RenderBackend() {}
+};
+
+/**
+ * @brief RenderBackend that discards every command
+ *
+ * Used to measure the CPU cost of the draw traversal in isolation.
+ */
+class RenderBackendNull : public RenderBackend {
+public:
+	//! creates RenderBackendNull instance wrapped by STL shared pointer
+	static std::shared_ptr<RenderBackendNull> create() { return std::shared_ptr<RenderBackendNull>( new RenderBackendNull() ); }
+
+	virtual void clear(const ci::ColorA& color) { /* no-op */ }
+	virtual void pushModelMatrix(const ci::mat4& transform) { /* no-op */ }
+	virtual void popModelMatrix() { /* no-op */ }
+	virtual void setColor(const ci::ColorA& color) { /* no-op */ }
+	virtual void drawMesh(const ci::TriMesh& mesh) { /* no-op */ }
+	virtual void drawMesh(const CompactMesh& mesh) { /* no-op */ }
+	virtual void drawShape(const ci::Shape2d& shape) { /* no-op */ }
+	virtual void drawSolidShape(const ci::Shape2d& shape) { /* no-op */ }
+
+protected:
+	RenderBackendNull() {}
+};
+
+/**
+ * @brief A single command captured by RenderBackendRecorder
+ *
+ * Resource pointers are only valid for as long as the node that issued the command.
+ */
+struct RenderCommand {
+	typedef enum Type_t {
+		BEGIN_FRAME, END_FRAME, CLEAR, PUSH_MODEL_MATRIX, POP_MODEL_MATRIX, SET_COLOR, DRAW_MESH, DRAW_COMPACT_MESH, DRAW_SHAPE, DRAW_SOLID_SHAPE
+	} Type;
+
+	RenderCommand() : mType(BEGIN_FRAME), mTransform(1), mColor(ci::ColorA::white()), mResource(nullptr) {}
+
+	Type			mType;			//!< the kind of command that was issued
+	ci::mat4		mTransform;		//!< the matrix of a PUSH_MODEL_MATRIX command
+	ci::ColorA		mColor;			//!< the color of a CLEAR or SET_COLOR command
+	const void*		mResource;		//!< the TriMesh, CompactMesh or Shape2d of a DRAW_* command, see mType
+};
+
+/**
+ * @brief RenderBackend that logs every command it receives
+ *
+ * The recorder also tracks the model matrix stack so that unbalanced
+ * push/pop pairs in the draw traversal can be detected headless.
+ */
+class RenderBackendRecorder : public RenderBackend {
+public:
+	//! creates RenderBackendRecorder instance wrapped by STL shared pointer
+	static std::shared_ptr<RenderBackendRecorder> create() { return std::shared_ptr<RenderBackendRecorder>( new RenderBackendRecorder() ); }
+
+	virtual void beginFrame();
+	virtual void endFrame();
+	virtual void clear(const ci::ColorA& color);
+	virtual void pushModelMatrix(const ci::mat4& transform);
+	virtual void popModelMatrix();
+	virtual void setColor(const ci::ColorA& color);
+	virtual void drawMesh(const ci::TriMesh& mesh);
+	virtual void drawMesh(const CompactMesh& mesh);
+	virtual void drawShape(const ci::Shape2d& shape);
+	virtual void drawSolidShape(const ci::Shape2d& shape);
+
+	//! returns all the commands recorded since the last call to clear()
+	const std::vector<RenderCommand>& getCommands() const { return mCommands; }
+
+	//! returns the number of recorded commands of a given type
+	size_t getCommandCount(RenderCommand::Type type) const;
+
+	//! returns the current depth of the model matrix stack
+	size_t getStackDepth() const { return mStackDepth; }
+
+	//! returns the deepest the model matrix stack has been since the last call to clear()
+	size_t getMaxStackDepth() const { return mMaxStackDepth; }
+
+	//! discards all recorded commands and resets the matrix stack bookkeeping
+	void clear();
+
+protected:
+	RenderBackendRecorder();
+
+	void record(RenderCommand::Type type, const void* resource = nullptr);
+
+	std::vector<RenderCommand>	mCommands;		//!< the log of recorded commands
+	size_t						mStackDepth;	//!< current depth of the model matrix stack
+	size_t						mMaxStackDepth;	//!< maximum depth of the model matrix stack
+};
+
+typedef std::shared_ptr<RenderBackendNull> RenderBackendNullRef;			//!< A shared pointer to a RenderBackendNull instance
+typedef std::shared_ptr<RenderBackendRecorder> RenderBackendRecorderRef;	//!< A shared pointer to a RenderBackendRecorder instance
+
+}
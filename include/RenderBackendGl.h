@@ -0,0 +1,92 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "cinder/Matrix.h"
+#include "cinder/gl/GlslProg.h"
+#include "cinder/gl/Vao.h"
+#include "cinder/gl/Vbo.h"
+
+#include "RenderBackend.h"
+
+namespace scene {
+
+class RenderBackendGl;
+typedef std::shared_ptr<RenderBackendGl> RenderBackendGlRef;	//!< A shared pointer to a RenderBackendGl instance
+
+/**
+ * @brief RenderBackend implementation that forwards all commands to cinder::gl
+ *
+ * Requires a current OpenGL context, so it is only usable from within a Cinder app.
+ *
+ * Compact meshes are uploaded the first time they are drawn and drawn from the buffers
+ * from then on. The buffers keep the vertices quantized, 16 bytes each instead of the 32
+ * of a decoded TriMesh: positions as unsigned shorts that the model matrix maps back into
+ * object space, normals as normalized bytes and texture coordinates as half floats, which
+ * the vertex fetch converts without any shader support. Like gl::draw(), drawing needs a
+ * bound GLSL program. Buffers of meshes that were not drawn for a number of frames are
+ * released by endFrame(), so the app has to call beginFrame() and endFrame().
+ *
+ * popModelMatrix() restores the gl::color() that was current at the matching
+ * pushModelMatrix(), just like the nodes used to save the color state around their draw code.
+ *
+ * @see scene::RenderBackend
+ */
+class RenderBackendGl : public RenderBackend {
+public:
+	//! creates RenderBackendGl instance wrapped by STL shared pointer
+	static RenderBackendGlRef create();
+
+	virtual void endFrame();
+	virtual void clear(const ci::ColorA& color);
+	virtual void pushModelMatrix(const ci::mat4& transform);
+	virtual void popModelMatrix();
+	virtual void setColor(const ci::ColorA& color);
+	virtual void drawMesh(const ci::TriMesh& mesh);
+	virtual void drawMesh(const CompactMesh& mesh);
+	virtual void drawShape(const ci::Shape2d& shape);
+	virtual void drawSolidShape(const ci::Shape2d& shape);
+
+	//! returns the number of compact meshes with a vertex buffer
+	size_t getCachedMeshCount() const { return mMeshCache.size(); }
+
+protected:
+	//! The layout of the vertices of a compact mesh on the GPU
+	struct CompactVertex {
+		uint16_t	mPosition[4];	//!< the quantized position, the last component pads to 4 byte alignment
+		int8_t		mNormal[4];		//!< the normal scaled by the quantization steps as normalized bytes, padded likewise
+		uint16_t	mTexCoord[2];	//!< the texture coordinates as half floats
+	};
+
+	//! A compact mesh uploaded to the GPU
+	struct CachedMesh {
+		ci::gl::VboRef	mVertices;		//!< the CompactVertex buffer
+		ci::gl::VboRef	mIndices;		//!< the index buffer
+		ci::gl::VaoRef	mVao;			//!< the attribute bindings for mProgram
+		GLuint			mProgram;		//!< the handle of the GLSL program mVao was set up for
+		GLenum			mIndexType;		//!< GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+		GLsizei			mIndexCount;	//!< the number of indices
+		bool			mHasNormals;
+		bool			mHasTexCoords;
+		ci::mat4		mDecode;		//!< maps the quantized positions into object space
+		uint32_t		mLastFrame;		//!< the frame the mesh was last drawn in
+	};
+
+	//! creates the buffers of a compact mesh
+	static void upload(const CompactMesh& mesh, CachedMesh& cached);
+	//! binds the attributes of an uploaded mesh to the inputs of a GLSL program
+	static void bindAttributes(CachedMesh& cached, const ci::gl::GlslProg& glsl);
+
+	//! the number of frames the buffer of a mesh is kept without being drawn
+	static const uint32_t MAX_UNUSED_FRAMES = 120;
+
+	RenderBackendGl() : mFrame(0) {}
+
+	std::vector<ci::ColorA>						mColorStack;	//!< the colors saved by pushModelMatrix()
+
+	std::unordered_map<uint64_t, CachedMesh>	mMeshCache;	//!< the buffers of the compact meshes, by the id of the mesh
+	uint32_t									mFrame;		//!< the number of frames ended so far
+};
+
+}
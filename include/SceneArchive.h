@@ -0,0 +1,141 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "SceneFormat.h"
+
+namespace scene {
+
+class SceneArchive;
+typedef std::shared_ptr<SceneArchive> SceneArchiveRef;	//!< A shared pointer to a SceneArchive instance
+
+/**
+ * @brief Lazily materialized view of a binary scene file
+ *
+ * The archive maps the file into memory and reads the node table in place; nodes are only
+ * created once they are needed. getRoot() creates the root and every node that is reachable
+ * through active nodes. An inactive node is created without its descendants ("collapsed")
+ * and expanded when it is activated (see sync), or when one of its descendants is asked for
+ * with getNode() or findNode(). Nodes that were not created yet remain addressable by their
+ * index in the node table and by name.
+ *
+ * The archive holds the root, and weak references to the other nodes it created, which
+ * are owned by their parents. Expanding a node appends the children from the file after
+ * any children that were added to it in the meantime. A node that was destroyed is not
+ * created again.
+ *
+ * Nodes are created on the calling thread, which must own the scene graph.
+ *
+ * @see scene::SceneWriter
+ */
+class SceneArchive {
+public:
+	static const uint32_t INVALID_INDEX = 0xffffffff;
+
+	/**
+	 * Maps a scene file into memory and validates its node table.
+	 *
+	 * @param path the path of the file
+	 * @param registry the factories of the node types, must outlive the archive
+	 * @return the archive, or nullptr if the file can not be mapped or is malformed
+	 */
+	static SceneArchiveRef open(const std::string& path, const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault());
+
+	//! validates the contents of a scene file held in memory and takes them over, returns nullptr if they are malformed
+	static SceneArchiveRef create(std::vector<uint8_t> buffer, const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault());
+
+	//! unmaps the file, the nodes that were created stay valid
+	~SceneArchive();
+
+	//! returns the number of nodes in the file
+	uint32_t getNodeCount() const { return mHeader.mNodeCount; }
+
+	//! returns the record of a node in the file, the index must be less than getNodeCount()
+	const SceneNodeRecord& getRecord(uint32_t index) const { return *reinterpret_cast<const SceneNodeRecord*>(mData + mHeader.mNodeOffset + size_t(index) * mHeader.mRecordSize); }
+
+	//! returns the name of a node in the file, the index must be less than getNodeCount()
+	std::string getName(uint32_t index) const;
+
+	//! returns the index of the first node with a name, or INVALID_INDEX, without creating any node
+	uint32_t findIndex(const std::string& name) const;
+
+	//! creates the root and the nodes reachable through active nodes on first use, returns the root
+	NodeRef getRoot();
+
+	//! returns the node at an index, creating it and its ancestors if needed, or nullptr if it was destroyed
+	NodeRef getNode(uint32_t index);
+
+	//! returns the first node with a name, creating it if needed, or nullptr
+	NodeRef findNode(const std::string& name);
+
+	/**
+	 * Creates the descendants of a collapsed node, down to the inactive nodes beneath it.
+	 *
+	 * @param index the index of the node
+	 * @return false if the node was not created yet or was destroyed
+	 */
+	bool expand(uint32_t index);
+
+	/**
+	 * Expands the collapsed nodes that were activated since the last call, see NodeBase::setActive.
+	 * Call it once per frame, at a point where nothing traverses the scene graph.
+	 *
+	 * @return the number of nodes that were expanded
+	 */
+	size_t sync();
+
+	//! returns wether the node at an index was created
+	bool isMaterialized(uint32_t index) const { return mStates[index] != STATE_UNLOADED; }
+
+	//! returns wether the node at an index was created without its descendants
+	bool isCollapsed(uint32_t index) const { return mStates[index] == STATE_COLLAPSED; }
+
+	//! returns the number of nodes that were created
+	size_t getMaterializedCount() const { return mMaterializedCount; }
+
+protected:
+	//! Type that describes how far a node of the file was created
+	typedef enum State_t {
+		STATE_UNLOADED = 0,		//!< the node was not created
+		STATE_COLLAPSED = 1,	//!< the node was created without its descendants
+		STATE_EXPANDED = 2,		//!< the node and the descendants reachable through active nodes were created
+		STATE_FAILED = 3		//!< the payload of the node was rejected, it is never created
+	} State;
+
+	SceneArchive(const SceneTypeRegistry& registry);
+
+	//! validates the header and the node table of the mapped data
+	bool validate();
+
+	//! creates the node at an index and attaches it to its parent, if any
+	NodeRef materialize(uint32_t index, NodeBase* parent);
+
+	//! creates the descendants of an expanded node, skipping those beneath collapsed nodes
+	void materializeDescendants(uint32_t index);
+
+	//! builds the sorted hashes of the names on first use
+	void buildNameIndex() const;
+
+	//! releases the mapping of the file
+	void unmap();
+
+	const SceneTypeRegistry&	mRegistry;			//!< the factories of the node types
+	const uint8_t*				mData;				//!< the contents of the file
+	size_t						mSize;				//!< the size of the contents in bytes
+	std::vector<uint8_t>		mBuffer;			//!< the contents when they are held in memory instead of mapped
+	bool						mIsMapped;			//!< flag set when mData is a mapping of a file
+	SceneFileHeader				mHeader;			//!< the header of the file
+
+	NodeRef						mRoot;				//!< the root, once it was created
+	std::vector<NodeWeakRef>	mNodes;				//!< the created nodes, indexed like the records
+	std::vector<uint8_t>		mStates;			//!< the State of every node
+	std::vector<uint32_t>		mCollapsed;			//!< the indices of the collapsed nodes, checked by sync
+	size_t						mMaterializedCount;	//!< the number of nodes that were created
+
+	mutable std::vector<std::pair<uint64_t, uint32_t>>	mNameIndex;	//!< the hash of every name and its node index, sorted
+};
+
+}
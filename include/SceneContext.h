@@ -0,0 +1,98 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "ChangeJournal.h"
+#include "MutationQueue.h"
+#include "NodeBase.h"
+#include "WorkQueue.h"
+
+namespace scene {
+
+class SceneContext;
+typedef std::shared_ptr<SceneContext> SceneContextRef;	//!< A shared pointer to a SceneContext instance
+
+/**
+ * @brief Scene-wide state shared by all nodes of one scene graph
+ *
+ * Assigning a root to the context propagates the context to every node of the tree,
+ * and nodes that are added or removed later inherit or lose it automatically.
+ *
+ * The context keeps a flat list of the nodes that enabled per-frame updates (see
+ * NodeBase::setUpdateEnabled), so the frame loop only visits those instead of the
+ * whole tree. Registration and removal are constant time. Nodes are updated in the
+ * order in which they registered, not in tree order.
+ *
+ * The context also owns the WorkQueue that receives the jobs deferred by its nodes
+ * (see NodeBase::defer). The frame loop drains it once per frame, typically after
+ * update().
+ *
+ * Structural, transformation and activation changes of the nodes are recorded in a
+ * ChangeJournal once it is enabled, see getJournal().
+ *
+ * Structural edits that must not happen immediately, because a traversal is running
+ * or because they come from another thread, are queued in the MutationQueue (see
+ * getMutations) and applied by sync(). update() syncs before and after updating the
+ * nodes; the frame loop may add further sync points.
+ */
+class SceneContext {
+public:
+	//! creates SceneContext instance wrapped by STL shared pointer
+	static SceneContextRef create() { return SceneContextRef( new SceneContext() ); }
+
+	SceneContext();
+
+	//! detaches the root, so that no node refers to the context anymore
+	virtual ~SceneContext();
+
+	//! assigns the root of the scene graph, the previous root (if any) is detached
+	void setRoot(const NodeRef& root);
+
+	//! returns the root of the scene graph
+	const NodeRef& getRoot() const { return mRoot; }
+
+	//! applies the queued structural edits, then calls the update() function of every node that enabled updates and applies the edits they queued
+	void update(double elapsed);
+
+	//! applies the queued structural edits, must be called from the thread that owns the scene graph while nothing traverses it
+	size_t sync() { return mMutations.apply(); }
+
+	//! returns the queue of structural edits, edits may be queued from any thread
+	MutationQueue& getMutations() { return mMutations; }
+
+	//! returns the number of nodes that enabled updates
+	size_t getUpdateCount() const { return mUpdateList.size() - mHoleCount; }
+	
+	//! returns the queue of deferred jobs
+	WorkQueue& getWorkQueue() { return mWorkQueue; }
+	//! returns the queue of deferred jobs
+	const WorkQueue& getWorkQueue() const { return mWorkQueue; }
+	
+	//! returns the journal of node changes
+	ChangeJournal& getJournal() { return mJournal; }
+	//! returns the journal of node changes
+	const ChangeJournal& getJournal() const { return mJournal; }
+
+protected:
+	friend class NodeBase;
+
+	//! adds a node to the update list
+	void registerUpdate(NodeBase& node);
+
+	//! removes a node from the update list
+	void unregisterUpdate(NodeBase& node);
+
+	//! removes the holes left by nodes that unregistered during update()
+	void compact();
+
+	NodeRef					mRoot;			//!< the root of the scene graph
+	std::vector<NodeBase*>	mUpdateList;	//!< the nodes that enabled updates
+	size_t					mHoleCount;		//!< the number of null entries in mUpdateList
+	bool					mIsUpdating;	//!< true while update() iterates mUpdateList
+	WorkQueue				mWorkQueue;		//!< the jobs deferred by the nodes
+	ChangeJournal			mJournal;		//!< the changes made to the nodes this frame
+	MutationQueue			mMutations;		//!< the structural edits waiting for the next sync
+};
+
+}
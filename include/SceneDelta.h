@@ -0,0 +1,245 @@
+#pragma once
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "SceneContext.h"
+#include "SceneFormat.h"
+
+namespace scene {
+
+/**
+ * @brief Header of a scene delta
+ *
+ * A delta is followed by mEntryCount entries, one per changed node, each starting with the
+ * id of the node on the encoding side and its DeltaBits. The sections selected by the bits
+ * follow in the order of the bits:
+ *
+ *   DELTA_CREATE     uint32 type id, string name
+ *   DELTA_FLAGS      uint8 SceneNodeRecord::Flag bits
+ *   DELTA_TRANSFORM  uint8 dimensions (2, 3 or 0), then position, rotation, scale and pivot
+ *   DELTA_CONTENT    uint8 dimensions, size, uint32 payload size, payload
+ *   DELTA_CHILDREN   uint32 count, the ids of all children in drawing order
+ *
+ * Vectors are stored as int32 multiples of mStep. 2d rotations are int32 multiples of
+ * 2 pi / 65536; 3d rotations use the "smallest three" encoding in 32 bits: the index of the
+ * largest quaternion component and the other three components at 10 bits each.
+ */
+struct SceneDeltaHeader {
+	static const uint32_t MAGIC = 0x444e4353;	//!< "SCND"
+	static const uint16_t VERSION = 1;			//!< the version of the format written by SceneDeltaEncoder
+	static const uint64_t NO_ROOT = 0xffffffffffffffffull;	//!< the root id of a scene without root
+
+	//! Type that describes the sections of an entry
+	typedef enum DeltaBits_t {
+		DELTA_CREATE = 1 << 0,		//!< the node entered the scene, all other sections but DELTA_REMOVE follow
+		DELTA_FLAGS = 1 << 1,		//!< the node was activated, deactivated or toggled pointer input
+		DELTA_TRANSFORM = 1 << 2,	//!< the local transformation changed
+		DELTA_CONTENT = 1 << 3,		//!< the size or the type specific state changed
+		DELTA_CHILDREN = 1 << 4,	//!< children were added, removed or reordered
+		DELTA_REMOVE = 1 << 5		//!< the node left the scene, no section follows
+	} DeltaBits;
+
+	uint32_t	mMagic;			//!< MAGIC
+	uint16_t	mVersion;		//!< the version of the format
+	uint16_t	mReserved;		//!< 0
+	uint32_t	mFromVersion;	//!< the scene version the delta applies to, 0 for an empty scene
+	uint32_t	mToVersion;		//!< the scene version after the delta was applied
+	uint64_t	mRootId;		//!< the id of the root, or NO_ROOT
+	float		mStep;			//!< the quantization step of positions, scales, pivots and sizes
+	uint32_t	mEntryCount;	//!< the number of entries
+};
+
+/**
+ * @brief Encodes the changes made to a scene since a version
+ *
+ * The encoder reads the ChangeJournal of a SceneContext once per frame (see capture) and
+ * remembers, for every node, the version at which each part of its state last changed.
+ * encode() then writes the current state of exactly those parts that changed after a given
+ * version, so each replica may be at its own version and a delta from version 0 is a full
+ * snapshot. Nodes are kept in the order of their last change, so encoding visits only
+ * the nodes that changed, not the whole scene.
+ *
+ * Removed nodes are remembered so replicas can be told about them; forget() drops them
+ * once every replica moved past their removal.
+ *
+ * The encoder enables the journal of the context and must be destroyed before the
+ * context. It runs on the thread that owns the scene graph.
+ *
+ * @see scene::SceneDeltaApplier
+ */
+class SceneDeltaEncoder {
+public:
+	/**
+	 * Starts tracking a scene, the current state of the scene becomes version 1.
+	 *
+	 * @param context the context whose journal is read, must outlive the encoder
+	 * @param registry the ids of the node types, must outlive the encoder
+	 */
+	SceneDeltaEncoder(SceneContext& context, const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault());
+
+	/**
+	 * Reads the journal of the context, call it once per frame before the journal is cleared.
+	 *
+	 * @return the version of the scene, which only advances if something changed
+	 */
+	uint32_t capture();
+
+	//! returns the current version of the scene
+	uint32_t getVersion() const { return mVersion; }
+
+	/**
+	 * Writes the changes made after a version, up to the last capture.
+	 *
+	 * @param since the version of the replica, 0 for a full snapshot
+	 * @param buffer receives the delta, replacing what it held
+	 * @return false if the version is newer than the scene or was forgotten, or a changed node has an unregistered type
+	 */
+	bool encode(uint32_t since, std::vector<uint8_t>& buffer);
+
+	//! drops the removed nodes that every replica at or past a version knows about, linear in the number of nodes that did not change since
+	void forget(uint32_t version);
+
+	//! sets the quantization step of positions, scales, pivots and sizes for the deltas encoded afterwards
+	void setStep(float step) { mStep = step; }
+	//! returns the quantization step of positions, scales, pivots and sizes
+	float getStep() const { return mStep; }
+
+	//! returns the number of nodes being tracked, including the removed nodes that were not forgotten
+	size_t getTrackedCount() const { return mIndex.size(); }
+
+protected:
+	static const uint32_t INVALID_SLOT = 0xffffffff;
+
+	//! The state of a node as far as the encoder tracks it
+	struct Tracked {
+		NodeWeakRef	mNode;			//!< the node, expired once it left the scene
+		uint64_t	mId;			//!< the id of the node
+		uint32_t	mCreated;		//!< the version at which the node entered the scene
+		uint32_t	mFlags;			//!< the version at which the flags last changed
+		uint32_t	mTransform;		//!< the version at which the transformation last changed
+		uint32_t	mContent;		//!< the version at which the contents last changed
+		uint32_t	mChildren;		//!< the version at which the children last changed
+		uint32_t	mRemoved;		//!< the version at which the node left the scene, or 0
+		uint32_t	mLatest;		//!< the latest of the versions above
+		uint32_t	mPrev;			//!< the slot of the node that changed before this one
+		uint32_t	mNext;			//!< the slot of the node that changed after this one
+	};
+
+	//! starts or restarts tracking a node as created at the current version
+	void track(NodeBase& node);
+
+	//! returns the slot of a node, or INVALID_SLOT
+	uint32_t find(uint64_t id) const;
+
+	//! moves a slot to the end of the change order, marking it as changed at the current version
+	void touch(uint32_t slot);
+
+	//! removes a slot from the change order
+	void unlink(uint32_t slot);
+
+	//! writes the entry of a node that is in the scene
+	bool writeEntry(const Tracked& tracked, const NodeBase& node, uint32_t since, BinaryWriter& writer);
+
+	SceneContext&				mContext;	//!< the context whose journal is read
+	const SceneTypeRegistry&	mRegistry;	//!< the ids of the node types
+	uint32_t					mVersion;	//!< the current version
+	uint32_t					mForgotten;	//!< the newest version passed to forget()
+	uint64_t					mRootId;	//!< the id of the root as of the last capture
+	float						mStep;		//!< the quantization step
+
+	std::vector<Tracked>					mSlots;		//!< the tracked nodes
+	std::vector<uint32_t>					mFree;		//!< the slots of forgotten nodes
+	std::unordered_map<uint64_t, uint32_t>	mIndex;		//!< the slot of every tracked node by id
+	uint32_t								mHead;		//!< the slot that changed first
+	uint32_t								mTail;		//!< the slot that changed last
+	std::vector<uint32_t>					mChanged;	//!< the slots written by encode()
+	std::vector<uint8_t>					mPayload;	//!< the payload of the node being written
+};
+
+/**
+ * @brief Applies deltas written by a SceneDeltaEncoder to a replica of the scene
+ *
+ * The replica starts empty at version 0 and accepts any delta encoded since a version it
+ * reached, so deltas may be skipped as long as the next one starts early enough. Nodes
+ * are created through the SceneTypeRegistry and remembered by their id on the encoding
+ * side (see findNode). The replica may be attached to a SceneContext of its own.
+ *
+ * A delta is validated before anything is changed; malformed deltas, unknown types and
+ * references to nodes the replica does not know leave the replica untouched. A payload
+ * rejected by SceneObject::deserialize is only detected while the delta is applied, which
+ * leaves the replica partially updated: it must then be rebuilt from a full snapshot.
+ *
+ * @see scene::SceneDeltaEncoder
+ */
+class SceneDeltaApplier {
+public:
+	SceneDeltaApplier(const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault());
+
+	/**
+	 * Applies a delta to the replica.
+	 *
+	 * @param data the delta
+	 * @param size the size of the delta in bytes
+	 * @return false if the delta is malformed, starts after the version of the replica or was rejected
+	 */
+	bool apply(const uint8_t* data, size_t size);
+
+	//! applies a delta to the replica, see above
+	bool apply(const std::vector<uint8_t>& buffer) { return apply(buffer.data(), buffer.size()); }
+
+	//! returns the version of the scene the replica reflects
+	uint32_t getVersion() const { return mVersion; }
+
+	//! returns the root of the replica, or nullptr
+	const NodeRef& getRoot() const { return mRoot; }
+
+	//! returns the replica of the node with an id on the encoding side, or nullptr
+	NodeRef findNode(uint64_t id) const;
+
+	//! returns the number of nodes in the replica
+	size_t getNodeCount() const { return mNodes.size(); }
+
+	//! forgets the replica, the next delta must be a full snapshot
+	void reset();
+
+protected:
+	//! An entry of a delta, decoded but not applied yet
+	struct Entry {
+		uint64_t		mId;			//!< the id of the node
+		uint32_t		mBits;			//!< the DeltaBits of the entry
+		NodeRef			mNode;			//!< the node the entry applies to, once the delta was validated
+		uint32_t		mType;			//!< the type id, for DELTA_CREATE
+		const uint8_t*	mName;			//!< the name, for DELTA_CREATE
+		uint32_t		mNameSize;		//!< the size of the name in bytes
+		uint32_t		mDimensions;	//!< the dimensions of the transformation and contents
+		SceneNodeRecord	mRecord;		//!< the decoded flags, transformation and size
+		const uint8_t*	mPayload;		//!< the payload, for DELTA_CONTENT
+		uint32_t		mPayloadSize;	//!< the size of the payload in bytes
+		const uint8_t*	mChildren;		//!< the unaligned ids of the children, for DELTA_CHILDREN
+		uint32_t		mChildCount;	//!< the number of children
+	};
+
+	//! decodes and validates an entry
+	bool readEntry(BinaryReader& reader, float step, Entry& entry);
+
+	//! returns wether a node is known or created by the delta being applied
+	bool isKnown(uint64_t id) const { return mNodes.count(id) || mCreated.count(id); }
+
+	//! applies the flags, transformation and contents of an entry to its node
+	bool applyEntry(const Entry& entry, NodeBase& node);
+
+	//! replaces the children of a node by those of an entry
+	bool applyChildren(const Entry& entry, NodeBase& parent);
+
+	const SceneTypeRegistry&				mRegistry;	//!< the factories of the node types
+	uint32_t								mVersion;	//!< the version of the replica
+	NodeRef									mRoot;		//!< the root of the replica
+	std::unordered_map<uint64_t, NodeRef>	mNodes;		//!< the nodes of the replica by their id on the encoding side
+	std::unordered_set<uint64_t>			mCreated;	//!< the ids created by the delta being applied
+	std::vector<Entry>						mEntries;	//!< the entries of the delta being applied
+};
+
+}
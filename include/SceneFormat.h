@@ -0,0 +1,238 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "BinaryStream.hpp"
+#include "NodeBase.h"
+#include "SceneTypeRegistry.h"
+#include "ThreadPool.h"
+
+namespace scene {
+
+/**
+ * @brief Header of a binary scene file
+ *
+ * A scene file holds the header, the node table, the chunk index, the string table and the
+ * payload block, at the offsets given by the header. All values are little endian. Readers
+ * reject files of a newer version; records of a newer version may be larger than
+ * SceneNodeRecord, so the node table is walked using mRecordSize.
+ *
+ * Files of version 1 end the header before mChunkOffset and have no chunk index.
+ */
+struct SceneFileHeader {
+	static const uint32_t MAGIC = 0x424e4353;	//!< "SCNB"
+	static const uint16_t VERSION = 2;			//!< the version written by SceneWriter
+
+	uint32_t	mMagic;			//!< MAGIC, also rejects files of the wrong byte order
+	uint16_t	mVersion;		//!< the version of the format
+	uint16_t	mRecordSize;	//!< the size of a node record in bytes
+	uint32_t	mNodeCount;		//!< the number of node records, at least 1
+	uint32_t	mNodeOffset;	//!< the offset of the node table from the start of the file
+	uint32_t	mStringOffset;	//!< the offset of the string table
+	uint32_t	mStringSize;	//!< the size of the string table in bytes
+	uint32_t	mPayloadOffset;	//!< the offset of the payload block
+	uint32_t	mPayloadSize;	//!< the size of the payload block in bytes
+	uint32_t	mChunkOffset;	//!< the offset of the chunk index
+	uint32_t	mChunkCount;	//!< the number of SceneChunkRecords, 0 if the file is not split into chunks
+};
+
+/**
+ * @brief A node as stored in the node table of a binary scene file
+ *
+ * Nodes are stored in depth-first order, so a parent always precedes its children, the
+ * children of a node keep their drawing order, and the descendants of a node are the
+ * mSubtreeSize records that follow it. The first record is the root.
+ *
+ * 2d nodes store their rotation angle in mRotation[0] and leave the z components at 0.
+ */
+struct SceneNodeRecord {
+	static const uint32_t NO_PARENT = 0xffffffff;
+
+	//! Type that describes the state flags of a node
+	typedef enum Flag_t {
+		FLAG_ACTIVE = 1 << 0,		//!< the node is active (see NodeBase::setActive)
+		FLAG_INTERACTIVE = 1 << 1	//!< the node accepts pointer input (see NodeBase::setInteractive)
+	} Flag;
+
+	uint32_t	mParent;		//!< the index of the parent record, or NO_PARENT for the root
+	uint32_t	mSubtreeSize;	//!< the number of descendants
+	uint32_t	mType;			//!< the id of the node type (see SceneTypeRegistry)
+	uint32_t	mFlags;			//!< the Flag bits
+	uint32_t	mNameOffset;	//!< the offset of the name in the string table
+	uint32_t	mNameSize;		//!< the length of the name in bytes
+	uint32_t	mPayloadOffset;	//!< the offset of the serialized state in the payload block
+	uint32_t	mPayloadSize;	//!< the size of the serialized state in bytes
+	float		mPosition[3];	//!< the local position
+	float		mRotation[4];	//!< the local rotation as a quaternion (x, y, z, w) or as an angle
+	float		mScale[3];		//!< the local scale
+	float		mPivot[3];		//!< the pivot point
+	float		mSize[3];		//!< the size of the contents
+};
+
+/**
+ * @brief An entry of the chunk index of a binary scene file
+ *
+ * A chunk is a run of consecutive node records that is decoded on its own: the names and
+ * payloads of its nodes lie within the ranges of the string table and payload block given
+ * by the entry. The chunks follow each other and together hold every record.
+ *
+ * The nodes of a chunk whose parent precedes the chunk are the roots of the subtrees it
+ * holds. A reader builds the subtrees of all chunks in parallel and then attaches their
+ * roots to their parents, in the order of the records.
+ */
+struct SceneChunkRecord {
+	uint32_t	mFirstNode;		//!< the index of the first record of the chunk
+	uint32_t	mNodeCount;		//!< the number of records, at least 1
+	uint32_t	mRootCount;		//!< the number of records whose parent precedes the chunk, the root of the scene included
+	uint32_t	mReserved;		//!< 0
+	uint32_t	mStringOffset;	//!< the offset of the names of the chunk in the string table
+	uint32_t	mStringSize;	//!< the size of the names of the chunk in bytes
+	uint32_t	mPayloadOffset;	//!< the offset of the payloads of the chunk in the payload block
+	uint32_t	mPayloadSize;	//!< the size of the payloads of the chunk in bytes
+};
+
+/**
+ * @brief Writes scene graphs to the binary scene format
+ *
+ * The transformation, name and flags of every node go into a fixed size record, whatever
+ * the type of the node. Type specific state is written by SceneObject::serialize into the
+ * payload block. The writer keeps its buffers between calls, so saving a scene repeatedly
+ * does not allocate once the buffers have grown.
+ *
+ * The node table is split into chunks of a fixed number of records (see SceneChunkRecord),
+ * so that readers can decode large files on several threads.
+ *
+ * @see scene::SceneReader
+ */
+class SceneWriter {
+public:
+	static const uint32_t DEFAULT_CHUNK_SIZE = 4096;	//!< the number of records per chunk unless set otherwise
+
+	SceneWriter(const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault());
+
+	//! sets the number of records per chunk, 0 writes no chunk index
+	void setChunkSize(uint32_t size) { mChunkSize = size; }
+	//! returns the number of records per chunk
+	uint32_t getChunkSize() const { return mChunkSize; }
+
+	/**
+	 * Serializes a node and its descendants.
+	 *
+	 * @param root the root of the subtree to write
+	 * @param buffer receives the file contents, replacing what it held
+	 * @return false if the subtree holds a node of a type that is not registered
+	 */
+	bool write(const NodeBase& root, std::vector<uint8_t>& buffer);
+
+	//! serializes a node and its descendants to a stream, see above
+	bool write(const NodeBase& root, std::ostream& stream);
+
+	//! serializes a node and its descendants to a file, see above
+	bool write(const NodeBase& root, const std::string& path);
+
+	//! copies the transformation and flags of a node of any of the builtin types to a record
+	static void captureRecord(const NodeBase& node, SceneNodeRecord& record);
+
+protected:
+	const SceneTypeRegistry&	mRegistry;	//!< the ids of the node types
+	uint32_t					mChunkSize;	//!< the number of records per chunk, 0 for none
+	std::vector<SceneNodeRecord>	mRecords;	//!< the node table being written
+	std::vector<SceneChunkRecord>	mChunks;	//!< the chunk index being written
+	std::vector<uint8_t>		mStrings;	//!< the string table being written
+	std::vector<uint8_t>		mPayloads;	//!< the payload block being written
+	std::vector<uint8_t>		mBuffer;	//!< the file contents written to streams
+	std::vector<std::pair<const NodeBase*, uint32_t>>	mStack;	//!< the nodes left to write and the index of their parent record
+};
+
+/**
+ * @brief Reads scene graphs from the binary scene format
+ *
+ * The file is validated while it is read; malformed or truncated files, unknown node
+ * types and payloads rejected by SceneObject::deserialize make the reader return nullptr.
+ * The nodes are created without a context, so a scene may be read on a loader thread
+ * and attached with a MutationQueue.
+ *
+ * With a thread pool, the chunks of a file are decoded in parallel and the subtrees are
+ * stitched together on the calling thread; the result is the same scene as a serial read,
+ * but the factories, SceneObject::deserialize and NodeBase::addedToScene of the registered
+ * types run on the workers. Files without a chunk index are read as a single chunk.
+ *
+ * @see scene::SceneWriter
+ */
+class SceneReader {
+public:
+	SceneReader(const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault(), const ThreadPoolRef& pool = ThreadPoolRef());
+
+	//! sets the pool that decodes the chunks of a file, nullptr decodes them on the calling thread
+	void setThreadPool(const ThreadPoolRef& pool) { mPool = pool; }
+	//! returns the pool that decodes the chunks of a file
+	const ThreadPoolRef& getThreadPool() const { return mPool; }
+
+	//! deserializes a scene from the contents of a file, returns the root node or nullptr
+	NodeRef read(const uint8_t* data, size_t size);
+
+	//! deserializes a scene from the contents of a file, returns the root node or nullptr
+	NodeRef read(const std::vector<uint8_t>& buffer) { return read(buffer.data(), buffer.size()); }
+
+	//! deserializes a scene from a stream, returns the root node or nullptr
+	NodeRef read(std::istream& stream);
+
+	//! deserializes a scene from a file, returns the root node or nullptr
+	NodeRef read(const std::string& path);
+
+	/**
+	 * Validates the header of a scene file.
+	 *
+	 * @param data the contents of the file
+	 * @param size the size of the contents in bytes
+	 * @param header receives the header
+	 * @return false if the header is malformed or the tables lie outside of the file
+	 */
+	static bool readHeader(const uint8_t* data, size_t size, SceneFileHeader& header);
+
+	/**
+	 * Reads and validates the chunk index of a scene file.
+	 *
+	 * @param data the contents of the file
+	 * @param header the header validated by readHeader
+	 * @param chunks receives the chunks, a single one covering the file if it has no index
+	 * @return false if the chunks do not follow each other or lie outside of their tables
+	 */
+	static bool readChunks(const uint8_t* data, const SceneFileHeader& header, std::vector<SceneChunkRecord>& chunks);
+
+	//! returns wether a record has a valid parent and its name and payload lie within their tables
+	static bool checkRecord(const SceneFileHeader& header, const SceneNodeRecord& record, uint32_t index);
+
+	//! copies the transformation and flags of a record to a node of any of the builtin types
+	static void applyRecord(const SceneNodeRecord& record, NodeBase& node);
+
+	/**
+	 * Creates the node described by a record, without children.
+	 *
+	 * @param entry the type of the node
+	 * @param record the record of the node, validated by checkRecord
+	 * @param data the contents of the scene file
+	 * @param header the header of the scene file
+	 * @return the node, or nullptr if its payload was rejected
+	 */
+	static NodeRef createNode(const SceneTypeRegistry::Entry& entry, const SceneNodeRecord& record, const uint8_t* data, const SceneFileHeader& header);
+
+protected:
+	//! The roots of the subtrees of a chunk and the indices of their parents
+	typedef std::vector<std::pair<uint32_t, NodeRef>> ChunkRoots;
+
+	//! creates the nodes of a chunk and links those whose parent is in the chunk, returns false if a record is malformed
+	bool decodeChunk(const uint8_t* data, const SceneFileHeader& header, size_t chunk);
+
+	const SceneTypeRegistry&		mRegistry;	//!< the factories of the node types
+	ThreadPoolRef					mPool;		//!< decodes the chunks, nullptr to decode them serially
+	std::vector<NodeBase*>			mNodes;		//!< the nodes created so far, indexed like the records
+	std::vector<SceneChunkRecord>	mChunks;	//!< the chunks of the file being read
+	std::vector<ChunkRoots>			mRoots;		//!< the roots of the subtrees of every chunk
+	std::vector<uint8_t>			mBuffer;	//!< the file contents read from streams
+};
+
+}
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <atomic>
 #include <string>
 #include <iostream>
 #include <memory>
 
 namespace scene {
 
+class BinaryReader;
+class BinaryWriter;
+
 class SceneObject;
 typedef std::shared_ptr<SceneObject> ObjectRef;				//!< A shared pointer to a Component instance
 typedef std::shared_ptr<const SceneObject> ObjectConstRef;	//!< A shared pointer to a constant Component instance
@@ -14,8 +18,11 @@ typedef std::weak_ptr<SceneObject> ObjectWeakRef;			//!< A weak pointer to a Com
 /**
  * @brief SceneObject is the abstract base class for all entities within the scenegraph system
  *
- * SceneObject encapsulates logic for serialization and deserialization
+ * SceneObject encapsulates logic for serialization and deserialization. Types with state
+ * beyond what the scene format stores for every node write it in serialize() and read
+ * it back in deserialize().
  *
+ * @see scene::SceneWriter
  */
 class SceneObject : public std::enable_shared_from_this<SceneObject> {
 public:
@@ -24,10 +31,18 @@ public:
 	virtual ~SceneObject();
 	
 	//! accessor method for the name property
-	std::string getName() const { return mName; }
+	const std::string& getName() const { return mName; }
+	
+	//! assigns the name property, used when an entity is restored from a scene file
+	void setName(const std::string& name) { mName = name; }
+	
+	//! returns the unique numeric id of the entity, used to key component storage
+	uint64_t getId() const { return mId; }
 	
-	virtual void serialize() const {};
-	virtual void deserialize() {};
+	//! writes the type specific state of the entity
+	virtual void serialize(BinaryWriter& writer) const {}
+	//! reads the state written by serialize(), returns false if the data is malformed
+	virtual bool deserialize(BinaryReader& reader) { return true; }
 	
 	// stream logging support
 	friend std::ostream& operator<<(std::ostream& lhs, const SceneObject& rhs) {
@@ -39,7 +54,8 @@ protected:
 	std::string& name() { return mName; }
 	
 	std::string		mName;			//!< The string name used to uniquely identify the entity
-	static uint64_t sNameNum;		//!< The running counter used to ensure all names are unique
+	uint64_t		mId;			//!< The unique numeric id of the entity
+	static std::atomic<uint64_t> sNameNum;	//!< The running counter used to ensure all names are unique, shared by all threads
 
 	template<class T>
 	std::shared_ptr<T> shared_from_base()
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <memory>
+
+#include "cinder/Color.h"
+#include "cinder/Matrix.h"
+#include "cinder/Shape2d.h"
+#include "cinder/TriMesh.h"
+
+#include "CompactMesh.h"
+#include "NodeBase.h"
+
+namespace scene {
+
+class Node2d;
+class Node3d;
+
+class SceneSnapshotBuffer;
+typedef std::shared_ptr<SceneSnapshotBuffer> SceneSnapshotBufferRef;	//!< A shared pointer to a SceneSnapshotBuffer instance
+
+/**
+ * @brief The render-relevant state of a single node, captured at the end of a frame
+ *
+ * The node pointer is only meant to be used as an identity key. It must never
+ * be dereferenced from a thread other than the one that mutates the scene.
+ *
+ * The draw data is filled in by NodeBase::snapshot(). Meshes and shapes are shared,
+ * immutable copies that nodes only replace when their content changes, so capturing
+ * does not copy them every frame and the render thread may hold them for as long as
+ * it needs.
+ */
+struct SnapshotItem {
+	static const uint32_t NO_PARENT = 0xffffffff;
+
+	const NodeBase*	mNode;				//!< the node this item was captured from
+	uint32_t		mParent;			//!< index of the parent item, or NO_PARENT for the root
+	bool			mIsVisible;			//!< true if the node and all its ancestors are active
+	ci::mat4		mWorldTransform;	//!< the world transformation of the node
+
+	ci::ColorA							mColor;			//!< the color of the mesh or the fill color of the shape
+	ci::ColorA							mStrokeColor;	//!< the outline color of the shape
+	std::shared_ptr<const ci::TriMesh>	mMesh;			//!< the triangle mesh to draw, or nullptr
+	CompactMeshConstRef					mCompactMesh;	//!< the quantized mesh to draw, or nullptr
+	std::shared_ptr<const ci::Shape2d>	mShape;			//!< the shape to fill and outline, or nullptr
+
+	SnapshotItem() : mNode(nullptr), mParent(NO_PARENT), mIsVisible(false), mWorldTransform(1),
+		mColor(ci::ColorA::white()), mStrokeColor(ci::ColorA::white()) {}
+};
+
+/**
+ * @brief An immutable copy of the world transforms, visibility and draw data of a scene graph
+ *
+ * Items are stored in depth-first order, so a parent always precedes its children.
+ * Capturing into a snapshot reuses its storage, so steady-state frames do not allocate.
+ * RenderBackend::drawSnapshot() draws a snapshot without touching the nodes.
+ *
+ * @see scene::SceneSnapshotBuffer
+ */
+class SceneSnapshot {
+public:
+	SceneSnapshot() : mFrame(0) {}
+
+	//! returns the frame number that was assigned when the snapshot was captured
+	uint64_t getFrame() const { return mFrame; }
+
+	//! returns the captured items in depth-first order
+	const std::vector<SnapshotItem>& getItems() const { return mItems; }
+
+	//! returns the number of captured items
+	size_t size() const { return mItems.size(); }
+
+	//! returns wether the snapshot holds no items
+	bool empty() const { return mItems.empty(); }
+
+	//! replaces the contents of the snapshot with the state of a 3d scene graph (deepTransform must have been called)
+	void capture(const Node3d& root, uint64_t frame);
+
+	//! replaces the contents of the snapshot with the state of a 2d scene graph (deepTransform must have been called)
+	void capture(const Node2d& root, uint64_t frame);
+
+	//! removes all items
+	void clear() { mItems.clear(); mFrame = 0; }
+
+protected:
+	void capture(const Node3d& node, uint32_t parent, bool visible);
+	void capture(const Node2d& node, uint32_t parent, bool visible);
+
+	uint64_t					mFrame;		//!< the frame number of the captured state
+	std::vector<SnapshotItem>	mItems;		//!< the captured node state in depth-first order
+};
+
+/**
+ * @brief Lock-free hand-off of scene snapshots between a simulation thread and a render thread
+ *
+ * The buffer holds three snapshots: one owned by the writer, one owned by the
+ * reader and one in transit. publish() and acquire() swap ownership with a
+ * single atomic exchange, so neither thread ever blocks the other. The render
+ * thread always consumes the most recently published frame while the simulation
+ * thread is free to mutate the scene and capture the next one.
+ *
+ * Exactly one thread may write and exactly one thread may read. The reader draws the
+ * acquired snapshot with RenderBackend::drawSnapshot().
+ */
+class SceneSnapshotBuffer {
+public:
+	//! creates SceneSnapshotBuffer instance wrapped by STL shared pointer
+	static SceneSnapshotBufferRef create() { return SceneSnapshotBufferRef( new SceneSnapshotBuffer() ); }
+
+	//! returns the snapshot owned by the writer (simulation thread only)
+	SceneSnapshot& getWriteBuffer() { return mBuffers[mWriteIndex]; }
+
+	//! publishes the write buffer to the reader and hands a free buffer back to the writer (simulation thread only)
+	void publish();
+
+	//! returns the most recently published snapshot, or nullptr if nothing was published yet (render thread only)
+	const SceneSnapshot* acquire();
+
+	//! returns wether a snapshot was published since the last call to acquire()
+	bool hasPending() const { return (mPending.load(std::memory_order_acquire) & FRESH_BIT) != 0; }
+
+protected:
+	SceneSnapshotBuffer();
+
+	static const uint8_t FRESH_BIT = 0x4;		//!< set on the pending index when it holds an unread snapshot
+	static const uint8_t INDEX_MASK = 0x3;		//!< masks out the buffer index from the pending value
+
+	SceneSnapshot			mBuffers[3];	//!< the storage shared by the writer, the reader and the hand-off slot
+	uint8_t					mWriteIndex;	//!< the buffer owned by the writer
+	uint8_t					mReadIndex;		//!< the buffer owned by the reader
+	bool					mHasRead;		//!< true once the reader has acquired at least one snapshot
+	std::atomic<uint8_t>	mPending;		//!< the buffer in transit, combined with FRESH_BIT
+};
+
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <typeindex>
+#include <typeinfo>
+#include <vector>
+
+#include "NodeBase.h"
+
+namespace scene {
+
+/**
+ * @brief Maps node types to the stable ids and names stored in scene files
+ *
+ * Each entry holds a factory that creates an empty node of the type, which the scene
+ * readers then fill from the file. Ids must never change once files were written with
+ * them. Ids below FIRST_USER_TYPE are reserved for the node types of the scene graph.
+ *
+ * Registering types is not thread safe; register them at startup before scenes are
+ * loaded or saved. Looking them up from several threads is safe.
+ *
+ * @see scene::SceneWriter
+ * @see scene::SceneReader
+ */
+class SceneTypeRegistry {
+public:
+	typedef std::function<NodeRef()> Factory;	//!< creates an empty node of a type
+
+	//! Ids of the node types registered by default
+	typedef enum BuiltinType_t {
+		TYPE_NODE2D = 1,
+		TYPE_NODE3D = 2,
+		TYPE_NODESHAPE2D = 3,
+		TYPE_STREAMINGPROXY3D = 4,
+		FIRST_USER_TYPE = 256
+	} BuiltinType;
+
+	struct Entry {
+		uint32_t		mId;		//!< the id stored in binary scene files
+		std::string		mName;		//!< the name stored in text scene files
+		std::type_index	mType;		//!< the exact dynamic type of the nodes
+		Factory			mFactory;	//!< creates an empty node
+	};
+
+	//! creates an empty registry
+	SceneTypeRegistry() {}
+
+	//! returns the registry used by default, which knows the node types of the scene graph
+	static SceneTypeRegistry& getDefault();
+
+	/**
+	 * Registers a node type.
+	 *
+	 * @param id the id stored in binary scene files, must not be 0
+	 * @param name the name stored in text scene files
+	 * @param type the exact dynamic type of the nodes, subclasses must be registered themselves
+	 * @param factory creates an empty node of the type
+	 * @return false if the id, the name or the type is already registered
+	 */
+	bool registerType(uint32_t id, const std::string& name, const std::type_info& type, const Factory& factory);
+
+	//! registers a node type, see above
+	template<class T>
+	bool registerType(uint32_t id, const std::string& name, const Factory& factory) { return registerType(id, name, typeid(T), factory); }
+
+	//! returns the entry with an id, or nullptr
+	const Entry* find(uint32_t id) const;
+	//! returns the entry with a name, or nullptr
+	const Entry* find(const std::string& name) const;
+	//! returns the entry of a type, or nullptr
+	const Entry* find(const std::type_info& type) const;
+	//! returns the entry of the dynamic type of a node, or nullptr
+	const Entry* find(const NodeBase& node) const { return find(typeid(node)); }
+
+	//! returns all entries in the order of registration
+	const std::vector<Entry>& getEntries() const { return mEntries; }
+
+protected:
+	std::vector<Entry>	mEntries;	//!< the registered types, few enough for linear lookups
+};
+
+}
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "SceneFormat.h"
+#include "XmlSaxParser.h"
+
+namespace scene {
+
+/**
+ * @brief Writes scene graphs as XML
+ *
+ * Every node becomes an element named after its type in the SceneTypeRegistry, nested like
+ * the scene graph inside a single <scene> element:
+ *
+ *   <scene version="1">
+ *     <Node2d name="root" active="1" interactive="0" position="0 0" rotation="0" scale="1 1" pivot="0 0" size="0 0">
+ *       <NodeShape2d name="shape" ... payload="base64"/>
+ *     </Node2d>
+ *   </scene>
+ *
+ * 2d nodes store two components per vector and their rotation angle, 3d nodes three
+ * components and their rotation quaternion as "x y z w". Type specific state written by
+ * SceneObject::serialize goes into the base64 encoded "payload" attribute. The document is
+ * written to the stream while the scene is traversed, through a buffer of fixed size.
+ *
+ * @see scene::XmlSceneReader
+ */
+class XmlSceneWriter {
+public:
+	static const uint32_t VERSION = 1;	//!< the version written to the scene element
+
+	XmlSceneWriter(const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault());
+
+	/**
+	 * Writes a node and its descendants as a document.
+	 *
+	 * @param root the root of the subtree to write
+	 * @param stream receives the document
+	 * @return false if the subtree holds a node of a type that is not registered, or the stream failed
+	 */
+	bool write(const NodeBase& root, std::ostream& stream);
+
+	//! writes a node and its descendants to a file, see above
+	bool write(const NodeBase& root, const std::string& path);
+
+protected:
+	//! writes the start tag of a node, as an empty element tag if it has no children
+	void writeStartTag(const NodeBase& node, const SceneTypeRegistry::Entry& entry, size_t depth);
+
+	//! appends a value to the output, escaped for an attribute
+	void appendEscaped(const std::string& value);
+
+	//! appends a number of floats separated by spaces
+	void appendFloats(const float* values, size_t count);
+
+	//! appends the payload of a node in base64
+	void appendBase64(const std::vector<uint8_t>& data);
+
+	//! appends indentation for a depth
+	void appendIndent(size_t depth) { mOutput.append(depth + 1, '\t'); }
+
+	//! passes the output to the stream once it grew past the size of a chunk, or always if forced
+	bool flush(bool force = false);
+
+	const SceneTypeRegistry&	mRegistry;	//!< the names of the node types
+	std::ostream*				mStream;	//!< the stream being written
+	std::string					mOutput;	//!< the output not yet passed to the stream
+	std::vector<uint8_t>		mPayload;	//!< the payload of the current node
+	std::vector<std::pair<const NodeBase*, const SceneTypeRegistry::Entry*>>	mStack;	//!< the nodes left to write, or the open elements to close when an entry is set
+};
+
+/**
+ * @brief Reads scene graphs from XML written by an XmlSceneWriter
+ *
+ * The document is parsed as a stream of tags (see XmlSaxParser) and every element is
+ * created through the factory of its type as soon as its start tag was read, so nothing
+ * but the scene itself grows with the size of the document. Attributes that are missing
+ * keep the values the factory gave the node and unknown attributes are ignored, which
+ * leaves room for hand written files and newer writers. Unknown elements, malformed
+ * numbers or payloads rejected by SceneObject::deserialize make the reader return nullptr.
+ *
+ * The nodes are created without a context, so a scene may be read on a loader thread
+ * and attached with a MutationQueue.
+ *
+ * @see scene::XmlSceneWriter
+ */
+class XmlSceneReader : protected XmlSaxParser {
+public:
+	XmlSceneReader(const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault());
+
+	//! reads a scene from a stream, returns the root node or nullptr
+	NodeRef read(std::istream& stream);
+
+	//! reads a scene from a file, returns the root node or nullptr
+	NodeRef read(const std::string& path);
+
+	using XmlSaxParser::setMaxTokenSize;
+	using XmlSaxParser::getMaxTokenSize;
+
+	//! returns the line at which the last document failed
+	size_t getErrorLine() const { return getLine(); }
+
+protected:
+	virtual bool onStartElement(const std::string& name, const Attributes& attributes, size_t count);
+	virtual bool onEndElement(const std::string& name);
+
+	//! creates a node from its element
+	NodeRef createNode(const SceneTypeRegistry::Entry& entry, const Attributes& attributes, size_t count);
+
+	const SceneTypeRegistry&		mRegistry;	//!< the factories of the node types
+	const SceneTypeRegistry::Entry*	mEntry;		//!< the type of the previous element, elements mostly share their type
+	bool							mInScene;	//!< flag set between the start and end tag of the scene element
+	NodeRef							mRoot;		//!< the root of the scene being read
+	std::vector<NodeBase*>			mOpen;		//!< the nodes whose end tag was not read yet, owned by mRoot
+	std::vector<uint8_t>			mPayload;	//!< the decoded payload of the current node
+};
+
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+
+namespace scene {
+
+/**
+ * @brief A generational index that refers to an element of a SlotMap
+ *
+ * A handle stays valid until its element is removed. After that, the slot may be
+ * reused by another element, but with a new generation, so the old handle is
+ * detected as stale instead of silently referring to the new element.
+ */
+struct SlotHandle {
+	static const uint32_t INVALID_INDEX = 0xffffffff;
+
+	SlotHandle() : mIndex(INVALID_INDEX), mGeneration(0) {}
+	SlotHandle(uint32_t index, uint32_t generation) : mIndex(index), mGeneration(generation) {}
+
+	//! returns wether the handle was ever assigned (it may still be stale)
+	bool isNull() const { return mIndex == INVALID_INDEX; }
+
+	bool operator==(const SlotHandle& rhs) const { return mIndex == rhs.mIndex && mGeneration == rhs.mGeneration; }
+	bool operator!=(const SlotHandle& rhs) const { return !(*this == rhs); }
+
+	uint32_t	mIndex;			//!< the slot of the element
+	uint32_t	mGeneration;	//!< the generation of the slot when the element was inserted
+};
+
+/**
+ * @brief Densely packed container with O(1) insertion, removal and handle lookup
+ *
+ * Elements are stored contiguously for fast iteration. A slot table maps handles to
+ * dense positions, removal moves the last element into the gap and released slots
+ * are recycled through a free list with their generation incremented.
+ */
+template<typename T>
+class SlotMap {
+public:
+	typedef typename std::vector<T>::iterator iterator;
+	typedef typename std::vector<T>::const_iterator const_iterator;
+
+	SlotMap() : mFreeHead(SlotHandle::INVALID_INDEX) {}
+
+	//! inserts an element and returns its handle
+	SlotHandle insert(T value)
+	{
+		uint32_t index;
+		if (mFreeHead != SlotHandle::INVALID_INDEX) {
+			index = mFreeHead;
+			mFreeHead = mSlots[index].mDense;
+		}
+		else {
+			index = static_cast<uint32_t>(mSlots.size());
+			mSlots.push_back(Slot());
+		}
+
+		mSlots[index].mDense = static_cast<uint32_t>(mElements.size());
+		mElements.push_back(std::move(value));
+		mDenseToSlot.push_back(index);
+
+		return SlotHandle(index, mSlots[index].mGeneration);
+	}
+
+	//! removes the element of a handle, returns false if the handle is stale
+	bool remove(const SlotHandle& handle)
+	{
+		if (!contains(handle)) return false;
+
+		// move the last element into the gap
+		uint32_t dense = mSlots[handle.mIndex].mDense;
+		uint32_t last = static_cast<uint32_t>(mElements.size() - 1);
+		if (dense != last) {
+			mElements[dense] = std::move(mElements[last]);
+			mDenseToSlot[dense] = mDenseToSlot[last];
+			mSlots[mDenseToSlot[dense]].mDense = dense;
+		}
+		mElements.pop_back();
+		mDenseToSlot.pop_back();
+
+		// invalidate outstanding handles and recycle the slot
+		Slot& slot = mSlots[handle.mIndex];
+		slot.mGeneration++;
+		slot.mDense = mFreeHead;
+		mFreeHead = handle.mIndex;
+
+		return true;
+	}
+
+	//! returns wether the handle refers to an element
+	bool contains(const SlotHandle& handle) const
+	{
+		return handle.mIndex < mSlots.size() && mSlots[handle.mIndex].mGeneration == handle.mGeneration;
+	}
+
+	//! returns the element of a handle, or nullptr if the handle is stale
+	T* get(const SlotHandle& handle)
+	{
+		return contains(handle)? &mElements[mSlots[handle.mIndex].mDense]: nullptr;
+	}
+
+	//! returns the element of a handle, or nullptr if the handle is stale
+	const T* get(const SlotHandle& handle) const
+	{
+		return contains(handle)? &mElements[mSlots[handle.mIndex].mDense]: nullptr;
+	}
+
+	//! returns the handle of the element at a dense position
+	SlotHandle getHandle(size_t dense) const
+	{
+		uint32_t index = mDenseToSlot[dense];
+		return SlotHandle(index, mSlots[index].mGeneration);
+	}
+
+	//! returns the number of elements
+	size_t size() const { return mElements.size(); }
+
+	//! returns wether there are no elements
+	bool empty() const { return mElements.empty(); }
+
+	//! removes all elements, invalidating every outstanding handle
+	void clear()
+	{
+		while (!mElements.empty()) {
+			remove(getHandle(mElements.size() - 1));
+		}
+	}
+
+	iterator begin() { return mElements.begin(); }
+	iterator end() { return mElements.end(); }
+	const_iterator begin() const { return mElements.begin(); }
+	const_iterator end() const { return mElements.end(); }
+
+protected:
+	struct Slot {
+		Slot() : mDense(0), mGeneration(1) {}
+
+		uint32_t	mDense;			//!< position in mElements, or the next free slot while released
+		uint32_t	mGeneration;	//!< incremented every time the slot is released
+	};
+
+	std::vector<T>			mElements;		//!< the densely packed elements
+	std::vector<uint32_t>	mDenseToSlot;	//!< the slot of each element, used to patch slots on removal
+	std::vector<Slot>		mSlots;			//!< maps handle indices to dense positions
+	uint32_t				mFreeHead;		//!< first released slot, slots are chained through mDense
+};
+
+}
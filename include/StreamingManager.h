@@ -0,0 +1,179 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "MpscQueue.hpp"
+#include "SceneTypeRegistry.h"
+#include "StreamingProxy3d.h"
+#include "ThreadPool.h"
+
+namespace scene {
+
+class StreamingManager;
+typedef std::shared_ptr<StreamingManager> StreamingManagerRef;	//!< A shared pointer to a StreamingManager instance
+
+/**
+ * @brief Loads and releases the content of StreamingProxy3d nodes by the distance of the viewer
+ *
+ * The application registers the proxies of a world and calls update() once per frame
+ * with the position of the viewer, after deepTransform and while nothing traverses the
+ * scene. Each update:
+ *
+ *   - ranks the proxies by their distance to the viewer, divided by their priority
+ *   - keeps the content of proxies closer than the unload distance, and loads proxies
+ *     closer than the load distance, nearest first, as long as the memory budget allows
+ *   - releases the content of all other proxies and cancels their pending loads
+ *   - starts loads on the thread pool, at most a given number at a time
+ *   - attaches the subtrees that finished loading
+ *
+ * The unload distance is larger than the load distance, so a viewer moving back and forth
+ * at the edge of a region does not load it again and again. A proxy of unknown size counts
+ * as the size of its file once it was loaded, so the first load may exceed the budget; the
+ * farthest content is released by the next update.
+ *
+ * Proxies found in a loaded subtree are registered as well, so worlds can be nested, and
+ * are unregistered, with their own content released, when the subtree is released. A
+ * proxy that is destroyed leaves the manager by itself.
+ *
+ * @see scene::StreamingProxy3d
+ */
+class StreamingManager {
+public:
+	//! Type that describes the state of a registered proxy
+	typedef enum State_t {
+		STATE_UNLOADED = 0,		//!< the content is not loaded
+		STATE_LOADING = 1,		//!< the file is being read on the pool
+		STATE_LOADED = 2,		//!< the content is attached to the proxy
+		STATE_FAILED = 3		//!< the file could not be read, it is not tried again until the proxy is registered again
+	} State;
+
+	//! creates StreamingManager instance wrapped by STL shared pointer, a pool with one thread is created if none is given
+	static StreamingManagerRef create(const ThreadPoolRef& pool = ThreadPoolRef(), const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault())
+	{
+		return StreamingManagerRef( new StreamingManager(pool, registry) );
+	}
+
+	/**
+	 * @param pool the pool that reads the files, a pool with one thread is created if none is given
+	 * @param registry the factories of the node types in the files, must outlive the loads of the manager
+	 */
+	StreamingManager(const ThreadPoolRef& pool = ThreadPoolRef(), const SceneTypeRegistry& registry = SceneTypeRegistry::getDefault());
+
+	//! skips the queued loads and drops the results of the running ones, the loaded content stays attached
+	~StreamingManager();
+
+	//! registers a proxy, its current content counts as loaded
+	void add(const StreamingProxy3dRef& proxy);
+	//! unregisters a proxy, which keeps its content
+	void remove(const StreamingProxy3dRef& proxy);
+	//! returns the number of registered proxies
+	size_t getProxyCount() const { return mEntries.size(); }
+
+	//! returns the state of a proxy, STATE_UNLOADED if it is not registered
+	State getState(const StreamingProxy3d& proxy) const;
+
+	//! assigns the distance within which the content of proxies is loaded
+	void setLoadDistance(float distance) { mLoadDistance = distance; }
+	//! returns the distance within which the content of proxies is loaded
+	float getLoadDistance() const { return mLoadDistance; }
+	//! assigns the distance beyond which the content of proxies is released, at least the load distance
+	void setUnloadDistance(float distance) { mUnloadDistance = distance; }
+	//! returns the distance beyond which the content of proxies is released
+	float getUnloadDistance() const { return mUnloadDistance; }
+
+	//! assigns the memory the loaded content may take in bytes
+	void setMemoryBudget(uint64_t bytes) { mMemoryBudget = bytes; }
+	//! returns the memory the loaded content may take in bytes
+	uint64_t getMemoryBudget() const { return mMemoryBudget; }
+
+	//! assigns the number of files read at the same time
+	void setMaxPendingLoads(size_t count) { mMaxPendingLoads = count; }
+	//! returns the number of files read at the same time
+	size_t getMaxPendingLoads() const { return mMaxPendingLoads; }
+
+	/**
+	 * Loads and releases content for the current position of the viewer, see above.
+	 *
+	 * @param viewer the position of the viewer in world space
+	 * @return the number of subtrees that were attached or released
+	 */
+	size_t update(const ci::vec3& viewer);
+
+	//! returns the memory taken by the loaded content in bytes
+	uint64_t getResidentSize() const { return mResidentSize; }
+	//! returns the number of loads that did not reach update() yet, including the cancelled ones
+	size_t getPendingCount() const { return mPendingCount; }
+	//! returns the number of proxies whose content is loaded
+	size_t getLoadedCount() const;
+
+	//! returns the number of subtrees attached since the manager was created
+	size_t getLoadCount() const { return mLoadCount; }
+	//! returns the number of subtrees released since the manager was created
+	size_t getUnloadCount() const { return mUnloadCount; }
+	//! returns the number of loads that failed since the manager was created
+	size_t getFailedCount() const { return mFailedCount; }
+
+protected:
+	//! A registered proxy
+	struct Entry {
+		StreamingProxy3dWeakRef		mProxy;			//!< the proxy, expired once it was destroyed
+		const StreamingProxy3d*		mKey;			//!< the proxy, as a key of mIndices
+		State						mState;			//!< how far the content was loaded
+		uint32_t					mGeneration;	//!< the generation of the last load, so the results of cancelled loads are recognized
+		uint64_t					mSize;			//!< the memory taken by the content, 0 if unknown
+		float						mDistance;		//!< the distance of the viewer divided by the priority
+		bool						mIsOrphaned;	//!< set when the content holding the proxy was released, the entry is removed after the update
+	};
+
+	//! A subtree on its way to its proxy
+	struct Result {
+		StreamingProxy3dWeakRef		mProxy;			//!< the proxy, expired if it was released meanwhile
+		uint32_t					mGeneration;	//!< the generation of the load
+		NodeRef						mContent;		//!< the root of the subtree, nullptr if it could not be read
+		uint64_t					mFileSize;		//!< the size of the file in bytes
+	};
+
+	//! The state shared with the workers, which may outlive the manager
+	struct Shared {
+		MpscQueue<Result>			mResults;		//!< the loaded subtrees, pushed by the workers
+		std::atomic<bool>			mIsCancelled;	//!< set once the manager is gone, so queued loads are skipped
+	};
+
+	//! returns the entry of a proxy, or nullptr
+	Entry* find(const StreamingProxy3d* proxy);
+
+	//! removes the entry at an index, keeping mIndices up to date
+	void erase(size_t index);
+
+	//! starts reading the file of a proxy on the pool
+	void load(Entry& entry, const StreamingProxy3dRef& proxy);
+
+	//! releases the content of a proxy or cancels its load, the proxies nested in the content are orphaned
+	bool unload(Entry& entry, const StreamingProxy3dRef& proxy);
+
+	//! attaches the subtrees that finished loading, returns their number
+	size_t sync();
+
+	const SceneTypeRegistry&	mRegistry;			//!< the factories of the node types
+	ThreadPoolRef				mPool;				//!< reads the files
+	std::shared_ptr<Shared>		mShared;			//!< the results of the loads
+	std::vector<Entry>			mEntries;			//!< the registered proxies
+	std::unordered_map<const StreamingProxy3d*, size_t>	mIndices;	//!< the index of the entry of every proxy
+	std::vector<size_t>			mOrder;				//!< the entries sorted by distance, kept between updates
+	float						mLoadDistance;		//!< the distance within which content is loaded
+	float						mUnloadDistance;	//!< the distance beyond which content is released
+	uint64_t					mMemoryBudget;		//!< the memory the loaded content may take
+	size_t						mMaxPendingLoads;	//!< the number of files read at the same time
+	uint64_t					mResidentSize;		//!< the memory taken by the loaded content
+	size_t						mPendingCount;		//!< the number of loads that did not reach sync()
+	uint32_t					mGeneration;		//!< counts the loads, every load has its own generation
+	size_t						mLoadCount;			//!< the number of attached subtrees
+	size_t						mUnloadCount;		//!< the number of released subtrees
+	size_t						mFailedCount;		//!< the number of failed loads
+};
+
+}
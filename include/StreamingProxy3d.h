@@ -0,0 +1,91 @@
+#pragma once
+
+#include <string>
+
+#include "cinder/AxisAlignedBox.h"
+
+#include "Node3d.h"
+
+namespace scene {
+
+typedef std::shared_ptr<class StreamingProxy3d> StreamingProxy3dRef;		//!< A shared pointer to a StreamingProxy3d instance
+typedef std::shared_ptr<const StreamingProxy3d> StreamingProxy3dConstRef;	//!< A shared pointer to a constant StreamingProxy3d instance
+typedef std::weak_ptr<StreamingProxy3d> StreamingProxy3dWeakRef;			//!< A weak pointer to a StreamingProxy3d instance
+
+/**
+ * @brief Node3d that stands in for a subtree stored in a binary scene file
+ *
+ * The proxy describes a region of the world: the file that holds its subtree, the
+ * bounding box of the region in object space and how much memory the subtree takes once
+ * loaded. A StreamingManager loads the file when the viewer comes close to the region and
+ * attaches its root as the content of the proxy, and releases the content again when the
+ * viewer moves away or the memory budget runs out.
+ *
+ * Proxies are saved with the scene like any other node, so a world can be described by a
+ * small scene of proxies. A proxy that is saved while its content is loaded writes the
+ * content as well, as it is a regular child.
+ *
+ * @see scene::StreamingManager
+ */
+class StreamingProxy3d : public scene::Node3d {
+public:
+	//! creates StreamingProxy3d instance wrapped by STL shared pointer
+	static StreamingProxy3dRef create(const std::string& path = "", const ci::AxisAlignedBox& region = ci::AxisAlignedBox(ci::vec3(0.0f), ci::vec3(0.0f)),
+									  const std::string& name = "StreamingProxy3d")
+	{
+		return StreamingProxy3dRef( new StreamingProxy3d(path, region, name) );
+	}
+
+	StreamingProxy3d(const std::string& path = "", const ci::AxisAlignedBox& region = ci::AxisAlignedBox(ci::vec3(0.0f), ci::vec3(0.0f)),
+					 const std::string& name = "StreamingProxy3d");
+	virtual ~StreamingProxy3d();
+
+	//! returns the path of the scene file that holds the subtree
+	const std::string& getPath() const { return mPath; }
+	//! assigns the path of the scene file that holds the subtree
+	void setPath(const std::string& path) { mPath = path; setContentDirty(); }
+
+	//! returns the bounding box of the region in object space
+	const ci::AxisAlignedBox& getRegion() const { return mRegion; }
+	//! assigns the bounding box of the region in object space
+	void setRegion(const ci::AxisAlignedBox& region) { mRegion = region; setContentDirty(); }
+
+	//! returns the priority, which divides the distance of the viewer
+	float getPriority() const { return mPriority; }
+	//! assigns the priority: 2 loads the region from twice as far and before regions of priority 1 at the same distance
+	void setPriority(float priority) { mPriority = priority; setContentDirty(); }
+
+	//! returns the estimated memory taken by the loaded subtree in bytes, 0 if unknown
+	uint64_t getMemorySize() const { return mMemorySize; }
+	//! assigns the estimated memory taken by the loaded subtree in bytes, 0 uses the size of the file once it was loaded
+	void setMemorySize(uint64_t size) { mMemorySize = size; setContentDirty(); }
+
+	//! returns the root of the loaded subtree, or nullptr
+	const NodeRef& getContent() const { return mContent; }
+	//! replaces the loaded subtree, which is attached as a child; nullptr releases it
+	void setContent(const NodeRef& content);
+	//! returns true if the subtree is loaded
+	bool isLoaded() const { return mContent != nullptr; }
+
+	//! returns the distance from a point in world space to the region, 0 inside of it; needs an up to date world transformation
+	float calcDistance(const ci::vec3& point) const;
+
+	/** @inherit */
+	virtual void serialize(BinaryWriter& writer) const;
+	/** @inherit */
+	virtual bool deserialize(BinaryReader& reader);
+
+	// stream logging support
+	friend std::ostream& operator<<(std::ostream& lhs, const StreamingProxy3d& rhs) {
+		return lhs << "[StreamingProxy3d name=" << rhs.mName << ", path=" << rhs.mPath << ", loaded=" << rhs.isLoaded() << "]";
+	}
+
+protected:
+	std::string			mPath;			//!< the scene file that holds the subtree
+	ci::AxisAlignedBox	mRegion;		//!< the bounding box of the region in object space
+	float				mPriority;		//!< divides the distance of the viewer
+	uint64_t			mMemorySize;	//!< the estimated memory taken by the subtree, 0 if unknown
+	NodeRef				mContent;		//!< the root of the loaded subtree, a child of the proxy
+};
+
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace scene {
+
+class ThreadPool;
+typedef std::shared_ptr<ThreadPool> ThreadPoolRef;	//!< A shared pointer to a ThreadPool instance
+
+/**
+ * @brief A fixed set of worker threads that execute queued tasks
+ *
+ * Tasks are executed in the order they were submitted, but on any worker. The
+ * pool is shared by the systems that offload work from the main thread, such as
+ * the parallel update scheduler and background loaders.
+ */
+class ThreadPool {
+public:
+	//! creates ThreadPool instance wrapped by STL shared pointer, zero threads means one less than the hardware concurrency
+	static ThreadPoolRef create(size_t threads = 0) { return ThreadPoolRef( new ThreadPool(threads) ); }
+
+	//! joins all workers after the queued tasks were executed
+	~ThreadPool();
+
+	//! queues a task for execution on a worker thread
+	void submit(const std::function<void()>& task);
+
+	/**
+	 * Invokes fn(i) for every i in [0, count) and returns once all invocations finished.
+	 * The calling thread takes part in the work, so the call can not deadlock even when
+	 * it is made from a worker thread or while all workers are busy.
+	 *
+	 * @param count the number of invocations
+	 * @param fn the function to invoke with each index
+	 */
+	void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+	//! blocks until the queue is empty and no task is executing
+	void waitIdle();
+
+	//! returns the number of worker threads
+	size_t getThreadCount() const { return mThreads.size(); }
+
+protected:
+	ThreadPool(size_t threads);
+
+	//! the loop executed by each worker thread
+	void run();
+
+	std::vector<std::thread>			mThreads;		//!< the worker threads
+	std::deque<std::function<void()>>	mTasks;			//!< the queued tasks
+	std::mutex							mMutex;			//!< guards mTasks, mActive and mIsStopping
+	std::condition_variable				mTaskReady;		//!< signaled when a task was queued or the pool stops
+	std::condition_variable				mIdle;			//!< signaled when a worker finished a task
+	size_t								mActive;		//!< the number of tasks currently executing
+	bool								mIsStopping;	//!< set by the destructor to end the workers
+};
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "NodeBase.h"
+#include "ThreadPool.h"
+
+namespace scene {
+
+class UpdateScheduler;
+typedef std::shared_ptr<UpdateScheduler> UpdateSchedulerRef;	//!< A shared pointer to an UpdateScheduler instance
+
+/**
+ * @brief Parallel replacement for NodeBase::deepUpdate
+ *
+ * Every frame the scheduler flattens the tree in pre-order and finds the isolated
+ * subtrees: subtrees in which every node declares NodeBase::UPDATE_SUBTREE. Isolated
+ * subtrees that follow each other are updated concurrently on the thread pool. A node
+ * that is not isolated acts as a barrier: the pending subtrees finish first, then the
+ * node is updated on the calling thread. Since an isolated subtree never touches data
+ * outside of itself, every node observes the same state as with a serial deepUpdate,
+ * and the results are deterministic.
+ *
+ * Within a subtree, nodes are updated in pre-order (parents before children), exactly
+ * like deepUpdate. Overrides of deepUpdate are bypassed, update() is called directly.
+ * The structure of the tree must not change while the update runs.
+ *
+ * @see NodeBase::getUpdateScope
+ */
+class UpdateScheduler {
+public:
+	//! creates UpdateScheduler instance wrapped by STL shared pointer
+	static UpdateSchedulerRef create(const ThreadPoolRef& pool) { return UpdateSchedulerRef( new UpdateScheduler(pool) ); }
+
+	UpdateScheduler(const ThreadPoolRef& pool);
+
+	//! calls the update() function of the root and all its decendants
+	void deepUpdate(NodeBase& root, double elapsed);
+
+	//! returns the minimum number of nodes that a batch needs before it is dispatched to the pool
+	size_t getMinBatchSize() const { return mMinBatchSize; }
+	//! assigns the minimum number of nodes that a batch needs before it is dispatched to the pool
+	void setMinBatchSize(size_t size) { mMinBatchSize = size; }
+
+	//! returns the number of nodes updated in isolated subtrees during the last update
+	size_t getParallelNodeCount() const { return mParallelNodeCount; }
+	//! returns the number of nodes updated as barriers during the last update
+	size_t getSerialNodeCount() const { return mSerialNodeCount; }
+	//! returns the number of batches dispatched to the pool during the last update
+	size_t getBatchCount() const { return mBatchCount; }
+
+protected:
+	//! a node in pre-order along with the size of its subtree
+	struct Entry {
+		NodeBase*	mNode;			//!< the node
+		uint32_t	mSubtreeSize;	//!< the number of entries in the subtree, including the node
+		bool		mIsIsolated;	//!< true if every node of the subtree has UPDATE_SUBTREE scope
+	};
+
+	//! a contiguous range of entries forming one or more sibling subtrees
+	struct Range {
+		uint32_t	mBegin;
+		uint32_t	mEnd;
+	};
+
+	//! appends the subtree of a node in pre-order, returns wether it is isolated
+	bool flatten(NodeBase& node);
+
+	//! updates all pending ranges and clears them
+	void flush(double elapsed);
+
+	ThreadPoolRef			mPool;				//!< the pool that runs the isolated subtrees
+	size_t					mMinBatchSize;		//!< batches smaller than this run on the calling thread
+	std::vector<Entry>		mEntries;			//!< the flattened tree, reused every frame
+	std::vector<Range>		mPending;			//!< the isolated ranges waiting for the next barrier
+	std::vector<Range>		mTasks;				//!< the pending ranges grouped into tasks
+	size_t					mPendingNodes;		//!< the number of nodes in mPending
+	size_t					mParallelNodeCount;
+	size_t					mSerialNodeCount;
+	size_t					mBatchCount;
+};
+
+}
@@ -15,9 +15,18 @@ static uint64_t getHash( const std::string &name )
     
 static std::string toFormattedString( const uint32_t input, const uint8_t length )
 {
-    std::ostringstream ss_out;
-    ss_out << std::setw( length ) << std::setfill('0') << input;
-    return ss_out.str();
+    // every node formats its name on construction, so avoid the cost of a stream
+    char digits[10];
+    size_t count = 0;
+    uint32_t value = input;
+    do {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value);
+
+    std::string out(length > count? length - count: 0, '0');
+    while (count) out += digits[--count];
+    return out;
 }
 
 }
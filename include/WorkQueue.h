@@ -0,0 +1,106 @@
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+
+namespace scene {
+
+class WorkQueue;
+typedef std::shared_ptr<WorkQueue> WorkQueueRef;	//!< A shared pointer to a WorkQueue instance
+
+/**
+ * @brief Queue of deferrable jobs that are run on the main thread within a time budget
+ *
+ * Expensive work such as mesh generation or layout is submitted as a job instead of
+ * being done immediately. Once per frame, drain() runs jobs in priority order until
+ * the budget is spent, so a burst of work is spread across several frames. At least
+ * one job runs per drain, so a single job that exceeds the budget can not stall the
+ * queue.
+ *
+ * Jobs that wait longer than the aging period move up one priority level, so a steady
+ * stream of high priority work can not starve low priority jobs forever.
+ */
+class WorkQueue {
+public:
+	typedef std::function<void()> Job;	//!< A deferred unit of work
+	typedef uint64_t JobId;				//!< Identifies a submitted job
+
+	//! Type that describes the urgency of a job
+	typedef enum Priority_t {
+		PRIORITY_LOW = 0, PRIORITY_NORMAL = 1, PRIORITY_HIGH = 2
+	} Priority;
+
+	//! statistics of the last call to drain()
+	struct Stats {
+		size_t		mJobsRun;		//!< the number of jobs that ran
+		size_t		mJobsPending;	//!< the number of jobs left for later frames
+		size_t		mJobsPromoted;	//!< the number of jobs that moved up a priority level
+		double		mMicroseconds;	//!< the time spent running jobs
+		double		mLongestJob;	//!< the duration of the slowest job in microseconds
+	};
+
+	static const JobId INVALID_JOB = 0;
+
+	//! creates WorkQueue instance wrapped by STL shared pointer
+	static WorkQueueRef create(double budget_us = 2000.0) { return WorkQueueRef( new WorkQueue(budget_us) ); }
+
+	WorkQueue(double budget_us = 2000.0);
+
+	//! adds a job to the queue and returns its id
+	JobId submit(const Job& job, Priority priority = PRIORITY_NORMAL);
+
+	//! removes a job that did not run yet, returns false if it already ran or is unknown
+	bool cancel(JobId id);
+
+	//! runs queued jobs until the budget is spent or the queue is empty, returns the number of jobs that ran
+	size_t drain();
+
+	//! runs every queued job regardless of the budget
+	void flush();
+
+	//! assigns the time that drain() may spend per call in microseconds
+	void setBudget(double budget_us) { mBudget = budget_us; }
+	//! returns the time that drain() may spend per call in microseconds
+	double getBudget() const { return mBudget; }
+
+	//! assigns the number of calls to drain() a job waits before it moves up one priority level
+	void setAgingPeriod(uint32_t frames) { mAgingPeriod = (frames > 0)? frames: 1; }
+	//! returns the number of calls to drain() a job waits before it moves up one priority level
+	uint32_t getAgingPeriod() const { return mAgingPeriod; }
+
+	//! returns the number of jobs waiting to run
+	size_t getPendingCount() const;
+
+	//! returns the statistics of the last call to drain()
+	const Stats& getStats() const { return mStats; }
+
+	//! removes all queued jobs without running them
+	void clear();
+
+protected:
+	static const int PRIORITY_COUNT = 3;
+
+	struct Entry {
+		JobId		mId;		//!< the id returned by submit
+		Job			mJob;		//!< the work, empty once cancelled
+		uint64_t	mFrame;		//!< the frame in which the job entered its current level
+	};
+
+	//! moves jobs that waited longer than the aging period up one level
+	void promote();
+
+	//! removes and returns the next job to run, returns false when the queue is empty
+	bool pop(Entry& entry);
+
+	std::deque<Entry>	mLevels[PRIORITY_COUNT];	//!< the queued jobs of each priority, by id
+	uint64_t			mOldestFrames[PRIORITY_COUNT];	//!< a frame no later than the mFrame of any entry of each level
+	size_t				mCancelledCount;			//!< the number of cancelled entries still in mLevels
+	JobId				mNextId;					//!< the id of the next submitted job
+	uint64_t			mFrame;						//!< the number of calls to drain()
+	double				mBudget;					//!< the time budget per drain in microseconds
+	uint32_t			mAgingPeriod;				//!< the frames a job waits before promotion
+	Stats				mStats;						//!< the statistics of the last drain
+};
+
+}
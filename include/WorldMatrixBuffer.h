@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+#include "cinder/Matrix.h"
+
+namespace scene {
+
+class WorldMatrixBuffer;
+typedef std::shared_ptr<WorldMatrixBuffer> WorldMatrixBufferRef;	//!< A shared pointer to a WorldMatrixBuffer instance
+typedef std::weak_ptr<WorldMatrixBuffer> WorldMatrixBufferWeakRef;	//!< A weak pointer to a WorldMatrixBuffer instance
+
+/**
+ * @brief An affine world transformation packed as three 16-byte aligned rows
+ *
+ * The rows hold the upper 3x4 part of the column-major mat4, transposed, which
+ * matches the layout of a row-major float3x4 or three vec4 instance attributes.
+ */
+struct alignas(16) PackedMatrix34 {
+	float	mRows[3][4];	//!< the first three rows of the transformation, the last row is always (0,0,0,1)
+};
+
+/**
+ * @brief A half-open range [mBegin, mEnd) of matrix slots
+ */
+struct MatrixRange {
+	uint32_t	mBegin;		//!< the first slot of the range
+	uint32_t	mEnd;		//!< one past the last slot of the range
+
+	//! returns the number of slots in the range
+	uint32_t size() const { return mEnd - mBegin; }
+};
+
+/**
+ * @brief Contiguous mirror of Node3d world transformations for instanced and GPU-driven rendering
+ *
+ * Every node that is transformed with the buffer owns a slot for as long as the node
+ * exists. Writing a slot marks it dirty, and getDirtyRanges() coalesces the slots that
+ * were written since the last call to clearDirty() so that a renderer can upload only
+ * the regions that changed.
+ *
+ * @see Node3d::deepTransform
+ */
+class WorldMatrixBuffer {
+public:
+	static const uint32_t INVALID_INDEX = 0xffffffff;
+
+	//! creates WorldMatrixBuffer instance wrapped by STL shared pointer
+	static WorldMatrixBufferRef create() { return WorldMatrixBufferRef( new WorldMatrixBuffer() ); }
+
+	WorldMatrixBuffer() {}
+
+	//! reserves a slot, reusing released slots first, the slot is initialized to identity and marked dirty
+	uint32_t allocate();
+
+	//! returns a slot to the buffer so that it can be reused, slots that are not allocated are ignored
+	void release(uint32_t index);
+
+	//! returns wether a slot is currently allocated
+	bool isAllocated(uint32_t index) const { return index < mAllocatedFlags.size() && mAllocatedFlags[index]; }
+
+	//! packs a world transformation into a slot and marks it dirty
+	void set(uint32_t index, const ci::mat4& world);
+
+	//! unpacks the world transformation stored in a slot
+	ci::mat4 get(uint32_t index) const;
+
+	//! returns the packed matrices, including released slots
+	const PackedMatrix34* data() const { return mMatrices.data(); }
+
+	//! returns the number of slots (allocated and released)
+	size_t size() const { return mMatrices.size(); }
+
+	//! returns the number of slots that are currently allocated
+	size_t getAllocatedCount() const { return mMatrices.size() - mFreeSlots.size(); }
+
+	//! returns the size of the packed data in bytes
+	size_t getSizeInBytes() const { return mMatrices.size() * sizeof(PackedMatrix34); }
+
+	//! returns the distance in bytes between consecutive matrices
+	static size_t getStride() { return sizeof(PackedMatrix34); }
+
+	//! returns wether a slot was written since the last call to clearDirty
+	bool isDirty(uint32_t index) const { return index < mDirtyFlags.size() && mDirtyFlags[index]; }
+
+	/**
+	 * Coalesces the dirty slots into sorted, disjoint ranges.
+	 *
+	 * @param max_gap ranges separated by up to this many clean slots are merged, trading
+	 *        a slightly larger upload for fewer upload calls
+	 * @return the dirty ranges in ascending order
+	 */
+	const std::vector<MatrixRange>& getDirtyRanges(uint32_t max_gap = 0);
+
+	//! forgets all dirty slots, typically called once the dirty ranges were uploaded
+	void clearDirty();
+
+	//! converts a world transformation into its packed form
+	static void pack(const ci::mat4& world, PackedMatrix34& out);
+
+	//! converts a packed transformation back into a mat4
+	static ci::mat4 unpack(const PackedMatrix34& packed);
+
+protected:
+	//! marks a slot dirty if it wasn't already
+	void markDirty(uint32_t index);
+
+	std::vector<PackedMatrix34>	mMatrices;		//!< the packed world transformations
+	std::vector<uint32_t>		mFreeSlots;		//!< released slots available for reuse
+	std::vector<uint8_t>		mAllocatedFlags;	//!< per slot flag, keeps a slot from being released twice
+	std::vector<uint8_t>		mDirtyFlags;	//!< per slot flag, avoids duplicate dirty entries
+	std::vector<uint32_t>		mDirtySlots;	//!< slots written since the last clearDirty, unordered
+	std::vector<MatrixRange>	mDirtyRanges;	//!< storage for the result of getDirtyRanges
+};
+
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace scene {
+
+/**
+ * @brief Event based XML parser that never holds more than one element
+ *
+ * The parser reads the stream in fixed size chunks and reports every start and end tag
+ * to its subclass as soon as the tag is complete, so its memory use depends on the
+ * nesting depth and the largest tag, not on the size of the document. Character data,
+ * comments, CDATA sections, processing instructions and the document type declaration are
+ * skipped. Entity and character references in attribute values are resolved; only the
+ * predefined entities are known.
+ *
+ * The document must be well formed: tags must be balanced and there must be a single root
+ * element. Namespaces are not interpreted, prefixed names are reported as they are.
+ */
+class XmlSaxParser {
+public:
+	typedef std::vector<std::pair<std::string, std::string>> Attributes;	//!< the names and values of the attributes of a tag
+
+	static const size_t CHUNK_SIZE = 64 * 1024;	//!< the number of bytes read from the stream at once
+
+	XmlSaxParser();
+	virtual ~XmlSaxParser() {}
+
+	/**
+	 * Parses a document and reports its tags.
+	 *
+	 * @param stream the document
+	 * @return false if the document is malformed, if a tag exceeds the maximum tag size or if a handler failed
+	 */
+	bool parse(std::istream& stream);
+
+	//! limits the size of a name or attribute value in bytes, longer ones fail the document
+	void setMaxTokenSize(size_t size) { mMaxTokenSize = size; }
+	//! returns the maximum size of a name or attribute value in bytes
+	size_t getMaxTokenSize() const { return mMaxTokenSize; }
+
+	//! returns the line the parser reached, the line of the error after parse() failed
+	size_t getLine() const { return mLine; }
+
+protected:
+	/**
+	 * Called for every start tag, and for empty element tags before onEndElement.
+	 *
+	 * @param name the name of the element
+	 * @param attributes the attributes in document order, only valid during the call
+	 * @param count the number of attributes, the vector may hold more entries
+	 * @return false to stop parsing and fail the document
+	 */
+	virtual bool onStartElement(const std::string& name, const Attributes& attributes, size_t count) = 0;
+
+	//! called for every end tag, return false to stop parsing and fail the document
+	virtual bool onEndElement(const std::string& name) = 0;
+
+	//! returns the value of an attribute of the current tag, or nullptr
+	static const std::string* findAttribute(const Attributes& attributes, size_t count, const char* name);
+
+private:
+	//! returns the next character, or -1 at the end of the stream
+	int get()
+	{
+		if (mPosition == mEnd && !fill()) return -1;
+		int c = static_cast<unsigned char>(mChunk[mPosition++]);
+		if (c == '\n') ++mLine;
+		return c;
+	}
+
+	//! reads the next chunk, returns false at the end of the stream
+	bool fill();
+
+	//! skips the input up to and including a terminator
+	bool skipPast(const char* terminator);
+
+	//! skips a comment, CDATA section or declaration after "<!"
+	bool skipMarkup();
+
+	//! reads a name starting with c, returns the character that follows it
+	int readName(int c, std::string& name);
+
+	//! reads a quoted attribute value, resolving references
+	bool readValue(int quote, std::string& value);
+
+	//! resolves a reference after '&' and appends it
+	bool readReference(std::string& value);
+
+	//! parses a start or empty element tag after its first character
+	bool parseStartTag(int c);
+
+	//! parses an end tag after "</"
+	bool parseEndTag();
+
+	std::istream*				mStream;		//!< the stream being parsed
+	std::vector<char>			mChunk;			//!< the current chunk of the stream
+	size_t						mPosition;		//!< the offset of the next character in mChunk
+	size_t						mEnd;			//!< the number of valid characters in mChunk
+	size_t						mLine;			//!< the current line, starting at 1
+	size_t						mMaxTokenSize;	//!< the limit for names and attribute values
+
+	std::vector<std::string>	mOpen;			//!< the names of the open elements, entries are reused
+	size_t						mDepth;			//!< the number of open elements
+	bool						mHasRoot;		//!< flag set once the root element was opened
+	std::string					mName;			//!< the name of the current tag
+	Attributes					mAttributes;	//!< the attributes of the current tag, entries are reused
+};
+
+}
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "AnimationSystem.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// Compares the cost of evaluating many position channels with
+// scene::AnimationSystem against a plain loop over the nodes:
+//
+//   AnimationBenchmark [channels] [frames]
+//
+// Prints the fastest frame of each variant, so the scheduler does not skew
+// the results. Build with optimizations, debug timings say nothing.
+//
+///////////////////////////////////////////////////////////////////////////
+
+typedef chrono::steady_clock Clock;
+
+//! returns the milliseconds elapsed since start
+static double elapsed(const Clock::time_point& start)
+{
+	return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+	const int nodes_count = argc > 1? atoi(argv[1]): 50000;
+	const int frames = argc > 2? atoi(argv[2]): 60;
+	const int KEYS = 8;
+	if (nodes_count <= 0 || frames <= 0) {
+		fprintf(stderr, "usage: %s [channels] [frames]\n", argv[0]);
+		return 2;
+	}
+
+	AnimationSystemRef system = AnimationSystem::create();
+	vector<Node3dRef> nodes;
+	vector<float> times;
+	vector<vector<vec3>> values(nodes_count);
+	for (int k = 0; k < KEYS; ++k) times.push_back(float(k));
+	for (int i = 0; i < nodes_count; ++i) {
+		for (int k = 0; k < KEYS; ++k) values[i].push_back(vec3(float(i + k), float(k), 0));
+		nodes.push_back(Node3d::create("node"));
+		system->addPositionChannel(nodes.back(), times, values[i]);
+	}
+
+	double system_ms = 1e9, naive_ms = 1e9, writes_ms = 1e9;
+	vector<uint32_t> cursors(nodes_count, 0);
+	float time = 0;
+	for (int frame = 0; frame < frames; ++frame) {
+		time += 1.0f / 60.0f;
+
+		Clock::time_point start = Clock::now();
+		system->evaluate(time);
+		system_ms = min(system_ms, elapsed(start));
+
+		// the same animation with a cursor per node and the regular setter
+		start = Clock::now();
+		for (int i = 0; i < nodes_count; ++i) {
+			uint32_t& k = cursors[i];
+			while (k + 2 < KEYS && time >= times[k + 1]) ++k;
+			float u = min(max((time - times[k]) / (times[k + 1] - times[k]), 0.0f), 1.0f);
+			nodes[i]->setPosition(glm::mix(values[i][k], values[i][k + 1], u));
+		}
+		naive_ms = min(naive_ms, elapsed(start));
+
+		// only the writes, which any animation of the nodes has to pay
+		start = Clock::now();
+		for (int i = 0; i < nodes_count; ++i) nodes[i]->setPosition(values[i][0]);
+		writes_ms = min(writes_ms, elapsed(start));
+	}
+
+	printf("%d channels, %d frames\n", nodes_count, frames);
+	printf("%-10s %10s\n", "variant", "best_ms");
+	printf("%-10s %10.3f\n", "system", system_ms);
+	printf("%-10s %10.3f\n", "naive", naive_ms);
+	printf("%-10s %10.3f\n", "writes", writes_ms);
+	printf("evaluation costs %.3f ms on top of the writes\n", max(system_ms - writes_ms, 0.0));
+
+	return 0;
+}
@@ -0,0 +1,81 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "FrameRecorder.h"
+
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// Replays a recording made with scene::FrameRecorder without a window and
+// prints the time spent in each phase of the frames:
+//
+//   SceneReplay <recording> [--frames]
+//
+// --frames also prints the measurements of every frame as CSV.
+//
+///////////////////////////////////////////////////////////////////////////
+
+static const char* PHASE_NAMES[FrameReplayer::PHASE_COUNT] = { "input", "apply", "update", "transform" };
+
+//! returns the value below which a fraction of the sorted values lie
+static double percentile(const vector<double>& sorted, double fraction)
+{
+	if (sorted.empty()) return 0.0;
+	size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+	return sorted[index];
+}
+
+int main(int argc, char* argv[])
+{
+	const char* path = nullptr;
+	bool print_frames = false;
+	for (int i = 1; i < argc; ++i) {
+		if (strcmp(argv[i], "--frames") == 0) print_frames = true;
+		else path = argv[i];
+	}
+	if (!path) {
+		fprintf(stderr, "usage: %s <recording> [--frames]\n", argv[0]);
+		return 2;
+	}
+
+	FrameReplayer replayer;
+	if (!replayer.open(string(path))) {
+		fprintf(stderr, "%s is not a frame recording\n", path);
+		return 1;
+	}
+
+	size_t frames = replayer.run();
+	if (!replayer.isComplete()) fprintf(stderr, "frame %u is corrupt, replayed the frames before it\n", static_cast<unsigned>(frames));
+
+	const vector<FrameReplayer::FrameTiming>& timings = replayer.getTimings();
+	if (print_frames) {
+		printf("frame,nodes,events,delta_bytes,input_us,apply_us,update_us,transform_us\n");
+		for (auto itr = timings.begin(); itr != timings.end(); ++itr) {
+			printf("%u,%u,%u,%u,%.2f,%.2f,%.2f,%.2f\n", itr->mFrame, itr->mNodeCount, itr->mEventCount, itr->mDeltaSize,
+				   itr->mMicroseconds[0], itr->mMicroseconds[1], itr->mMicroseconds[2], itr->mMicroseconds[3]);
+		}
+	}
+
+	printf("%u frames\n", static_cast<unsigned>(frames));
+	printf("%-10s %12s %10s %10s %10s %10s\n", "phase", "total_us", "mean_us", "p50_us", "p95_us", "max_us");
+
+	vector<double> values(timings.size());
+	for (int phase = 0; phase < FrameReplayer::PHASE_COUNT; ++phase) {
+		double total = 0.0;
+		for (size_t i = 0; i < timings.size(); ++i) {
+			values[i] = timings[i].mMicroseconds[phase];
+			total += values[i];
+		}
+		sort(values.begin(), values.end());
+
+		double mean = values.empty()? 0.0: total / values.size();
+		double max = values.empty()? 0.0: values.back();
+		printf("%-10s %12.1f %10.2f %10.2f %10.2f %10.2f\n", PHASE_NAMES[phase], total, mean, percentile(values, 0.5), percentile(values, 0.95), max);
+	}
+
+	return replayer.isComplete()? 0: 1;
+}
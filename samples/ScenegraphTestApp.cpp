@@ -5,6 +5,11 @@
 #include "NodeBase.h"
 #include "Node2d.h"
 #include "Node3d.h"
+#include "EventDispatcher.h"
+#include "FixedTimestep.h"
+#include "RenderBackendGl.h"
+#include "SceneContext.h"
+#include "SceneSnapshot.h"
 
 using namespace ci;
 using namespace ci::app;
@@ -31,13 +36,30 @@ protected:
 	//! Keeps track of current game time, used to calculate elapsed time in seconds.
 	double				mTime;
 	
+	//! Runs the simulation at a fixed rate, independent of the frame rate
+	scene::FixedTimestepRef	mClock;
+	
 	scene::Node2dRef		mRoot;
+	//! Journals the changes made to the nodes, so the dispatcher notices them
+	scene::SceneContextRef	mContext;
+	//! Routes mouse input to the node under the cursor
+	scene::EventDispatcherRef	mDispatcher;
+	scene::RenderBackendRef	mRenderer;
+	//! Hands the state of each frame to draw(), which could just as well run on a render thread
+	scene::SceneSnapshotBufferRef	mSnapshots;
+	uint64_t				mFrame;
 };
 
 void ScenegraphTestApp::setup()
 {
 	// Initialize game time
 	mTime = getElapsedSeconds();
+	mClock = scene::FixedTimestep::create( 1.0 / 60.0 );
+	
+	// all drawing done by the scene graph is routed through a render backend
+	mRenderer = scene::RenderBackendGl::create();
+	mSnapshots = scene::SceneSnapshotBuffer::create();
+	mFrame = 0;
 	
 	// create the root node: a large rectangle
 	mRoot = scene::Node2d::create();
@@ -69,33 +91,37 @@ void ScenegraphTestApp::setup()
 	child->setPosition(5, 5);
 	child->setSize(100, 100);
 	child2->addChild(child);
+	
+	// the context records the changes made to the nodes every frame
+	mContext = scene::SceneContext::create();
+	mContext->setRoot( mRoot );
+	
+	// route mouse input through a dispatcher instead of offering it to every node
+	mDispatcher = scene::EventDispatcher::create( mRoot );
 }
 
 void ScenegraphTestApp::mouseMove( MouseEvent event )
 {
-	// pass the mouseMove event to all nodes. Important: this can easily bring your
-	// frame rate down if you have a lot of nodes and none of them does anything with
-	// this event. Only use it if you must! Needs optimization.
-//	mRoot->deepMouseMove(event);
+	// the dispatcher hit-tests once and only notifies the node under the cursor
+	// and its ancestors, so this stays cheap with a lot of nodes. Moves are
+	// coalesced and delivered once per frame in update()
+	mDispatcher->post( scene::PointerEvent::POINTER_MOVE, vec2( event.getPos() ) );
 }
 
 void ScenegraphTestApp::mouseDown( MouseEvent event )
 {
-	// pass the mouseDown event to all nodes. This is usually very quick because
-	// it starts at the top nodes and they often catch the event.
-//	mRoot->deepMouseDown(event);
+	// the node that consumes the press receives the following drag and up events
+	mDispatcher->post( scene::PointerEvent::POINTER_DOWN, vec2( event.getPos() ) );
 }
 
 void ScenegraphTestApp::mouseDrag( MouseEvent event )
 {
-	// pass the mouseDrag event to all nodes. This is usually very quick.
-//	mRoot->deepMouseDrag(event);
+	mDispatcher->post( scene::PointerEvent::POINTER_DRAG, vec2( event.getPos() ) );
 }
 
 void ScenegraphTestApp::mouseUp( MouseEvent event )
 {
-	// pass the mouseUp event to all nodes. This is usually very quick.
-//	mRoot->deepMouseUp(event);
+	mDispatcher->post( scene::PointerEvent::POINTER_UP, vec2( event.getPos() ) );
 }
 
 void ScenegraphTestApp::keyDown( KeyEvent event )
@@ -126,25 +152,42 @@ void ScenegraphTestApp::update()
 	double elapsed = getElapsedSeconds() - mTime;
 	mTime = getElapsedSeconds();
 	
-	// rotate the root node around its anchor point
-	mRoot->setRotation( 0.1 * mTime );
+	// update all nodes in fixed steps, a slow frame runs a bounded number of steps
+	mClock->update( *mRoot, elapsed );
 	
-	// update all nodes
-	mRoot->deepUpdate( elapsed );
+	// rotate the root node around its anchor point, using the simulated time
+	mRoot->setRotation( 0.1 * mClock->getTime() );
 	
 	// important and easy to forget: calculate transformations of all nodes
 	// after they have been updated, so the transformation matrices reflect
-	// any animation done on the nodes
-	mRoot->deepTransform( gl::getModelView() );
+	// any animation done on the nodes. The transformations are blended between
+	// the last two steps to present the simulation smoothly at the frame rate
+	mRoot->deepTransformInterpolated( mat3(1), mClock->getAlpha() );
+	
+	// deliver the mouse motion of this frame and update the node under the cursor,
+	// the dispatcher picks up the nodes that moved from the journal of the context
+	mDispatcher->update();
+	
+	// all consumers of the journal ran, start recording the next frame
+	mContext->getJournal().clear();
+	
+	// capture what has to be drawn, draw() never touches the nodes
+	mSnapshots->getWriteBuffer().capture( *mRoot, ++mFrame );
+	mSnapshots->publish();
 }
 
 void ScenegraphTestApp::draw()
 {
+	mRenderer->beginFrame();
+	
 	// clear out the window with black
-	gl::clear( Color( 0, 0, 0 ) );
+	mRenderer->clear( ColorA( 0, 0, 0, 1 ) );
+	
+	// draw the most recently published frame
+	const scene::SceneSnapshot* snapshot = mSnapshots->acquire();
+	if( snapshot ) mRenderer->drawSnapshot( *snapshot );
 	
-	// draw all nodes, starting with the root node
-	mRoot->deepDraw();
+	mRenderer->endFrame();
 }
 
 
@@ -0,0 +1,563 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "AnimationSystem.h"
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+	#define SCENE_ANIMATION_SSE
+	#include <xmmintrin.h>
+#endif
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Evaluate channels of independent batches on the ThreadPool
+//
+///////////////////////////////////////////////////////////////////////////
+
+const uint32_t AnimationSystem::NO_SLOT;
+
+AnimationSystem::AnimationSystem()
+:	mTime(0)
+{
+}
+
+#pragma mark channels
+
+AnimationSystem::ChannelId AnimationSystem::addChannel(const NodeRef& node, Target target, Property property, Interpolation mode,
+														const vector<float>& times, const vector<vec4>& values)
+{
+	// rotations of Node3d always use the quaternion kernel, anything else is linear unless it asks for bezier
+	uint8_t kernel = LINEAR;
+	if (target == TARGET_NODE3D && property == ROTATION) kernel = SLERP;
+	else if (mode == BEZIER) kernel = BEZIER;
+
+	uint32_t index = 0;
+	while (index < mBatches.size() && !(mBatches[index].mTarget == target && mBatches[index].mProperty == property && mBatches[index].mInterpolation == kernel)) ++index;
+	if (index == mBatches.size()) {
+		Batch batch;
+		batch.mTarget = static_cast<uint8_t>(target);
+		batch.mProperty = static_cast<uint8_t>(property);
+		batch.mInterpolation = kernel;
+		if (target == TARGET_NODE3D) batch.mComponents = (property == ROTATION)? 4: 3;
+		else batch.mComponents = (property == ROTATION)? 1: 2;
+		batch.mCount = 0;
+		mBatches.push_back(batch);
+	}
+
+	Channel channel;
+	channel.mNodeRef = node;
+	channel.mBatch = index;
+	channel.mSlot = NO_SLOT;
+	channel.mIsLooping = false;
+	channel.mIsEnabled = node && !times.empty() && times.size() == values.size();
+	channel.mFirstKey = static_cast<uint32_t>(mKeyTimes.size());
+	channel.mKeyCount = static_cast<uint32_t>(std::min(times.size(), values.size()));
+	channel.mCursor = 0;
+	channel.mStartTime = mTime;
+
+	for (uint32_t i = 0; i < channel.mKeyCount; ++i) {
+		// default controls at a third of the neighbouring segments make a bezier segment a straight line
+		const vec4& prev = values[(i > 0)? i - 1: i];
+		const vec4& next = values[(i + 1 < channel.mKeyCount)? i + 1: i];
+
+		mKeyTimes.push_back(times[i]);
+		for (int c = 0; c < 4; ++c) {
+			mKeyValues[c].push_back(values[i][c]);
+			mKeyOut[c].push_back(values[i][c] + (next[c] - values[i][c]) / 3.0f);
+			mKeyIn[c].push_back(values[i][c] - (values[i][c] - prev[c]) / 3.0f);
+		}
+	}
+
+	ChannelId id = static_cast<ChannelId>(mChannels.size());
+	mChannels.push_back(channel);
+	if (channel.mIsEnabled) insert(id);
+	return id;
+}
+
+AnimationSystem::ChannelId AnimationSystem::addPositionChannel(const Node3dRef& node, const vector<float>& times, const vector<vec3>& values, Interpolation mode)
+{
+	vector<vec4> keys;
+	for (auto itr = values.begin(); itr != values.end(); ++itr) keys.push_back(vec4(*itr, 0));
+	return addChannel(node, TARGET_NODE3D, POSITION, mode, times, keys);
+}
+
+AnimationSystem::ChannelId AnimationSystem::addScaleChannel(const Node3dRef& node, const vector<float>& times, const vector<vec3>& values, Interpolation mode)
+{
+	vector<vec4> keys;
+	for (auto itr = values.begin(); itr != values.end(); ++itr) keys.push_back(vec4(*itr, 0));
+	return addChannel(node, TARGET_NODE3D, SCALE, mode, times, keys);
+}
+
+AnimationSystem::ChannelId AnimationSystem::addRotationChannel(const Node3dRef& node, const vector<float>& times, const vector<quat>& values)
+{
+	vector<vec4> keys;
+	for (auto itr = values.begin(); itr != values.end(); ++itr) keys.push_back(vec4(itr->x, itr->y, itr->z, itr->w));
+	return addChannel(node, TARGET_NODE3D, ROTATION, SLERP, times, keys);
+}
+
+AnimationSystem::ChannelId AnimationSystem::addPositionChannel(const Node2dRef& node, const vector<float>& times, const vector<vec2>& values, Interpolation mode)
+{
+	vector<vec4> keys;
+	for (auto itr = values.begin(); itr != values.end(); ++itr) keys.push_back(vec4(itr->x, itr->y, 0, 0));
+	return addChannel(node, TARGET_NODE2D, POSITION, mode, times, keys);
+}
+
+AnimationSystem::ChannelId AnimationSystem::addScaleChannel(const Node2dRef& node, const vector<float>& times, const vector<vec2>& values, Interpolation mode)
+{
+	vector<vec4> keys;
+	for (auto itr = values.begin(); itr != values.end(); ++itr) keys.push_back(vec4(itr->x, itr->y, 0, 0));
+	return addChannel(node, TARGET_NODE2D, SCALE, mode, times, keys);
+}
+
+AnimationSystem::ChannelId AnimationSystem::addRotationChannel(const Node2dRef& node, const vector<float>& times, const vector<float>& values, Interpolation mode)
+{
+	vector<vec4> keys;
+	for (auto itr = values.begin(); itr != values.end(); ++itr) keys.push_back(vec4(*itr, 0, 0, 0));
+	return addChannel(node, TARGET_NODE2D, ROTATION, mode, times, keys);
+}
+
+void AnimationSystem::setControls(ChannelId id, const vector<vec4>& out_controls, const vector<vec4>& in_controls)
+{
+	if (id >= mChannels.size()) return;
+
+	const Channel& channel = mChannels[id];
+	for (uint32_t i = 0; i < channel.mKeyCount; ++i) {
+		uint32_t key = channel.mFirstKey + i;
+		for (int c = 0; c < 4; ++c) {
+			if (i < out_controls.size()) mKeyOut[c][key] = out_controls[i][c];
+			if (i < in_controls.size()) mKeyIn[c][key] = in_controls[i][c];
+		}
+	}
+	if (channel.mSlot != NO_SLOT) reset(channel);
+}
+
+void AnimationSystem::setLooping(ChannelId id, bool looping)
+{
+	if (id >= mChannels.size()) return;
+
+	mChannels[id].mIsLooping = looping;
+	if (mChannels[id].mSlot != NO_SLOT) reset(mChannels[id]);
+}
+
+void AnimationSystem::setEnabled(ChannelId id, bool enabled)
+{
+	if (id >= mChannels.size()) return;
+
+	Channel& channel = mChannels[id];
+	channel.mIsEnabled = enabled && channel.mKeyCount > 0;
+	if (channel.mIsEnabled && channel.mSlot == NO_SLOT) insert(id);
+	else if (!channel.mIsEnabled && channel.mSlot != NO_SLOT) remove(id);
+}
+
+void AnimationSystem::setStartTime(ChannelId id, float time)
+{
+	if (id >= mChannels.size()) return;
+
+	mChannels[id].mStartTime = time;
+	if (mChannels[id].mSlot != NO_SLOT) reset(mChannels[id]);
+}
+
+void AnimationSystem::clear()
+{
+	mChannels.clear();
+	mBatches.clear();
+	mKeyTimes.clear();
+	for (int c = 0; c < 4; ++c) {
+		mKeyValues[c].clear();
+		mKeyOut[c].clear();
+		mKeyIn[c].clear();
+	}
+}
+
+#pragma mark batches
+
+void AnimationSystem::Batch::grow()
+{
+	size_t size = mU.size() + 4;
+
+	mChannels.resize(size);
+	mNodeRefs.resize(size);
+	if (mTarget == TARGET_NODE3D) mNodes3d.resize(size);
+	else mNodes2d.resize(size);
+	mStart.resize(size);
+	mFirst.resize(size);
+	mPeriod.resize(size);
+	mInvPeriod.resize(size);
+	mLow.resize(size);
+	mHigh.resize(size);
+	mBase.resize(size);
+	mInvLength.resize(size);
+	mU.resize(size);
+
+	// the padding slots hold unit keys, so the kernels compute valid values for them
+	for (uint8_t c = 0; c < mComponents; ++c) {
+		mA[c].resize(size, 1.0f);
+		mB[c].resize(size, 1.0f);
+		mOut[c].resize(size);
+		if (mInterpolation == BEZIER) {
+			mC[c].resize(size, 1.0f);
+			mD[c].resize(size, 1.0f);
+		}
+	}
+}
+
+void AnimationSystem::Batch::move(size_t from, size_t to)
+{
+	mChannels[to] = mChannels[from];
+	mNodeRefs[to] = mNodeRefs[from];
+	if (mTarget == TARGET_NODE3D) mNodes3d[to] = mNodes3d[from];
+	else mNodes2d[to] = mNodes2d[from];
+	mStart[to] = mStart[from];
+	mFirst[to] = mFirst[from];
+	mPeriod[to] = mPeriod[from];
+	mInvPeriod[to] = mInvPeriod[from];
+	mLow[to] = mLow[from];
+	mHigh[to] = mHigh[from];
+	mBase[to] = mBase[from];
+	mInvLength[to] = mInvLength[from];
+	mU[to] = mU[from];
+
+	for (uint8_t c = 0; c < mComponents; ++c) {
+		mA[c][to] = mA[c][from];
+		mB[c][to] = mB[c][from];
+		if (mInterpolation == BEZIER) {
+			mC[c][to] = mC[c][from];
+			mD[c][to] = mD[c][from];
+		}
+	}
+}
+
+void AnimationSystem::insert(ChannelId id)
+{
+	Channel& channel = mChannels[id];
+	NodeRef node = channel.mNodeRef.lock();
+	if (!node) return;
+
+	Batch& batch = mBatches[channel.mBatch];
+	if (batch.mCount == batch.mU.size()) batch.grow();
+
+	channel.mSlot = static_cast<uint32_t>(batch.mCount++);
+	batch.mChannels[channel.mSlot] = id;
+	batch.mNodeRefs[channel.mSlot] = node;
+	if (batch.mTarget == TARGET_NODE3D) batch.mNodes3d[channel.mSlot] = static_cast<Node3d*>(node.get());
+	else batch.mNodes2d[channel.mSlot] = static_cast<Node2d*>(node.get());
+	reset(channel);
+}
+
+void AnimationSystem::remove(ChannelId id)
+{
+	Channel& channel = mChannels[id];
+	Batch& batch = mBatches[channel.mBatch];
+
+	size_t last = --batch.mCount;
+	if (channel.mSlot != last) {
+		batch.move(last, channel.mSlot);
+		mChannels[batch.mChannels[channel.mSlot]].mSlot = channel.mSlot;
+	}
+	batch.mNodeRefs[last].reset();
+	channel.mSlot = NO_SLOT;
+}
+
+void AnimationSystem::reset(const Channel& channel)
+{
+	Batch& batch = mBatches[channel.mBatch];
+	const size_t slot = channel.mSlot;
+	const float first = mKeyTimes[channel.mFirstKey];
+	const float last = mKeyTimes[channel.mFirstKey + channel.mKeyCount - 1];
+	const float period = (channel.mIsLooping && last > first)? last - first: 0.0f;
+
+	batch.mStart[slot] = channel.mStartTime;
+	batch.mFirst[slot] = first;
+	batch.mPeriod[slot] = period;
+	batch.mInvPeriod[slot] = (period > 0)? 1.0f / period: 0.0f;
+
+	// an empty range makes the next evaluation look up the segment
+	batch.mLow[slot] = numeric_limits<float>::infinity();
+	batch.mHigh[slot] = -numeric_limits<float>::infinity();
+}
+
+#pragma mark evaluation
+
+void AnimationSystem::update(double elapsed)
+{
+	mTime += static_cast<float>(elapsed);
+	evaluate(mTime);
+}
+
+void AnimationSystem::evaluate(float time)
+{
+	for (auto itr = mBatches.begin(); itr != mBatches.end(); ++itr) {
+		Batch& batch = *itr;
+
+		// channels of destroyed nodes leave their batch for good
+		for (size_t i = batch.mCount; i-- > 0;) {
+			if (batch.mNodeRefs[i].expired()) remove(batch.mChannels[i]);
+		}
+		if (!batch.mCount) continue;
+
+		locate(batch, time);
+		interpolate(batch);
+		write(batch);
+	}
+}
+
+void AnimationSystem::locate(Batch& batch, float time)
+{
+	// looping channels wrap the local time by local -= period * floor((local - first) / period),
+	// which leaves the local time of channels without a period untouched
+	const size_t count = batch.mCount;
+	size_t i = 0;
+#if defined(SCENE_ANIMATION_SSE)
+	const __m128 now = _mm_set1_ps(time);
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; i < count; i += 4) {
+		__m128 local = _mm_sub_ps(now, _mm_loadu_ps(&batch.mStart[i]));
+		__m128 loops = _mm_mul_ps(_mm_sub_ps(local, _mm_loadu_ps(&batch.mFirst[i])), _mm_loadu_ps(&batch.mInvPeriod[i]));
+		__m128 whole = _mm_cvtepi32_ps(_mm_cvttps_epi32(loops));
+		whole = _mm_sub_ps(whole, _mm_and_ps(_mm_cmplt_ps(loops, whole), one));
+		local = _mm_sub_ps(local, _mm_mul_ps(_mm_loadu_ps(&batch.mPeriod[i]), whole));
+
+		__m128 inside = _mm_and_ps(_mm_cmpge_ps(local, _mm_loadu_ps(&batch.mLow[i])), _mm_cmplt_ps(local, _mm_loadu_ps(&batch.mHigh[i])));
+		_mm_storeu_ps(&batch.mU[i], _mm_mul_ps(_mm_sub_ps(local, _mm_loadu_ps(&batch.mBase[i])), _mm_loadu_ps(&batch.mInvLength[i])));
+
+		// channels that left their segment, ignoring the padding slots
+		int lanes = (count - i >= 4)? 0xf: (1 << (count - i)) - 1;
+		int moved = ~_mm_movemask_ps(inside) & lanes;
+		if (moved) {
+			float locals[4];
+			_mm_storeu_ps(locals, local);
+			for (int lane = 0; lane < 4; ++lane) {
+				if (moved & (1 << lane)) seek(batch, i + lane, locals[lane]);
+			}
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		float local = time - batch.mStart[i];
+		local -= batch.mPeriod[i] * std::floor((local - batch.mFirst[i]) * batch.mInvPeriod[i]);
+
+		if (local >= batch.mLow[i] && local < batch.mHigh[i]) batch.mU[i] = (local - batch.mBase[i]) * batch.mInvLength[i];
+		else seek(batch, i, local);
+	}
+}
+
+void AnimationSystem::seek(Batch& batch, size_t slot, float local)
+{
+	Channel& channel = mChannels[batch.mChannels[slot]];
+	const float* times = &mKeyTimes[channel.mFirstKey];
+	const uint32_t count = channel.mKeyCount;
+	const float infinity = numeric_limits<float>::infinity();
+
+	// find the segment [k0, k1] that contains the local time, before and after the keys k0 == k1 holds the first or last one
+	uint32_t k0, k1;
+	float low, high;
+	if (count == 1) {
+		k0 = k1 = 0;
+		low = -infinity;
+		high = infinity;
+	}
+	else if (!(local >= times[0])) {
+		k0 = k1 = 0;
+		low = -infinity;
+		high = times[0];
+	}
+	else if (local >= times[count - 1]) {
+		k0 = k1 = count - 1;
+		low = times[count - 1];
+		high = infinity;
+	}
+	else {
+		uint32_t k = channel.mCursor;
+		if (k >= count - 1 || local < times[k]) {
+			// jumped backwards (loop or seek), search from scratch
+			k = static_cast<uint32_t>(std::upper_bound(times, times + count, local) - times) - 1;
+		}
+		while (local >= times[k + 1]) ++k;
+		channel.mCursor = k;
+
+		k0 = k;
+		k1 = k + 1;
+		low = times[k0];
+		high = times[k1];
+	}
+
+	batch.mLow[slot] = low;
+	batch.mHigh[slot] = high;
+	batch.mBase[slot] = (k0 != k1)? low: 0.0f;
+	batch.mInvLength[slot] = (k0 != k1)? 1.0f / (high - low): 0.0f;
+	batch.mU[slot] = (local - batch.mBase[slot]) * batch.mInvLength[slot];
+
+	const uint32_t i0 = channel.mFirstKey + k0;
+	const uint32_t i1 = channel.mFirstKey + k1;
+	for (uint8_t c = 0; c < batch.mComponents; ++c) {
+		batch.mA[c][slot] = mKeyValues[c][i0];
+		batch.mB[c][slot] = mKeyValues[c][i1];
+		if (batch.mInterpolation == BEZIER) {
+			batch.mC[c][slot] = mKeyOut[c][i0];
+			batch.mD[c][slot] = mKeyIn[c][i1];
+		}
+	}
+}
+
+void AnimationSystem::interpolate(Batch& batch)
+{
+	const size_t count = (batch.mCount + 3) & ~size_t(3);
+
+	if (batch.mInterpolation == SLERP) {
+		const float* const a[4] = { batch.mA[0].data(), batch.mA[1].data(), batch.mA[2].data(), batch.mA[3].data() };
+		const float* const b[4] = { batch.mB[0].data(), batch.mB[1].data(), batch.mB[2].data(), batch.mB[3].data() };
+		float* const out[4] = { batch.mOut[0].data(), batch.mOut[1].data(), batch.mOut[2].data(), batch.mOut[3].data() };
+		nlerp(batch.mU.data(), a, b, out, count);
+	}
+	else if (batch.mInterpolation == BEZIER) {
+		for (uint8_t c = 0; c < batch.mComponents; ++c) {
+			bezier(batch.mU.data(), batch.mA[c].data(), batch.mC[c].data(), batch.mD[c].data(), batch.mB[c].data(), batch.mOut[c].data(), count);
+		}
+	}
+	else {
+		for (uint8_t c = 0; c < batch.mComponents; ++c) {
+			lerp(batch.mU.data(), batch.mA[c].data(), batch.mB[c].data(), batch.mOut[c].data(), count);
+		}
+	}
+}
+
+void AnimationSystem::write(const Batch& batch)
+{
+	const float* const out[4] = { batch.mOut[0].data(), batch.mOut[1].data(), batch.mOut[2].data(), batch.mOut[3].data() };
+
+	if (batch.mTarget == TARGET_NODE3D) {
+		switch (batch.mProperty) {
+			case POSITION:	Node3d::setPositions(batch.mNodes3d.data(), out, batch.mCount); break;
+			case SCALE:		Node3d::setScales(batch.mNodes3d.data(), out, batch.mCount); break;
+			case ROTATION:	Node3d::setRotations(batch.mNodes3d.data(), out, batch.mCount); break;
+		}
+	}
+	else {
+		switch (batch.mProperty) {
+			case POSITION:	Node2d::setPositions(batch.mNodes2d.data(), out, batch.mCount); break;
+			case SCALE:		Node2d::setScales(batch.mNodes2d.data(), out, batch.mCount); break;
+			case ROTATION:	Node2d::setRotations(batch.mNodes2d.data(), out[0], batch.mCount); break;
+		}
+	}
+}
+
+#pragma mark kernels
+
+void AnimationSystem::lerp(const float* u, const float* a, const float* b, float* out, size_t count)
+{
+	size_t i = 0;
+#if defined(SCENE_ANIMATION_SSE)
+	for (; i + 4 <= count; i += 4) {
+		__m128 va = _mm_loadu_ps(a + i);
+		__m128 vb = _mm_loadu_ps(b + i);
+		__m128 vu = _mm_loadu_ps(u + i);
+		_mm_storeu_ps(out + i, _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), vu)));
+	}
+#endif
+	for (; i < count; ++i) {
+		out[i] = a[i] + (b[i] - a[i]) * u[i];
+	}
+}
+
+void AnimationSystem::bezier(const float* u, const float* a, const float* c, const float* d, const float* b, float* out, size_t count)
+{
+	size_t i = 0;
+#if defined(SCENE_ANIMATION_SSE)
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 three = _mm_set1_ps(3.0f);
+	for (; i + 4 <= count; i += 4) {
+		__m128 t = _mm_loadu_ps(u + i);
+		__m128 s = _mm_sub_ps(one, t);
+		__m128 ss = _mm_mul_ps(s, s);
+		__m128 tt = _mm_mul_ps(t, t);
+
+		// bernstein weights
+		__m128 w0 = _mm_mul_ps(ss, s);
+		__m128 w1 = _mm_mul_ps(three, _mm_mul_ps(ss, t));
+		__m128 w2 = _mm_mul_ps(three, _mm_mul_ps(s, tt));
+		__m128 w3 = _mm_mul_ps(tt, t);
+
+		__m128 r = _mm_mul_ps(w0, _mm_loadu_ps(a + i));
+		r = _mm_add_ps(r, _mm_mul_ps(w1, _mm_loadu_ps(c + i)));
+		r = _mm_add_ps(r, _mm_mul_ps(w2, _mm_loadu_ps(d + i)));
+		r = _mm_add_ps(r, _mm_mul_ps(w3, _mm_loadu_ps(b + i)));
+		_mm_storeu_ps(out + i, r);
+	}
+#endif
+	for (; i < count; ++i) {
+		float t = u[i];
+		float s = 1.0f - t;
+		out[i] = s * s * s * a[i] + 3.0f * s * s * t * c[i] + 3.0f * s * t * t * d[i] + t * t * t * b[i];
+	}
+}
+
+void AnimationSystem::nlerp(const float* u, const float* const a[4], const float* const b[4], float* const out[4], size_t count)
+{
+	// The interpolation parameter is adjusted with a cubic whose coefficients depend on the
+	// angle between the quaternions, which brings the angular velocity of nlerp close to slerp.
+	size_t i = 0;
+#if defined(SCENE_ANIMATION_SSE)
+	const __m128 sign_bit = _mm_set1_ps(-0.0f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 one = _mm_set1_ps(1.0f);
+	for (; i + 4 <= count; i += 4) {
+		__m128 ax = _mm_loadu_ps(a[0] + i), ay = _mm_loadu_ps(a[1] + i), az = _mm_loadu_ps(a[2] + i), aw = _mm_loadu_ps(a[3] + i);
+		__m128 bx = _mm_loadu_ps(b[0] + i), by = _mm_loadu_ps(b[1] + i), bz = _mm_loadu_ps(b[2] + i), bw = _mm_loadu_ps(b[3] + i);
+		__m128 t = _mm_loadu_ps(u + i);
+
+		// take the shorter arc by flipping b when the dot product is negative
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ax, bx), _mm_mul_ps(ay, by)), _mm_add_ps(_mm_mul_ps(az, bz), _mm_mul_ps(aw, bw)));
+		__m128 sign = _mm_and_ps(dot, sign_bit);
+		bx = _mm_xor_ps(bx, sign);
+		by = _mm_xor_ps(by, sign);
+		bz = _mm_xor_ps(bz, sign);
+		bw = _mm_xor_ps(bw, sign);
+		__m128 d = _mm_andnot_ps(sign_bit, dot);
+
+		// k = A * (t - 0.5)^2 + B
+		__m128 A = _mm_add_ps(_mm_set1_ps(3.55645f), _mm_mul_ps(d, _mm_set1_ps(-1.43519f)));
+		A = _mm_add_ps(_mm_set1_ps(-3.2452f), _mm_mul_ps(d, A));
+		A = _mm_add_ps(_mm_set1_ps(1.0904f), _mm_mul_ps(d, A));
+		__m128 B = _mm_add_ps(_mm_set1_ps(-1.06021f), _mm_mul_ps(d, _mm_set1_ps(0.215638f)));
+		B = _mm_add_ps(_mm_set1_ps(0.848013f), _mm_mul_ps(d, B));
+		__m128 th = _mm_sub_ps(t, half);
+		__m128 k = _mm_add_ps(_mm_mul_ps(A, _mm_mul_ps(th, th)), B);
+
+		// ot = t + t * (t - 0.5) * (t - 1) * k
+		__m128 ot = _mm_add_ps(t, _mm_mul_ps(_mm_mul_ps(t, th), _mm_mul_ps(_mm_sub_ps(t, one), k)));
+
+		__m128 rx = _mm_add_ps(ax, _mm_mul_ps(_mm_sub_ps(bx, ax), ot));
+		__m128 ry = _mm_add_ps(ay, _mm_mul_ps(_mm_sub_ps(by, ay), ot));
+		__m128 rz = _mm_add_ps(az, _mm_mul_ps(_mm_sub_ps(bz, az), ot));
+		__m128 rw = _mm_add_ps(aw, _mm_mul_ps(_mm_sub_ps(bw, aw), ot));
+
+		__m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_add_ps(_mm_mul_ps(rz, rz), _mm_mul_ps(rw, rw))));
+		__m128 inv = _mm_div_ps(one, len);
+		_mm_storeu_ps(out[0] + i, _mm_mul_ps(rx, inv));
+		_mm_storeu_ps(out[1] + i, _mm_mul_ps(ry, inv));
+		_mm_storeu_ps(out[2] + i, _mm_mul_ps(rz, inv));
+		_mm_storeu_ps(out[3] + i, _mm_mul_ps(rw, inv));
+	}
+#endif
+	for (; i < count; ++i) {
+		float t = u[i];
+		float dot = a[0][i] * b[0][i] + a[1][i] * b[1][i] + a[2][i] * b[2][i] + a[3][i] * b[3][i];
+		float flip = (dot < 0)? -1.0f: 1.0f;
+		float d = std::fabs(dot);
+
+		float A = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+		float B = 0.848013f + d * (-1.06021f + d * 0.215638f);
+		float k = A * (t - 0.5f) * (t - 0.5f) + B;
+		float ot = t + t * (t - 0.5f) * (t - 1.0f) * k;
+
+		float r[4];
+		for (int c = 0; c < 4; ++c) r[c] = a[c][i] + (flip * b[c][i] - a[c][i]) * ot;
+		float inv = 1.0f / std::sqrt(r[0] * r[0] + r[1] * r[1] + r[2] * r[2] + r[3] * r[3]);
+		for (int c = 0; c < 4; ++c) out[c][i] = r[c] * inv;
+	}
+}
@@ -0,0 +1,61 @@
+#include "ChangeJournal.h"
+#include "NodeBase.h"
+
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+ChangeJournal::ChangeJournal()
+:	mIsEnabled(false)
+{
+}
+
+ChangeJournal::~ChangeJournal()
+{
+	clear();
+}
+
+void ChangeJournal::setEnabled(bool enabled)
+{
+	if (!enabled) clear();
+	mIsEnabled = enabled;
+}
+
+void ChangeJournal::record(NodeBase& node, uint32_t changes)
+{
+	if (!mIsEnabled) return;
+
+	uint32_t index = node.mJournalIndex;
+	if (index == NodeBase::INVALID_JOURNAL_INDEX) {
+		index = static_cast<uint32_t>(mRecords.size());
+
+		Record record;
+		record.mNode = &node;
+		record.mId = node.getId();
+		record.mChanges = 0;
+		mRecords.push_back(record);
+		node.mJournalIndex = index;
+	}
+
+	Record& record = mRecords[index];
+	record.mChanges |= changes;
+
+	// the node may be destroyed after it left, further changes start a new record
+	if (changes & CHANGE_REMOVED) {
+		record.mNode = nullptr;
+		node.mJournalIndex = NodeBase::INVALID_JOURNAL_INDEX;
+	}
+}
+
+void ChangeJournal::clear()
+{
+	for (auto itr = mRecords.begin(); itr != mRecords.end(); ++itr) {
+		if (itr->mNode) itr->mNode->mJournalIndex = NodeBase::INVALID_JOURNAL_INDEX;
+	}
+	mRecords.clear();
+}
@@ -0,0 +1,427 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+#include "CompactMesh.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SCENE_COMPACT_MESH_SSE2
+	#include <emmintrin.h>
+#endif
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Upload the quantized attributes as normalized vertex attributes
+//			instead of a decoded copy
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	const float POSITION_STEPS = 65535.0f;
+	const float NORMAL_STEPS = 127.0f;
+
+	//! returns -1 for negative values and 1 otherwise, so the octahedral folding never maps to 0
+	float signNotZero(float value) { return value < 0.0f? -1.0f: 1.0f; }
+
+	//! decodes two 8 bit components of an octahedral normal
+	vec3 decodeOctahedral(float x, float y)
+	{
+		vec3 n(x, y, 1.0f - fabsf(x) - fabsf(y));
+		if (n.z < 0.0f) {
+			n.x = (1.0f - fabsf(y)) * signNotZero(x);
+			n.y = (1.0f - fabsf(x)) * signNotZero(y);
+		}
+		return glm::normalize(n);
+	}
+
+	//! tests a ray against a triangle (Moller-Trumbore), from either side, and lowers the nearest hit
+	void intersectTriangle(const vec3& origin, const vec3& direction, const vec3& v0, const vec3& v1, const vec3& v2, float& nearest)
+	{
+		vec3 e1 = v1 - v0;
+		vec3 e2 = v2 - v0;
+		vec3 p = glm::cross(direction, e2);
+		float det = glm::dot(e1, p);
+		if (det == 0.0f) return;
+
+		float inv = 1.0f / det;
+		vec3 s = origin - v0;
+		float u = glm::dot(s, p) * inv;
+		vec3 q = glm::cross(s, e1);
+		float v = glm::dot(direction, q) * inv;
+		float t = glm::dot(e2, q) * inv;
+		if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f && t < nearest) nearest = t;
+	}
+
+	/**
+	 * Tests a ray against a run of triangles in the quantized space of the positions and
+	 * returns the parameter of the nearest hit, FLT_MAX if there is none.
+	 */
+	template<typename IndexT>
+	float intersectTriangles(const IndexT* indices, size_t triangles, const uint16_t* const positions[3], const vec3& origin, const vec3& direction)
+	{
+		float nearest = FLT_MAX;
+		size_t tri = 0;
+
+#if defined(SCENE_COMPACT_MESH_SSE2)
+		// four triangles at a time, the corners are gathered into one lane each
+		const __m128 ox = _mm_set1_ps(origin.x), oy = _mm_set1_ps(origin.y), oz = _mm_set1_ps(origin.z);
+		const __m128 dx = _mm_set1_ps(direction.x), dy = _mm_set1_ps(direction.y), dz = _mm_set1_ps(direction.z);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		__m128 best = _mm_set1_ps(FLT_MAX);
+
+		for (; tri + 4 <= triangles; tri += 4) {
+			float corners[9][4];
+			for (int lane = 0; lane < 4; ++lane) {
+				const IndexT* triangle = indices + (tri + lane) * 3;
+				for (int corner = 0; corner < 3; ++corner) {
+					size_t vertex = triangle[corner];
+					corners[corner * 3 + 0][lane] = positions[0][vertex];
+					corners[corner * 3 + 1][lane] = positions[1][vertex];
+					corners[corner * 3 + 2][lane] = positions[2][vertex];
+				}
+			}
+			__m128 v0x = _mm_loadu_ps(corners[0]), v0y = _mm_loadu_ps(corners[1]), v0z = _mm_loadu_ps(corners[2]);
+			__m128 e1x = _mm_sub_ps(_mm_loadu_ps(corners[3]), v0x);
+			__m128 e1y = _mm_sub_ps(_mm_loadu_ps(corners[4]), v0y);
+			__m128 e1z = _mm_sub_ps(_mm_loadu_ps(corners[5]), v0z);
+			__m128 e2x = _mm_sub_ps(_mm_loadu_ps(corners[6]), v0x);
+			__m128 e2y = _mm_sub_ps(_mm_loadu_ps(corners[7]), v0y);
+			__m128 e2z = _mm_sub_ps(_mm_loadu_ps(corners[8]), v0z);
+
+			// p = direction x e2
+			__m128 px = _mm_sub_ps(_mm_mul_ps(dy, e2z), _mm_mul_ps(dz, e2y));
+			__m128 py = _mm_sub_ps(_mm_mul_ps(dz, e2x), _mm_mul_ps(dx, e2z));
+			__m128 pz = _mm_sub_ps(_mm_mul_ps(dx, e2y), _mm_mul_ps(dy, e2x));
+			__m128 det = _mm_add_ps(_mm_add_ps(_mm_mul_ps(e1x, px), _mm_mul_ps(e1y, py)), _mm_mul_ps(e1z, pz));
+			__m128 inv = _mm_div_ps(one, det);
+
+			// s = origin - v0, q = s x e1
+			__m128 sx = _mm_sub_ps(ox, v0x), sy = _mm_sub_ps(oy, v0y), sz = _mm_sub_ps(oz, v0z);
+			__m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, px), _mm_mul_ps(sy, py)), _mm_mul_ps(sz, pz)), inv);
+			__m128 qx = _mm_sub_ps(_mm_mul_ps(sy, e1z), _mm_mul_ps(sz, e1y));
+			__m128 qy = _mm_sub_ps(_mm_mul_ps(sz, e1x), _mm_mul_ps(sx, e1z));
+			__m128 qz = _mm_sub_ps(_mm_mul_ps(sx, e1y), _mm_mul_ps(sy, e1x));
+			__m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, qx), _mm_mul_ps(dy, qy)), _mm_mul_ps(dz, qz)), inv);
+			__m128 t = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(e2x, qx), _mm_mul_ps(e2y, qy)), _mm_mul_ps(e2z, qz)), inv);
+
+			// comparisons against NaN fail, so degenerate triangles drop out with det != 0
+			__m128 hit = _mm_cmpneq_ps(det, zero);
+			hit = _mm_and_ps(hit, _mm_cmpge_ps(u, zero));
+			hit = _mm_and_ps(hit, _mm_cmpge_ps(v, zero));
+			hit = _mm_and_ps(hit, _mm_cmple_ps(_mm_add_ps(u, v), one));
+			hit = _mm_and_ps(hit, _mm_cmpgt_ps(t, zero));
+			best = _mm_min_ps(best, _mm_or_ps(_mm_and_ps(hit, t), _mm_andnot_ps(hit, best)));
+		}
+
+		float lanes[4];
+		_mm_storeu_ps(lanes, best);
+		nearest = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+#endif
+
+		for (; tri < triangles; ++tri) {
+			const IndexT* triangle = indices + tri * 3;
+			vec3 v[3];
+			for (int corner = 0; corner < 3; ++corner) v[corner] = vec3(positions[0][triangle[corner]], positions[1][triangle[corner]], positions[2][triangle[corner]]);
+			intersectTriangle(origin, direction, v[0], v[1], v[2], nearest);
+		}
+		return nearest;
+	}
+
+#if defined(SCENE_COMPACT_MESH_SSE2)
+	//! converts four quantized values to floats
+	inline __m128 loadQuantized(const uint16_t* values)
+	{
+		__m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(values));
+		return _mm_cvtepi32_ps(_mm_unpacklo_epi16(packed, _mm_setzero_si128()));
+	}
+#endif
+}
+
+atomic<uint64_t> CompactMesh::sNextId(0);
+
+CompactMesh::CompactMesh(const TriMesh& mesh)
+:	mId(sNextId++), mOffset(0.0f), mStep(0.0f)
+{
+	size_t vertex_count = mesh.getNumVertices();
+	const vec3* positions = mesh.getPositions<3>();
+
+	if (vertex_count) {
+		vec3 min = positions[0];
+		vec3 max = positions[0];
+		for (size_t i = 1; i < vertex_count; ++i) {
+			min = glm::min(min, positions[i]);
+			max = glm::max(max, positions[i]);
+		}
+		mBounds = AxisAlignedBox(min, max);
+		mOffset = min;
+		mStep = (max - min) / POSITION_STEPS;
+	}
+
+	// the extremes map to 0 and 65535, so the rounding error is at most half a step
+	for (int axis = 0; axis < 3; ++axis) {
+		mPositions[axis].resize(vertex_count);
+		float scale = mStep[axis] > 0.0f? 1.0f / mStep[axis]: 0.0f;
+		for (size_t i = 0; i < vertex_count; ++i) {
+			float value = (positions[i][axis] - mOffset[axis]) * scale + 0.5f;
+			mPositions[axis][i] = static_cast<uint16_t>(std::min(std::max(value, 0.0f), POSITION_STEPS));
+		}
+	}
+
+	if (mesh.hasNormals() && mesh.getNormals().size() == vertex_count) {
+		const vector<vec3>& normals = mesh.getNormals();
+		mNormals.resize(vertex_count);
+		for (size_t i = 0; i < vertex_count; ++i) mNormals[i] = encodeNormal(normals[i]);
+	}
+
+	if (mesh.hasTexCoords0()) {
+		const vec2* texcoords = mesh.getTexCoords0<2>();
+		mTexCoords.resize(vertex_count * 2);
+		for (size_t i = 0; i < vertex_count; ++i) {
+			mTexCoords[i * 2] = encodeHalf(texcoords[i].x);
+			mTexCoords[i * 2 + 1] = encodeHalf(texcoords[i].y);
+		}
+	}
+
+	const vector<uint32_t>& indices = mesh.getIndices();
+	if (vertex_count <= 0x10000) mShortIndices.assign(indices.begin(), indices.end());
+	else mIndices = indices;
+}
+
+vec3 CompactMesh::getNormal(size_t vertex) const
+{
+	return decodeNormal(mNormals[vertex]);
+}
+
+vec2 CompactMesh::getTexCoord0(size_t vertex) const
+{
+	return vec2(decodeHalf(mTexCoords[vertex * 2]), decodeHalf(mTexCoords[vertex * 2 + 1]));
+}
+
+void CompactMesh::decodePositions(size_t first, size_t count, vec3* out) const
+{
+	size_t i = first;
+	size_t end = first + count;
+
+#if defined(SCENE_COMPACT_MESH_SSE2)
+	const __m128 offset_x = _mm_set1_ps(mOffset.x), offset_y = _mm_set1_ps(mOffset.y), offset_z = _mm_set1_ps(mOffset.z);
+	const __m128 step_x = _mm_set1_ps(mStep.x), step_y = _mm_set1_ps(mStep.y), step_z = _mm_set1_ps(mStep.z);
+
+	for (; i + 4 <= end; i += 4) {
+		float x[4], y[4], z[4];
+		_mm_storeu_ps(x, _mm_add_ps(offset_x, _mm_mul_ps(step_x, loadQuantized(&mPositions[0][i]))));
+		_mm_storeu_ps(y, _mm_add_ps(offset_y, _mm_mul_ps(step_y, loadQuantized(&mPositions[1][i]))));
+		_mm_storeu_ps(z, _mm_add_ps(offset_z, _mm_mul_ps(step_z, loadQuantized(&mPositions[2][i]))));
+		for (int lane = 0; lane < 4; ++lane) *out++ = vec3(x[lane], y[lane], z[lane]);
+	}
+#endif
+
+	for (; i < end; ++i) *out++ = getPosition(i);
+}
+
+AxisAlignedBox CompactMesh::calcBounds(const mat4& transform) const
+{
+	size_t vertex_count = getNumVertices();
+	if (!vertex_count) return mBounds;
+
+	// the transformation and the dequantization are folded into one affine map of the quantized values
+	vec3 axis_x = vec3(transform[0]) * mStep.x;
+	vec3 axis_y = vec3(transform[1]) * mStep.y;
+	vec3 axis_z = vec3(transform[2]) * mStep.z;
+	vec3 origin = vec3(transform * vec4(mOffset, 1.0f));
+
+	vec3 min(FLT_MAX);
+	vec3 max(-FLT_MAX);
+	size_t i = 0;
+
+#if defined(SCENE_COMPACT_MESH_SSE2)
+	__m128 min_v[3], max_v[3];
+	for (int c = 0; c < 3; ++c) {
+		min_v[c] = _mm_set1_ps(FLT_MAX);
+		max_v[c] = _mm_set1_ps(-FLT_MAX);
+	}
+
+	for (; i + 4 <= vertex_count; i += 4) {
+		__m128 qx = loadQuantized(&mPositions[0][i]);
+		__m128 qy = loadQuantized(&mPositions[1][i]);
+		__m128 qz = loadQuantized(&mPositions[2][i]);
+		for (int c = 0; c < 3; ++c) {
+			__m128 value = _mm_add_ps(_mm_set1_ps(origin[c]), _mm_mul_ps(_mm_set1_ps(axis_x[c]), qx));
+			value = _mm_add_ps(value, _mm_mul_ps(_mm_set1_ps(axis_y[c]), qy));
+			value = _mm_add_ps(value, _mm_mul_ps(_mm_set1_ps(axis_z[c]), qz));
+			min_v[c] = _mm_min_ps(min_v[c], value);
+			max_v[c] = _mm_max_ps(max_v[c], value);
+		}
+	}
+
+	for (int c = 0; c < 3; ++c) {
+		float lanes[4];
+		_mm_storeu_ps(lanes, min_v[c]);
+		min[c] = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+		_mm_storeu_ps(lanes, max_v[c]);
+		max[c] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+	}
+#endif
+
+	for (; i < vertex_count; ++i) {
+		vec3 value = origin + axis_x * float(mPositions[0][i]) + axis_y * float(mPositions[1][i]) + axis_z * float(mPositions[2][i]);
+		min = glm::min(min, value);
+		max = glm::max(max, value);
+	}
+	return AxisAlignedBox(min, max);
+}
+
+bool CompactMesh::intersect(const Ray& ray, float* distance) const
+{
+	// the ray parameter of a hit survives the affine map into the quantized space,
+	// an axis of zero extent keeps its scale since all its values are 0 anyway
+	vec3 scale;
+	for (int axis = 0; axis < 3; ++axis) scale[axis] = mStep[axis] > 0.0f? 1.0f / mStep[axis]: 1.0f;
+	vec3 origin = (ray.getOrigin() - mOffset) * scale;
+	vec3 direction = ray.getDirection() * scale;
+
+	const uint16_t* const positions[3] = { mPositions[0].data(), mPositions[1].data(), mPositions[2].data() };
+	float nearest = mIndices.empty()?
+		intersectTriangles(mShortIndices.data(), getNumTriangles(), positions, origin, direction):
+		intersectTriangles(mIndices.data(), getNumTriangles(), positions, origin, direction);
+
+	if (nearest == FLT_MAX) return false;
+	if (distance) *distance = nearest;
+	return true;
+}
+
+void CompactMesh::decode(TriMesh& mesh) const
+{
+	size_t vertex_count = getNumVertices();
+
+	TriMesh::Format format = TriMesh::Format().positions(3);
+	if (hasNormals()) format.normals();
+	if (hasTexCoords0()) format.texCoords0(2);
+	mesh = TriMesh(format);
+
+	vector<vec3> positions(vertex_count);
+	decodePositions(0, vertex_count, positions.data());
+	mesh.appendPositions(positions.data(), positions.size());
+
+	if (hasNormals()) {
+		vector<vec3> normals(vertex_count);
+		for (size_t i = 0; i < vertex_count; ++i) normals[i] = getNormal(i);
+		mesh.appendNormals(normals.data(), normals.size());
+	}
+
+	if (hasTexCoords0()) {
+		vector<vec2> texcoords(vertex_count);
+		for (size_t i = 0; i < vertex_count; ++i) texcoords[i] = getTexCoord0(i);
+		mesh.appendTexCoords0(texcoords.data(), texcoords.size());
+	}
+
+	if (mIndices.empty()) {
+		vector<uint32_t> indices(mShortIndices.begin(), mShortIndices.end());
+		mesh.appendIndices(indices.data(), indices.size());
+	}
+	else mesh.appendIndices(mIndices.data(), mIndices.size());
+}
+
+size_t CompactMesh::getMemorySize() const
+{
+	return (mPositions[0].size() * 3 + mNormals.size() + mTexCoords.size() + mShortIndices.size()) * sizeof(uint16_t) + mIndices.size() * sizeof(uint32_t);
+}
+
+size_t CompactMesh::calcMemorySize(const TriMesh& mesh)
+{
+	size_t vertex_count = mesh.getNumVertices();
+	size_t size = vertex_count * sizeof(vec3) + mesh.getNumIndices() * sizeof(uint32_t);
+	if (mesh.hasNormals()) size += vertex_count * sizeof(vec3);
+	if (mesh.hasTexCoords0()) size += vertex_count * sizeof(vec2);
+	return size;
+}
+
+uint16_t CompactMesh::encodeNormal(const vec3& normal)
+{
+	float length = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+	if (!(length > 0.0f)) return encodeNormal(vec3(0.0f, 0.0f, 1.0f));
+
+	// project onto the octahedron and fold the lower half over the upper one
+	vec3 n = normal / length;
+	vec2 folded(n.x, n.y);
+	if (n.z < 0.0f) folded = vec2((1.0f - fabsf(n.y)) * signNotZero(n.x), (1.0f - fabsf(n.x)) * signNotZero(n.y));
+
+	// of the four neighboring grid points, keep the one that decodes closest to the normal
+	vec3 unit = glm::normalize(normal);
+	float base_x = floorf(folded.x * NORMAL_STEPS);
+	float base_y = floorf(folded.y * NORMAL_STEPS);
+	int best_x = 0, best_y = 0;
+	float best_dot = -2.0f;
+	for (int i = 0; i < 4; ++i) {
+		int x = static_cast<int>(std::min(std::max(base_x + float(i & 1), -NORMAL_STEPS), NORMAL_STEPS));
+		int y = static_cast<int>(std::min(std::max(base_y + float(i >> 1), -NORMAL_STEPS), NORMAL_STEPS));
+		float d = glm::dot(decodeOctahedral(x / NORMAL_STEPS, y / NORMAL_STEPS), unit);
+		if (d > best_dot) {
+			best_dot = d;
+			best_x = x;
+			best_y = y;
+		}
+	}
+	return static_cast<uint16_t>(static_cast<uint8_t>(static_cast<int8_t>(best_x)) | (static_cast<uint8_t>(static_cast<int8_t>(best_y)) << 8));
+}
+
+vec3 CompactMesh::decodeNormal(uint16_t encoded)
+{
+	float x = std::max(static_cast<int8_t>(encoded & 0xff) / NORMAL_STEPS, -1.0f);
+	float y = std::max(static_cast<int8_t>(encoded >> 8) / NORMAL_STEPS, -1.0f);
+	return decodeOctahedral(x, y);
+}
+
+uint16_t CompactMesh::encodeHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = bits & 0x80000000u;
+	bits ^= sign;
+
+	uint16_t half;
+	if (bits >= 0x47800000u) {
+		// too large for a half, infinity or NaN
+		half = bits > 0x7f800000u? 0x7e00: 0x7c00;
+	}
+	else if (bits < 0x38800000u) {
+		// a subnormal half, the float addition does the rounding
+		const uint32_t magic_bits = 0x3f000000u;
+		float magic;
+		float abs_value;
+		memcpy(&magic, &magic_bits, sizeof(magic));
+		memcpy(&abs_value, &bits, sizeof(abs_value));
+		abs_value += magic;
+		memcpy(&bits, &abs_value, sizeof(bits));
+		half = static_cast<uint16_t>(bits - magic_bits);
+	}
+	else {
+		// rebias the exponent and round the mantissa to nearest even
+		uint32_t odd = (bits >> 13) & 1;
+		bits += 0xc8000fffu + odd;
+		half = static_cast<uint16_t>(bits >> 13);
+	}
+	return static_cast<uint16_t>(half | (sign >> 16));
+}
+
+float CompactMesh::decodeHalf(uint16_t value)
+{
+	uint32_t sign = uint32_t(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1f;
+	uint32_t mantissa = value & 0x3ff;
+
+	if (exponent == 0) {
+		float magnitude = ldexpf(static_cast<float>(mantissa), -24);
+		return sign? -magnitude: magnitude;
+	}
+
+	uint32_t bits = exponent == 0x1f? (sign | 0x7f800000u | (mantissa << 13)): (sign | ((exponent + 112) << 23) | (mantissa << 13));
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
@@ -13,6 +13,9 @@ using namespace scene;
 //
 ///////////////////////////////////////////////////////////////////////////
 
+ComponentFactoryRef ComponentFactory::sInstance;
+size_t ComponentFactory::sNextTypeIndex = 0;
+
 ComponentFactory::ComponentFactory()
 {
 }
@@ -28,41 +31,65 @@ void ComponentFactory::setup()
 
 void ComponentFactory::update(double elapsed)
 {
-	// update all components
+	// update polymorphic components
+	for (auto itr = mComponents.begin(); itr != mComponents.end(); ++itr) {
+		(*itr)->update(elapsed);
+	}
+	
+	// update pooled components, one linear sweep per type
+	for (auto itr = mPools.begin(); itr != mPools.end(); ++itr) {
+		if (*itr) (*itr)->update(elapsed);
+	}
 }
 
-ComponentRef ComponentFactory::instantiate(const std::string& name)
+ComponentHandle ComponentFactory::instantiate(const std::string& name)
 {
-	ComponentRef comp(new ComponentBase(name));
-	
-	mComponents.push_back(comp);
-	
-	return comp;
+	return addComponent(std::unique_ptr<ComponentBase>(new ComponentBase(name)));
 }
 
-bool ComponentFactory::addComponent(ComponentRef comp)
+void ComponentFactory::detachAll(uint64_t entity)
 {
-	if (!comp) return false;
+	for (auto itr = mPools.begin(); itr != mPools.end(); ++itr) {
+		if (*itr) (*itr)->remove(entity);
+	}
+}
+
+ComponentHandle ComponentFactory::addComponent(std::unique_ptr<ComponentBase> comp)
+{
+	if (!comp) return ComponentHandle();
 	
-	mComponents.push_back(comp);
+	std::string name = comp->getName();
+	ComponentHandle handle = mComponents.insert(std::move(comp));
+	mComponentNames[name] = handle;
 	
-	return true;
+	return handle;
 }
 
-bool ComponentFactory::removeComponent(ComponentRef comp)
+ComponentBase* ComponentFactory::getComponent(const ComponentHandle& handle) const
 {
-	if (!comp) return false;
-	
-	int s = mComponents.size();
-	remove(mComponents.begin(), mComponents.end(), comp);
-	return s != mComponents.size();
+	const std::unique_ptr<ComponentBase>* comp = mComponents.get(handle);
+	return comp? comp->get(): nullptr;
+}
+
+ComponentHandle ComponentFactory::getComponentByName(const std::string& name) const
+{
+	auto itr = mComponentNames.find(name);
+	return (itr != mComponentNames.end())? itr->second: ComponentHandle();
 }
 
-ComponentRef ComponentFactory::getComponentByName(const std::string& name) const
+bool ComponentFactory::destroyComponent(const ComponentHandle& handle)
 {
+	ComponentBase* comp = getComponent(handle);
+	if (!comp) return false;
+	
+	mComponentNames.erase(comp->getName());
+	mComponents.remove(handle);
+	
+	return true;
 }
 
-bool ComponentFactory::clearComponents()
+void ComponentFactory::clearComponents()
 {
 	mComponents.clear();
+	mComponentNames.clear();
 }
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <limits>
+
+#include "DamageTracker.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	inline Rectf unionOf(const Rectf& lhs, const Rectf& rhs)
+	{
+		Rectf out(lhs);
+		out.include(rhs);
+		return out;
+	}
+}
+
+DamageTracker::DamageTracker(size_t max_rects)
+:	mMaxRects(std::max<size_t>(max_rects, 1))
+{
+}
+
+bool DamageTracker::overlaps(const Rectf& lhs, const Rectf& rhs)
+{
+	return lhs.getX1() < rhs.getX2() && rhs.getX1() < lhs.getX2() &&
+		   lhs.getY1() < rhs.getY2() && rhs.getY1() < lhs.getY2();
+}
+
+void DamageTracker::add(const Rectf& rect)
+{
+	Rectf merged = rect.canonicalized();
+	if (isEmpty(merged)) return;
+
+	// absorb every rectangle the new one overlaps, growing it as we go
+	bool absorbed = true;
+	while (absorbed) {
+		absorbed = false;
+		for (auto itr = mRects.begin(); itr != mRects.end(); ++itr) {
+			if (overlaps(*itr, merged)) {
+				merged = unionOf(*itr, merged);
+				mRects.erase(itr);
+				absorbed = true;
+				break;
+			}
+		}
+	}
+
+	mRects.push_back(merged);
+	reduce();
+}
+
+void DamageTracker::reduce()
+{
+	while (mRects.size() > mMaxRects) {
+		// find the pair whose union adds the least area that was not damaged
+		size_t best_i = 0, best_j = 1;
+		float best_cost = std::numeric_limits<float>::max();
+		for (size_t i = 0; i < mRects.size(); ++i) {
+			for (size_t j = i + 1; j < mRects.size(); ++j) {
+				float cost = unionOf(mRects[i], mRects[j]).calcArea() - mRects[i].calcArea() - mRects[j].calcArea();
+				if (cost < best_cost) {
+					best_cost = cost;
+					best_i = i;
+					best_j = j;
+				}
+			}
+		}
+
+		Rectf merged = unionOf(mRects[best_i], mRects[best_j]);
+		mRects.erase(mRects.begin() + best_j);
+		mRects.erase(mRects.begin() + best_i);
+
+		// the union may now overlap others, add() merges those
+		add(merged);
+	}
+}
+
+Rectf DamageTracker::getBounds() const
+{
+	if (mRects.empty()) return Rectf(0, 0, 0, 0);
+
+	Rectf bounds = mRects.front();
+	for (auto itr = mRects.begin() + 1; itr != mRects.end(); ++itr) {
+		bounds.include(*itr);
+	}
+
+	return bounds;
+}
+
+bool DamageTracker::intersects(const Rectf& rect) const
+{
+	for (auto itr = mRects.begin(); itr != mRects.end(); ++itr) {
+		if (overlaps(*itr, rect)) return true;
+	}
+
+	return false;
+}
+
+void DamageTracker::setMaxRects(size_t max_rects)
+{
+	mMaxRects = std::max<size_t>(max_rects, 1);
+	reduce();
+}
@@ -0,0 +1,163 @@
+#include <cstring>
+#include <limits>
+
+#include "DepthSort.h"
+#include "Node3d.h"
+#include "SceneSnapshot.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	const uint32_t kRadixBits = 11;
+	const uint32_t kRadixSize = 1 << kRadixBits;
+	const uint32_t kRadixMask = kRadixSize - 1;
+	const uint32_t kRadixPasses = 3;	// 3 x 11 bits covers the full 32-bit key
+
+	// view space z of a world space point (the camera looks down the negative z-axis)
+	inline float viewDepth(const mat4& view, const vec3& pt)
+	{
+		return view[0][2] * pt.x + view[1][2] * pt.y + view[2][2] * pt.z + view[3][2];
+	}
+}
+
+uint32_t DepthSorter::toSortableKey(float value)
+{
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+
+	// negative floats have their order reversed, positive floats just need the sign bit set
+	return (bits & 0x80000000)? ~bits: (bits | 0x80000000);
+}
+
+void DepthSorter::radixSort(vector<uint32_t>& keys, vector<uint32_t>& order,
+							vector<uint32_t>& key_scratch, vector<uint32_t>& order_scratch)
+{
+	const size_t count = keys.size();
+
+	order.resize(count);
+	for (size_t i = 0; i < count; ++i) order[i] = static_cast<uint32_t>(i);
+	if (count < 2) return;
+
+	key_scratch.resize(count);
+	order_scratch.resize(count);
+
+	// build the histograms for all passes at once
+	uint32_t histograms[kRadixPasses][kRadixSize];
+	std::memset(histograms, 0, sizeof(histograms));
+	for (size_t i = 0; i < count; ++i) {
+		uint32_t key = keys[i];
+		for (uint32_t pass = 0; pass < kRadixPasses; ++pass) {
+			histograms[pass][(key >> (pass * kRadixBits)) & kRadixMask]++;
+		}
+	}
+
+	uint32_t* src_keys = keys.data();
+	uint32_t* src_order = order.data();
+	uint32_t* dst_keys = key_scratch.data();
+	uint32_t* dst_order = order_scratch.data();
+
+	for (uint32_t pass = 0; pass < kRadixPasses; ++pass) {
+		uint32_t* histogram = histograms[pass];
+		uint32_t shift = pass * kRadixBits;
+
+		// skip the pass if every key has the same digit
+		if (histogram[(src_keys[0] >> shift) & kRadixMask] == count) continue;
+
+		// exclusive prefix sum gives the output offset of each bucket
+		uint32_t sum = 0;
+		for (uint32_t i = 0; i < kRadixSize; ++i) {
+			uint32_t c = histogram[i];
+			histogram[i] = sum;
+			sum += c;
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			uint32_t key = src_keys[i];
+			uint32_t dst = histogram[(key >> shift) & kRadixMask]++;
+			dst_keys[dst] = key;
+			dst_order[dst] = src_order[i];
+		}
+
+		std::swap(src_keys, dst_keys);
+		std::swap(src_order, dst_order);
+	}
+
+	// make sure the result ends up in the output vectors
+	if (src_order != order.data()) {
+		std::memcpy(order.data(), src_order, count * sizeof(uint32_t));
+		std::memcpy(keys.data(), src_keys, count * sizeof(uint32_t));
+	}
+}
+
+void DepthSorter::pushDepth(float view_z, SortOrder order)
+{
+	// distance in front of the camera grows as the view space z decreases
+	uint32_t key = toSortableKey(-view_z);
+	mKeys.push_back(order == FRONT_TO_BACK? key: ~key);
+}
+
+const vector<uint32_t>& DepthSorter::finish()
+{
+	radixSort(mKeys, mOrder, mKeyScratch, mOrderScratch);
+	return mOrder;
+}
+
+const vector<uint32_t>& DepthSorter::sort(const mat4& view, const vec3* positions, size_t count, SortOrder order)
+{
+	mKeys.clear();
+	mKeys.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		pushDepth(viewDepth(view, positions[i]), order);
+	}
+
+	return finish();
+}
+
+const vector<uint32_t>& DepthSorter::sort(const mat4& view, const NodeDeque& nodes, SortOrder order)
+{
+	mKeys.clear();
+	mKeys.reserve(nodes.size());
+	for (auto itr = nodes.begin(); itr != nodes.end(); ++itr) {
+		const Node3d* node = dynamic_cast<const Node3d*>(itr->get());
+		if (node) {
+			const mat4& world = node->getWorldTransform();
+			pushDepth(viewDepth(view, vec3(world[3].x, world[3].y, world[3].z)), order);
+		}
+		else {
+			mKeys.push_back(std::numeric_limits<uint32_t>::max());
+		}
+	}
+
+	return finish();
+}
+
+const vector<uint32_t>& DepthSorter::sort(const mat4& view, const SceneSnapshot& snapshot, SortOrder order)
+{
+	const vector<SnapshotItem>& items = snapshot.getItems();
+
+	// sort only the visible items, then map back to snapshot indices
+	mKeys.clear();
+	mKeys.reserve(items.size());
+	mMapping.clear();
+	for (uint32_t i = 0; i < items.size(); ++i) {
+		if (!items[i].mIsVisible) continue;
+		const mat4& world = items[i].mWorldTransform;
+		pushDepth(viewDepth(view, vec3(world[3].x, world[3].y, world[3].z)), order);
+		mMapping.push_back(i);
+	}
+
+	finish();
+	for (size_t i = 0; i < mOrder.size(); ++i) {
+		mOrder[i] = mMapping[mOrder[i]];
+	}
+
+	return mOrder;
+}
@@ -0,0 +1,328 @@
+#include <algorithm>
+
+#include "EventDispatcher.h"
+#include "SceneContext.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Dispatch to Node3d trees by ray casting against world space boxes
+//
+///////////////////////////////////////////////////////////////////////////
+
+EventDispatcher::EventDispatcher(const Node2dRef& root)
+:	mRoot(root), mIsDirty(true), mNeedsRefit(false), mRebuildCount(0), mLastTestCount(0), mHitTestCount(0), mHoverPosition(0), mHasHover(false),
+	mHasMotion(false), mMotionType(PointerEvent::POINTER_MOVE), mMotionPosition(0), mMotionButton(0)
+{
+}
+
+void EventDispatcher::setRoot(const Node2dRef& root)
+{
+	mRoot = root;
+	mCapture.reset();
+	mHover.reset();
+	mHasHover = false;
+	mHasMotion = false;
+	mIsDirty = true;
+}
+
+#pragma mark hierarchy
+
+void EventDispatcher::collect(const NodeRef& node, uint32_t& order)
+{
+	// inactive nodes hide their whole subtree
+	if (!node->isActive()) return;
+
+	Node2d* node2d = dynamic_cast<Node2d*>(node.get());
+	if (node2d && node->isInteractive()) {
+		Item item;
+		item.mNode = node;
+		item.mBounds = node2d->getContentBounds().transformed(node2d->getWorldTransform());
+		item.mOrder = order;
+		mItems.push_back(item);
+	}
+	++order;
+
+	const NodeDeque& children = node->getChildren();
+	for (auto itr = children.begin(); itr != children.end(); ++itr) collect(*itr, order);
+}
+
+void EventDispatcher::rebuild()
+{
+	mItems.clear();
+	mNodes.clear();
+	mIsDirty = false;
+	mNeedsRefit = false;
+	++mRebuildCount;
+
+	Node2dRef root = mRoot.lock();
+	if (!root) return;
+
+	uint32_t order = 0;
+	collect(root, order);
+	if (mItems.empty()) return;
+
+	mNodes.reserve(2 * mItems.size() / LEAF_SIZE + 1);
+	mNodes.push_back(BvhNode());
+	build(0, 0, static_cast<uint32_t>(mItems.size()));
+}
+
+void EventDispatcher::build(uint32_t index, uint32_t first, uint32_t count)
+{
+	Rectf bounds = mItems[first].mBounds;
+	Rectf centers(mItems[first].mBounds.getCenter(), mItems[first].mBounds.getCenter());
+	uint32_t max_order = 0;
+	for (uint32_t i = first; i < first + count; ++i) {
+		bounds.include(mItems[i].mBounds);
+		centers.include(mItems[i].mBounds.getCenter());
+		max_order = std::max(max_order, mItems[i].mOrder);
+	}
+
+	mNodes[index].mBounds = bounds;
+	mNodes[index].mMaxOrder = max_order;
+
+	if (count <= LEAF_SIZE) {
+		mNodes[index].mFirst = first;
+		mNodes[index].mCount = count;
+		return;
+	}
+
+	// split at the median center along the longest axis
+	uint32_t half = count / 2;
+	auto begin = mItems.begin() + first;
+	if (centers.getWidth() >= centers.getHeight()) {
+		std::nth_element(begin, begin + half, begin + count, [](const Item& a, const Item& b) { return a.mBounds.getCenter().x < b.mBounds.getCenter().x; });
+	}
+	else {
+		std::nth_element(begin, begin + half, begin + count, [](const Item& a, const Item& b) { return a.mBounds.getCenter().y < b.mBounds.getCenter().y; });
+	}
+
+	uint32_t left = static_cast<uint32_t>(mNodes.size());
+	mNodes.push_back(BvhNode());
+	mNodes.push_back(BvhNode());
+	mNodes[index].mFirst = left;
+	mNodes[index].mCount = 0;
+
+	build(left, first, half);
+	build(left + 1, first + half, count - half);
+}
+
+void EventDispatcher::refit()
+{
+	mNeedsRefit = false;
+
+	for (auto itr = mItems.begin(); itr != mItems.end(); ++itr) {
+		// removals are journaled, but a node may also have been released by other means
+		NodeRef node = itr->mNode.lock();
+		if (!node) {
+			rebuild();
+			return;
+		}
+
+		Node2d* node2d = static_cast<Node2d*>(node.get());
+		itr->mBounds = node2d->getContentBounds().transformed(node2d->getWorldTransform());
+	}
+
+	// children are stored after their parents, so walking backwards refits them first
+	for (size_t i = mNodes.size(); i > 0; --i) {
+		BvhNode& bvh = mNodes[i - 1];
+		if (bvh.mCount == 0) {
+			bvh.mBounds = mNodes[bvh.mFirst].mBounds;
+			bvh.mBounds.include(mNodes[bvh.mFirst + 1].mBounds);
+			continue;
+		}
+
+		bvh.mBounds = mItems[bvh.mFirst].mBounds;
+		for (uint32_t j = bvh.mFirst + 1; j < bvh.mFirst + bvh.mCount; ++j) bvh.mBounds.include(mItems[j].mBounds);
+	}
+}
+
+void EventDispatcher::readJournal(ChangeJournal& journal)
+{
+	// changes made before recording started are unknown
+	if (!journal.isEnabled()) {
+		journal.setEnabled();
+		mIsDirty = true;
+		return;
+	}
+
+	const uint32_t structure = ChangeJournal::CHANGE_ADDED | ChangeJournal::CHANGE_REMOVED | ChangeJournal::CHANGE_CHILDREN |
+							   ChangeJournal::CHANGE_ACTIVE | ChangeJournal::CHANGE_INTERACTIVE;
+	const uint32_t bounds = ChangeJournal::CHANGE_TRANSFORM | ChangeJournal::CHANGE_CONTENT;
+
+	const std::vector<ChangeJournal::Record>& records = journal.getRecords();
+	for (auto itr = records.begin(); itr != records.end(); ++itr) {
+		if (itr->mChanges & structure) {
+			mIsDirty = true;
+			return;
+		}
+		if (itr->mChanges & bounds) mNeedsRefit = true;
+	}
+}
+
+Node2dRef EventDispatcher::hitTest(const vec2& position)
+{
+	if (mIsDirty) rebuild();
+	else if (mNeedsRefit) refit();
+
+	mLastTestCount = 0;
+	++mHitTestCount;
+	if (mNodes.empty()) return Node2dRef();
+
+	Node2dRef best;
+	uint32_t best_order = 0;
+
+	uint32_t stack[64];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0) {
+		const BvhNode& bvh = mNodes[stack[--top]];
+		++mLastTestCount;
+
+		// nothing below can be on top of the current best
+		if (best && bvh.mMaxOrder <= best_order) continue;
+		if (!bvh.mBounds.contains(position)) continue;
+
+		if (bvh.mCount == 0) {
+			// visit the child with the topmost items first, it is more likely to prune the other
+			uint32_t left = bvh.mFirst, right = bvh.mFirst + 1;
+			if (mNodes[left].mMaxOrder > mNodes[right].mMaxOrder) std::swap(left, right);
+			stack[top++] = left;
+			stack[top++] = right;
+			continue;
+		}
+
+		for (uint32_t i = bvh.mFirst; i < bvh.mFirst + bvh.mCount; ++i) {
+			const Item& item = mItems[i];
+			++mLastTestCount;
+			if ((best && item.mOrder <= best_order) || !item.mBounds.contains(position)) continue;
+
+			// precise test in the local coordinates of the node
+			Node2dRef node = std::static_pointer_cast<Node2d>(item.mNode.lock());
+			if (node && node->hitTest(Node2d::worldToObject(position, *node))) {
+				best = node;
+				best_order = item.mOrder;
+			}
+		}
+	}
+
+	return best;
+}
+
+#pragma mark dispatch
+
+NodeRef EventDispatcher::dispatch(PointerEvent::Type type, const vec2& position, int button)
+{
+	PointerEvent event(type, position, button);
+
+	// a captured pointer goes straight to the capturing node
+	NodeRef capture = mCapture.lock();
+	if (capture && (type == PointerEvent::POINTER_DRAG || type == PointerEvent::POINTER_UP)) {
+		if (type == PointerEvent::POINTER_UP) mCapture.reset();
+
+		event.mTarget = capture.get();
+		event.mPhase = PointerEvent::PHASE_TARGET;
+		event.mIsCaptured = true;
+		return capture->onPointerEvent(event)? capture: NodeRef();
+	}
+	if (type == PointerEvent::POINTER_UP) mCapture.reset();
+
+	NodeRef target = pick(position);
+	if (!target) return NodeRef();
+
+	NodeRef consumer = deliver(event, target);
+	if (consumer && type == PointerEvent::POINTER_DOWN) mCapture = consumer;
+
+	return consumer;
+}
+
+NodeRef EventDispatcher::deliver(PointerEvent& event, const NodeRef& target)
+{
+	event.mTarget = target.get();
+
+	// ancestors of the target, nearest first
+	std::vector<NodeRef> path;
+	for (NodeRef node = target->getParent(); node; node = node->getParent()) path.push_back(node);
+
+	event.mPhase = PointerEvent::PHASE_CAPTURE;
+	for (auto itr = path.rbegin(); itr != path.rend(); ++itr) {
+		if ((*itr)->onPointerEvent(event)) return *itr;
+	}
+
+	event.mPhase = PointerEvent::PHASE_TARGET;
+	if (target->onPointerEvent(event)) return target;
+
+	event.mPhase = PointerEvent::PHASE_BUBBLE;
+	for (auto itr = path.begin(); itr != path.end(); ++itr) {
+		if ((*itr)->onPointerEvent(event)) return *itr;
+	}
+
+	return NodeRef();
+}
+
+void EventDispatcher::post(PointerEvent::Type type, const vec2& position, int button)
+{
+	if (type == PointerEvent::POINTER_MOVE || type == PointerEvent::POINTER_DRAG) {
+		mHasMotion = true;
+		mMotionType = type;
+		mMotionPosition = position;
+		mMotionButton = button;
+		return;
+	}
+
+	// keep the order of events: the press happens where the pointer moved to
+	if (mHasMotion) {
+		mHasMotion = false;
+		dispatch(mMotionType, mMotionPosition, mMotionButton);
+	}
+	dispatch(type, position, button);
+}
+
+void EventDispatcher::update()
+{
+	Node2dRef root = mRoot.lock();
+	if (root && root->getContext()) readJournal(root->getContext()->getJournal());
+
+	if (mHasMotion) {
+		mHasMotion = false;
+		dispatch(mMotionType, mMotionPosition, mMotionButton);
+	}
+	else if (mHasHover && (mIsDirty || mNeedsRefit)) {
+		// the scene changed under a still pointer
+		pick(mHoverPosition);
+	}
+}
+
+NodeRef EventDispatcher::pick(const vec2& position)
+{
+	if (mHasHover && !mIsDirty && !mNeedsRefit && position == mHoverPosition) return mHover.lock();
+
+	NodeRef node = hitTest(position);
+	setHover(node, position);
+	return node;
+}
+
+void EventDispatcher::setHover(const NodeRef& node, const vec2& position)
+{
+	NodeRef previous = mHover.lock();
+	mHover = node;
+	mHoverPosition = position;
+	mHasHover = true;
+
+	if (previous == node) return;
+
+	if (previous) {
+		PointerEvent event(PointerEvent::POINTER_LEAVE, position);
+		event.mTarget = previous.get();
+		previous->onPointerEvent(event);
+	}
+	if (node) {
+		PointerEvent event(PointerEvent::POINTER_ENTER, position);
+		event.mTarget = node.get();
+		node->onPointerEvent(event);
+	}
+}
@@ -0,0 +1,67 @@
+#include <cmath>
+
+#include "FixedTimestep.h"
+#include "SceneContext.h"
+
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+FixedTimestep::FixedTimestep(double step, uint32_t max_steps)
+:	mStep(step > 0? step: 1.0 / 60.0), mMaxSteps(max_steps > 0? max_steps: 1),
+	mAccumulator(0), mStepCount(0), mDroppedTime(0)
+{
+}
+
+uint32_t FixedTimestep::advance(double elapsed)
+{
+	if (elapsed > 0) mAccumulator += elapsed;
+
+	uint32_t steps = 0;
+	while (mAccumulator >= mStep && steps < mMaxSteps) {
+		mAccumulator -= mStep;
+		++steps;
+	}
+
+	// drop what the catch-up limit does not allow, but keep the fraction for interpolation
+	if (mAccumulator >= mStep) {
+		double dropped = mAccumulator - fmod(mAccumulator, mStep);
+		mDroppedTime += dropped;
+		mAccumulator -= dropped;
+	}
+
+	mStepCount += steps;
+	return steps;
+}
+
+uint32_t FixedTimestep::update(NodeBase& root, double elapsed)
+{
+	uint32_t steps = advance(elapsed);
+	for (uint32_t i = 0; i < steps; ++i) {
+		root.deepSaveTransform();
+		root.deepUpdate(mStep);
+	}
+	return steps;
+}
+
+uint32_t FixedTimestep::update(SceneContext& context, double elapsed)
+{
+	uint32_t steps = advance(elapsed);
+	for (uint32_t i = 0; i < steps; ++i) {
+		if (context.getRoot()) context.getRoot()->deepSaveTransform();
+		context.update(mStep);
+	}
+	return steps;
+}
+
+void FixedTimestep::reset()
+{
+	mAccumulator = 0;
+	mStepCount = 0;
+	mDroppedTime = 0;
+}
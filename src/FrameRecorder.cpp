@@ -0,0 +1,233 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "FrameRecorder.h"
+#include "Node2d.h"
+#include "Node3d.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Record keyboard input once nodes receive it
+//
+///////////////////////////////////////////////////////////////////////////
+
+const uint32_t FrameFileHeader::MAGIC;
+const uint16_t FrameFileHeader::VERSION;
+
+namespace {
+	typedef std::chrono::steady_clock Clock;
+
+	//! returns the microseconds passed since a point in time and advances it to now
+	double lap(Clock::time_point& start)
+	{
+		Clock::time_point now = Clock::now();
+		double us = std::chrono::duration<double, std::micro>(now - start).count();
+		start = now;
+		return us;
+	}
+}
+
+FrameRecorder::FrameRecorder(SceneContext& context, const SceneTypeRegistry& registry)
+:	mEncoder(context, registry), mStream(nullptr), mSent(0), mFrameCount(0), mByteCount(0)
+{
+}
+
+bool FrameRecorder::begin(ostream& stream)
+{
+	end();
+
+	mStream = &stream;
+	mSent = 0;
+	mFrameCount = 0;
+	mByteCount = 0;
+	mEvents.clear();
+
+	FrameFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = FrameFileHeader::MAGIC;
+	header.mVersion = FrameFileHeader::VERSION;
+	return write(&header, sizeof(header));
+}
+
+bool FrameRecorder::begin(const string& path)
+{
+	end();
+
+	mFile.reset( new ofstream(path.c_str(), ios::binary) );
+	if (!*mFile) {
+		mFile.reset();
+		return false;
+	}
+	return begin(*mFile);
+}
+
+void FrameRecorder::recordEvent(PointerEvent::Type type, const vec2& position, int button)
+{
+	FrameEventRecord event;
+	event.mType = static_cast<uint32_t>(type);
+	event.mButton = button;
+	event.mPosition[0] = position.x;
+	event.mPosition[1] = position.y;
+	mEvents.push_back(event);
+}
+
+bool FrameRecorder::endFrame(double elapsed)
+{
+	// the changes are captured even when not recording, so the encoder stays in sync
+	uint32_t version = mEncoder.capture();
+	if (!mStream) {
+		mEncoder.forget(version);
+		mEvents.clear();
+		return false;
+	}
+
+	// the first frame is a snapshot, later frames only carry what changed
+	mDelta.clear();
+	if (version != mSent && !mEncoder.encode(mSent, mDelta)) return false;
+	mSent = version;
+	mEncoder.forget(version);
+
+	FrameRecord record;
+	memset(&record, 0, sizeof(record));
+	record.mFrame = mFrameCount;
+	record.mEventCount = static_cast<uint32_t>(mEvents.size());
+	record.mDeltaSize = static_cast<uint32_t>(mDelta.size());
+	record.mElapsed = elapsed;
+
+	bool ok = write(&record, sizeof(record)) && write(mEvents.data(), mEvents.size() * sizeof(FrameEventRecord)) && write(mDelta.data(), mDelta.size());
+	mEvents.clear();
+	++mFrameCount;
+	return ok;
+}
+
+bool FrameRecorder::end()
+{
+	if (!mStream) return true;
+
+	bool ok = mStream->flush().good();
+	mStream = nullptr;
+	mFile.reset();
+	return ok;
+}
+
+bool FrameRecorder::write(const void* data, size_t size)
+{
+	if (size) mStream->write(static_cast<const char*>(data), size);
+	mByteCount += size;
+	return mStream->good();
+}
+
+FrameReplayer::FrameReplayer(const SceneTypeRegistry& registry)
+:	mApplier(registry), mStream(nullptr), mNextFrame(0), mIsComplete(false)
+{
+}
+
+bool FrameReplayer::open(istream& stream)
+{
+	mStream = nullptr;
+	mNextFrame = 0;
+	mIsComplete = false;
+	mTimings.clear();
+	mApplier.reset();
+	mDispatcher.setRoot(Node2dRef());
+
+	FrameFileHeader header;
+	if (!stream.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+	if (header.mMagic != FrameFileHeader::MAGIC || header.mVersion > FrameFileHeader::VERSION) return false;
+
+	mStream = &stream;
+	return true;
+}
+
+bool FrameReplayer::open(const string& path)
+{
+	mFile.reset( new ifstream(path.c_str(), ios::binary) );
+	if (!*mFile || !open(*mFile)) {
+		mFile.reset();
+		return false;
+	}
+	return true;
+}
+
+bool FrameReplayer::step()
+{
+	if (!mStream || mIsComplete) return false;
+
+	// the recording ends cleanly between two frames
+	FrameRecord record;
+	mStream->read(reinterpret_cast<char*>(&record), sizeof(record));
+	if (mStream->gcount() == 0 && mStream->eof()) {
+		mIsComplete = true;
+		return false;
+	}
+	if (!*mStream || record.mFrame != mNextFrame) return false;
+
+	size_t events_size = size_t(record.mEventCount) * sizeof(FrameEventRecord);
+	if (!read(events_size + record.mDeltaSize)) return false;
+
+	FrameTiming timing;
+	memset(&timing, 0, sizeof(timing));
+	timing.mFrame = record.mFrame;
+	timing.mEventCount = record.mEventCount;
+	timing.mDeltaSize = record.mDeltaSize;
+
+	Clock::time_point start = Clock::now();
+
+	// the events reached the application before the frame changed the scene
+	for (uint32_t i = 0; i < record.mEventCount; ++i) {
+		FrameEventRecord event;
+		memcpy(&event, mBuffer.data() + i * sizeof(FrameEventRecord), sizeof(event));
+		if (event.mType > PointerEvent::POINTER_LEAVE) return false;
+		mDispatcher.dispatch(static_cast<PointerEvent::Type>(event.mType), vec2(event.mPosition[0], event.mPosition[1]), event.mButton);
+	}
+	timing.mMicroseconds[PHASE_INPUT] = lap(start);
+
+	if (record.mDeltaSize) {
+		NodeRef previous = mApplier.getRoot();
+		if (!mApplier.apply(mBuffer.data() + events_size, record.mDeltaSize)) return false;
+		if (mApplier.getRoot() != previous) mDispatcher.setRoot(dynamic_pointer_cast<Node2d>(mApplier.getRoot()));
+	}
+	timing.mMicroseconds[PHASE_APPLY] = lap(start);
+
+	const NodeRef& root = mApplier.getRoot();
+	if (root) root->deepUpdate(record.mElapsed);
+	timing.mMicroseconds[PHASE_UPDATE] = lap(start);
+
+	if (Node2d* node = dynamic_cast<Node2d*>(root.get())) node->deepTransform();
+	else if (Node3d* node = dynamic_cast<Node3d*>(root.get())) node->deepTransform();
+	timing.mMicroseconds[PHASE_TRANSFORM] = lap(start);
+
+	// the replica moved, the next events are hit tested against the new transformations
+	if (record.mDeltaSize) mDispatcher.invalidate();
+
+	timing.mNodeCount = static_cast<uint32_t>(mApplier.getNodeCount());
+	mTimings.push_back(timing);
+	++mNextFrame;
+	return true;
+}
+
+size_t FrameReplayer::run()
+{
+	size_t count = 0;
+	while (step()) ++count;
+	return count;
+}
+
+bool FrameReplayer::read(size_t size)
+{
+	const size_t CHUNK_SIZE = 1 << 20;
+
+	mBuffer.clear();
+	while (mBuffer.size() < size) {
+		size_t offset = mBuffer.size();
+		size_t chunk = std::min(size - offset, CHUNK_SIZE);
+		mBuffer.resize(offset + chunk);
+		if (!mStream->read(reinterpret_cast<char*>(mBuffer.data() + offset), chunk)) return false;
+	}
+	return true;
+}
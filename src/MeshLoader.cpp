@@ -0,0 +1,331 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+#include "BinaryStream.hpp"
+#include "MeshLoader.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Read OBJ materials and groups
+//
+///////////////////////////////////////////////////////////////////////////
+
+const uint32_t MeshFileHeader::MAGIC;
+const uint16_t MeshFileHeader::VERSION;
+
+namespace {
+	//! the indices a face corner refers to, 0 if absent, the position is always present
+	struct ObjCorner {
+		uint32_t	mPosition;
+		uint32_t	mTexCoord;
+		uint32_t	mNormal;
+
+		bool operator==(const ObjCorner& other) const
+		{
+			return mPosition == other.mPosition && mTexCoord == other.mTexCoord && mNormal == other.mNormal;
+		}
+	};
+
+	struct ObjCornerHash {
+		size_t operator()(const ObjCorner& corner) const
+		{
+			return (size_t(corner.mPosition) * 73856093u) ^ (size_t(corner.mTexCoord) * 19349663u) ^ (size_t(corner.mNormal) * 83492791u);
+		}
+	};
+
+	//! parses up to a number of floats, returns the number of parsed floats
+	size_t parseObjFloats(const char*& p, float* out, size_t count)
+	{
+		size_t parsed = 0;
+		for (; parsed < count; ++parsed) {
+			char* end;
+			out[parsed] = strtof(p, &end);
+			if (end == p) break;
+			p = end;
+		}
+		return parsed;
+	}
+
+	//! parses a 1-based or negative (relative) index, 0 stays 0 for an absent index
+	bool parseObjIndex(const char*& p, size_t count, uint32_t& index)
+	{
+		char* end;
+		long value = strtol(p, &end, 10);
+		if (end == p) {
+			index = 0;
+			return true;
+		}
+		p = end;
+
+		if (value < 0) value += static_cast<long>(count) + 1;
+		if (value <= 0 || static_cast<unsigned long>(value) > count) return false;
+		index = static_cast<uint32_t>(value);
+		return true;
+	}
+
+	//! parses a face corner in one of the forms v, v/t, v//n and v/t/n
+	bool parseObjCorner(const char*& p, size_t positions, size_t texcoords, size_t normals, ObjCorner& corner)
+	{
+		if (!parseObjIndex(p, positions, corner.mPosition) || !corner.mPosition) return false;
+
+		corner.mTexCoord = corner.mNormal = 0;
+		if (*p != '/') return true;
+		++p;
+		if (*p != '/' && !parseObjIndex(p, texcoords, corner.mTexCoord)) return false;
+
+		if (*p != '/') return true;
+		++p;
+		return parseObjIndex(p, normals, corner.mNormal) && corner.mNormal;
+	}
+
+	bool isObjSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+}
+
+MeshLoader::MeshLoader(const ThreadPoolRef& pool)
+:	mPool(pool), mShared(new Shared()), mFailedCount(0), mIsCompact(false)
+{
+	if (!mPool) mPool = ThreadPool::create(1);
+
+	mShared->mPendingCount = 0;
+	mShared->mIsCancelled = false;
+}
+
+MeshLoader::~MeshLoader()
+{
+	mShared->mIsCancelled = true;
+}
+
+NodeMeshRef MeshLoader::load(const string& path, const AxisAlignedBox& placeholder, Format format, const Callback& callback)
+{
+	NodeMeshRef node( new NodeMesh() );
+	node->setPlaceholder(placeholder);
+	load(node, path, format, callback);
+	return node;
+}
+
+void MeshLoader::load(const NodeMeshRef& node, const string& path, Format format, const Callback& callback)
+{
+	++mShared->mPendingCount;
+
+	// the task keeps the shared state alive, not the loader nor the node
+	shared_ptr<Shared> shared = mShared;
+	NodeMeshWeakRef weak_node = node;
+	bool compact = mIsCompact;
+	mPool->submit([shared, weak_node, path, format, callback, compact]() {
+		Result result;
+		result.mNode = weak_node;
+		result.mCallback = callback;
+
+		if (!shared->mIsCancelled && !weak_node.expired()) {
+			TriMeshRef mesh( new TriMesh() );
+			if (loadFile(path, format, *mesh)) {
+				if (compact) result.mCompactMesh = CompactMesh::create(*mesh);
+				else result.mMesh = mesh;
+			}
+		}
+		shared->mResults.push(std::move(result));
+	});
+}
+
+size_t MeshLoader::sync()
+{
+	size_t count = 0;
+	Result result;
+	while (mShared->mResults.pop(result)) {
+		--mShared->mPendingCount;
+		++count;
+
+		// the loads of released nodes were skipped, a failed load leaves the node as it was
+		NodeMeshRef node = result.mNode.lock();
+		if (node) {
+			bool loaded = result.mMesh || result.mCompactMesh;
+			if (result.mCompactMesh) node->setMesh(result.mCompactMesh);
+			else if (result.mMesh) node->setMesh(std::move(*result.mMesh));
+			else ++mFailedCount;
+
+			if (result.mCallback) result.mCallback(node, loaded);
+		}
+		result = Result();
+	}
+	return count;
+}
+
+bool MeshLoader::loadFile(const string& path, Format format, TriMesh& mesh)
+{
+	if (format == FORMAT_AUTO) {
+		bool binary = path.size() >= 5 && path.compare(path.size() - 5, 5, ".mesh") == 0;
+		format = binary? FORMAT_BINARY: FORMAT_OBJ;
+	}
+
+	ifstream stream(path.c_str(), ios::binary);
+	if (!stream) return false;
+
+	if (format == FORMAT_OBJ) return decodeObj(stream, mesh);
+
+	vector<uint8_t> data((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+	return !stream.bad() && decodeBinary(data.data(), data.size(), mesh);
+}
+
+bool MeshLoader::decodeObj(istream& stream, TriMesh& mesh)
+{
+	vector<vec3> positions;
+	vector<vec2> texcoords;
+	vector<vec3> normals;
+
+	// every distinct combination of indices becomes a vertex of the mesh
+	vector<ObjCorner> corners;
+	unordered_map<ObjCorner, uint32_t, ObjCornerHash> vertices;
+	vector<uint32_t> indices;
+	vector<uint32_t> face;
+	bool has_texcoords = false;
+	bool has_normals = false;
+
+	string line;
+	while (getline(stream, line)) {
+		const char* p = line.c_str();
+		while (isObjSpace(*p)) ++p;
+
+		if (p[0] == 'v' && isObjSpace(p[1])) {
+			float v[3];
+			++p;
+			if (parseObjFloats(p, v, 3) != 3) return false;
+			positions.push_back(vec3(v[0], v[1], v[2]));
+		}
+		else if (p[0] == 'v' && p[1] == 't' && isObjSpace(p[2])) {
+			float v[2] = { 0.0f, 0.0f };
+			p += 2;
+			if (parseObjFloats(p, v, 2) == 0) return false;
+			texcoords.push_back(vec2(v[0], v[1]));
+		}
+		else if (p[0] == 'v' && p[1] == 'n' && isObjSpace(p[2])) {
+			float v[3];
+			p += 2;
+			if (parseObjFloats(p, v, 3) != 3) return false;
+			normals.push_back(vec3(v[0], v[1], v[2]));
+		}
+		else if (p[0] == 'f' && isObjSpace(p[1])) {
+			++p;
+			face.clear();
+			for (;;) {
+				while (isObjSpace(*p)) ++p;
+				if (!*p || *p == '#') break;
+
+				ObjCorner corner;
+				if (!parseObjCorner(p, positions.size(), texcoords.size(), normals.size(), corner)) return false;
+				if (*p && !isObjSpace(*p) && *p != '#') return false;
+				has_texcoords = has_texcoords || corner.mTexCoord;
+				has_normals = has_normals || corner.mNormal;
+
+				auto inserted = vertices.insert(make_pair(corner, static_cast<uint32_t>(corners.size())));
+				if (inserted.second) corners.push_back(corner);
+				face.push_back(inserted.first->second);
+			}
+			if (face.size() < 3) return false;
+
+			for (size_t i = 2; i < face.size(); ++i) {
+				indices.push_back(face[0]);
+				indices.push_back(face[i - 1]);
+				indices.push_back(face[i]);
+			}
+		}
+		// comments, groups, materials, lines and points are skipped
+	}
+	if (stream.bad()) return false;
+
+	TriMesh::Format format = TriMesh::Format().positions(3);
+	if (has_normals) format.normals();
+	if (has_texcoords) format.texCoords0(2);
+	mesh = TriMesh(format);
+
+	// corners without a normal or texture coordinate get zeros
+	for (auto itr = corners.begin(); itr != corners.end(); ++itr) {
+		mesh.appendPosition(positions[itr->mPosition - 1]);
+		if (has_normals) mesh.appendNormal(itr->mNormal? normals[itr->mNormal - 1]: vec3(0.0f));
+		if (has_texcoords) mesh.appendTexCoord0(itr->mTexCoord? texcoords[itr->mTexCoord - 1]: vec2(0.0f));
+	}
+	mesh.appendIndices(indices.data(), indices.size());
+	return true;
+}
+
+bool MeshLoader::decodeBinary(const uint8_t* data, size_t size, TriMesh& mesh)
+{
+	BinaryReader reader(data, size);
+
+	MeshFileHeader header;
+	if (!reader.readBytes(&header, sizeof(header))) return false;
+	if (header.mMagic != MeshFileHeader::MAGIC || header.mVersion > MeshFileHeader::VERSION) return false;
+	if (header.mIndexCount % 3 != 0) return false;
+
+	bool has_normals = (header.mAttributes & MeshFileHeader::ATTRIBUTE_NORMALS) != 0;
+	bool has_texcoords = (header.mAttributes & MeshFileHeader::ATTRIBUTE_TEXCOORDS) != 0;
+
+	// the sizes are checked before anything is allocated
+	uint64_t vertex_size = sizeof(vec3) + (has_normals? sizeof(vec3): 0) + (has_texcoords? sizeof(vec2): 0);
+	uint64_t needed = uint64_t(header.mVertexCount) * vertex_size + uint64_t(header.mIndexCount) * sizeof(uint32_t);
+	if (needed != reader.getRemaining()) return false;
+
+	vector<vec3> positions(header.mVertexCount);
+	vector<vec3> normals(has_normals? header.mVertexCount: 0);
+	vector<vec2> texcoords(has_texcoords? header.mVertexCount: 0);
+	vector<uint32_t> indices(header.mIndexCount);
+
+	reader.readBytes(positions.data(), positions.size() * sizeof(vec3));
+	reader.readBytes(normals.data(), normals.size() * sizeof(vec3));
+	reader.readBytes(texcoords.data(), texcoords.size() * sizeof(vec2));
+	reader.readBytes(indices.data(), indices.size() * sizeof(uint32_t));
+
+	for (auto itr = indices.begin(); itr != indices.end(); ++itr) {
+		if (*itr >= header.mVertexCount) return false;
+	}
+
+	TriMesh::Format format = TriMesh::Format().positions(3);
+	if (has_normals) format.normals();
+	if (has_texcoords) format.texCoords0(2);
+	mesh = TriMesh(format);
+
+	mesh.appendPositions(positions.data(), positions.size());
+	if (has_normals) mesh.appendNormals(normals.data(), normals.size());
+	if (has_texcoords) mesh.appendTexCoords0(texcoords.data(), texcoords.size());
+	mesh.appendIndices(indices.data(), indices.size());
+	return true;
+}
+
+void MeshLoader::encodeBinary(const TriMesh& mesh, vector<uint8_t>& buffer)
+{
+	buffer.clear();
+	BinaryWriter writer(buffer);
+
+	size_t vertex_count = mesh.getNumVertices();
+	const vec3* positions = mesh.getPositions<3>();
+	bool has_normals = mesh.hasNormals() && mesh.getNormals().size() == vertex_count;
+	bool has_texcoords = mesh.hasTexCoords0();
+
+	MeshFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = MeshFileHeader::MAGIC;
+	header.mVersion = MeshFileHeader::VERSION;
+	header.mAttributes = static_cast<uint16_t>((has_normals? MeshFileHeader::ATTRIBUTE_NORMALS: 0) | (has_texcoords? MeshFileHeader::ATTRIBUTE_TEXCOORDS: 0));
+	header.mVertexCount = static_cast<uint32_t>(vertex_count);
+	header.mIndexCount = static_cast<uint32_t>(mesh.getIndices().size());
+
+	if (vertex_count) {
+		AxisAlignedBox bounds = mesh.calcBoundingBox();
+		vec3 min = bounds.getMin();
+		vec3 max = bounds.getMax();
+		memcpy(header.mMin, &min, sizeof(header.mMin));
+		memcpy(header.mMax, &max, sizeof(header.mMax));
+	}
+
+	writer.writeBytes(&header, sizeof(header));
+	writer.writeBytes(positions, vertex_count * sizeof(vec3));
+	if (has_normals) writer.writeBytes(mesh.getNormals().data(), vertex_count * sizeof(vec3));
+	if (has_texcoords) writer.writeBytes(mesh.getTexCoords0<2>(), vertex_count * sizeof(vec2));
+	writer.writeBytes(mesh.getIndices().data(), mesh.getIndices().size() * sizeof(uint32_t));
+}
@@ -0,0 +1,67 @@
+#include "MutationQueue.h"
+
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+MutationQueue::MutationQueue()
+:	mPendingCount(0)
+{
+}
+
+void MutationQueue::push(Operation operation, const NodeRef& parent, const NodeRef& node)
+{
+	if (!node) return;
+
+	Mutation mutation;
+	mutation.mOperation = operation;
+	mutation.mParent = parent;
+	mutation.mNode = node;
+
+	mPendingCount.fetch_add(1, std::memory_order_relaxed);
+	mQueue.push(std::move(mutation));
+}
+
+size_t MutationQueue::apply()
+{
+	size_t count = 0;
+
+	Mutation mutation;
+	while (mQueue.pop(mutation)) {
+		mPendingCount.fetch_sub(1, std::memory_order_relaxed);
+		++count;
+
+		NodeRef& node = mutation.mNode;
+		switch (mutation.mOperation) {
+			case MUTATION_ATTACH:
+				if (mutation.mParent) mutation.mParent->addChild(node);
+				break;
+			case MUTATION_DETACH:
+				node->removeFromParent();
+				break;
+			case MUTATION_MOVE_TO_TOP:
+				node->moveToTop();
+				break;
+			case MUTATION_MOVE_TO_BOTTOM:
+				node->moveToBottom();
+				break;
+			case MUTATION_DESTROY:
+				// detach the node and its children from the scene, nodes that are still referenced
+				// elsewhere (by the caller, a handler or a cache) outlive this and are not freed
+				node->removeFromParent();
+				node->removeChildren();
+				break;
+		}
+
+		// release the references now rather than when the next edit overwrites them
+		mutation.mParent.reset();
+		mutation.mNode.reset();
+	}
+
+	return count;
+}
@@ -5,8 +5,10 @@
 #include "cinder/gl/gl.h"
 #include "cinder/gl/wrapper.h"
 #include "glm/gtx/vec_swizzle.hpp"
+#include "glm/gtx/matrix_transform_2d.hpp"
 
 #include "Node2d.h"
+#include "RenderBackend.h"
 
 using namespace ci;
 using namespace std;
@@ -24,9 +26,10 @@ Node2dRef Node2d::create(const std::string& name, const bool active)
 }
 
 Node2d::Node2d(const std::string& name, const bool active)
-:	NodeBase(name, active), mSize(0), mPosition(0),
+:	NodeBase(name, active), mTransformIsDirty(true), mIsDamaged(true), mSize(0), mPosition(0),
 	mScale(1), mPivot(0), mTransform(1),
-	mWorldTransform(1), mRotation(0)
+	mWorldTransform(1), mRotation(0), mDamageRect(0, 0, 0, 0),
+	mHasPreviousTransform(false), mPreviousPosition(0), mPreviousScale(1), mPreviousRotation(0)
 {
 	
 }
@@ -42,7 +45,11 @@ void Node2d::deepTransform(const mat3& world)
 	transform();
 	
 	// calculate world transform matrix
-	mWorldTransform = world * mTransform;
+	mat3 world_transform = world * mTransform;
+	if (world_transform != mWorldTransform) {
+		mWorldTransform = world_transform;
+		mIsDamaged = true;
+	}
 	
 	// do the same for all children
 //	NodeDeque::iterator itr;
@@ -52,42 +59,159 @@ void Node2d::deepTransform(const mat3& world)
 	}
 }
 
-void Node2d::deepDraw() {}
-/*
-void Node2d::deepDraw()
+void Node2d::deepTransformInterpolated(const mat3& world, float alpha)
+{
+	// keep the cached local transformation in sync with the current state
+	transform();
+	
+	mat3 local = mTransform;
+	if (mHasPreviousTransform && alpha < 1.0f) {
+		vec2 position = glm::mix(mPreviousPosition, mPosition, alpha);
+		vec2 scale = glm::mix(mPreviousScale, mScale, alpha);
+		float rotation = glm::mix(mPreviousRotation, mRotation, alpha);
+		
+		local = mat3(1);
+		local = glm::translate(local, position);
+		local = glm::rotate(local, rotation);
+		local = glm::scale(local, scale);
+		local = glm::translate(local, -mPivot);
+	}
+	
+	mat3 world_transform = world * local;
+	if (world_transform != mWorldTransform) {
+		mWorldTransform = world_transform;
+		mIsDamaged = true;
+		
+		// consumers of the journal, like the hit test hierarchy, have to see the blended motion
+		if (mContext) journal(ChangeJournal::CHANGE_TRANSFORM);
+	}
+	
+	for (auto itr = mChildren.begin(); itr != mChildren.end(); ++itr) {
+		Node2d* child = dynamic_cast<Node2d*>(itr->get());
+		if (child) child->deepTransformInterpolated(mWorldTransform, alpha);
+	}
+}
+
+void Node2d::deepDraw(RenderBackend& renderer)
 {
 	if (!mIsActive) return;
 	
 	// let derived class know we are about to draw stuff
 	pre_draw();
 	
-	// update transform matrix by calling derived class's function
-	// (do it again here in case this node has no parent and thus wasn't updated)
-	transform();
-	
-	// apply transform
-	gl::pushModelView();
-	
-	// usual way to update modelview matrix
-	Matrix44f local_transform(mTransform);
-	gl::multModelView( local_transform );
+	// apply model transform
+	renderer.pushModelMatrix( RenderBackend::toMat4(mWorldTransform) );
 	
 	// draw this node by calling derived class
-	draw();
+	draw(renderer);
+	renderer.popModelMatrix();
 	
 	// draw this node's children
-//	typename NodeDeque::iterator itr;
 	for (auto itr = mChildren.begin(); itr != mChildren.end(); ++itr) {
-		(*itr)->deepDraw();
+		(*itr)->deepDraw(renderer);
+	}
+	
+	// let derived class know we are done drawing
+	post_draw();
+}
+
+void Node2d::deepDraw(RenderBackend& renderer, const DamageTracker& damage)
+{
+	if (!mIsActive) return;
+	
+	// let derived class know we are about to draw stuff
+	pre_draw();
+	
+	// draw this node only if it covers a damaged region
+	if (damage.intersects(mDamageRect)) {
+		renderer.pushModelMatrix( RenderBackend::toMat4(mWorldTransform) );
+		draw(renderer);
+		renderer.popModelMatrix();
 	}
 	
-	// restore transform
-	gl::popModelView();
+	// draw this node's children
+	for (auto itr = mChildren.begin(); itr != mChildren.end(); ++itr) {
+		Node2d* child = dynamic_cast<Node2d*>(itr->get());
+		if (child) child->deepDraw(renderer, damage);
+		else (*itr)->deepDraw(renderer);
+	}
 	
 	// let derived class know we are done drawing
 	post_draw();
 }
-*/
+
+void Node2d::deepCollectDamage(DamageTracker& damage)
+{
+	bool visible = true;
+	for (NodeRef parent = getParent(); parent; parent = parent->getParent()) {
+		visible = visible && parent->isActive();
+	}
+	
+	collectDamage(damage, visible);
+}
+
+void Node2d::collectDamage(DamageTracker& damage, bool visible)
+{
+	visible = visible && mIsActive;
+	
+	// inactive nodes occupy no region
+	Rectf rect = visible? getContentBounds().transformed(mWorldTransform): Rectf(0, 0, 0, 0);
+	if (mIsDamaged || rect != mDamageRect) {
+		damage.add(mDamageRect);
+		damage.add(rect);
+		mDamageRect = rect;
+		mIsDamaged = false;
+	}
+	
+	// regions left behind by children that are gone or were reordered
+	for (auto itr = mDetachedDamage.begin(); itr != mDetachedDamage.end(); ++itr) {
+		damage.add(*itr);
+	}
+	mDetachedDamage.clear();
+	
+	for (auto itr = mChildren.begin(); itr != mChildren.end(); ++itr) {
+		Node2d* child = dynamic_cast<Node2d*>(itr->get());
+		if (child) child->collectDamage(damage, visible);
+	}
+}
+
+void Node2d::gatherDamageRects(vector<Rectf>& rects, bool reset)
+{
+	if (!DamageTracker::isEmpty(mDamageRect)) rects.push_back(mDamageRect);
+	if (reset) {
+		mDamageRect = Rectf(0, 0, 0, 0);
+		mIsDamaged = true;
+	}
+	
+	for (auto itr = mChildren.begin(); itr != mChildren.end(); ++itr) {
+		Node2d* child = dynamic_cast<Node2d*>(itr->get());
+		if (child) child->gatherDamageRects(rects, reset);
+	}
+}
+
+void Node2d::childRemoved(NodeRef node)
+{
+	Node2d* child = dynamic_cast<Node2d*>(node.get());
+	if (child) child->gatherDamageRects(mDetachedDamage, true);
+}
+
+void Node2d::childReordered(NodeRef node)
+{
+	Node2d* child = dynamic_cast<Node2d*>(node.get());
+	if (child) child->gatherDamageRects(mDetachedDamage, false);
+}
+
+void Node2d::setActive(bool active)
+{
+	if (active != mIsActive) mIsDamaged = true;
+	
+	NodeBase::setActive(active);
+}
+
+Rectf Node2d::getContentBounds() const
+{
+	return Rectf(vec2(0), mSize);
+}
 
 void Node2d::transform()
 {
@@ -99,18 +223,50 @@ void Node2d::transform()
 //	mTransform.scale(mScale);
 //	mTransform.translate(-mPivot);
 	
-	mTransform = mat4(1);
+	mTransform = mat3(1);
 	mTransform = glm::translate(mTransform, mPosition);
 	mTransform = glm::rotate(mTransform, mRotation);
-	mTransform = glm::translate(mTransform, mScale);
+	mTransform = glm::scale(mTransform, mScale);
 	mTransform = glm::translate(mTransform, -mPivot);
 	mTransformIsDirty = false;
 }
 
+void Node2d::saveTransform()
+{
+	mPreviousPosition = mPosition;
+	mPreviousScale = mScale;
+	mPreviousRotation = mRotation;
+	mHasPreviousTransform = true;
+}
+
 void Node2d::setRotation(const float radians, const bool use_degrees)
 {
 	mRotation = use_degrees? radians * 180.0/M_PI: radians;
-	mTransformIsDirty = true;
+	setTransformDirty();
+}
+
+void Node2d::setPositions(Node2d* const* nodes, const float* const xy[2], size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		nodes[i]->mPosition = vec2(xy[0][i], xy[1][i]);
+		nodes[i]->setTransformDirty();
+	}
+}
+
+void Node2d::setScales(Node2d* const* nodes, const float* const xy[2], size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		nodes[i]->mScale = vec2(xy[0][i], xy[1][i]);
+		nodes[i]->setTransformDirty();
+	}
+}
+
+void Node2d::setRotations(Node2d* const* nodes, const float* radians, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		nodes[i]->mRotation = radians[i];
+		nodes[i]->setTransformDirty();
+	}
 }
 
 vec2 Node2d::getPivotPercentage() const
@@ -207,7 +363,7 @@ vec2 Node2d::viewportToObject( const vec2& pt, const mat3& inverse_transform, co
 
 vec2 Node2d::objectToViewport( const vec2& pt, const mat3& transform, const Area& viewport )
 {
-	vec2 b = glm::xy( transform * vec3(pt, 0) );
+	vec2 b = glm::xy( transform * vec3(pt, 1) );
 	
 	vec2 result;
 	result.x = viewport.getX1() + viewport.getWidth() * (b.x + 1.0f) / 2.0f;
@@ -223,25 +379,25 @@ vec2 Node2d::parentToObject( const vec2& pt, const Node2d& object )
 //	return glm::xyz(pt_trans);
 	
 	mat3 obj_trans_inv = glm::inverse(object.getTransform());
-	vec3 pt_trans = obj_trans_inv * vec3(pt, 0);
+	vec3 pt_trans = obj_trans_inv * vec3(pt, 1);
 	return glm::xy(pt_trans);
 }
 
 vec2 Node2d::objectToParent( const vec2& pt, const Node2d& object )
 {
-	return glm::xy( object.getTransform() * vec3(pt,0) );
+	return glm::xy( object.getTransform() * vec3(pt,1) );
 }
 
 vec2 Node2d::worldToObject( const vec2& pt, const Node2d& object )
 {
 	mat3 world_trans_inv = glm::inverse(object.getWorldTransform());
-	vec3 pt_trans = world_trans_inv * vec3(pt, 0);
+	vec3 pt_trans = world_trans_inv * vec3(pt, 1);
 	return glm::xy(pt_trans);
 }
 
 vec2 Node2d::objectToWorld( const vec2& pt, const Node2d& object )
 {
-	return glm::xy( object.getWorldTransform() * vec3(pt,0) );
+	return glm::xy( object.getWorldTransform() * vec3(pt,1) );
 }
 
 bool Node2d::sortHorizontally(const NodeRef& lhs, const NodeRef& rhs)
@@ -7,6 +7,7 @@
 #include "glm/gtx/vec_swizzle.hpp"
 
 #include "Node3d.h"
+#include "RenderBackend.h"
 
 using namespace ci;
 using namespace std;
@@ -24,14 +25,17 @@ Node3dRef Node3d::create(const std::string& name, const bool active)
 }
 
 Node3d::Node3d(const std::string& name, const bool active)
-:	NodeBase(name, active), mSize(0), mPosition(0),
+:	NodeBase(name, active), mTransformIsDirty(true), mSize(0), mPosition(0),
 	mScale(1), mPivot(0), mTransform(1),
-	mWorldTransform(1), mRotation()
+	mWorldTransform(1), mRotation(), mMatrixIndex(WorldMatrixBuffer::INVALID_INDEX), mMatrixIsStale(false),
+	mHasPreviousTransform(false), mPreviousPosition(0), mPreviousScale(1), mPreviousRotation()
 {
 }
 
 Node3d::~Node3d()
 {
+	WorldMatrixBufferRef buffer = mMatrixBuffer.lock();
+	if (buffer) buffer->release(mMatrixIndex);
 }
 
 vec3 Node3d::getPivotPercentage()
@@ -52,6 +56,9 @@ void Node3d::deepTransform(const mat4& world)
 	// calculate world transform matrix
 	mWorldTransform = world * mTransform;
 	
+	// the matrix buffer has to catch up the next time it is passed in
+	if (mMatrixIndex != WorldMatrixBuffer::INVALID_INDEX) mMatrixIsStale = true;
+	
 	// do the same for all children
 	//NodeDeque::iterator itr;
 	for (auto itr = mChildren.begin(); itr != mChildren.end(); ++itr) {
@@ -60,41 +67,92 @@ void Node3d::deepTransform(const mat4& world)
 	}
 }
 
-void Node3d::deepDraw() {}
-/*
-void Node3d::deepDraw()
+void Node3d::deepTransform(const mat4& world, const WorldMatrixBufferRef& buffer)
+{
+	// update transform matrix by calling derived class's function
+	transform();
+	
+	// calculate world transform matrix
+	mat4 world_transform = world * mTransform;
+	bool changed = mMatrixIsStale || world_transform != mWorldTransform;
+	mWorldTransform = world_transform;
+	
+	if (buffer) {
+		// claim a slot the first time this node meets the buffer (owner comparison avoids locking the weak pointer)
+		bool same_buffer = !mMatrixBuffer.owner_before(buffer) && !buffer.owner_before(mMatrixBuffer);
+		if (mMatrixIndex == WorldMatrixBuffer::INVALID_INDEX || !same_buffer) {
+			WorldMatrixBufferRef previous = mMatrixBuffer.lock();
+			if (previous) previous->release(mMatrixIndex);
+			
+			mMatrixBuffer = buffer;
+			mMatrixIndex = buffer->allocate();
+			changed = true;
+		}
+		
+		if (changed) buffer->set(mMatrixIndex, mWorldTransform);
+		mMatrixIsStale = false;
+	}
+	
+	// do the same for all children
+	for (auto itr = mChildren.begin(); itr != mChildren.end(); ++itr) {
+		Node3d* child = dynamic_cast<Node3d*>(itr->get());
+		if (child) child->deepTransform(mWorldTransform, buffer);
+	}
+}
+
+void Node3d::deepTransformInterpolated(const mat4& world, float alpha)
+{
+	// keep the cached local transformation in sync with the current state
+	transform();
+	
+	mat4 local = mTransform;
+	if (mHasPreviousTransform && alpha < 1.0f) {
+		local = mat4(1);
+		local = glm::translate(local, glm::mix(mPreviousPosition, mPosition, alpha));
+		local *= glm::toMat4(glm::slerp(mPreviousRotation, mRotation, alpha));
+		local = glm::scale(local, glm::mix(mPreviousScale, mScale, alpha));
+		local = glm::translate(local, -mPivot);
+	}
+	
+	mat4 world_transform = world * local;
+	if (world_transform != mWorldTransform) {
+		mWorldTransform = world_transform;
+		
+		// consumers of the journal have to see the blended motion
+		if (mContext) journal(ChangeJournal::CHANGE_TRANSFORM);
+	}
+	
+	// the matrix buffer has to catch up the next time it is passed in
+	if (mMatrixIndex != WorldMatrixBuffer::INVALID_INDEX) mMatrixIsStale = true;
+	
+	for (auto itr = mChildren.begin(); itr != mChildren.end(); ++itr) {
+		Node3d* child = dynamic_cast<Node3d*>(itr->get());
+		if (child) child->deepTransformInterpolated(mWorldTransform, alpha);
+	}
+}
+
+void Node3d::deepDraw(RenderBackend& renderer)
 {
 	if (!mIsActive) return;
 	
 	// let derived class know we are about to draw stuff
 	pre_draw();
 	
-	// update transform matrix by calling derived class's function
-	// (do it again here in case this node has no parent and thus wasn't updated)
-	transform();
-	
-	// apply model-view transform
-	gl::pushModelView();
-//	gl::multModelView( mTransform );
-	gl::multModelView( mWorldTransform );	// TODO: convert to glm version
+	// apply model transform
+	renderer.pushModelMatrix( mWorldTransform );
 	
 	// draw this node by calling derived class
-	draw();
-	gl::popModelView();
+	draw(renderer);
+	renderer.popModelMatrix();
 	
 	// draw this node's children
-	//typename NodeDeque::iterator itr;
 	for (auto itr = mChildren.begin(); itr != mChildren.end(); ++itr) {
-		(*itr)->deepDraw();
+		(*itr)->deepDraw(renderer);
 	}
 	
-	// restore transform
-//	gl::popModelView();
-	
 	// let derived class know we are done drawing
 	post_draw();
 }
-*/
 
 void Node3d::transform()
 {
@@ -103,11 +161,19 @@ void Node3d::transform()
 	mTransform = mat4(1);
 	mTransform = glm::translate(mTransform, mPosition);
 	mTransform *= glm::toMat4(mRotation);
-	mTransform = glm::translate(mTransform, mScale);
+	mTransform = glm::scale(mTransform, mScale);
 	mTransform = glm::translate(mTransform, -mPivot);
 	mTransformIsDirty = false;
 }
 
+void Node3d::saveTransform()
+{
+	mPreviousPosition = mPosition;
+	mPreviousScale = mScale;
+	mPreviousRotation = mRotation;
+	mHasPreviousTransform = true;
+}
+
 void Node3d::setRotation( float angle_x, float angle_y, float angle_z, bool use_degrees )
 {
 	if (use_degrees) {
@@ -120,7 +186,31 @@ void Node3d::setRotation( float angle_x, float angle_y, float angle_z, bool use_
 	quat yrot = glm::angleAxis(angle_y, vec3(0,1,0));
 	quat zrot = glm::angleAxis(angle_z, vec3(0,0,1));
 	mRotation = xrot * yrot * zrot;
-	mTransformIsDirty = true;
+	setTransformDirty();
+}
+
+void Node3d::setPositions( Node3d* const* nodes, const float* const xyz[3], size_t count )
+{
+	for (size_t i = 0; i < count; ++i) {
+		nodes[i]->mPosition = vec3(xyz[0][i], xyz[1][i], xyz[2][i]);
+		nodes[i]->setTransformDirty();
+	}
+}
+
+void Node3d::setScales( Node3d* const* nodes, const float* const xyz[3], size_t count )
+{
+	for (size_t i = 0; i < count; ++i) {
+		nodes[i]->mScale = vec3(xyz[0][i], xyz[1][i], xyz[2][i]);
+		nodes[i]->setTransformDirty();
+	}
+}
+
+void Node3d::setRotations( Node3d* const* nodes, const float* const xyzw[4], size_t count )
+{
+	for (size_t i = 0; i < count; ++i) {
+		nodes[i]->mRotation = quat(xyzw[3][i], xyzw[0][i], xyzw[1][i], xyzw[2][i]);
+		nodes[i]->setTransformDirty();
+	}
 }
 
 AxisAlignedBox Node3d::getBounds() const
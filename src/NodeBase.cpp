@@ -5,6 +5,7 @@
 #include "cinder/gl/gl.h"
 
 #include "NodeBase.h"
+#include "SceneContext.h"
 
 using namespace scene;
 using namespace ci;
@@ -18,16 +19,67 @@ using namespace std;
 ///////////////////////////////////////////////////////////////////////////
 
 NodeBase::NodeBase(const string& name, const bool active)
-:	SceneObject(name), mIsActive(active)
+:	SceneObject(name), mIsActive(active), mIsInteractive(false), mContext(nullptr),
+	mIsUpdateEnabled(false), mUpdateIndex(INVALID_UPDATE_INDEX), mJournalIndex(INVALID_JOURNAL_INDEX)
 {
 }
 
 NodeBase::~NodeBase()
 {
+	if (mContext) {
+		if (mIsUpdateEnabled) mContext->unregisterUpdate(*this);
+		mContext->getJournal().record(*this, ChangeJournal::CHANGE_REMOVED);
+	}
+	mContext = nullptr;
+	
 	mParent.reset();
 	removeChildren();
 }
 
+void NodeBase::setContext(SceneContext* context)
+{
+	// descendants always share the context of their parent
+	if (mContext == context) return;
+	
+	if (mContext) {
+		if (mIsUpdateEnabled) mContext->unregisterUpdate(*this);
+		mContext->getJournal().record(*this, ChangeJournal::CHANGE_REMOVED);
+	}
+	mContext = context;
+	if (mContext) {
+		if (mIsUpdateEnabled) mContext->registerUpdate(*this);
+		mContext->getJournal().record(*this, ChangeJournal::CHANGE_ADDED);
+	}
+	
+	for (auto itr = mChildren.begin(); itr != mChildren.end(); ++itr) {
+		(*itr)->setContext(context);
+	}
+}
+
+void NodeBase::journal(uint32_t changes)
+{
+	if (mContext) mContext->getJournal().record(*this, changes);
+}
+
+void NodeBase::setActive(bool active)
+{
+	if (active == mIsActive) return;
+	
+	mIsActive = active;
+	journal(ChangeJournal::CHANGE_ACTIVE);
+}
+
+void NodeBase::setUpdateEnabled(bool enabled)
+{
+	if (enabled == mIsUpdateEnabled) return;
+	
+	mIsUpdateEnabled = enabled;
+	if (mContext) {
+		if (enabled) mContext->registerUpdate(*this);
+		else mContext->unregisterUpdate(*this);
+	}
+}
+
 void NodeBase::setParent(NodeRef node)
 {
 	bool dispatchAddedToScene = !hasParent();
@@ -65,19 +117,26 @@ NodeRef NodeBase::getChildByName(const string& name) const
 
 bool NodeBase::addChild(NodeRef node)
 {
-	if (hasChild(node) || node.get() == this || node.get() == nullptr) {
+	if (node.get() == this || node.get() == nullptr) {
 		return false;
 	}
 	
-	// remove child from current parent
+	// only a child of this node can already be in the list, spare the scan for all others
 	std::shared_ptr<NodeBase> parent = node->getParent();
+	if (parent.get() == this && hasChild(node)) {
+		return false;
+	}
+	
+	// remove child from current parent
 	if (parent) parent->removeChild(node);
 
 	// add to children
 	mChildren.push_back(node);
 
-	// set parent
-	node->setParent( shared_from_base<NodeBase>() );
+	// set parent (without setParent, which would dispatch addedToScene a second time)
+	node->mParent = shared_from_base<NodeBase>();
+	node->setContext(mContext);
+	journal(ChangeJournal::CHANGE_CHILDREN);
 	
 	// dispatch addedToScene
 	node->addedToScene();
@@ -92,13 +151,16 @@ bool NodeBase::removeChild(NodeRef node)
 	{
 		// reset parent
 		(*itr)->setParent( NodeRef() );
+		(*itr)->setContext(nullptr);
 		(*itr).reset();
 
 		// remove from children
 		mChildren.erase(itr);
+		journal(ChangeJournal::CHANGE_CHILDREN);
 		
 		// dispatch removedFromScene
 		node->removedFromScene();
+		childRemoved(node);
 		
 		return true;
 	}
@@ -109,15 +171,19 @@ void NodeBase::removeChildren()
 {
 	for (auto itr = mChildren.begin(); itr != mChildren.end();)
 	{
-		// reset parent
-//		(*itr)->setParent( NodeRef() );
-		(*itr).reset();
+		NodeRef node = *itr;
+
+		// reset parent (without setParent, which would dispatch addedToScene)
+		node->mParent.reset();
+		node->setContext(nullptr);
 
 		// remove from children
 		itr = mChildren.erase(itr);
-		
+		journal(ChangeJournal::CHANGE_CHILDREN);
+
 		// dispatch removedFromScene
-		(*itr)->removedFromScene();
+		node->removedFromScene();
+		childRemoved(node);
 	}
 }
 
@@ -143,6 +209,9 @@ void NodeBase::moveToTop(NodeRef node)
 
 	// add to end of list
 	mChildren.push_back(node);
+	journal(ChangeJournal::CHANGE_CHILDREN);
+
+	childReordered(node);
 }
 
 bool NodeBase::isOnTop() const
@@ -198,6 +267,9 @@ void NodeBase::moveToBottom(NodeRef node)
 
 	// add to start of list
 	mChildren.push_front(node);
+	journal(ChangeJournal::CHANGE_CHILDREN);
+
+	childReordered(node);
 }
 
 void NodeBase::deepSetup()
@@ -219,3 +291,27 @@ void NodeBase::deepUpdate(double elapsed)
 		(*itr)->deepUpdate(elapsed);
 	}
 }
+
+WorkQueue::JobId NodeBase::defer(const WorkQueue::Job& job, WorkQueue::Priority priority)
+{
+	if (!mContext) {
+		job();
+		return WorkQueue::INVALID_JOB;
+	}
+	
+	NodeWeakRef node = shared_from_base<NodeBase>();
+	return mContext->getWorkQueue().submit([node, job]() {
+		// keep the node alive while the job runs
+		NodeRef ref = node.lock();
+		if (ref) job();
+	}, priority);
+}
+
+void NodeBase::deepSaveTransform()
+{
+	saveTransform();
+
+	for (auto itr = mChildren.begin(); itr != mChildren.end(); ++itr) {
+		(*itr)->deepSaveTransform();
+	}
+}
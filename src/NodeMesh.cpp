@@ -1,7 +1,11 @@
+#include <cfloat>
+
 #include "cinder/gl/gl.h"
 #include "cinder/Ray.h"
 
 #include "NodeMesh.h"
+#include "RenderBackend.h"
+#include "SceneSnapshot.h"
 
 using namespace ci;
 using namespace ci::app;
@@ -15,7 +19,7 @@ using namespace scene;
 ///////////////////////////////////////////////////////////////////////////
 
 NodeMesh::NodeMesh(const ci::TriMesh& mesh, const std::string& name, const bool active)
-:	Node3d(name, active), mMesh(mesh), mMeshColor(ColorA::white()), mMousePos(Vec2f::zero()), mIsDragged(false)
+:	Node3d(name, active), mMesh(mesh), mMeshColor(ColorA::white()), mMousePos(0.0f), mIsDragged(false), mIsLoading(false)
 {
 }
 
@@ -32,11 +36,55 @@ void NodeMesh::update(double elapsed)
 {
 }
 
-void NodeMesh::draw()
+void NodeMesh::draw(RenderBackend& renderer)
+{
+	if (mIsLoading) return;
+	
+	renderer.setColor(mMeshColor);
+	if (mCompactMesh) renderer.drawMesh(*mCompactMesh);
+	else renderer.drawMesh(mMesh);
+}
+
+void NodeMesh::snapshot(SnapshotItem& item) const
+{
+	if (mIsLoading) return;
+	
+	item.mColor = mMeshColor;
+	if (mCompactMesh) {
+		item.mCompactMesh = mCompactMesh;
+		return;
+	}
+	
+	// snapshots share one copy until the mesh is replaced
+	if (!mSharedMesh) mSharedMesh = std::make_shared<const TriMesh>(mMesh);
+	item.mMesh = mSharedMesh;
+}
+
+void NodeMesh::compact()
+{
+	if (mIsLoading || mCompactMesh) return;
+	
+	mCompactMesh = CompactMesh::create(mMesh);
+	mMesh = TriMesh();
+	mSharedMesh.reset();
+}
+
+bool NodeMesh::intersect(const Ray& ray, float* distance) const
 {
-	gl::SaveColorState colorState;
-	gl::color(mMeshColor);
-	gl::draw(mMesh);
+	if (mIsLoading) return false;
+	if (mCompactMesh) return mCompactMesh->intersect(ray, distance);
+	
+	const vec3* positions = mMesh.getPositions<3>();
+	const std::vector<uint32_t>& indices = mMesh.getIndices();
+	float nearest = FLT_MAX;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		float t;
+		if (ray.calcTriangleIntersection(positions[indices[i]], positions[indices[i + 1]], positions[indices[i + 2]], &t) && t > 0.0f && t < nearest) nearest = t;
+	}
+	
+	if (nearest == FLT_MAX) return false;
+	if (distance) *distance = nearest;
+	return true;
 }
 
 /*
@@ -46,19 +94,24 @@ void	NodeMesh::setScreenRect(const Rectf& bounds, const float depth)
 }
  */
 
-Rectf NodeMesh::getScreenRect(const Matrix44f& MVP, const Area& viewport, bool precise) const
+Rectf NodeMesh::getScreenRect(const mat4& MVP, const Area& viewport, bool precise) const
 {
 	Rectf rect = Node3d::getScreenRect(MVP, viewport, precise);
 	
-	Matrix44f composed_transform = MVP * mWorldTransform;
+	mat4 composed_transform = MVP * mWorldTransform;
 	
-	if (precise) {
-		std::vector<Vec3f> vertices = mMesh.getVertices();
-		std::vector<Vec2f> screen_points;
+	if (precise && !mIsLoading) {
+		std::vector<vec3> vertices;
+		if (mCompactMesh) {
+			vertices.resize(mCompactMesh->getNumVertices());
+			mCompactMesh->decodePositions(0, vertices.size(), vertices.data());
+		}
+		else vertices = mMesh.getVertices();
+		std::vector<vec2> screen_points;
 		screen_points.resize(vertices.size());
 		
-		std::vector<Vec3f>::const_iterator input_iter;
-		std::vector<Vec2f>::iterator output_iter = screen_points.begin();
+		std::vector<vec3>::const_iterator input_iter;
+		std::vector<vec2>::iterator output_iter = screen_points.begin();
 		for (input_iter = vertices.begin(); input_iter != vertices.end(); input_iter++, output_iter++) {
 			*output_iter = Node3d::objectToViewport( *input_iter, composed_transform, viewport );
 		}
@@ -66,12 +119,12 @@ Rectf NodeMesh::getScreenRect(const Matrix44f& MVP, const Area& viewport, bool p
 		rect.include(screen_points);
 	}
 	else {
-		AxisAlignedBox3f aabb = Node3d::getBounds();
-		AxisAlignedBox3f mesh_bounds = mMesh.calcBoundingBox();
+		AxisAlignedBox aabb = Node3d::getBounds();
+		AxisAlignedBox mesh_bounds = calcMeshBounds();
 		aabb.include(mesh_bounds);
 		
-		Vec2f screen_min = Node3d::objectToViewport( aabb.getMin(), composed_transform, viewport );
-		Vec2f screen_max = Node3d::objectToViewport( aabb.getMax(), composed_transform, viewport );
+		vec2 screen_min = Node3d::objectToViewport( aabb.getMin(), composed_transform, viewport );
+		vec2 screen_max = Node3d::objectToViewport( aabb.getMax(), composed_transform, viewport );
 		rect.include(screen_min);
 		rect.include(screen_max);
 	}
@@ -79,19 +132,19 @@ Rectf NodeMesh::getScreenRect(const Matrix44f& MVP, const Area& viewport, bool p
 	return rect;
 }
 
-AxisAlignedBox3f NodeMesh::getBounds() const
+AxisAlignedBox NodeMesh::getBounds() const
 {
-	AxisAlignedBox3f aabb = Node3d::getBounds();
-	AxisAlignedBox3f mesh_bounds = mMesh.calcBoundingBox().transformed(mTransform);
+	AxisAlignedBox aabb = Node3d::getBounds();
+	AxisAlignedBox mesh_bounds = calcMeshBounds().transformed(mTransform);
 	
 	aabb.include(mesh_bounds);
 	
 	return aabb;
 }
 
-AxisAlignedBox3f NodeMesh::getMeshBounds() const
+AxisAlignedBox NodeMesh::getMeshBounds() const
 {
-	return mMesh.calcBoundingBox().transformed(mTransform);
+	return calcMeshBounds().transformed(mTransform);
 }
 
 bool NodeMesh::mouseMove(MouseEvent event)
@@ -102,8 +155,8 @@ bool NodeMesh::mouseMove(MouseEvent event)
 	
 	// check if mouse is inside node (screen space -> object space)
 	//	Vec2f o = Node2d::viewportToObject(event.getPos(), *this);
-	Vec2f o = Vec2f(event.getPos());	
-	Matrix44f transform = mCamera.getProjectionMatrix() * mCamera.getModelViewMatrix();
+	vec2 o = vec2(event.getPos());	
+	mat4 transform = mCamera.getProjectionMatrix() * mCamera.getModelViewMatrix();
 	Area viewport = gl::getViewport();
 	if (getScreenRect(transform, viewport, true).contains(o)) {
 		mMeshColor = ColorA(0, 1, 0, 1);
@@ -122,8 +175,8 @@ bool NodeMesh::mouseDown(MouseEvent event)
 	
 	// check if we clicked inside node (screen space -> object space)
 	//	Vec2f o = Node2d::viewportToObject(event.getPos(), *this);
-	Vec2f pos = Vec2f(event.getPos());
-	Matrix44f transform = mCamera.getProjectionMatrix() * mCamera.getModelViewMatrix();
+	vec2 pos = vec2(event.getPos());
+	mat4 transform = mCamera.getProjectionMatrix() * mCamera.getModelViewMatrix();
 	Area viewport = gl::getViewport();
 	Rectf rect = getScreenRect(transform, viewport, true);
 	if (!rect.contains(pos)) return false;
@@ -153,7 +206,7 @@ bool NodeMesh::mouseDrag(MouseEvent event)
 //		Vec2f p = local_position.xy() - mMousePos;
 //		setPosition(p);
 		
-		Vec2f pos(event.getPos());
+		vec2 pos(event.getPos());
 		Area viewport = gl::getViewport();
 	
 //	float imagePlaneApectRatio = viewport.getWidth() / viewport.getHeight();
@@ -165,24 +218,22 @@ bool NodeMesh::mouseDrag(MouseEvent event)
 	
 		Ray r = mCamera.generateRay(pos.x/viewport.getWidth(), (viewport.getHeight()-pos.y)/viewport.getHeight(), mCamera.getAspectRatio());
 		
-		Vec3f n(mCamera.getEyePoint());
-	n.normalize();
-	Vec3f dVector = getPosition();
-		float distance = -dVector.dot(n);
-		Vec3f origin = r.getOrigin();
-		Vec3f direction = r.getDirection();
+		vec3 n = glm::normalize(mCamera.getEyePoint());
+	vec3 dVector = getPosition();
+		float distance = -glm::dot(dVector, n);
+		vec3 origin = r.getOrigin();
+		vec3 direction = r.getDirection();
 		
 		// calculate intersection point.
 		//t = -(AX0 + BY0 + CZ0 + D) / (AXd + BYd + CZd)
 		float t_hit = -(n.x*origin.x + n.y*origin.y + n.z*origin.z + distance) / (n.x*direction.x + n.y*direction.y + n.z*direction.z);
-		Vec3f intersection = origin + (direction * t_hit);
+		vec3 intersection = origin + (direction * t_hit);
 		
 		// apply the new translation values
 //		intersection = mWorldTransform.inverted().transformPoint(intersection);
 	//
-		Matrix44f parent_trans = mWorldTransform * mTransform.inverted();
-	parent_trans.invert();
-	intersection = parent_trans.transformPoint(intersection);
+		mat4 parent_trans = glm::inverse(mWorldTransform * glm::inverse(mTransform));
+	intersection = vec3(parent_trans * vec4(intersection, 1.0f));
 		setPosition(intersection);
 	//
 	
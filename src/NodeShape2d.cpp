@@ -1,7 +1,10 @@
 #include "cinder/gl/gl.h"
 #include "cinder/Triangulate.h"
 
+#include "BinaryStream.hpp"
 #include "NodeShape2d.h"
+#include "RenderBackend.h"
+#include "SceneSnapshot.h"
 
 using namespace ci;
 using namespace ci::app;
@@ -18,6 +21,9 @@ NodeShape2d::NodeShape2d(const ci::Shape2d& shape, const std::string& name, cons
 :	Node2d(name, active), mShape(shape), mIsDragged(false), mStrokeColor(ColorA(1,0,0,1)),
 	mFillSelectedColor(ColorA(0.9f,0.9f,0.9f,1.0f)), mFillUnselectedColor(ColorA::white()), mFillColor(ColorA::white())
 {
+	// update() keeps the size in sync with the shape
+	setUpdateEnabled();
+	setInteractive();
 }
 
 NodeShape2d::~NodeShape2d()
@@ -36,13 +42,22 @@ void NodeShape2d::update(double elapsed)
 	mSize = mScale * mShape.calcPreciseBoundingBox().getSize();
 }
 
-void NodeShape2d::draw()
+void NodeShape2d::draw(RenderBackend& renderer)
 {
-	gl::SaveColorState colorState;
-	gl::color(mFillColor);
-	gl::drawSolid(mShape);
-	gl::color(mStrokeColor);
-	gl::draw(mShape);
+	renderer.setColor(mFillColor);
+	renderer.drawSolidShape(mShape);
+	renderer.setColor(mStrokeColor);
+	renderer.drawShape(mShape);
+}
+
+void NodeShape2d::snapshot(SnapshotItem& item) const
+{
+	item.mColor = mFillColor;
+	item.mStrokeColor = mStrokeColor;
+	
+	// snapshots share one copy until the shape is replaced
+	if (!mSharedShape) mSharedShape = std::make_shared<const Shape2d>(mShape);
+	item.mShape = mSharedShape;
 }
 
 /*
@@ -84,6 +99,19 @@ Rectf NodeShape2d::getShapeBounds() const
 	return mShape.calcBoundingBox().transformCopy(mTransform);
 }
 
+Rectf NodeShape2d::getContentBounds() const
+{
+	return mShape.calcBoundingBox();
+}
+
+void NodeShape2d::setShape(const Shape2d& shape)
+{
+	mShape = shape;
+	mShapeMesh = Triangulator(mShape).calcMesh();
+	mSharedShape.reset();
+	setContentDirty();
+}
+
 Vec2f NodeShape2d::getAnchorPercentage()
 {
 	Rectf shape_bounds = mShape.calcBoundingBox();
@@ -102,14 +130,135 @@ bool NodeShape2d::mouseMove(MouseEvent event)
 //	Vec2f o = Node2d::viewportToObject(event.getPos(), *this);
 	Vec2f o = Vec2f(event.getPos());
 	if (getScreenRect().contains(o)) {
-		mStrokeColor = ColorA(0, 1, 0, 1);
+		setStrokeColor(ColorA(0, 1, 0, 1));
 		return true;
 	} else {
-		mStrokeColor = ColorA(1, 1, 1, 1);
+		setStrokeColor(ColorA(1, 1, 1, 1));
 		return false;
 	}
 }
 
+bool NodeShape2d::onPointerEvent(const PointerEvent& event)
+{
+	// ancestors see the event too, only react to our own
+	if (event.mPhase != PointerEvent::PHASE_TARGET) return false;
+	
+	Node2dRef parent = getParent<Node2d>();
+	vec2 local_position = parent? Node2d::worldToObject(event.mPosition, *parent): event.mPosition;
+	
+	switch (event.mType) {
+		case PointerEvent::POINTER_MOVE:
+			// highlighting is handled by enter and leave
+			return true;
+		case PointerEvent::POINTER_DOWN:
+			// calculate click offset
+			mMouseOffset = local_position - getPosition();
+			mIsDragged = true;
+			return true;
+		case PointerEvent::POINTER_DRAG:
+			if (!mIsDragged) return false;
+			setPosition(local_position - vec2(mMouseOffset));
+			return true;
+		case PointerEvent::POINTER_UP:
+			mIsDragged = false;
+			return false;
+		case PointerEvent::POINTER_ENTER:
+			setStrokeColor(ColorA(0, 1, 0, 1));
+			return true;
+		case PointerEvent::POINTER_LEAVE:
+			setStrokeColor(ColorA(1, 1, 1, 1));
+			return true;
+	}
+	
+	return false;
+}
+
+static void writeColor(BinaryWriter& writer, const ColorA& color)
+{
+	writer.write(color.r);
+	writer.write(color.g);
+	writer.write(color.b);
+	writer.write(color.a);
+}
+
+static bool readColor(BinaryReader& reader, ColorA& color)
+{
+	return reader.read(color.r) && reader.read(color.g) && reader.read(color.b) && reader.read(color.a);
+}
+
+void NodeShape2d::serialize(BinaryWriter& writer) const
+{
+	writeColor(writer, mFillColor);
+	writeColor(writer, mStrokeColor);
+	
+	const vector<Path2d>& contours = mShape.getContours();
+	writer.write(static_cast<uint32_t>(contours.size()));
+	for (auto itr = contours.begin(); itr != contours.end(); ++itr) {
+		const vector<vec2>& points = itr->getPoints();
+		const vector<Path2d::SegmentType>& segments = itr->getSegments();
+		writer.write(static_cast<uint32_t>(points.size()));
+		writer.write(static_cast<uint32_t>(segments.size()));
+		for (auto pt = points.begin(); pt != points.end(); ++pt) {
+			writer.write(pt->x);
+			writer.write(pt->y);
+		}
+		for (auto segment = segments.begin(); segment != segments.end(); ++segment) {
+			writer.write(static_cast<uint8_t>(*segment));
+		}
+	}
+}
+
+bool NodeShape2d::deserialize(BinaryReader& reader)
+{
+	ColorA fill_color, stroke_color;
+	uint32_t contour_count = 0;
+	if (!readColor(reader, fill_color) || !readColor(reader, stroke_color) || !reader.read(contour_count)) return false;
+	
+	Shape2d shape;
+	vector<vec2> points;
+	for (uint32_t i = 0; i < contour_count; ++i) {
+		uint32_t point_count = 0, segment_count = 0;
+		if (!reader.read(point_count) || !reader.read(segment_count)) return false;
+		
+		// reject counts the data can not hold before allocating for them
+		if (point_count > reader.getRemaining() / (2 * sizeof(float))) return false;
+		
+		points.resize(point_count);
+		for (uint32_t p = 0; p < point_count; ++p) {
+			if (!reader.read(points[p].x) || !reader.read(points[p].y)) return false;
+		}
+		
+		// the first point starts the contour, every segment consumes the points it ends with
+		Path2d path;
+		if (point_count > 0) path.moveTo(points[0]);
+		uint32_t used = point_count > 0? 1: 0;
+		for (uint32_t s = 0; s < segment_count; ++s) {
+			uint8_t segment = 0;
+			if (!reader.read(segment)) return false;
+			
+			uint32_t needed = segment == Path2d::LINETO? 1: segment == Path2d::QUADTO? 2: segment == Path2d::CUBICTO? 3: 0;
+			if (used == 0 || used + needed > point_count) return false;
+			
+			switch (segment) {
+				case Path2d::LINETO: path.lineTo(points[used]); break;
+				case Path2d::QUADTO: path.quadTo(points[used], points[used + 1]); break;
+				case Path2d::CUBICTO: path.curveTo(points[used], points[used + 1], points[used + 2]); break;
+				case Path2d::CLOSE: path.close(); break;
+				default: return false;
+			}
+			used += needed;
+		}
+		if (used != point_count) return false;
+		
+		if (point_count > 0) shape.appendContour(path);
+	}
+	
+	setFillColor(fill_color);
+	setStrokeColor(stroke_color);
+	setShape(shape);
+	return true;
+}
+
 bool NodeShape2d::mouseDown(MouseEvent event)
 {
 	// The event specifies the mouse coordinates in screen space, and our
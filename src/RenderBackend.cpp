@@ -0,0 +1,136 @@
+#include <algorithm>
+
+#include "CompactMesh.h"
+#include "RenderBackend.h"
+#include "SceneSnapshot.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+mat4 RenderBackend::toMat4(const mat3& affine)
+{
+	mat4 out(1);
+	out[0] = vec4(affine[0].x, affine[0].y, 0, 0);
+	out[1] = vec4(affine[1].x, affine[1].y, 0, 0);
+	out[3] = vec4(affine[2].x, affine[2].y, 0, 1);
+	return out;
+}
+
+void RenderBackend::drawMesh(const CompactMesh& mesh)
+{
+	TriMesh decoded;
+	mesh.decode(decoded);
+	drawMesh(decoded);
+}
+
+void RenderBackend::drawSnapshot(const SceneSnapshot& snapshot)
+{
+	const vector<SnapshotItem>& items = snapshot.getItems();
+	for (vector<SnapshotItem>::const_iterator itr = items.begin(); itr != items.end(); ++itr) {
+		if (!itr->mIsVisible || !(itr->mMesh || itr->mCompactMesh || itr->mShape)) continue;
+
+		// like deepDraw, each node is drawn with its world transformation
+		pushModelMatrix(itr->mWorldTransform);
+		setColor(itr->mColor);
+		if (itr->mCompactMesh) drawMesh(*itr->mCompactMesh);
+		else if (itr->mMesh) drawMesh(*itr->mMesh);
+		if (itr->mShape) {
+			drawSolidShape(*itr->mShape);
+			setColor(itr->mStrokeColor);
+			drawShape(*itr->mShape);
+		}
+		popModelMatrix();
+	}
+}
+
+RenderBackendRecorder::RenderBackendRecorder()
+:	RenderBackend(), mStackDepth(0), mMaxStackDepth(0)
+{
+}
+
+void RenderBackendRecorder::record(RenderCommand::Type type, const void* resource)
+{
+	RenderCommand command;
+	command.mType = type;
+	command.mResource = resource;
+	mCommands.push_back(command);
+}
+
+void RenderBackendRecorder::beginFrame()
+{
+	record(RenderCommand::BEGIN_FRAME);
+}
+
+void RenderBackendRecorder::endFrame()
+{
+	record(RenderCommand::END_FRAME);
+}
+
+void RenderBackendRecorder::clear(const ColorA& color)
+{
+	record(RenderCommand::CLEAR);
+	mCommands.back().mColor = color;
+}
+
+void RenderBackendRecorder::pushModelMatrix(const mat4& transform)
+{
+	record(RenderCommand::PUSH_MODEL_MATRIX);
+	mCommands.back().mTransform = transform;
+
+	mStackDepth++;
+	mMaxStackDepth = std::max(mMaxStackDepth, mStackDepth);
+}
+
+void RenderBackendRecorder::popModelMatrix()
+{
+	record(RenderCommand::POP_MODEL_MATRIX);
+
+	if (mStackDepth > 0) mStackDepth--;
+}
+
+void RenderBackendRecorder::setColor(const ColorA& color)
+{
+	record(RenderCommand::SET_COLOR);
+	mCommands.back().mColor = color;
+}
+
+void RenderBackendRecorder::drawMesh(const TriMesh& mesh)
+{
+	record(RenderCommand::DRAW_MESH, &mesh);
+}
+
+void RenderBackendRecorder::drawMesh(const CompactMesh& mesh)
+{
+	record(RenderCommand::DRAW_COMPACT_MESH, &mesh);
+}
+
+void RenderBackendRecorder::drawShape(const Shape2d& shape)
+{
+	record(RenderCommand::DRAW_SHAPE, &shape);
+}
+
+void RenderBackendRecorder::drawSolidShape(const Shape2d& shape)
+{
+	record(RenderCommand::DRAW_SOLID_SHAPE, &shape);
+}
+
+size_t RenderBackendRecorder::getCommandCount(RenderCommand::Type type) const
+{
+	return std::count_if(mCommands.begin(), mCommands.end(), [type](const RenderCommand& command) {
+		return command.mType == type;
+	});
+}
+
+void RenderBackendRecorder::clear()
+{
+	mCommands.clear();
+	mStackDepth = 0;
+	mMaxStackDepth = 0;
+}
@@ -0,0 +1,163 @@
+#include <cmath>
+#include <cstddef>
+
+#include "cinder/gl/gl.h"
+#include "cinder/gl/scoped.h"
+
+#include "CompactMesh.h"
+#include "RenderBackendGl.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+const uint32_t RenderBackendGl::MAX_UNUSED_FRAMES;
+
+RenderBackendGlRef RenderBackendGl::create()
+{
+	return RenderBackendGlRef( new RenderBackendGl() );
+}
+
+void RenderBackendGl::endFrame()
+{
+	// the ids of released meshes are never drawn again, their buffers age out
+	++mFrame;
+	for (unordered_map<uint64_t, CachedMesh>::iterator itr = mMeshCache.begin(); itr != mMeshCache.end();) {
+		if (mFrame - itr->second.mLastFrame > MAX_UNUSED_FRAMES) itr = mMeshCache.erase(itr);
+		else ++itr;
+	}
+}
+
+void RenderBackendGl::clear(const ColorA& color)
+{
+	gl::clear(color);
+}
+
+void RenderBackendGl::pushModelMatrix(const mat4& transform)
+{
+	gl::pushModelMatrix();
+	gl::multModelMatrix(transform);
+	mColorStack.push_back(gl::context()->getCurrentColor());
+}
+
+void RenderBackendGl::popModelMatrix()
+{
+	gl::popModelMatrix();
+	if (mColorStack.empty()) return;
+
+	gl::color(mColorStack.back());
+	mColorStack.pop_back();
+}
+
+void RenderBackendGl::setColor(const ColorA& color)
+{
+	gl::color(color);
+}
+
+void RenderBackendGl::drawMesh(const TriMesh& mesh)
+{
+	gl::draw(mesh);
+}
+
+void RenderBackendGl::drawMesh(const CompactMesh& mesh)
+{
+	// like gl::draw(), nothing can be drawn without a program
+	const gl::GlslProg* glsl = gl::context()->getGlslProg();
+	if (!glsl) return;
+
+	// compact meshes are read-only, so they are uploaded once
+	CachedMesh& cached = mMeshCache[mesh.getId()];
+	if (!cached.mVertices) upload(mesh, cached);
+	if (!cached.mVao || cached.mProgram != glsl->getHandle()) bindAttributes(cached, *glsl);
+	cached.mLastFrame = mFrame;
+	if (!cached.mIndexCount) return;
+
+	gl::ScopedModelMatrix model;
+	gl::multModelMatrix(cached.mDecode);
+	gl::ScopedVao vao(cached.mVao);
+	gl::context()->setDefaultShaderVars();
+	gl::drawElements(GL_TRIANGLES, cached.mIndexCount, cached.mIndexType, nullptr);
+}
+
+void RenderBackendGl::upload(const CompactMesh& mesh, CachedMesh& cached)
+{
+	// an axis without extent has a step of 0, its quantized values are all 0 anyway
+	vec3 step = mesh.getPositionStep();
+	for (int axis = 0; axis < 3; ++axis) if (step[axis] <= 0.0f) step[axis] = 1.0f;
+	cached.mDecode = glm::scale(glm::translate(mat4(1), mesh.getPositionOffset()), step);
+
+	const size_t count = mesh.getNumVertices();
+	cached.mHasNormals = mesh.hasNormals();
+	cached.mHasTexCoords = mesh.hasTexCoords0();
+	vector<CompactVertex> vertices(count);
+	for (size_t i = 0; i < count; ++i) {
+		CompactVertex& vertex = vertices[i];
+		for (int axis = 0; axis < 3; ++axis) vertex.mPosition[axis] = mesh.getQuantizedPositions(axis)[i];
+		vertex.mPosition[3] = 0;
+
+		// the normal matrix of the decoding scale divides by the steps, so they are multiplied in beforehand
+		vec3 normal = cached.mHasNormals? glm::normalize(mesh.getNormal(i) * step): vec3(0.0f);
+		for (int axis = 0; axis < 3; ++axis) vertex.mNormal[axis] = static_cast<int8_t>(std::lround(glm::clamp(normal[axis], -1.0f, 1.0f) * 127.0f));
+		vertex.mNormal[3] = 0;
+
+		vertex.mTexCoord[0] = cached.mHasTexCoords? mesh.getHalfTexCoords()[i * 2]: 0;
+		vertex.mTexCoord[1] = cached.mHasTexCoords? mesh.getHalfTexCoords()[i * 2 + 1]: 0;
+	}
+	cached.mVertices = gl::Vbo::create(GL_ARRAY_BUFFER, vertices, GL_STATIC_DRAW);
+
+	// the indices are uploaded as they are stored
+	cached.mIndexCount = static_cast<GLsizei>(mesh.getNumIndices());
+	if (mesh.hasShortIndices()) {
+		cached.mIndexType = GL_UNSIGNED_SHORT;
+		cached.mIndices = gl::Vbo::create(GL_ELEMENT_ARRAY_BUFFER, mesh.getShortIndices(), GL_STATIC_DRAW);
+	}
+	else {
+		cached.mIndexType = GL_UNSIGNED_INT;
+		cached.mIndices = gl::Vbo::create(GL_ELEMENT_ARRAY_BUFFER, mesh.getIndices(), GL_STATIC_DRAW);
+	}
+}
+
+void RenderBackendGl::bindAttributes(CachedMesh& cached, const gl::GlslProg& glsl)
+{
+	cached.mVao = gl::Vao::create();
+	cached.mProgram = glsl.getHandle();
+
+	gl::ScopedVao vao(cached.mVao);
+	gl::ScopedBuffer vertices(cached.mVertices);
+	const GLsizei stride = sizeof(CompactVertex);
+
+	int location = glsl.getAttribSemanticLocation(geom::Attrib::POSITION);
+	if (location >= 0) {
+		gl::enableVertexAttribArray(location);
+		gl::vertexAttribPointer(location, 3, GL_UNSIGNED_SHORT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(CompactVertex, mPosition)));
+	}
+	location = glsl.getAttribSemanticLocation(geom::Attrib::NORMAL);
+	if (cached.mHasNormals && location >= 0) {
+		gl::enableVertexAttribArray(location);
+		gl::vertexAttribPointer(location, 3, GL_BYTE, GL_TRUE, stride, reinterpret_cast<const GLvoid*>(offsetof(CompactVertex, mNormal)));
+	}
+	location = glsl.getAttribSemanticLocation(geom::Attrib::TEX_COORD_0);
+	if (cached.mHasTexCoords && location >= 0) {
+		gl::enableVertexAttribArray(location);
+		gl::vertexAttribPointer(location, 2, GL_HALF_FLOAT, GL_FALSE, stride, reinterpret_cast<const GLvoid*>(offsetof(CompactVertex, mTexCoord)));
+	}
+
+	// the element buffer binding is part of the state of the vertex array
+	cached.mIndices->bind();
+}
+
+void RenderBackendGl::drawShape(const Shape2d& shape)
+{
+	gl::draw(shape);
+}
+
+void RenderBackendGl::drawSolidShape(const Shape2d& shape)
+{
+	gl::drawSolid(shape);
+}
@@ -0,0 +1,302 @@
+#include <algorithm>
+#include <cstring>
+
+#if defined( _WIN32 )
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "SceneArchive.h"
+
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Map the file on a loader thread and hand the archive over
+//
+///////////////////////////////////////////////////////////////////////////
+
+const uint32_t SceneArchive::INVALID_INDEX;
+
+//! FNV-1a, hashes the names in place without copying them into strings
+static uint64_t hashName(const char* name, size_t size)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < size; ++i) {
+		hash ^= static_cast<uint8_t>(name[i]);
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+SceneArchiveRef SceneArchive::open(const string& path, const SceneTypeRegistry& registry)
+{
+	SceneArchiveRef archive( new SceneArchive(registry) );
+
+#if defined( _WIN32 )
+	HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) return SceneArchiveRef();
+
+	LARGE_INTEGER size;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+		mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	}
+	CloseHandle(file);
+	if (!mapping) return SceneArchiveRef();
+
+	// the view keeps the mapping alive
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!data) return SceneArchiveRef();
+
+	archive->mSize = static_cast<size_t>(size.QuadPart);
+#else
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file < 0) return SceneArchiveRef();
+
+	struct stat info;
+	void* data = MAP_FAILED;
+	if (fstat(file, &info) == 0 && info.st_size > 0) {
+		data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	}
+	::close(file);
+	if (data == MAP_FAILED) return SceneArchiveRef();
+
+	archive->mSize = static_cast<size_t>(info.st_size);
+#endif
+
+	archive->mData = static_cast<const uint8_t*>(data);
+	archive->mIsMapped = true;
+
+	if (!archive->validate()) return SceneArchiveRef();
+	return archive;
+}
+
+SceneArchiveRef SceneArchive::create(vector<uint8_t> buffer, const SceneTypeRegistry& registry)
+{
+	SceneArchiveRef archive( new SceneArchive(registry) );
+	archive->mBuffer.swap(buffer);
+	archive->mData = archive->mBuffer.data();
+	archive->mSize = archive->mBuffer.size();
+
+	if (!archive->validate()) return SceneArchiveRef();
+	return archive;
+}
+
+SceneArchive::SceneArchive(const SceneTypeRegistry& registry)
+:	mRegistry(registry), mData(nullptr), mSize(0), mIsMapped(false), mMaterializedCount(0)
+{
+	memset(&mHeader, 0, sizeof(mHeader));
+}
+
+SceneArchive::~SceneArchive()
+{
+	unmap();
+}
+
+void SceneArchive::unmap()
+{
+	if (mIsMapped) {
+#if defined( _WIN32 )
+		UnmapViewOfFile(mData);
+#else
+		munmap(const_cast<uint8_t*>(mData), mSize);
+#endif
+	}
+
+	mData = nullptr;
+	mSize = 0;
+	mIsMapped = false;
+}
+
+bool SceneArchive::validate()
+{
+	if (!SceneReader::readHeader(mData, mSize, mHeader)) return false;
+
+	// the records are read in place
+	if (mHeader.mNodeOffset % sizeof(uint32_t) != 0 || mHeader.mRecordSize % sizeof(uint32_t) != 0) return false;
+
+	// the subtrees that contain the current record, innermost last
+	vector<pair<uint32_t, uint32_t>> ancestors;
+	uint32_t known_type = 0;
+
+	for (uint32_t i = 0; i < mHeader.mNodeCount; ++i) {
+		const SceneNodeRecord& record = getRecord(i);
+		if (!SceneReader::checkRecord(mHeader, record, i)) return false;
+
+		// consecutive nodes mostly share their type
+		if (record.mType != known_type) {
+			if (!mRegistry.find(record.mType)) return false;
+			known_type = record.mType;
+		}
+
+		// subtrees are skipped by their size, so the parent must be the innermost subtree that
+		// contains the record and hold all of its descendants
+		uint32_t last = i + record.mSubtreeSize;
+		if (i > 0) {
+			while (!ancestors.empty() && ancestors.back().second < i) ancestors.pop_back();
+			if (ancestors.empty() || ancestors.back().first != record.mParent || last > ancestors.back().second) return false;
+		}
+		ancestors.push_back(make_pair(i, last));
+	}
+
+	mNodes.resize(mHeader.mNodeCount);
+	mStates.assign(mHeader.mNodeCount, STATE_UNLOADED);
+	return true;
+}
+
+string SceneArchive::getName(uint32_t index) const
+{
+	const SceneNodeRecord& record = getRecord(index);
+	return string(reinterpret_cast<const char*>(mData + mHeader.mStringOffset + record.mNameOffset), record.mNameSize);
+}
+
+void SceneArchive::buildNameIndex() const
+{
+	const char* strings = reinterpret_cast<const char*>(mData + mHeader.mStringOffset);
+
+	mNameIndex.resize(mHeader.mNodeCount);
+	for (uint32_t i = 0; i < mHeader.mNodeCount; ++i) {
+		const SceneNodeRecord& record = getRecord(i);
+		mNameIndex[i] = make_pair(hashName(strings + record.mNameOffset, record.mNameSize), i);
+	}
+
+	// equal hashes stay ordered by index, so the first match is the first node
+	sort(mNameIndex.begin(), mNameIndex.end());
+}
+
+uint32_t SceneArchive::findIndex(const string& name) const
+{
+	if (mNameIndex.empty()) buildNameIndex();
+
+	const char* strings = reinterpret_cast<const char*>(mData + mHeader.mStringOffset);
+	uint64_t hash = hashName(name.data(), name.size());
+
+	auto itr = lower_bound(mNameIndex.begin(), mNameIndex.end(), make_pair(hash, uint32_t(0)));
+	for (; itr != mNameIndex.end() && itr->first == hash; ++itr) {
+		const SceneNodeRecord& record = getRecord(itr->second);
+		if (record.mNameSize == name.size() && memcmp(strings + record.mNameOffset, name.data(), name.size()) == 0) {
+			return itr->second;
+		}
+	}
+
+	return INVALID_INDEX;
+}
+
+NodeRef SceneArchive::materialize(uint32_t index, NodeBase* parent)
+{
+	const SceneNodeRecord& record = getRecord(index);
+	const SceneTypeRegistry::Entry* entry = mRegistry.find(record.mType);
+
+	NodeRef node = entry? SceneReader::createNode(*entry, record, mData, mHeader): NodeRef();
+	if (!node) {
+		mStates[index] = STATE_FAILED;
+		return node;
+	}
+
+	// inactive nodes keep their descendants in the file until they are needed
+	bool collapsed = record.mSubtreeSize > 0 && !(record.mFlags & SceneNodeRecord::FLAG_ACTIVE);
+	mStates[index] = collapsed? STATE_COLLAPSED: STATE_EXPANDED;
+	if (collapsed) mCollapsed.push_back(index);
+
+	mNodes[index] = node;
+	++mMaterializedCount;
+
+	if (parent) parent->addChild(node);
+	return node;
+}
+
+void SceneArchive::materializeDescendants(uint32_t index)
+{
+	uint32_t end = index + getRecord(index).mSubtreeSize;
+
+	// the parent of a record always precedes it, so it was handled already
+	for (uint32_t i = index + 1; i <= end;) {
+		const SceneNodeRecord& record = getRecord(i);
+
+		NodeRef parent = mStates[record.mParent] == STATE_EXPANDED? mNodes[record.mParent].lock(): NodeRef();
+		if (!parent || mStates[i] != STATE_UNLOADED) {
+			i += record.mSubtreeSize + 1;
+			continue;
+		}
+
+		NodeRef node = materialize(i, parent.get());
+		i += node? 1: record.mSubtreeSize + 1;
+	}
+}
+
+NodeRef SceneArchive::getRoot()
+{
+	if (mStates[0] == STATE_UNLOADED) {
+		mRoot = materialize(0, nullptr);
+		if (mStates[0] == STATE_EXPANDED) materializeDescendants(0);
+	}
+
+	return mRoot;
+}
+
+bool SceneArchive::expand(uint32_t index)
+{
+	if (index >= mHeader.mNodeCount) return false;
+	if (mStates[index] == STATE_EXPANDED) return true;
+	if (mStates[index] != STATE_COLLAPSED || mNodes[index].expired()) return false;
+
+	mStates[index] = STATE_EXPANDED;
+	materializeDescendants(index);
+	return true;
+}
+
+NodeRef SceneArchive::getNode(uint32_t index)
+{
+	if (index >= mHeader.mNodeCount) return NodeRef();
+
+	// the root anchors every other node
+	if (mStates[0] == STATE_UNLOADED) getRoot();
+
+	// expand the closest created ancestor until the node exists, one level of collapsed nodes at a time
+	while (mStates[index] == STATE_UNLOADED) {
+		uint32_t ancestor = getRecord(index).mParent;
+		while (mStates[ancestor] == STATE_UNLOADED) ancestor = getRecord(ancestor).mParent;
+
+		if (mStates[ancestor] != STATE_COLLAPSED || !expand(ancestor)) return NodeRef();
+	}
+
+	return mNodes[index].lock();
+}
+
+NodeRef SceneArchive::findNode(const string& name)
+{
+	uint32_t index = findIndex(name);
+	if (index == INVALID_INDEX) return NodeRef();
+	return getNode(index);
+}
+
+size_t SceneArchive::sync()
+{
+	size_t count = 0;
+
+	for (size_t i = 0; i < mCollapsed.size();) {
+		uint32_t index = mCollapsed[i];
+		NodeRef node = mStates[index] == STATE_COLLAPSED? mNodes[index].lock(): NodeRef();
+
+		if (node && !node->isActive()) {
+			++i;
+			continue;
+		}
+
+		// expanded on demand, destroyed or activated, either way it leaves the list
+		mCollapsed[i] = mCollapsed.back();
+		mCollapsed.pop_back();
+
+		// nodes collapsed by the expansion are appended and checked in this pass as well
+		if (node && expand(index)) ++count;
+	}
+
+	return count;
+}
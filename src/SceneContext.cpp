@@ -0,0 +1,89 @@
+#include "SceneContext.h"
+
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+SceneContext::SceneContext()
+:	mHoleCount(0), mIsUpdating(false)
+{
+}
+
+SceneContext::~SceneContext()
+{
+	setRoot(NodeRef());
+}
+
+void SceneContext::setRoot(const NodeRef& root)
+{
+	if (mRoot == root) return;
+
+	if (mRoot) mRoot->setContext(nullptr);
+	mRoot = root;
+	if (mRoot) mRoot->setContext(this);
+}
+
+void SceneContext::registerUpdate(NodeBase& node)
+{
+	node.mUpdateIndex = static_cast<uint32_t>(mUpdateList.size());
+	mUpdateList.push_back(&node);
+}
+
+void SceneContext::unregisterUpdate(NodeBase& node)
+{
+	uint32_t index = node.mUpdateIndex;
+	if (index >= mUpdateList.size() || mUpdateList[index] != &node) return;
+
+	// leave a hole while iterating, moving entries would skip or repeat nodes
+	if (mIsUpdating) {
+		mUpdateList[index] = nullptr;
+		++mHoleCount;
+	}
+	else {
+		NodeBase* last = mUpdateList.back();
+		mUpdateList[index] = last;
+		last->mUpdateIndex = index;
+		mUpdateList.pop_back();
+	}
+
+	node.mUpdateIndex = NodeBase::INVALID_UPDATE_INDEX;
+}
+
+void SceneContext::update(double elapsed)
+{
+	sync();
+
+	mIsUpdating = true;
+
+	// nodes registered during the loop are appended and updated in the same frame
+	for (size_t i = 0; i < mUpdateList.size(); ++i) {
+		NodeBase* node = mUpdateList[i];
+		if (node) node->update(elapsed);
+	}
+
+	mIsUpdating = false;
+
+	if (mHoleCount > 0) compact();
+
+	sync();
+}
+
+void SceneContext::compact()
+{
+	size_t count = 0;
+	for (size_t i = 0; i < mUpdateList.size(); ++i) {
+		NodeBase* node = mUpdateList[i];
+		if (!node) continue;
+
+		node->mUpdateIndex = static_cast<uint32_t>(count);
+		mUpdateList[count++] = node;
+	}
+
+	mUpdateList.resize(count);
+	mHoleCount = 0;
+}
@@ -0,0 +1,583 @@
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <typeindex>
+
+#include "Node2d.h"
+#include "Node3d.h"
+#include "SceneDelta.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Send only the transformation components that changed
+//
+///////////////////////////////////////////////////////////////////////////
+
+const uint32_t SceneDeltaHeader::MAGIC;
+const uint16_t SceneDeltaHeader::VERSION;
+const uint64_t SceneDeltaHeader::NO_ROOT;
+const uint32_t SceneDeltaEncoder::INVALID_SLOT;
+
+static const uint32_t ALL_SECTIONS = SceneDeltaHeader::DELTA_CREATE | SceneDeltaHeader::DELTA_FLAGS | SceneDeltaHeader::DELTA_TRANSFORM
+	| SceneDeltaHeader::DELTA_CONTENT | SceneDeltaHeader::DELTA_CHILDREN;
+
+//! the quantization step of 2d rotations
+static const double ANGLE_STEP = 6.283185307179586 / 65536.0;
+static const double SQRT2 = 1.4142135623730951;
+//! the number of steps between 0 and +-1/sqrt(2) of a packed quaternion component
+static const double ROTATION_STEPS = 511.0;
+
+//! returns the number of components of the vectors of a node, 0 if it has no transformation
+static uint8_t getDimensions(const NodeBase& node)
+{
+	if (dynamic_cast<const Node2d*>(&node)) return 2;
+	if (dynamic_cast<const Node3d*>(&node)) return 3;
+	return 0;
+}
+
+static int32_t quantize(double value, double step)
+{
+	double steps = floor(value / step + 0.5);
+	if (steps != steps) return 0;
+	return static_cast<int32_t>(max(-2147483647.0, min(2147483647.0, steps)));
+}
+
+static void writeVector(BinaryWriter& writer, const float* values, uint8_t dimensions, float step)
+{
+	for (uint8_t i = 0; i < dimensions; ++i) writer.write(quantize(values[i], step));
+}
+
+static bool readVector(BinaryReader& reader, float* values, uint8_t dimensions, float step)
+{
+	for (uint8_t i = 0; i < dimensions; ++i) {
+		int32_t steps;
+		if (!reader.read(steps)) return false;
+		values[i] = static_cast<float>(double(steps) * step);
+	}
+	return true;
+}
+
+/**
+ * Packs a quaternion (x, y, z, w) into 32 bits: the index of the largest component, and the
+ * other three at 10 bits each. The sign is chosen so the largest component is positive and
+ * can be restored from the others, which all lie within +-1/sqrt(2). The grid is symmetric
+ * around 511, so components that are 0 (as in the identity) are restored exactly.
+ */
+static uint32_t packRotation(const float* rotation)
+{
+	double length = sqrt(double(rotation[0]) * rotation[0] + double(rotation[1]) * rotation[1]
+		+ double(rotation[2]) * rotation[2] + double(rotation[3]) * rotation[3]);
+
+	// the identity stands in for rotations that can not be normalized
+	float identity[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+	if (!(length > 0.0)) {
+		rotation = identity;
+		length = 1.0;
+	}
+
+	uint32_t largest = 0;
+	for (uint32_t i = 1; i < 4; ++i) {
+		if (fabs(rotation[i]) > fabs(rotation[largest])) largest = i;
+	}
+
+	double scale = (rotation[largest] < 0.0f? -1.0: 1.0) / length;
+	uint32_t packed = largest << 30;
+	uint32_t shift = 20;
+	for (uint32_t i = 0; i < 4; ++i) {
+		if (i == largest) continue;
+		double value = rotation[i] * scale * SQRT2 * ROTATION_STEPS + ROTATION_STEPS;
+		packed |= static_cast<uint32_t>(max(0.0, min(2.0 * ROTATION_STEPS, floor(value + 0.5)))) << shift;
+		shift -= 10;
+	}
+	return packed;
+}
+
+static void unpackRotation(uint32_t packed, float* rotation)
+{
+	uint32_t largest = packed >> 30;
+	uint32_t shift = 20;
+	double sum = 0.0;
+
+	for (uint32_t i = 0; i < 4; ++i) {
+		if (i == largest) continue;
+		double value = (double((packed >> shift) & 1023) - ROTATION_STEPS) / ROTATION_STEPS / SQRT2;
+		rotation[i] = static_cast<float>(value);
+		sum += value * value;
+		shift -= 10;
+	}
+	rotation[largest] = static_cast<float>(sqrt(max(0.0, 1.0 - sum)));
+}
+
+SceneDeltaEncoder::SceneDeltaEncoder(SceneContext& context, const SceneTypeRegistry& registry)
+:	mContext(context), mRegistry(registry), mVersion(1), mForgotten(0), mRootId(SceneDeltaHeader::NO_ROOT),
+	mStep(1.0f / 1024.0f), mHead(INVALID_SLOT), mTail(INVALID_SLOT)
+{
+	mContext.getJournal().setEnabled();
+
+	const NodeRef& root = mContext.getRoot();
+	if (!root) return;
+
+	mRootId = root->getId();
+	vector<NodeBase*> stack(1, root.get());
+	while (!stack.empty()) {
+		NodeBase* node = stack.back();
+		stack.pop_back();
+		track(*node);
+
+		const NodeDeque& children = node->getChildren();
+		for (auto itr = children.rbegin(); itr != children.rend(); ++itr) stack.push_back(itr->get());
+	}
+}
+
+uint32_t SceneDeltaEncoder::find(uint64_t id) const
+{
+	auto itr = mIndex.find(id);
+	return itr != mIndex.end()? itr->second: INVALID_SLOT;
+}
+
+void SceneDeltaEncoder::track(NodeBase& node)
+{
+	uint32_t slot = find(node.getId());
+	if (slot == INVALID_SLOT) {
+		if (mFree.empty()) {
+			slot = static_cast<uint32_t>(mSlots.size());
+			mSlots.push_back(Tracked());
+		}
+		else {
+			slot = mFree.back();
+			mFree.pop_back();
+		}
+
+		mIndex[node.getId()] = slot;
+		mSlots[slot].mId = node.getId();
+		mSlots[slot].mLatest = 0;
+	}
+
+	Tracked& tracked = mSlots[slot];
+	tracked.mNode = static_pointer_cast<NodeBase>(node.shared_from_this());
+	tracked.mCreated = tracked.mFlags = tracked.mTransform = tracked.mContent = tracked.mChildren = mVersion;
+	tracked.mRemoved = 0;
+	touch(slot);
+}
+
+void SceneDeltaEncoder::touch(uint32_t slot)
+{
+	// slots that never changed are not linked yet
+	if (mSlots[slot].mLatest) unlink(slot);
+
+	Tracked& tracked = mSlots[slot];
+	tracked.mLatest = mVersion;
+	tracked.mPrev = mTail;
+	tracked.mNext = INVALID_SLOT;
+
+	if (mTail != INVALID_SLOT) mSlots[mTail].mNext = slot;
+	else mHead = slot;
+	mTail = slot;
+}
+
+void SceneDeltaEncoder::unlink(uint32_t slot)
+{
+	Tracked& tracked = mSlots[slot];
+	if (tracked.mPrev != INVALID_SLOT) mSlots[tracked.mPrev].mNext = tracked.mNext;
+	else mHead = tracked.mNext;
+	if (tracked.mNext != INVALID_SLOT) mSlots[tracked.mNext].mPrev = tracked.mPrev;
+	else mTail = tracked.mPrev;
+
+	tracked.mPrev = tracked.mNext = INVALID_SLOT;
+}
+
+uint32_t SceneDeltaEncoder::capture()
+{
+	const vector<ChangeJournal::Record>& records = mContext.getJournal().getRecords();
+	const NodeRef& root = mContext.getRoot();
+	uint64_t root_id = root? root->getId(): SceneDeltaHeader::NO_ROOT;
+	if (records.empty() && root_id == mRootId) return mVersion;
+
+	++mVersion;
+	mRootId = root_id;
+
+	for (auto itr = records.begin(); itr != records.end(); ++itr) {
+		uint32_t slot = find(itr->mId);
+
+		if (!itr->mNode) {
+			// a node that entered and left since the last capture was never reported
+			if (slot == INVALID_SLOT) continue;
+
+			mSlots[slot].mNode.reset();
+			mSlots[slot].mRemoved = mVersion;
+			touch(slot);
+		}
+		else if (slot == INVALID_SLOT || mSlots[slot].mRemoved || (itr->mChanges & ChangeJournal::CHANGE_ADDED)) {
+			track(*itr->mNode);
+		}
+		else {
+			Tracked& tracked = mSlots[slot];
+			if (itr->mChanges & (ChangeJournal::CHANGE_ACTIVE | ChangeJournal::CHANGE_INTERACTIVE)) tracked.mFlags = mVersion;
+			if (itr->mChanges & ChangeJournal::CHANGE_TRANSFORM) tracked.mTransform = mVersion;
+			if (itr->mChanges & ChangeJournal::CHANGE_CONTENT) tracked.mContent = mVersion;
+			if (itr->mChanges & ChangeJournal::CHANGE_CHILDREN) tracked.mChildren = mVersion;
+			touch(slot);
+		}
+	}
+
+	return mVersion;
+}
+
+bool SceneDeltaEncoder::encode(uint32_t since, vector<uint8_t>& buffer)
+{
+	if (since > mVersion || (since && since < mForgotten)) return false;
+
+	SceneDeltaHeader header;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = SceneDeltaHeader::MAGIC;
+	header.mVersion = SceneDeltaHeader::VERSION;
+	header.mFromVersion = since;
+	header.mToVersion = mVersion;
+	header.mRootId = mRootId;
+	header.mStep = mStep;
+
+	buffer.clear();
+	BinaryWriter writer(buffer);
+	writer.writeBytes(&header, sizeof(header));
+
+	// the slots are ordered by their last change, so the walk stops at the first older one
+	mChanged.clear();
+	for (uint32_t slot = mTail; slot != INVALID_SLOT && mSlots[slot].mLatest > since; slot = mSlots[slot].mPrev) {
+		mChanged.push_back(slot);
+	}
+
+	uint32_t count = 0;
+	for (auto itr = mChanged.rbegin(); itr != mChanged.rend(); ++itr) {
+		const Tracked& tracked = mSlots[*itr];
+		NodeRef node = tracked.mNode.lock();
+
+		if (!node) {
+			// a full snapshot only holds the nodes in the scene
+			if (!since) continue;
+
+			writer.write(tracked.mId);
+			writer.write(static_cast<uint8_t>(SceneDeltaHeader::DELTA_REMOVE));
+		}
+		else if (!writeEntry(tracked, *node, since, writer)) return false;
+
+		++count;
+	}
+
+	memcpy(buffer.data() + offsetof(SceneDeltaHeader, mEntryCount), &count, sizeof(count));
+	return true;
+}
+
+bool SceneDeltaEncoder::writeEntry(const Tracked& tracked, const NodeBase& node, uint32_t since, BinaryWriter& writer)
+{
+	uint32_t bits = 0;
+	if (tracked.mCreated > since) bits = ALL_SECTIONS;
+	else {
+		if (tracked.mFlags > since) bits |= SceneDeltaHeader::DELTA_FLAGS;
+		if (tracked.mTransform > since) bits |= SceneDeltaHeader::DELTA_TRANSFORM;
+		if (tracked.mContent > since) bits |= SceneDeltaHeader::DELTA_CONTENT;
+		if (tracked.mChildren > since) bits |= SceneDeltaHeader::DELTA_CHILDREN;
+	}
+
+	writer.write(tracked.mId);
+	writer.write(static_cast<uint8_t>(bits));
+
+	if (bits & SceneDeltaHeader::DELTA_CREATE) {
+		const SceneTypeRegistry::Entry* entry = mRegistry.find(node);
+		if (!entry) return false;
+
+		writer.write(entry->mId);
+		writer.writeString(node.getName());
+	}
+
+	SceneNodeRecord record;
+	memset(&record, 0, sizeof(record));
+	SceneWriter::captureRecord(node, record);
+	uint8_t dimensions = getDimensions(node);
+
+	if (bits & SceneDeltaHeader::DELTA_FLAGS) writer.write(static_cast<uint8_t>(record.mFlags));
+
+	if (bits & SceneDeltaHeader::DELTA_TRANSFORM) {
+		writer.write(dimensions);
+		writeVector(writer, record.mPosition, dimensions, mStep);
+		if (dimensions == 2) writer.write(quantize(record.mRotation[0], ANGLE_STEP));
+		if (dimensions == 3) writer.write(packRotation(record.mRotation));
+		writeVector(writer, record.mScale, dimensions, mStep);
+		writeVector(writer, record.mPivot, dimensions, mStep);
+	}
+
+	if (bits & SceneDeltaHeader::DELTA_CONTENT) {
+		writer.write(dimensions);
+		writeVector(writer, record.mSize, dimensions, mStep);
+
+		mPayload.clear();
+		BinaryWriter payload(mPayload);
+		node.serialize(payload);
+		writer.write(static_cast<uint32_t>(mPayload.size()));
+		writer.writeBytes(mPayload.data(), mPayload.size());
+	}
+
+	if (bits & SceneDeltaHeader::DELTA_CHILDREN) {
+		const NodeDeque& children = node.getChildren();
+		writer.write(static_cast<uint32_t>(children.size()));
+		for (auto itr = children.begin(); itr != children.end(); ++itr) writer.write((*itr)->getId());
+	}
+
+	return true;
+}
+
+void SceneDeltaEncoder::forget(uint32_t version)
+{
+	version = min(version, mVersion);
+	mForgotten = max(mForgotten, version);
+
+	for (uint32_t slot = mHead; slot != INVALID_SLOT && mSlots[slot].mLatest <= version;) {
+		Tracked& tracked = mSlots[slot];
+		uint32_t next = tracked.mNext;
+
+		if (tracked.mRemoved) {
+			unlink(slot);
+			mIndex.erase(tracked.mId);
+			tracked.mLatest = 0;
+			mFree.push_back(slot);
+		}
+		slot = next;
+	}
+}
+
+SceneDeltaApplier::SceneDeltaApplier(const SceneTypeRegistry& registry)
+:	mRegistry(registry), mVersion(0)
+{
+}
+
+NodeRef SceneDeltaApplier::findNode(uint64_t id) const
+{
+	auto itr = mNodes.find(id);
+	return itr != mNodes.end()? itr->second: NodeRef();
+}
+
+void SceneDeltaApplier::reset()
+{
+	mVersion = 0;
+	mRoot.reset();
+	mNodes.clear();
+}
+
+bool SceneDeltaApplier::readEntry(BinaryReader& reader, float step, Entry& entry)
+{
+	uint8_t bits;
+	if (!reader.read(entry.mId) || !reader.read(bits)) return false;
+
+	entry.mBits = bits;
+	entry.mNode.reset();
+	entry.mDimensions = 0;
+	entry.mPayloadSize = 0;
+	entry.mChildCount = 0;
+	memset(&entry.mRecord, 0, sizeof(entry.mRecord));
+
+	if (bits & SceneDeltaHeader::DELTA_REMOVE) return bits == SceneDeltaHeader::DELTA_REMOVE;
+	if (bits & ~ALL_SECTIONS) return false;
+
+	if (bits & SceneDeltaHeader::DELTA_CREATE) {
+		if (bits != ALL_SECTIONS || !reader.read(entry.mType) || !reader.read(entry.mNameSize)) return false;
+		entry.mName = reader.skip(entry.mNameSize);
+		if (!entry.mName || !mRegistry.find(entry.mType)) return false;
+
+		// a node is created once per delta
+		if (!mCreated.insert(entry.mId).second) return false;
+	}
+
+	if (bits & SceneDeltaHeader::DELTA_FLAGS) {
+		uint8_t flags;
+		if (!reader.read(flags)) return false;
+		entry.mRecord.mFlags = flags;
+	}
+
+	if (bits & SceneDeltaHeader::DELTA_TRANSFORM) {
+		uint8_t dimensions;
+		if (!reader.read(dimensions) || (dimensions != 0 && dimensions != 2 && dimensions != 3)) return false;
+		entry.mDimensions = dimensions;
+
+		if (!readVector(reader, entry.mRecord.mPosition, dimensions, step)) return false;
+		if (dimensions == 2) {
+			int32_t steps;
+			if (!reader.read(steps)) return false;
+			entry.mRecord.mRotation[0] = static_cast<float>(steps * ANGLE_STEP);
+		}
+		if (dimensions == 3) {
+			uint32_t packed;
+			if (!reader.read(packed)) return false;
+			unpackRotation(packed, entry.mRecord.mRotation);
+		}
+		if (!readVector(reader, entry.mRecord.mScale, dimensions, step)) return false;
+		if (!readVector(reader, entry.mRecord.mPivot, dimensions, step)) return false;
+	}
+
+	if (bits & SceneDeltaHeader::DELTA_CONTENT) {
+		uint8_t dimensions;
+		if (!reader.read(dimensions) || (dimensions != 0 && dimensions != 2 && dimensions != 3)) return false;
+		if ((bits & SceneDeltaHeader::DELTA_TRANSFORM) && dimensions != entry.mDimensions) return false;
+		entry.mDimensions = dimensions;
+
+		if (!readVector(reader, entry.mRecord.mSize, dimensions, step) || !reader.read(entry.mPayloadSize)) return false;
+		entry.mPayload = reader.skip(entry.mPayloadSize);
+		if (!entry.mPayload) return false;
+	}
+
+	if (bits & SceneDeltaHeader::DELTA_CHILDREN) {
+		if (!reader.read(entry.mChildCount)) return false;
+		entry.mChildren = reader.skip(size_t(entry.mChildCount) * sizeof(uint64_t));
+		if (!entry.mChildren) return false;
+	}
+
+	return true;
+}
+
+bool SceneDeltaApplier::apply(const uint8_t* data, size_t size)
+{
+	SceneDeltaHeader header;
+	if (!data || size < sizeof(header)) return false;
+	memcpy(&header, data, sizeof(header));
+
+	if (header.mMagic != SceneDeltaHeader::MAGIC || header.mVersion != SceneDeltaHeader::VERSION) return false;
+	// a delta that starts after the replica misses changes
+	if (header.mFromVersion > mVersion || header.mToVersion < header.mFromVersion) return false;
+	if (!(header.mStep > 0.0f) || !isfinite(header.mStep)) return false;
+
+	mEntries.clear();
+	mCreated.clear();
+
+	// decode everything first, so a malformed delta leaves the replica untouched
+	BinaryReader reader(data + sizeof(header), size - sizeof(header));
+	for (uint32_t i = 0; i < header.mEntryCount; ++i) {
+		mEntries.push_back(Entry());
+		if (!readEntry(reader, header.mStep, mEntries.back())) return false;
+	}
+	if (reader.getRemaining()) return false;
+
+	bool valid = header.mRootId == SceneDeltaHeader::NO_ROOT || isKnown(header.mRootId);
+	for (auto itr = mEntries.begin(); valid && itr != mEntries.end(); ++itr) {
+		if (itr->mBits & SceneDeltaHeader::DELTA_REMOVE) continue;
+
+		NodeRef existing = findNode(itr->mId);
+		if (itr->mBits & SceneDeltaHeader::DELTA_CREATE) {
+			// a node the replica already has is updated in place, unless its type changed
+			const SceneTypeRegistry::Entry* type = mRegistry.find(itr->mType);
+			if (existing && type->mType == type_index(typeid(*existing))) itr->mNode = existing;
+			else itr->mNode = type->mFactory();
+		}
+		else itr->mNode = existing;
+
+		valid = itr->mNode && (!(itr->mBits & (SceneDeltaHeader::DELTA_TRANSFORM | SceneDeltaHeader::DELTA_CONTENT)) || getDimensions(*itr->mNode) == itr->mDimensions);
+		for (uint32_t i = 0; valid && i < itr->mChildCount; ++i) {
+			uint64_t id;
+			memcpy(&id, itr->mChildren + i * sizeof(uint64_t), sizeof(id));
+			valid = id != itr->mId && isKnown(id);
+		}
+	}
+
+	bool ok = valid;
+	if (ok) {
+		for (auto itr = mEntries.begin(); itr != mEntries.end(); ++itr) {
+			if (!(itr->mBits & SceneDeltaHeader::DELTA_CREATE)) continue;
+
+			// a node of another type is replaced
+			NodeRef& node = mNodes[itr->mId];
+			if (node && node != itr->mNode) node->removeFromParent();
+			node = itr->mNode;
+		}
+
+		for (auto itr = mEntries.begin(); ok && itr != mEntries.end(); ++itr) {
+			if (!(itr->mBits & SceneDeltaHeader::DELTA_REMOVE)) ok = applyEntry(*itr, *itr->mNode);
+		}
+
+		// children moving between parents leave their old parent first, so moves in either direction succeed
+		for (auto itr = mEntries.begin(); ok && itr != mEntries.end(); ++itr) {
+			for (uint32_t i = 0; i < itr->mChildCount; ++i) {
+				uint64_t id;
+				memcpy(&id, itr->mChildren + i * sizeof(uint64_t), sizeof(id));
+				const NodeRef& child = mNodes[id];
+				if (child->getParent() != itr->mNode) child->removeFromParent();
+			}
+		}
+
+		for (auto itr = mEntries.begin(); ok && itr != mEntries.end(); ++itr) {
+			if (itr->mBits & SceneDeltaHeader::DELTA_CHILDREN) ok = applyChildren(*itr, *itr->mNode);
+		}
+
+		for (auto itr = mEntries.begin(); ok && itr != mEntries.end(); ++itr) {
+			if (!(itr->mBits & SceneDeltaHeader::DELTA_REMOVE)) continue;
+
+			auto node = mNodes.find(itr->mId);
+			if (node == mNodes.end()) continue;
+			node->second->removeFromParent();
+			mNodes.erase(node);
+		}
+
+		if (ok) {
+			mRoot = findNode(header.mRootId);
+			mVersion = header.mToVersion;
+		}
+	}
+
+	mEntries.clear();
+	mCreated.clear();
+	return ok;
+}
+
+bool SceneDeltaApplier::applyEntry(const Entry& entry, NodeBase& node)
+{
+	if (entry.mBits & SceneDeltaHeader::DELTA_CREATE) node.setName(string(reinterpret_cast<const char*>(entry.mName), entry.mNameSize));
+
+	// the sections that did not change keep the current state of the node
+	SceneNodeRecord record;
+	memset(&record, 0, sizeof(record));
+	SceneWriter::captureRecord(node, record);
+
+	if (entry.mBits & SceneDeltaHeader::DELTA_FLAGS) record.mFlags = entry.mRecord.mFlags;
+	if (entry.mBits & SceneDeltaHeader::DELTA_TRANSFORM) {
+		memcpy(record.mPosition, entry.mRecord.mPosition, sizeof(record.mPosition));
+		memcpy(record.mRotation, entry.mRecord.mRotation, sizeof(record.mRotation));
+		memcpy(record.mScale, entry.mRecord.mScale, sizeof(record.mScale));
+		memcpy(record.mPivot, entry.mRecord.mPivot, sizeof(record.mPivot));
+	}
+	if (entry.mBits & SceneDeltaHeader::DELTA_CONTENT) memcpy(record.mSize, entry.mRecord.mSize, sizeof(record.mSize));
+
+	SceneReader::applyRecord(record, node);
+
+	if (!(entry.mBits & SceneDeltaHeader::DELTA_CONTENT)) return true;
+	BinaryReader payload(entry.mPayload, entry.mPayloadSize);
+	return node.deserialize(payload);
+}
+
+bool SceneDeltaApplier::applyChildren(const Entry& entry, NodeBase& parent)
+{
+	const NodeDeque& children = parent.getChildren();
+
+	// children mostly change at the end, keep the part that did not change
+	uint32_t common = 0;
+	for (; common < entry.mChildCount && common < children.size(); ++common) {
+		uint64_t id;
+		memcpy(&id, entry.mChildren + common * sizeof(uint64_t), sizeof(id));
+		if (children[common] != mNodes[id]) break;
+	}
+	while (children.size() > common) parent.removeChild(children.back());
+
+	for (uint32_t i = common; i < entry.mChildCount; ++i) {
+		uint64_t id;
+		memcpy(&id, entry.mChildren + i * sizeof(uint64_t), sizeof(id));
+		const NodeRef& child = mNodes[id];
+
+		// a node can not become its own descendant
+		for (NodeRef ancestor = parent.getParent(); ancestor; ancestor = ancestor->getParent()) {
+			if (ancestor == child) return false;
+		}
+		if (!parent.addChild(child)) return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,379 @@
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+
+#include "Node2d.h"
+#include "Node3d.h"
+#include "SceneFormat.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Store the type names in the file, so readers can report unknown types by name
+//
+///////////////////////////////////////////////////////////////////////////
+
+const uint32_t SceneNodeRecord::NO_PARENT;
+const uint32_t SceneWriter::DEFAULT_CHUNK_SIZE;
+
+//! the size of the header of version 1 files, which have no chunk index
+static const size_t HEADER_SIZE_V1 = offsetof(SceneFileHeader, mChunkOffset);
+
+static void copyTo(float* out, const vec2& v) { out[0] = v.x; out[1] = v.y; out[2] = 0.0f; }
+static void copyTo(float* out, const vec3& v) { out[0] = v.x; out[1] = v.y; out[2] = v.z; }
+static vec2 toVec2(const float* in) { return vec2(in[0], in[1]); }
+static vec3 toVec3(const float* in) { return vec3(in[0], in[1], in[2]); }
+
+//! returns wether a range lies within a block of a given size, without overflowing
+static bool contains(uint64_t size, uint64_t offset, uint64_t length)
+{
+	return offset <= size && length <= size - offset;
+}
+
+//! returns wether a range lies within a range of a block
+static bool contains(uint64_t block_offset, uint64_t block_size, uint64_t offset, uint64_t length)
+{
+	return offset >= block_offset && contains(block_size, offset - block_offset, length);
+}
+
+SceneWriter::SceneWriter(const SceneTypeRegistry& registry)
+:	mRegistry(registry), mChunkSize(DEFAULT_CHUNK_SIZE)
+{
+}
+
+void SceneWriter::captureRecord(const NodeBase& node, SceneNodeRecord& record)
+{
+	record.mFlags = 0;
+	if (node.isActive()) record.mFlags |= SceneNodeRecord::FLAG_ACTIVE;
+	if (node.isInteractive()) record.mFlags |= SceneNodeRecord::FLAG_INTERACTIVE;
+
+	if (const Node2d* node2d = dynamic_cast<const Node2d*>(&node)) {
+		copyTo(record.mPosition, node2d->getPosition());
+		record.mRotation[0] = node2d->getRotation();
+		record.mRotation[1] = record.mRotation[2] = record.mRotation[3] = 0.0f;
+		copyTo(record.mScale, node2d->getScale());
+		copyTo(record.mPivot, node2d->getPivot());
+		copyTo(record.mSize, node2d->getSize());
+	}
+	else if (const Node3d* node3d = dynamic_cast<const Node3d*>(&node)) {
+		quat rotation = node3d->getRotation();
+		copyTo(record.mPosition, node3d->getPosition());
+		record.mRotation[0] = rotation.x;
+		record.mRotation[1] = rotation.y;
+		record.mRotation[2] = rotation.z;
+		record.mRotation[3] = rotation.w;
+		copyTo(record.mScale, node3d->getScale());
+		copyTo(record.mPivot, node3d->getPivot());
+		copyTo(record.mSize, node3d->getSize());
+	}
+}
+
+bool SceneWriter::write(const NodeBase& root, vector<uint8_t>& buffer)
+{
+	mRecords.clear();
+	mStrings.clear();
+	mPayloads.clear();
+	mStack.clear();
+
+	BinaryWriter payloads(mPayloads);
+
+	// depth-first, children are pushed in reverse so the first child is written first
+	mStack.push_back(make_pair(&root, SceneNodeRecord::NO_PARENT));
+	while (!mStack.empty()) {
+		const NodeBase* node = mStack.back().first;
+		uint32_t parent = mStack.back().second;
+		mStack.pop_back();
+
+		const SceneTypeRegistry::Entry* entry = mRegistry.find(*node);
+		if (!entry) return false;
+
+		SceneNodeRecord record;
+		memset(&record, 0, sizeof(record));
+		record.mParent = parent;
+		record.mType = entry->mId;
+
+		const string& name = node->getName();
+		record.mNameOffset = static_cast<uint32_t>(mStrings.size());
+		record.mNameSize = static_cast<uint32_t>(name.size());
+		mStrings.insert(mStrings.end(), name.begin(), name.end());
+
+		record.mPayloadOffset = static_cast<uint32_t>(mPayloads.size());
+		node->serialize(payloads);
+		record.mPayloadSize = static_cast<uint32_t>(mPayloads.size()) - record.mPayloadOffset;
+
+		captureRecord(*node, record);
+
+		uint32_t index = static_cast<uint32_t>(mRecords.size());
+		mRecords.push_back(record);
+
+		const NodeDeque& children = node->getChildren();
+		for (auto itr = children.rbegin(); itr != children.rend(); ++itr) {
+			mStack.push_back(make_pair(itr->get(), index));
+		}
+	}
+
+	// descendants follow their ancestors, so the sizes add up from the back
+	for (size_t i = mRecords.size() - 1; i > 0; --i) {
+		mRecords[mRecords[i].mParent].mSubtreeSize += mRecords[i].mSubtreeSize + 1;
+	}
+
+	// names and payloads are appended in the order of the records, so each chunk has one range of both
+	mChunks.clear();
+	uint32_t chunk_size = mChunkSize? mChunkSize: static_cast<uint32_t>(mRecords.size());
+	for (uint32_t first = 0; first < mRecords.size(); first += chunk_size) {
+		uint32_t end = static_cast<uint32_t>(std::min<size_t>(size_t(first) + chunk_size, mRecords.size()));
+		const SceneNodeRecord& last = mRecords[end - 1];
+
+		SceneChunkRecord chunk;
+		memset(&chunk, 0, sizeof(chunk));
+		chunk.mFirstNode = first;
+		chunk.mNodeCount = end - first;
+		chunk.mStringOffset = mRecords[first].mNameOffset;
+		chunk.mStringSize = last.mNameOffset + last.mNameSize - chunk.mStringOffset;
+		chunk.mPayloadOffset = mRecords[first].mPayloadOffset;
+		chunk.mPayloadSize = last.mPayloadOffset + last.mPayloadSize - chunk.mPayloadOffset;
+		for (uint32_t i = first; i < end; ++i) {
+			if (i == 0 || mRecords[i].mParent < first) ++chunk.mRootCount;
+		}
+		mChunks.push_back(chunk);
+	}
+	if (!mChunkSize) mChunks.clear();
+
+	// keep the payload block aligned
+	mStrings.resize((mStrings.size() + 3) & ~size_t(3), 0);
+
+	SceneFileHeader header;
+	header.mMagic = SceneFileHeader::MAGIC;
+	header.mVersion = SceneFileHeader::VERSION;
+	header.mRecordSize = sizeof(SceneNodeRecord);
+	header.mNodeCount = static_cast<uint32_t>(mRecords.size());
+	header.mNodeOffset = sizeof(SceneFileHeader);
+	header.mChunkOffset = header.mNodeOffset + header.mNodeCount * header.mRecordSize;
+	header.mChunkCount = static_cast<uint32_t>(mChunks.size());
+	header.mStringOffset = header.mChunkOffset + header.mChunkCount * sizeof(SceneChunkRecord);
+	header.mStringSize = static_cast<uint32_t>(mStrings.size());
+	header.mPayloadOffset = header.mStringOffset + header.mStringSize;
+	header.mPayloadSize = static_cast<uint32_t>(mPayloads.size());
+
+	buffer.resize(header.mPayloadOffset + header.mPayloadSize);
+	memcpy(buffer.data(), &header, sizeof(header));
+	memcpy(buffer.data() + header.mNodeOffset, mRecords.data(), mRecords.size() * sizeof(SceneNodeRecord));
+	if (!mChunks.empty()) memcpy(buffer.data() + header.mChunkOffset, mChunks.data(), mChunks.size() * sizeof(SceneChunkRecord));
+	if (!mStrings.empty()) memcpy(buffer.data() + header.mStringOffset, mStrings.data(), mStrings.size());
+	if (!mPayloads.empty()) memcpy(buffer.data() + header.mPayloadOffset, mPayloads.data(), mPayloads.size());
+
+	return true;
+}
+
+bool SceneWriter::write(const NodeBase& root, ostream& stream)
+{
+	if (!write(root, mBuffer)) return false;
+
+	stream.write(reinterpret_cast<const char*>(mBuffer.data()), mBuffer.size());
+	return stream.good();
+}
+
+bool SceneWriter::write(const NodeBase& root, const string& path)
+{
+	ofstream stream(path.c_str(), ios::binary);
+	return stream && write(root, stream);
+}
+
+SceneReader::SceneReader(const SceneTypeRegistry& registry, const ThreadPoolRef& pool)
+:	mRegistry(registry), mPool(pool)
+{
+}
+
+bool SceneReader::readHeader(const uint8_t* data, size_t size, SceneFileHeader& header)
+{
+	if (!data || size < HEADER_SIZE_V1) return false;
+	memset(&header, 0, sizeof(header));
+	memcpy(&header, data, HEADER_SIZE_V1);
+
+	if (header.mMagic != SceneFileHeader::MAGIC) return false;
+	if (header.mVersion == 0 || header.mVersion > SceneFileHeader::VERSION) return false;
+	if (header.mRecordSize < sizeof(SceneNodeRecord) || header.mNodeCount == 0) return false;
+
+	// version 1 ends before the chunk index
+	if (header.mVersion > 1) {
+		if (size < sizeof(SceneFileHeader)) return false;
+		memcpy(&header, data, sizeof(header));
+	}
+
+	return contains(size, header.mNodeOffset, uint64_t(header.mNodeCount) * header.mRecordSize)
+		&& contains(size, header.mChunkOffset, uint64_t(header.mChunkCount) * sizeof(SceneChunkRecord))
+		&& contains(size, header.mStringOffset, header.mStringSize)
+		&& contains(size, header.mPayloadOffset, header.mPayloadSize);
+}
+
+bool SceneReader::readChunks(const uint8_t* data, const SceneFileHeader& header, vector<SceneChunkRecord>& chunks)
+{
+	chunks.clear();
+
+	if (header.mChunkCount == 0) {
+		SceneChunkRecord chunk;
+		memset(&chunk, 0, sizeof(chunk));
+		chunk.mNodeCount = header.mNodeCount;
+		chunk.mRootCount = 1;
+		chunk.mStringSize = header.mStringSize;
+		chunk.mPayloadSize = header.mPayloadSize;
+		chunks.push_back(chunk);
+		return true;
+	}
+
+	if (header.mChunkCount > header.mNodeCount) return false;
+	chunks.resize(header.mChunkCount);
+	memcpy(chunks.data(), data + header.mChunkOffset, chunks.size() * sizeof(SceneChunkRecord));
+
+	// the chunks follow each other and hold every record
+	uint64_t next = 0;
+	for (auto itr = chunks.begin(); itr != chunks.end(); ++itr) {
+		if (itr->mFirstNode != next || itr->mNodeCount == 0 || itr->mRootCount > itr->mNodeCount) return false;
+		if (!contains(header.mStringSize, itr->mStringOffset, itr->mStringSize)) return false;
+		if (!contains(header.mPayloadSize, itr->mPayloadOffset, itr->mPayloadSize)) return false;
+		next += itr->mNodeCount;
+	}
+	return next == header.mNodeCount;
+}
+
+bool SceneReader::checkRecord(const SceneFileHeader& header, const SceneNodeRecord& record, uint32_t index)
+{
+	// parents precede their children, only the first record is a root
+	if (index == 0? record.mParent != SceneNodeRecord::NO_PARENT: record.mParent >= index) return false;
+	if (record.mSubtreeSize >= header.mNodeCount - index) return false;
+
+	return contains(header.mStringSize, record.mNameOffset, record.mNameSize)
+		&& contains(header.mPayloadSize, record.mPayloadOffset, record.mPayloadSize);
+}
+
+void SceneReader::applyRecord(const SceneNodeRecord& record, NodeBase& node)
+{
+	if (Node2d* node2d = dynamic_cast<Node2d*>(&node)) {
+		node2d->setPosition(toVec2(record.mPosition));
+		node2d->setRotation(record.mRotation[0]);
+		node2d->setScale(toVec2(record.mScale));
+		node2d->setPivot(toVec2(record.mPivot));
+		node2d->setSize(toVec2(record.mSize));
+	}
+	else if (Node3d* node3d = dynamic_cast<Node3d*>(&node)) {
+		node3d->setPosition(toVec3(record.mPosition));
+		node3d->setRotation(quat(record.mRotation[3], record.mRotation[0], record.mRotation[1], record.mRotation[2]));
+		node3d->setScale(toVec3(record.mScale));
+		node3d->setPivot(toVec3(record.mPivot));
+		node3d->setSize(toVec3(record.mSize));
+	}
+
+	node.setActive((record.mFlags & SceneNodeRecord::FLAG_ACTIVE) != 0);
+	node.setInteractive((record.mFlags & SceneNodeRecord::FLAG_INTERACTIVE) != 0);
+}
+
+NodeRef SceneReader::createNode(const SceneTypeRegistry::Entry& entry, const SceneNodeRecord& record, const uint8_t* data, const SceneFileHeader& header)
+{
+	NodeRef node = entry.mFactory();
+	if (!node) return NodeRef();
+
+	const char* name = reinterpret_cast<const char*>(data + header.mStringOffset + record.mNameOffset);
+	node->setName(string(name, record.mNameSize));
+	applyRecord(record, *node);
+
+	BinaryReader payload(data + header.mPayloadOffset + record.mPayloadOffset, record.mPayloadSize);
+	if (!node->deserialize(payload)) return NodeRef();
+
+	return node;
+}
+
+bool SceneReader::decodeChunk(const uint8_t* data, const SceneFileHeader& header, size_t index)
+{
+	const SceneChunkRecord& chunk = mChunks[index];
+	const uint8_t* records = data + header.mNodeOffset;
+	ChunkRoots& roots = mRoots[index];
+	roots.reserve(chunk.mRootCount);
+
+	const SceneTypeRegistry::Entry* entry = nullptr;
+	uint32_t end = chunk.mFirstNode + chunk.mNodeCount;
+
+	for (uint32_t i = chunk.mFirstNode; i < end; ++i) {
+		// the table is not necessarily aligned within the data
+		SceneNodeRecord record;
+		memcpy(&record, records + size_t(i) * header.mRecordSize, sizeof(record));
+		if (!checkRecord(header, record, i)) return false;
+
+		// a chunk only reads its own part of the tables
+		if (!contains(chunk.mStringOffset, chunk.mStringSize, record.mNameOffset, record.mNameSize)) return false;
+		if (!contains(chunk.mPayloadOffset, chunk.mPayloadSize, record.mPayloadOffset, record.mPayloadSize)) return false;
+
+		// consecutive nodes mostly share their type
+		if (!entry || entry->mId != record.mType) entry = mRegistry.find(record.mType);
+		if (!entry) return false;
+
+		NodeRef node = createNode(*entry, record, data, header);
+		if (!node) return false;
+
+		// parents in the chunk keep the nodes alive, the roots are attached once all chunks are done
+		if (i > 0 && record.mParent >= chunk.mFirstNode) mNodes[record.mParent]->addChild(node);
+		else if (roots.size() < chunk.mRootCount) roots.push_back(make_pair(record.mParent, node));
+		else return false;
+		mNodes[i] = node.get();
+	}
+
+	return roots.size() == chunk.mRootCount;
+}
+
+NodeRef SceneReader::read(const uint8_t* data, size_t size)
+{
+	SceneFileHeader header;
+	if (!readHeader(data, size, header)) return NodeRef();
+	if (!readChunks(data, header, mChunks)) return NodeRef();
+
+	mNodes.assign(header.mNodeCount, nullptr);
+	mRoots.clear();
+	mRoots.resize(mChunks.size());
+
+	// every chunk writes its own part of mNodes and mRoots
+	std::atomic<bool> failed(false);
+	auto decode = [&](size_t chunk) {
+		if (!failed.load(std::memory_order_relaxed) && !decodeChunk(data, header, chunk)) failed = true;
+	};
+	if (mPool && mChunks.size() > 1) mPool->parallelFor(mChunks.size(), decode);
+	else for (size_t chunk = 0; chunk < mChunks.size(); ++chunk) decode(chunk);
+
+	// attaching the roots in the order of the records keeps the order of the children
+	NodeRef root;
+	if (!failed) {
+		for (auto chunk = mRoots.begin(); chunk != mRoots.end(); ++chunk) {
+			for (auto itr = chunk->begin(); itr != chunk->end(); ++itr) {
+				if (itr->first == SceneNodeRecord::NO_PARENT) root = itr->second;
+				else mNodes[itr->first]->addChild(itr->second);
+			}
+		}
+	}
+
+	mNodes.clear();
+	mRoots.clear();
+	return root;
+}
+
+NodeRef SceneReader::read(istream& stream)
+{
+	stream.seekg(0, ios::end);
+	streamoff size = stream.tellg();
+	stream.seekg(0, ios::beg);
+	if (size <= 0 || !stream) return NodeRef();
+
+	mBuffer.resize(static_cast<size_t>(size));
+	if (!stream.read(reinterpret_cast<char*>(mBuffer.data()), size)) return NodeRef();
+
+	return read(mBuffer.data(), mBuffer.size());
+}
+
+NodeRef SceneReader::read(const string& path)
+{
+	ifstream stream(path.c_str(), ios::binary);
+	if (!stream) return NodeRef();
+	return read(stream);
+}
@@ -7,11 +7,12 @@
 
 using namespace scene;
 
-uint64_t SceneObject::sNameNum = 0;
+std::atomic<uint64_t> SceneObject::sNameNum(0);
 
 SceneObject::SceneObject(const std::string& name)
+:	mId(sNameNum++)
 {
-	mName = name + "_" + scene::toFormattedString(sNameNum++, 8);
+	mName = name + "_" + scene::toFormattedString(mId, 8);
 }
 
 SceneObject::~SceneObject()
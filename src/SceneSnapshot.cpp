@@ -0,0 +1,90 @@
+#include "RenderBackend.h"
+#include "Node2d.h"
+#include "Node3d.h"
+#include "SceneSnapshot.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+void SceneSnapshot::capture(const Node3d& root, uint64_t frame)
+{
+	mItems.clear();
+	mFrame = frame;
+	capture(root, SnapshotItem::NO_PARENT, true);
+}
+
+void SceneSnapshot::capture(const Node2d& root, uint64_t frame)
+{
+	mItems.clear();
+	mFrame = frame;
+	capture(root, SnapshotItem::NO_PARENT, true);
+}
+
+void SceneSnapshot::capture(const Node3d& node, uint32_t parent, bool visible)
+{
+	uint32_t index = static_cast<uint32_t>(mItems.size());
+	visible = visible && node.isActive();
+
+	SnapshotItem item;
+	item.mNode = &node;
+	item.mParent = parent;
+	item.mIsVisible = visible;
+	item.mWorldTransform = node.getWorldTransform();
+	if (visible) node.snapshot(item);
+	mItems.push_back(std::move(item));
+
+	for (auto itr = node.getChildren().begin(); itr != node.getChildren().end(); ++itr) {
+		const Node3d* child = dynamic_cast<const Node3d*>(itr->get());
+		if (child) capture(*child, index, visible);
+	}
+}
+
+void SceneSnapshot::capture(const Node2d& node, uint32_t parent, bool visible)
+{
+	uint32_t index = static_cast<uint32_t>(mItems.size());
+	visible = visible && node.isActive();
+
+	SnapshotItem item;
+	item.mNode = &node;
+	item.mParent = parent;
+	item.mIsVisible = visible;
+	item.mWorldTransform = RenderBackend::toMat4(node.getWorldTransform());
+	if (visible) node.snapshot(item);
+	mItems.push_back(std::move(item));
+
+	for (auto itr = node.getChildren().begin(); itr != node.getChildren().end(); ++itr) {
+		const Node2d* child = dynamic_cast<const Node2d*>(itr->get());
+		if (child) capture(*child, index, visible);
+	}
+}
+
+SceneSnapshotBuffer::SceneSnapshotBuffer()
+:	mWriteIndex(0), mReadIndex(1), mHasRead(false), mPending(2)
+{
+}
+
+void SceneSnapshotBuffer::publish()
+{
+	// hand the freshly written buffer over and take back whatever was in transit
+	uint8_t previous = mPending.exchange(mWriteIndex | FRESH_BIT, std::memory_order_acq_rel);
+	mWriteIndex = previous & INDEX_MASK;
+}
+
+const SceneSnapshot* SceneSnapshotBuffer::acquire()
+{
+	if (hasPending()) {
+		// swap the buffer we were reading for the newest one
+		uint8_t previous = mPending.exchange(mReadIndex, std::memory_order_acq_rel);
+		mReadIndex = previous & INDEX_MASK;
+		mHasRead = true;
+	}
+
+	return mHasRead? &mBuffers[mReadIndex]: nullptr;
+}
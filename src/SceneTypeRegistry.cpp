@@ -0,0 +1,66 @@
+#include "Node2d.h"
+#include "Node3d.h"
+#include "NodeShape2d.h"
+#include "SceneTypeRegistry.h"
+#include "StreamingProxy3d.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Register NodeMesh once it serializes its mesh
+//
+///////////////////////////////////////////////////////////////////////////
+
+static SceneTypeRegistry createDefaultRegistry()
+{
+	SceneTypeRegistry registry;
+	registry.registerType<Node2d>(SceneTypeRegistry::TYPE_NODE2D, "Node2d", []() -> NodeRef { return Node2d::create(); });
+	registry.registerType<Node3d>(SceneTypeRegistry::TYPE_NODE3D, "Node3d", []() -> NodeRef { return Node3d::create(); });
+	registry.registerType<NodeShape2d>(SceneTypeRegistry::TYPE_NODESHAPE2D, "NodeShape2d", []() -> NodeRef { return NodeRef( new NodeShape2d() ); });
+	registry.registerType<StreamingProxy3d>(SceneTypeRegistry::TYPE_STREAMINGPROXY3D, "StreamingProxy3d", []() -> NodeRef { return StreamingProxy3d::create(); });
+	return registry;
+}
+
+SceneTypeRegistry& SceneTypeRegistry::getDefault()
+{
+	// initialized once, even if loader threads ask for it concurrently
+	static SceneTypeRegistry registry = createDefaultRegistry();
+	return registry;
+}
+
+bool SceneTypeRegistry::registerType(uint32_t id, const string& name, const type_info& type, const Factory& factory)
+{
+	if (id == 0 || !factory || find(id) || find(name) || find(type)) return false;
+
+	Entry entry = { id, name, type_index(type), factory };
+	mEntries.push_back(entry);
+	return true;
+}
+
+const SceneTypeRegistry::Entry* SceneTypeRegistry::find(uint32_t id) const
+{
+	for (auto itr = mEntries.begin(); itr != mEntries.end(); ++itr) {
+		if (itr->mId == id) return &(*itr);
+	}
+	return nullptr;
+}
+
+const SceneTypeRegistry::Entry* SceneTypeRegistry::find(const string& name) const
+{
+	for (auto itr = mEntries.begin(); itr != mEntries.end(); ++itr) {
+		if (itr->mName == name) return &(*itr);
+	}
+	return nullptr;
+}
+
+const SceneTypeRegistry::Entry* SceneTypeRegistry::find(const type_info& type) const
+{
+	type_index index(type);
+	for (auto itr = mEntries.begin(); itr != mEntries.end(); ++itr) {
+		if (itr->mType == index) return &(*itr);
+	}
+	return nullptr;
+}
@@ -0,0 +1,380 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+#include "Node2d.h"
+#include "Node3d.h"
+#include "SceneXml.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Write the payloads of the builtin types as readable attributes
+//
+///////////////////////////////////////////////////////////////////////////
+
+const uint32_t XmlSceneWriter::VERSION;
+
+static const char BASE64_DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static int decodeBase64Digit(char c)
+{
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+	if (c >= '0' && c <= '9') return c - '0' + 52;
+	if (c == '+') return 62;
+	if (c == '/') return 63;
+	return -1;
+}
+
+//! decodes base64, ignoring the spaces that attribute normalization leaves of line breaks
+static bool decodeBase64(const string& in, vector<uint8_t>& out)
+{
+	out.clear();
+	out.reserve(in.size() / 4 * 3);
+
+	uint32_t bits = 0;
+	size_t count = 0;
+	size_t padding = 0;
+
+	for (auto itr = in.begin(); itr != in.end(); ++itr) {
+		if (*itr == ' ') continue;
+		if (*itr == '=') {
+			++padding;
+			continue;
+		}
+
+		int digit = decodeBase64Digit(*itr);
+		if (digit < 0 || padding) return false;
+
+		bits = (bits << 6) | static_cast<uint32_t>(digit);
+		if (++count == 4) {
+			out.push_back(static_cast<uint8_t>(bits >> 16));
+			out.push_back(static_cast<uint8_t>(bits >> 8));
+			out.push_back(static_cast<uint8_t>(bits));
+			bits = 0;
+			count = 0;
+		}
+	}
+
+	if (count == 1 || (padding && count + padding != 4)) return false;
+	if (count == 2) out.push_back(static_cast<uint8_t>(bits >> 4));
+	if (count == 3) {
+		out.push_back(static_cast<uint8_t>(bits >> 10));
+		out.push_back(static_cast<uint8_t>(bits >> 2));
+	}
+	return true;
+}
+
+//! parses exactly a number of floats separated by whitespace
+static bool parseFloats(const string& value, float* out, size_t count)
+{
+	const char* p = value.c_str();
+	for (size_t i = 0; i < count; ++i) {
+		char* end;
+		out[i] = strtof(p, &end);
+		if (end == p) return false;
+		p = end;
+	}
+
+	while (*p == ' ') ++p;
+	return *p == 0;
+}
+
+static bool parseFlag(const string& value, uint32_t flag, uint32_t& flags)
+{
+	if (value == "1" || value == "true") flags |= flag;
+	else if (value == "0" || value == "false") flags &= ~flag;
+	else return false;
+	return true;
+}
+
+//! returns the number of vector components and rotation values stored for a node, 0 if it has no transformation
+static size_t getComponentCount(const NodeBase& node, size_t& rotation_count)
+{
+	if (dynamic_cast<const Node2d*>(&node)) {
+		rotation_count = 1;
+		return 2;
+	}
+	if (dynamic_cast<const Node3d*>(&node)) {
+		rotation_count = 4;
+		return 3;
+	}
+
+	rotation_count = 0;
+	return 0;
+}
+
+XmlSceneWriter::XmlSceneWriter(const SceneTypeRegistry& registry)
+:	mRegistry(registry), mStream(nullptr)
+{
+}
+
+bool XmlSceneWriter::write(const NodeBase& root, ostream& stream)
+{
+	mStream = &stream;
+	mOutput.clear();
+	mStack.clear();
+
+	mOutput += "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<scene version=\"";
+	mOutput += to_string(VERSION);
+	mOutput += "\">\n";
+
+	// the closing entries on the stack are the ancestors of the next node
+	size_t depth = 0;
+	bool ok = true;
+
+	mStack.push_back(make_pair(&root, nullptr));
+	while (ok && !mStack.empty()) {
+		const NodeBase* node = mStack.back().first;
+		const SceneTypeRegistry::Entry* closing = mStack.back().second;
+		mStack.pop_back();
+
+		if (closing) {
+			appendIndent(--depth);
+			mOutput += "</";
+			mOutput += closing->mName;
+			mOutput += ">\n";
+		}
+		else if (const SceneTypeRegistry::Entry* entry = mRegistry.find(*node)) {
+			writeStartTag(*node, *entry, depth);
+
+			const NodeDeque& children = node->getChildren();
+			if (!children.empty()) {
+				mStack.push_back(make_pair(node, entry));
+				++depth;
+				for (auto itr = children.rbegin(); itr != children.rend(); ++itr) {
+					mStack.push_back(make_pair(itr->get(), nullptr));
+				}
+			}
+		}
+		else ok = false;
+
+		ok = ok && flush();
+	}
+
+	if (ok) {
+		mOutput += "</scene>\n";
+		ok = flush(true);
+	}
+
+	mStream = nullptr;
+	return ok;
+}
+
+bool XmlSceneWriter::write(const NodeBase& root, const string& path)
+{
+	ofstream stream(path.c_str(), ios::binary);
+	return stream && write(root, stream);
+}
+
+void XmlSceneWriter::writeStartTag(const NodeBase& node, const SceneTypeRegistry::Entry& entry, size_t depth)
+{
+	appendIndent(depth);
+	mOutput += '<';
+	mOutput += entry.mName;
+	mOutput += " name=\"";
+	appendEscaped(node.getName());
+	mOutput += node.isActive()? "\" active=\"1\"": "\" active=\"0\"";
+	mOutput += node.isInteractive()? " interactive=\"1\"": " interactive=\"0\"";
+
+	size_t rotation_count;
+	if (size_t count = getComponentCount(node, rotation_count)) {
+		SceneNodeRecord record;
+		memset(&record, 0, sizeof(record));
+		SceneWriter::captureRecord(node, record);
+
+		mOutput += " position=\"";
+		appendFloats(record.mPosition, count);
+		mOutput += "\" rotation=\"";
+		appendFloats(record.mRotation, rotation_count);
+		mOutput += "\" scale=\"";
+		appendFloats(record.mScale, count);
+		mOutput += "\" pivot=\"";
+		appendFloats(record.mPivot, count);
+		mOutput += "\" size=\"";
+		appendFloats(record.mSize, count);
+		mOutput += '"';
+	}
+
+	mPayload.clear();
+	BinaryWriter payload(mPayload);
+	node.serialize(payload);
+	if (!mPayload.empty()) {
+		mOutput += " payload=\"";
+		appendBase64(mPayload);
+		mOutput += '"';
+	}
+
+	mOutput += node.getChildren().empty()? "/>\n": ">\n";
+}
+
+void XmlSceneWriter::appendEscaped(const string& value)
+{
+	for (auto itr = value.begin(); itr != value.end(); ++itr) {
+		switch (*itr) {
+			case '&': mOutput += "&amp;"; break;
+			case '<': mOutput += "&lt;"; break;
+			case '>': mOutput += "&gt;"; break;
+			case '"': mOutput += "&quot;"; break;
+			// kept as references, readers turn them into spaces otherwise
+			case '\t': mOutput += "&#9;"; break;
+			case '\n': mOutput += "&#10;"; break;
+			case '\r': mOutput += "&#13;"; break;
+			default: mOutput += *itr; break;
+		}
+	}
+}
+
+void XmlSceneWriter::appendFloats(const float* values, size_t count)
+{
+	// 9 significant digits restore every float exactly
+	char number[32];
+	for (size_t i = 0; i < count; ++i) {
+		int length = snprintf(number, sizeof(number), i? " %.9g": "%.9g", values[i]);
+		mOutput.append(number, static_cast<size_t>(length));
+	}
+}
+
+void XmlSceneWriter::appendBase64(const vector<uint8_t>& data)
+{
+	size_t i = 0;
+	for (; i + 3 <= data.size(); i += 3) {
+		uint32_t bits = (uint32_t(data[i]) << 16) | (uint32_t(data[i + 1]) << 8) | data[i + 2];
+		mOutput += BASE64_DIGITS[bits >> 18];
+		mOutput += BASE64_DIGITS[(bits >> 12) & 0x3f];
+		mOutput += BASE64_DIGITS[(bits >> 6) & 0x3f];
+		mOutput += BASE64_DIGITS[bits & 0x3f];
+	}
+
+	if (i < data.size()) {
+		bool second = i + 1 < data.size();
+		uint32_t bits = (uint32_t(data[i]) << 16) | (second? uint32_t(data[i + 1]) << 8: 0);
+		mOutput += BASE64_DIGITS[bits >> 18];
+		mOutput += BASE64_DIGITS[(bits >> 12) & 0x3f];
+		mOutput += second? BASE64_DIGITS[(bits >> 6) & 0x3f]: '=';
+		mOutput += '=';
+	}
+}
+
+bool XmlSceneWriter::flush(bool force)
+{
+	if (force || mOutput.size() >= XmlSaxParser::CHUNK_SIZE) {
+		mStream->write(mOutput.data(), mOutput.size());
+		mOutput.clear();
+	}
+	return mStream->good();
+}
+
+XmlSceneReader::XmlSceneReader(const SceneTypeRegistry& registry)
+:	mRegistry(registry), mEntry(nullptr), mInScene(false)
+{
+}
+
+NodeRef XmlSceneReader::read(istream& stream)
+{
+	mEntry = nullptr;
+	mInScene = false;
+	mRoot.reset();
+	mOpen.clear();
+
+	bool ok = parse(stream);
+
+	NodeRef root;
+	root.swap(mRoot);
+	mOpen.clear();
+	return ok? root: NodeRef();
+}
+
+NodeRef XmlSceneReader::read(const string& path)
+{
+	ifstream stream(path.c_str(), ios::binary);
+	if (!stream) return NodeRef();
+	return read(stream);
+}
+
+bool XmlSceneReader::onStartElement(const string& name, const Attributes& attributes, size_t count)
+{
+	if (!mInScene) {
+		if (name != "scene") return false;
+
+		// documents of newer writers may hold what this reader can not restore
+		if (const string* version = findAttribute(attributes, count, "version")) {
+			char* end;
+			unsigned long number = strtoul(version->c_str(), &end, 10);
+			if (end == version->c_str() || *end || number > XmlSceneWriter::VERSION) return false;
+		}
+
+		mInScene = true;
+		return true;
+	}
+
+	// the scene holds a single root node
+	if (mOpen.empty() && mRoot) return false;
+
+	if (!mEntry || mEntry->mName != name) mEntry = mRegistry.find(name);
+	if (!mEntry) return false;
+
+	NodeRef node = createNode(*mEntry, attributes, count);
+	if (!node) return false;
+
+	// the parent and the root keep the nodes alive
+	if (mOpen.empty()) mRoot = node;
+	else mOpen.back()->addChild(node);
+	mOpen.push_back(node.get());
+	return true;
+}
+
+bool XmlSceneReader::onEndElement(const string&)
+{
+	// the parser matched the tags, so an end tag without open nodes closes the scene
+	if (mOpen.empty()) mInScene = false;
+	else mOpen.pop_back();
+	return true;
+}
+
+NodeRef XmlSceneReader::createNode(const SceneTypeRegistry::Entry& entry, const Attributes& attributes, size_t count)
+{
+	NodeRef node = entry.mFactory();
+	if (!node) return NodeRef();
+
+	// missing attributes keep the values of the factory
+	SceneNodeRecord record;
+	memset(&record, 0, sizeof(record));
+	SceneWriter::captureRecord(*node, record);
+
+	size_t rotation_count;
+	size_t component_count = getComponentCount(*node, rotation_count);
+	mPayload.clear();
+
+	for (size_t i = 0; i < count; ++i) {
+		const string& key = attributes[i].first;
+		const string& value = attributes[i].second;
+
+		bool ok = true;
+		if (key == "name") node->setName(value);
+		else if (key == "active") ok = parseFlag(value, SceneNodeRecord::FLAG_ACTIVE, record.mFlags);
+		else if (key == "interactive") ok = parseFlag(value, SceneNodeRecord::FLAG_INTERACTIVE, record.mFlags);
+		else if (key == "payload") ok = decodeBase64(value, mPayload);
+		else if (component_count) {
+			if (key == "position") ok = parseFloats(value, record.mPosition, component_count);
+			else if (key == "rotation") ok = parseFloats(value, record.mRotation, rotation_count);
+			else if (key == "scale") ok = parseFloats(value, record.mScale, component_count);
+			else if (key == "pivot") ok = parseFloats(value, record.mPivot, component_count);
+			else if (key == "size") ok = parseFloats(value, record.mSize, component_count);
+		}
+
+		if (!ok) return NodeRef();
+	}
+
+	SceneReader::applyRecord(record, *node);
+
+	BinaryReader payload(mPayload.data(), mPayload.size());
+	if (!node->deserialize(payload)) return NodeRef();
+
+	return node;
+}
@@ -3,6 +3,7 @@
 #include "cinder/gl/gl.h"
 
 #include "NodeBase.h"
+#include "RenderBackendGl.h"
 
 using namespace ci;
 using namespace ci::app;
@@ -16,10 +17,12 @@ class ScenegraphApp : public App {
 	void draw() override;
 	
 	scene::NodeBase* mNode;
+	scene::RenderBackendRef mRenderer;
 };
 
 void ScenegraphApp::setup()
 {
+	mRenderer = scene::RenderBackendGl::create();
 }
 
 void ScenegraphApp::mouseDown( MouseEvent event )
@@ -32,7 +35,7 @@ void ScenegraphApp::update()
 
 void ScenegraphApp::draw()
 {
-	gl::clear( Color( 0, 0, 0 ) ); 
+	mRenderer->clear( ColorA( 0, 0, 0, 1 ) );
 }
 
 CINDER_APP( ScenegraphApp, RendererGl )
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <limits>
+
+#include "SceneFormat.h"
+#include "StreamingManager.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Estimate the memory of the loaded content instead of using the file size
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	//! the smallest priority, smaller ones push the region out of reach
+	const float MIN_PRIORITY = 1e-6f;
+}
+
+StreamingManager::StreamingManager(const ThreadPoolRef& pool, const SceneTypeRegistry& registry)
+:	mRegistry(registry), mPool(pool), mShared(new Shared()), mLoadDistance(100.0f), mUnloadDistance(120.0f),
+	mMemoryBudget(numeric_limits<uint64_t>::max()), mMaxPendingLoads(4), mResidentSize(0), mPendingCount(0),
+	mGeneration(0), mLoadCount(0), mUnloadCount(0), mFailedCount(0)
+{
+	if (!mPool) mPool = ThreadPool::create(1);
+
+	mShared->mIsCancelled = false;
+}
+
+StreamingManager::~StreamingManager()
+{
+	mShared->mIsCancelled = true;
+}
+
+void StreamingManager::add(const StreamingProxy3dRef& proxy)
+{
+	if (!proxy || find(proxy.get())) return;
+
+	Entry entry;
+	entry.mProxy = proxy;
+	entry.mKey = proxy.get();
+	entry.mState = proxy->isLoaded()? STATE_LOADED: STATE_UNLOADED;
+	entry.mGeneration = 0;
+	entry.mSize = proxy->getMemorySize();
+	entry.mDistance = 0.0f;
+	entry.mIsOrphaned = false;
+	if (entry.mState == STATE_LOADED) mResidentSize += entry.mSize;
+
+	mIndices[entry.mKey] = mEntries.size();
+	mEntries.push_back(entry);
+}
+
+void StreamingManager::remove(const StreamingProxy3dRef& proxy)
+{
+	if (!proxy) return;
+
+	// a pending load is dropped by sync() as the proxy has no entry anymore
+	unordered_map<const StreamingProxy3d*, size_t>::iterator itr = mIndices.find(proxy.get());
+	if (itr != mIndices.end()) erase(itr->second);
+}
+
+StreamingManager::State StreamingManager::getState(const StreamingProxy3d& proxy) const
+{
+	unordered_map<const StreamingProxy3d*, size_t>::const_iterator itr = mIndices.find(&proxy);
+	return itr != mIndices.end()? mEntries[itr->second].mState: STATE_UNLOADED;
+}
+
+size_t StreamingManager::getLoadedCount() const
+{
+	size_t count = 0;
+	for (vector<Entry>::const_iterator itr = mEntries.begin(); itr != mEntries.end(); ++itr) {
+		if (itr->mState == STATE_LOADED) ++count;
+	}
+	return count;
+}
+
+size_t StreamingManager::update(const vec3& viewer)
+{
+	size_t count = 0;
+
+	// destroyed proxies took their content with them
+	for (size_t i = mEntries.size(); i > 0; --i) {
+		if (mEntries[i - 1].mProxy.expired()) erase(i - 1);
+	}
+
+	mOrder.resize(mEntries.size());
+	for (size_t i = 0; i < mEntries.size(); ++i) {
+		StreamingProxy3dRef proxy = mEntries[i].mProxy.lock();
+		mEntries[i].mDistance = proxy->calcDistance(viewer) / std::max(proxy->getPriority(), MIN_PRIORITY);
+		mOrder[i] = i;
+	}
+	sort(mOrder.begin(), mOrder.end(), [this](size_t a, size_t b) { return mEntries[a].mDistance < mEntries[b].mDistance; });
+
+	// the nearest regions take the budget, loaded ones stay until they are beyond the unload distance;
+	// entries are not erased during the pass, since unloading a region orphans the proxies nested in it
+	float unload_distance = std::max(mUnloadDistance, mLoadDistance);
+	uint64_t budget = mMemoryBudget;
+	for (vector<size_t>::const_iterator itr = mOrder.begin(); itr != mOrder.end(); ++itr) {
+		Entry& entry = mEntries[*itr];
+		if (entry.mState == STATE_FAILED || entry.mIsOrphaned) continue;
+
+		StreamingProxy3dRef proxy = entry.mProxy.lock();
+		if (!proxy) continue;
+
+		bool is_resident = entry.mState != STATE_UNLOADED;
+		bool is_near = entry.mDistance < (is_resident? unload_distance: mLoadDistance);
+
+		// a proxy that does not know its size uses the size of its file once it was loaded
+		uint64_t size = entry.mState == STATE_LOADED || !proxy->getMemorySize()? entry.mSize: proxy->getMemorySize();
+		if (is_near && size <= budget) {
+			budget -= size;
+			if (entry.mState == STATE_UNLOADED && mPendingCount < mMaxPendingLoads) load(entry, proxy);
+		}
+		else if (is_resident && unload(entry, proxy)) ++count;
+	}
+
+	for (size_t i = mEntries.size(); i > 0; --i) {
+		if (mEntries[i - 1].mIsOrphaned || mEntries[i - 1].mProxy.expired()) erase(i - 1);
+	}
+
+	return count + sync();
+}
+
+StreamingManager::Entry* StreamingManager::find(const StreamingProxy3d* proxy)
+{
+	unordered_map<const StreamingProxy3d*, size_t>::iterator itr = mIndices.find(proxy);
+	return itr != mIndices.end()? &mEntries[itr->second]: nullptr;
+}
+
+void StreamingManager::erase(size_t index)
+{
+	if (mEntries[index].mState == STATE_LOADED) mResidentSize -= mEntries[index].mSize;
+	mIndices.erase(mEntries[index].mKey);
+
+	// the last entry takes the place of the removed one
+	if (index + 1 < mEntries.size()) {
+		mEntries[index] = mEntries.back();
+		mIndices[mEntries[index].mKey] = index;
+	}
+	mEntries.pop_back();
+}
+
+void StreamingManager::load(Entry& entry, const StreamingProxy3dRef& proxy)
+{
+	entry.mState = STATE_LOADING;
+	entry.mGeneration = ++mGeneration;
+	++mPendingCount;
+
+	// the task keeps the shared state alive, not the manager nor the proxy
+	shared_ptr<Shared> shared = mShared;
+	StreamingProxy3dWeakRef weak_proxy = proxy;
+	uint32_t generation = entry.mGeneration;
+	string path = proxy->getPath();
+	const SceneTypeRegistry* registry = &mRegistry;
+	mPool->submit([shared, weak_proxy, generation, path, registry]() {
+		Result result;
+		result.mProxy = weak_proxy;
+		result.mGeneration = generation;
+		result.mFileSize = 0;
+
+		if (!shared->mIsCancelled && !weak_proxy.expired()) {
+			ifstream stream(path.c_str(), ios::binary);
+			if (stream) {
+				vector<uint8_t> data((istreambuf_iterator<char>(stream)), istreambuf_iterator<char>());
+				if (!stream.bad()) {
+					result.mContent = SceneReader(*registry).read(data);
+					result.mFileSize = data.size();
+				}
+			}
+		}
+		shared->mResults.push(std::move(result));
+	});
+}
+
+bool StreamingManager::unload(Entry& entry, const StreamingProxy3dRef& proxy)
+{
+	// the result of a pending load is dropped, even if the proxy is loading again by then
+	bool was_loaded = entry.mState == STATE_LOADED;
+	if (was_loaded) {
+		// the content may be the only owner of the nested proxies, so they are found before it goes
+		vector<StreamingProxy3dRef> nested;
+		NodeBase::Iter iter(proxy->getContent(), true);
+		while (iter.hasNext()) {
+			StreamingProxy3dRef node = iter.next<StreamingProxy3d>();
+			if (node) nested.push_back(node);
+		}
+
+		proxy->setContent(NodeRef());
+		mResidentSize -= entry.mSize;
+		++mUnloadCount;
+
+		for (vector<StreamingProxy3dRef>::const_iterator itr = nested.begin(); itr != nested.end(); ++itr) {
+			Entry* orphan = find(itr->get());
+			if (orphan && !orphan->mIsOrphaned) {
+				orphan->mIsOrphaned = true;
+				unload(*orphan, *itr);
+			}
+		}
+	}
+
+	entry.mState = STATE_UNLOADED;
+	return was_loaded;
+}
+
+size_t StreamingManager::sync()
+{
+	size_t count = 0;
+	Result result;
+	while (mShared->mResults.pop(result)) {
+		--mPendingCount;
+
+		// loads of released, unregistered or unloaded proxies are dropped
+		StreamingProxy3dRef proxy = result.mProxy.lock();
+		Entry* entry = proxy? find(proxy.get()): nullptr;
+		if (entry && entry->mState == STATE_LOADING && entry->mGeneration == result.mGeneration) {
+			if (result.mContent) {
+				entry->mSize = proxy->getMemorySize()? proxy->getMemorySize(): result.mFileSize;
+				entry->mState = STATE_LOADED;
+				mResidentSize += entry->mSize;
+				++mLoadCount;
+				++count;
+				proxy->setContent(result.mContent);
+
+				// the proxies of a nested world are streamed as well
+				NodeBase::Iter iter(result.mContent, true);
+				while (iter.hasNext()) {
+					StreamingProxy3dRef nested = iter.next<StreamingProxy3d>();
+					if (nested) add(nested);
+				}
+			}
+			else {
+				entry->mState = STATE_FAILED;
+				++mFailedCount;
+			}
+		}
+		result = Result();
+	}
+	return count;
+}
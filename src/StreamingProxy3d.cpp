@@ -0,0 +1,74 @@
+#include "BinaryStream.hpp"
+#include "StreamingProxy3d.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Draw the region while the content is not loaded
+//
+///////////////////////////////////////////////////////////////////////////
+
+StreamingProxy3d::StreamingProxy3d(const string& path, const AxisAlignedBox& region, const string& name)
+:	Node3d(name), mPath(path), mRegion(region), mPriority(1.0f), mMemorySize(0)
+{
+}
+
+StreamingProxy3d::~StreamingProxy3d()
+{
+}
+
+void StreamingProxy3d::setContent(const NodeRef& content)
+{
+	if (content == mContent) return;
+
+	// the content may have been moved elsewhere in the meantime
+	if (mContent && mContent->getParent().get() == this) removeChild(mContent);
+	mContent = content;
+	if (mContent) addChild(mContent);
+}
+
+float StreamingProxy3d::calcDistance(const vec3& point) const
+{
+	AxisAlignedBox region = mRegion.transformed(mWorldTransform);
+	vec3 outside = glm::max(glm::max(region.getMin() - point, point - region.getMax()), vec3(0.0f));
+	return glm::length(outside);
+}
+
+void StreamingProxy3d::serialize(BinaryWriter& writer) const
+{
+	writer.writeString(mPath);
+
+	vec3 min = mRegion.getMin();
+	vec3 max = mRegion.getMax();
+	writer.write(min.x);
+	writer.write(min.y);
+	writer.write(min.z);
+	writer.write(max.x);
+	writer.write(max.y);
+	writer.write(max.z);
+
+	writer.write(mPriority);
+	writer.write(mMemorySize);
+}
+
+bool StreamingProxy3d::deserialize(BinaryReader& reader)
+{
+	string path;
+	vec3 min, max;
+	float priority = 0.0f;
+	uint64_t memory_size = 0;
+	if (!reader.readString(path)) return false;
+	if (!reader.read(min.x) || !reader.read(min.y) || !reader.read(min.z)) return false;
+	if (!reader.read(max.x) || !reader.read(max.y) || !reader.read(max.z)) return false;
+	if (!reader.read(priority) || !reader.read(memory_size)) return false;
+
+	mPath = path;
+	mRegion = AxisAlignedBox(min, max);
+	mPriority = priority;
+	mMemorySize = memory_size;
+	setContentDirty();
+	return true;
+}
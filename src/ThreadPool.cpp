@@ -0,0 +1,129 @@
+#include <algorithm>
+
+#include "ThreadPool.h"
+
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	//! state shared by the caller and the helper tasks of a parallelFor
+	struct ParallelForState {
+		ParallelForState(size_t count, const std::function<void(size_t)>& fn)
+		:	mCount(count), mFn(fn), mNext(0), mDone(0) {}
+
+		//! claims and executes indices until none are left
+		void work()
+		{
+			size_t finished = 0;
+			for (size_t i = mNext++; i < mCount; i = mNext++) {
+				mFn(i);
+				++finished;
+			}
+
+			if (finished == 0) return;
+			if (mDone.fetch_add(finished) + finished == mCount) {
+				std::lock_guard<std::mutex> lock(mMutex);
+				mFinished.notify_all();
+			}
+		}
+
+		size_t							mCount;
+		std::function<void(size_t)>		mFn;
+		std::atomic<size_t>				mNext;
+		std::atomic<size_t>				mDone;
+		std::mutex						mMutex;
+		std::condition_variable			mFinished;
+	};
+}
+
+ThreadPool::ThreadPool(size_t threads)
+:	mActive(0), mIsStopping(false)
+{
+	if (threads == 0) {
+		size_t hardware = std::thread::hardware_concurrency();
+		threads = (hardware > 1)? hardware - 1: 1;
+	}
+
+	for (size_t i = 0; i < threads; ++i) {
+		mThreads.push_back(std::thread(&ThreadPool::run, this));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mIsStopping = true;
+	}
+	mTaskReady.notify_all();
+
+	for (auto itr = mThreads.begin(); itr != mThreads.end(); ++itr) {
+		itr->join();
+	}
+}
+
+void ThreadPool::submit(const std::function<void()>& task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mTasks.push_back(task);
+	}
+	mTaskReady.notify_one();
+}
+
+void ThreadPool::run()
+{
+	while (true) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mTaskReady.wait(lock, [this]() { return mIsStopping || !mTasks.empty(); });
+			if (mTasks.empty()) return;
+
+			task = std::move(mTasks.front());
+			mTasks.pop_front();
+			++mActive;
+		}
+
+		task();
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			--mActive;
+		}
+		mIdle.notify_all();
+	}
+}
+
+void ThreadPool::waitIdle()
+{
+	std::unique_lock<std::mutex> lock(mMutex);
+	mIdle.wait(lock, [this]() { return mTasks.empty() && mActive == 0; });
+}
+
+void ThreadPool::parallelFor(size_t count, const std::function<void(size_t)>& fn)
+{
+	if (count == 0) return;
+	if (count == 1 || mThreads.empty()) {
+		for (size_t i = 0; i < count; ++i) fn(i);
+		return;
+	}
+
+	// helpers keep the state alive, they may start after the caller already finished all work
+	std::shared_ptr<ParallelForState> state = std::make_shared<ParallelForState>(count, fn);
+	size_t helpers = std::min(count - 1, mThreads.size());
+	for (size_t i = 0; i < helpers; ++i) {
+		submit([state]() { state->work(); });
+	}
+
+	state->work();
+
+	std::unique_lock<std::mutex> lock(state->mMutex);
+	state->mFinished.wait(lock, [&state]() { return state->mDone == state->mCount; });
+}
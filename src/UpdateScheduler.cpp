@@ -0,0 +1,110 @@
+#include "UpdateScheduler.h"
+
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Split very large isolated subtrees into several ranges
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	// ranges are grouped into tasks of roughly this many nodes
+	const size_t kNodesPerTask = 64;
+}
+
+UpdateScheduler::UpdateScheduler(const ThreadPoolRef& pool)
+:	mPool(pool), mMinBatchSize(128), mPendingNodes(0),
+	mParallelNodeCount(0), mSerialNodeCount(0), mBatchCount(0)
+{
+}
+
+bool UpdateScheduler::flatten(NodeBase& node)
+{
+	size_t index = mEntries.size();
+	Entry entry = { &node, 1, node.getUpdateScope() == NodeBase::UPDATE_SUBTREE };
+	mEntries.push_back(entry);
+
+	bool isolated = entry.mIsIsolated;
+	for (auto itr = node.getChildren().begin(); itr != node.getChildren().end(); ++itr) {
+		isolated = flatten(**itr) && isolated;
+	}
+
+	mEntries[index].mSubtreeSize = static_cast<uint32_t>(mEntries.size() - index);
+	mEntries[index].mIsIsolated = isolated;
+	return isolated;
+}
+
+void UpdateScheduler::deepUpdate(NodeBase& root, double elapsed)
+{
+	mParallelNodeCount = 0;
+	mSerialNodeCount = 0;
+	mBatchCount = 0;
+
+	mEntries.clear();
+	flatten(root);
+
+	const uint32_t count = static_cast<uint32_t>(mEntries.size());
+	for (uint32_t i = 0; i < count;) {
+		const Entry& entry = mEntries[i];
+		if (entry.mIsIsolated) {
+			// the whole subtree can run concurrently with the other pending ones
+			Range range = { i, i + entry.mSubtreeSize };
+			mPending.push_back(range);
+			mPendingNodes += entry.mSubtreeSize;
+			i += entry.mSubtreeSize;
+		}
+		else {
+			// barrier: everything before it in tree order has to be done
+			flush(elapsed);
+			entry.mNode->update(elapsed);
+			++mSerialNodeCount;
+			++i;
+		}
+	}
+
+	flush(elapsed);
+}
+
+void UpdateScheduler::flush(double elapsed)
+{
+	if (mPending.empty()) return;
+
+	mParallelNodeCount += mPendingNodes;
+
+	if (!mPool || mPendingNodes < mMinBatchSize) {
+		for (auto itr = mPending.begin(); itr != mPending.end(); ++itr) {
+			for (uint32_t i = itr->mBegin; i < itr->mEnd; ++i) {
+				mEntries[i].mNode->update(elapsed);
+			}
+		}
+	}
+	else {
+		// merge adjacent ranges into tasks of similar size
+		std::vector<Range>& tasks = mTasks;
+		tasks.clear();
+		Range task = mPending.front();
+		for (auto itr = mPending.begin() + 1; itr != mPending.end(); ++itr) {
+			if (itr->mBegin == task.mEnd && task.mEnd - task.mBegin < kNodesPerTask) {
+				task.mEnd = itr->mEnd;
+			}
+			else {
+				tasks.push_back(task);
+				task = *itr;
+			}
+		}
+		tasks.push_back(task);
+
+		const Entry* entries = mEntries.data();
+		mPool->parallelFor(tasks.size(), [&tasks, entries, elapsed](size_t t) {
+			for (uint32_t i = tasks[t].mBegin; i < tasks[t].mEnd; ++i) {
+				entries[i].mNode->update(elapsed);
+			}
+		});
+		++mBatchCount;
+	}
+
+	mPending.clear();
+	mPendingNodes = 0;
+}
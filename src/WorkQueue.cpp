@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+#include "WorkQueue.h"
+
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+const WorkQueue::JobId WorkQueue::INVALID_JOB;
+
+WorkQueue::WorkQueue(double budget_us)
+:	mCancelledCount(0), mNextId(INVALID_JOB + 1), mFrame(0), mBudget(budget_us), mAgingPeriod(30)
+{
+	mStats = Stats();
+	for (int level = 0; level < PRIORITY_COUNT; ++level) mOldestFrames[level] = 0;
+}
+
+WorkQueue::JobId WorkQueue::submit(const Job& job, Priority priority)
+{
+	if (!job) return INVALID_JOB;
+
+	int level = std::min(std::max(static_cast<int>(priority), 0), PRIORITY_COUNT - 1);
+
+	Entry entry;
+	entry.mId = mNextId++;
+	entry.mJob = job;
+	entry.mFrame = mFrame;
+	if (mLevels[level].empty()) mOldestFrames[level] = mFrame;
+	mLevels[level].push_back(entry);
+	return entry.mId;
+}
+
+bool WorkQueue::cancel(JobId id)
+{
+	// ids grow monotonically within each level, so a binary search finds the entry
+	for (int level = 0; level < PRIORITY_COUNT; ++level) {
+		std::deque<Entry>& entries = mLevels[level];
+		auto itr = std::lower_bound(entries.begin(), entries.end(), id, [](const Entry& entry, JobId id) { return entry.mId < id; });
+		if (itr != entries.end() && itr->mId == id && itr->mJob) {
+			// leave the entry in place so the order stays sorted, pop skips it
+			itr->mJob = Job();
+			++mCancelledCount;
+			return true;
+		}
+	}
+	return false;
+}
+
+void WorkQueue::promote()
+{
+	mStats.mJobsPromoted = 0;
+
+	// walk from the top so a job moves at most one level per frame
+	for (int level = PRIORITY_COUNT - 2; level >= 0; --level) {
+		std::deque<Entry>& entries = mLevels[level];
+		if (entries.empty() || mFrame - mOldestFrames[level] < mAgingPeriod) continue;
+
+		// promoted jobs are sorted in by id, so the frames of a level are not in order and every entry is checked
+		std::deque<Entry> aged;
+		uint64_t oldest = mFrame;
+		auto kept = entries.begin();
+		for (auto itr = entries.begin(); itr != entries.end(); ++itr) {
+			if (!itr->mJob) {
+				--mCancelledCount;
+			}
+			else if (mFrame - itr->mFrame >= mAgingPeriod) {
+				aged.push_back(std::move(*itr));
+				aged.back().mFrame = mFrame;
+			}
+			else {
+				oldest = std::min(oldest, itr->mFrame);
+				if (kept != itr) *kept = std::move(*itr);
+				++kept;
+			}
+		}
+		entries.erase(kept, entries.end());
+		mOldestFrames[level] = oldest;
+		if (aged.empty()) continue;
+
+		// both levels are sorted by id, so they are merged
+		std::deque<Entry>& target = mLevels[level + 1];
+		if (target.empty()) mOldestFrames[level + 1] = mFrame;
+		std::deque<Entry> merged;
+		std::merge(target.begin(), target.end(), aged.begin(), aged.end(), std::back_inserter(merged), [](const Entry& a, const Entry& b) { return a.mId < b.mId; });
+		target.swap(merged);
+		mStats.mJobsPromoted += aged.size();
+	}
+}
+
+bool WorkQueue::pop(Entry& entry)
+{
+	for (int level = PRIORITY_COUNT - 1; level >= 0; --level) {
+		std::deque<Entry>& entries = mLevels[level];
+		while (!entries.empty()) {
+			entry = entries.front();
+			entries.pop_front();
+			if (entry.mJob) return true;
+			--mCancelledCount;
+		}
+	}
+	return false;
+}
+
+size_t WorkQueue::drain()
+{
+	typedef std::chrono::steady_clock Clock;
+
+	++mFrame;
+	promote();
+
+	mStats.mJobsRun = 0;
+	mStats.mMicroseconds = 0;
+	mStats.mLongestJob = 0;
+
+	Clock::time_point start = Clock::now();
+	Clock::time_point previous = start;
+
+	Entry entry;
+	while (pop(entry)) {
+		entry.mJob();
+		++mStats.mJobsRun;
+
+		Clock::time_point now = Clock::now();
+		double job_us = std::chrono::duration<double, std::micro>(now - previous).count();
+		mStats.mLongestJob = std::max(mStats.mLongestJob, job_us);
+		previous = now;
+
+		mStats.mMicroseconds = std::chrono::duration<double, std::micro>(now - start).count();
+		if (mStats.mMicroseconds >= mBudget) break;
+	}
+
+	mStats.mJobsPending = getPendingCount();
+	return mStats.mJobsRun;
+}
+
+void WorkQueue::flush()
+{
+	Entry entry;
+	while (pop(entry)) entry.mJob();
+}
+
+size_t WorkQueue::getPendingCount() const
+{
+	size_t count = 0;
+	for (int level = 0; level < PRIORITY_COUNT; ++level) count += mLevels[level].size();
+	return count - mCancelledCount;
+}
+
+void WorkQueue::clear()
+{
+	for (int level = 0; level < PRIORITY_COUNT; ++level) mLevels[level].clear();
+	mCancelledCount = 0;
+}
@@ -0,0 +1,116 @@
+#include <algorithm>
+
+#include "WorldMatrixBuffer.h"
+
+using namespace ci;
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+void WorldMatrixBuffer::pack(const mat4& world, PackedMatrix34& out)
+{
+	for (int row = 0; row < 3; ++row) {
+		for (int col = 0; col < 4; ++col) {
+			out.mRows[row][col] = world[col][row];
+		}
+	}
+}
+
+mat4 WorldMatrixBuffer::unpack(const PackedMatrix34& packed)
+{
+	mat4 out(1);
+	for (int row = 0; row < 3; ++row) {
+		for (int col = 0; col < 4; ++col) {
+			out[col][row] = packed.mRows[row][col];
+		}
+	}
+
+	return out;
+}
+
+uint32_t WorldMatrixBuffer::allocate()
+{
+	uint32_t index;
+	if (!mFreeSlots.empty()) {
+		index = mFreeSlots.back();
+		mFreeSlots.pop_back();
+	}
+	else {
+		index = static_cast<uint32_t>(mMatrices.size());
+		mMatrices.push_back(PackedMatrix34());
+		mDirtyFlags.push_back(0);
+		mAllocatedFlags.push_back(0);
+	}
+
+	mAllocatedFlags[index] = 1;
+	set(index, mat4(1));
+	return index;
+}
+
+void WorldMatrixBuffer::release(uint32_t index)
+{
+	// a second release would hand the slot out twice
+	if (!isAllocated(index)) return;
+
+	mAllocatedFlags[index] = 0;
+	mFreeSlots.push_back(index);
+}
+
+void WorldMatrixBuffer::set(uint32_t index, const mat4& world)
+{
+	if (index >= mMatrices.size()) return;
+
+	pack(world, mMatrices[index]);
+	markDirty(index);
+}
+
+mat4 WorldMatrixBuffer::get(uint32_t index) const
+{
+	if (index >= mMatrices.size()) return mat4(1);
+
+	return unpack(mMatrices[index]);
+}
+
+void WorldMatrixBuffer::markDirty(uint32_t index)
+{
+	if (mDirtyFlags[index]) return;
+
+	mDirtyFlags[index] = 1;
+	mDirtySlots.push_back(index);
+}
+
+const vector<MatrixRange>& WorldMatrixBuffer::getDirtyRanges(uint32_t max_gap)
+{
+	mDirtyRanges.clear();
+	if (mDirtySlots.empty()) return mDirtyRanges;
+
+	std::sort(mDirtySlots.begin(), mDirtySlots.end());
+
+	MatrixRange range = { mDirtySlots.front(), mDirtySlots.front() + 1 };
+	for (auto itr = mDirtySlots.begin() + 1; itr != mDirtySlots.end(); ++itr) {
+		if (*itr - range.mEnd <= max_gap) {
+			range.mEnd = *itr + 1;
+		}
+		else {
+			mDirtyRanges.push_back(range);
+			range.mBegin = *itr;
+			range.mEnd = *itr + 1;
+		}
+	}
+	mDirtyRanges.push_back(range);
+
+	return mDirtyRanges;
+}
+
+void WorldMatrixBuffer::clearDirty()
+{
+	for (auto itr = mDirtySlots.begin(); itr != mDirtySlots.end(); ++itr) {
+		mDirtyFlags[*itr] = 0;
+	}
+	mDirtySlots.clear();
+}
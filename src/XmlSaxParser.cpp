@@ -0,0 +1,303 @@
+#include <cstring>
+
+#include "XmlSaxParser.h"
+
+using namespace std;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:	Report character data for formats that need it
+//
+///////////////////////////////////////////////////////////////////////////
+
+const size_t XmlSaxParser::CHUNK_SIZE;
+
+static bool isSpace(int c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+static bool isNameStart(int c)
+{
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == ':' || c >= 0x80;
+}
+
+static bool isNameChar(int c)
+{
+	return isNameStart(c) || (c >= '0' && c <= '9') || c == '-' || c == '.';
+}
+
+//! appends a code point as UTF-8
+static void appendUtf8(uint32_t code, string& out)
+{
+	if (code < 0x80) {
+		out += static_cast<char>(code);
+	}
+	else if (code < 0x800) {
+		out += static_cast<char>(0xc0 | (code >> 6));
+		out += static_cast<char>(0x80 | (code & 0x3f));
+	}
+	else if (code < 0x10000) {
+		out += static_cast<char>(0xe0 | (code >> 12));
+		out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+		out += static_cast<char>(0x80 | (code & 0x3f));
+	}
+	else {
+		out += static_cast<char>(0xf0 | (code >> 18));
+		out += static_cast<char>(0x80 | ((code >> 12) & 0x3f));
+		out += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+		out += static_cast<char>(0x80 | (code & 0x3f));
+	}
+}
+
+XmlSaxParser::XmlSaxParser()
+:	mStream(nullptr), mChunk(CHUNK_SIZE), mPosition(0), mEnd(0), mLine(1), mMaxTokenSize(64 * 1024 * 1024),
+	mDepth(0), mHasRoot(false)
+{
+}
+
+const string* XmlSaxParser::findAttribute(const Attributes& attributes, size_t count, const char* name)
+{
+	for (size_t i = 0; i < count; ++i) {
+		if (attributes[i].first == name) return &attributes[i].second;
+	}
+	return nullptr;
+}
+
+bool XmlSaxParser::parse(istream& stream)
+{
+	mStream = &stream;
+	mPosition = mEnd = 0;
+	mLine = 1;
+	mDepth = 0;
+	mHasRoot = false;
+
+	bool ok = true;
+	while (ok) {
+		int c = get();
+		if (c < 0) break;
+
+		if (c != '<') {
+			// only whitespace may surround the root element
+			if (mDepth == 0 && !isSpace(c)) ok = false;
+			continue;
+		}
+
+		c = get();
+		if (c == '?') ok = skipPast("?>");
+		else if (c == '!') ok = skipMarkup();
+		else if (c == '/') ok = parseEndTag();
+		else ok = parseStartTag(c);
+	}
+
+	mStream = nullptr;
+	return ok && mHasRoot && mDepth == 0;
+}
+
+bool XmlSaxParser::fill()
+{
+	if (!mStream || !*mStream) return false;
+
+	mStream->read(mChunk.data(), mChunk.size());
+	mPosition = 0;
+	mEnd = static_cast<size_t>(mStream->gcount());
+	return mEnd > 0;
+}
+
+bool XmlSaxParser::skipPast(const char* terminator)
+{
+	size_t length = strlen(terminator);
+	size_t matched = 0;
+
+	while (matched < length) {
+		int c = get();
+		if (c < 0) return false;
+
+		if (c == terminator[matched]) {
+			++matched;
+			continue;
+		}
+
+		// fall back to the longest start of the terminator that still ends here, as in "--->"
+		size_t k = matched;
+		while (k > 0 && !(terminator[k - 1] == c && memcmp(terminator, terminator + matched - k + 1, k - 1) == 0)) --k;
+		matched = k;
+	}
+
+	return true;
+}
+
+bool XmlSaxParser::skipMarkup()
+{
+	int c = get();
+	if (c == '-') return get() == '-' && skipPast("-->");
+
+	if (c == '[') {
+		for (const char* expected = "CDATA["; *expected; ++expected) {
+			if (get() != *expected) return false;
+		}
+		return skipPast("]]>");
+	}
+
+	// a declaration, which may hold an internal subset in brackets and quoted literals
+	int quote = 0;
+	int brackets = 0;
+	for (; c >= 0; c = get()) {
+		if (quote) {
+			if (c == quote) quote = 0;
+		}
+		else if (c == '"' || c == '\'') quote = c;
+		else if (c == '[') ++brackets;
+		else if (c == ']') --brackets;
+		else if (c == '>' && brackets <= 0) return true;
+	}
+
+	return false;
+}
+
+int XmlSaxParser::readName(int c, string& name)
+{
+	name.clear();
+	if (!isNameStart(c)) return c;
+
+	do {
+		if (name.size() == mMaxTokenSize) {
+			name.clear();
+			return c;
+		}
+		name += static_cast<char>(c);
+		c = get();
+	} while (isNameChar(c));
+
+	return c;
+}
+
+bool XmlSaxParser::readValue(int quote, string& value)
+{
+	value.clear();
+
+	for (;;) {
+		int c = get();
+		if (c < 0 || c == '<') return false;
+		if (c == quote) return true;
+
+		if (c == '&') {
+			if (!readReference(value)) return false;
+		}
+		else {
+			// attribute values are normalized, line breaks and tabs become spaces
+			value += isSpace(c)? ' ': static_cast<char>(c);
+		}
+
+		if (value.size() > mMaxTokenSize) return false;
+	}
+}
+
+bool XmlSaxParser::readReference(string& value)
+{
+	char reference[12];
+	size_t length = 0;
+
+	for (int c = get(); c != ';'; c = get()) {
+		if (c < 0 || length == sizeof(reference) - 1) return false;
+		reference[length++] = static_cast<char>(c);
+	}
+	reference[length] = 0;
+
+	if (reference[0] == '#') {
+		bool hex = reference[1] == 'x';
+		const char* digits = reference + (hex? 2: 1);
+		if (!*digits) return false;
+
+		uint32_t code = 0;
+		for (const char* p = digits; *p; ++p) {
+			int digit;
+			if (*p >= '0' && *p <= '9') digit = *p - '0';
+			else if (hex && *p >= 'a' && *p <= 'f') digit = *p - 'a' + 10;
+			else if (hex && *p >= 'A' && *p <= 'F') digit = *p - 'A' + 10;
+			else return false;
+
+			code = code * (hex? 16: 10) + digit;
+			if (code > 0x10ffff) return false;
+		}
+
+		if (code == 0 || (code >= 0xd800 && code <= 0xdfff)) return false;
+		appendUtf8(code, value);
+		return true;
+	}
+
+	if (strcmp(reference, "lt") == 0) value += '<';
+	else if (strcmp(reference, "gt") == 0) value += '>';
+	else if (strcmp(reference, "amp") == 0) value += '&';
+	else if (strcmp(reference, "quot") == 0) value += '"';
+	else if (strcmp(reference, "apos") == 0) value += '\'';
+	else return false;
+
+	return true;
+}
+
+bool XmlSaxParser::parseStartTag(int c)
+{
+	// a document has a single root
+	if (mDepth == 0 && mHasRoot) return false;
+
+	c = readName(c, mName);
+	if (mName.empty()) return false;
+
+	size_t count = 0;
+	bool empty = false;
+
+	for (;;) {
+		bool separated = false;
+		while (isSpace(c)) {
+			separated = true;
+			c = get();
+		}
+
+		if (c == '>') break;
+		if (c == '/') {
+			if (get() != '>') return false;
+			empty = true;
+			break;
+		}
+		if (!separated) return false;
+
+		if (count == mAttributes.size()) mAttributes.emplace_back();
+		pair<string, string>& attribute = mAttributes[count];
+
+		c = readName(c, attribute.first);
+		if (attribute.first.empty()) return false;
+		for (size_t i = 0; i < count; ++i) {
+			if (mAttributes[i].first == attribute.first) return false;
+		}
+
+		while (isSpace(c)) c = get();
+		if (c != '=') return false;
+		c = get();
+		while (isSpace(c)) c = get();
+
+		if ((c != '"' && c != '\'') || !readValue(c, attribute.second)) return false;
+		++count;
+		c = get();
+	}
+
+	mHasRoot = true;
+	if (!onStartElement(mName, mAttributes, count)) return false;
+	if (empty) return onEndElement(mName);
+
+	// the names keep their storage, so nesting does not allocate once it was reached
+	if (mDepth == mOpen.size()) mOpen.emplace_back();
+	mOpen[mDepth++] = mName;
+	return true;
+}
+
+bool XmlSaxParser::parseEndTag()
+{
+	int c = readName(get(), mName);
+	if (mName.empty()) return false;
+
+	while (isSpace(c)) c = get();
+	if (c != '>') return false;
+
+	if (mDepth == 0 || mOpen[mDepth - 1] != mName) return false;
+	--mDepth;
+	return onEndElement(mName);
+}
@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <vector>
+
+#include "CinderGTest.h"
+
+#include "AnimationSystem.h"
+#include "SceneContext.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+class AnimationSystemTest : public testing::Test {
+public:
+	AnimationSystemTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mSystem = AnimationSystem::create();
+		mNode = Node3d::create("animated");
+	}
+
+	void TearDown()
+	{
+	}
+
+	AnimationSystemRef	mSystem;
+	Node3dRef			mNode;
+};
+
+TEST_F(AnimationSystemTest, LinearPosition)
+{
+	mSystem->addPositionChannel(mNode, { 0.0f, 1.0f, 3.0f }, { vec3(0), vec3(10, 0, 0), vec3(10, 20, 0) });
+
+	mSystem->evaluate(0.5f);
+	EXPECT_NEAR(mNode->getPosition().x, 5.0f, 1e-5f);
+
+	mSystem->evaluate(2.0f);
+	EXPECT_NEAR(mNode->getPosition().x, 10.0f, 1e-5f);
+	EXPECT_NEAR(mNode->getPosition().y, 10.0f, 1e-5f);
+
+	// times outside the keys hold the first or last key
+	mSystem->evaluate(-1.0f);
+	EXPECT_NEAR(mNode->getPosition().x, 0.0f, 1e-5f);
+	mSystem->evaluate(5.0f);
+	EXPECT_NEAR(mNode->getPosition().y, 20.0f, 1e-5f);
+}
+
+TEST_F(AnimationSystemTest, SeekBackwards)
+{
+	std::vector<float> times;
+	std::vector<vec3> values;
+	for (int i = 0; i < 10; ++i) {
+		times.push_back(float(i));
+		values.push_back(vec3(float(i * i), 0, 0));
+	}
+	mSystem->addPositionChannel(mNode, times, values);
+
+	mSystem->evaluate(8.5f);
+	EXPECT_NEAR(mNode->getPosition().x, 72.5f, 1e-4f);
+
+	mSystem->evaluate(2.5f);
+	EXPECT_NEAR(mNode->getPosition().x, 6.5f, 1e-4f);
+}
+
+TEST_F(AnimationSystemTest, Bezier)
+{
+	AnimationSystem::ChannelId id = mSystem->addScaleChannel(mNode, { 0.0f, 1.0f }, { vec3(1), vec3(2) }, AnimationSystem::BEZIER);
+
+	// without controls the curve is a straight line
+	mSystem->evaluate(0.25f);
+	EXPECT_NEAR(mNode->getScale().x, 1.25f, 1e-5f);
+
+	mSystem->setControls(id, { vec4(1), vec4(2) }, { vec4(1), vec4(2) });
+	mSystem->evaluate(0.0f);
+	EXPECT_NEAR(mNode->getScale().x, 1.0f, 1e-5f);
+	mSystem->evaluate(1.0f);
+	EXPECT_NEAR(mNode->getScale().x, 2.0f, 1e-5f);
+
+	// ease in and out: slow at the ends, symmetric in the middle
+	mSystem->evaluate(0.5f);
+	EXPECT_NEAR(mNode->getScale().x, 1.5f, 1e-5f);
+	mSystem->evaluate(0.1f);
+	EXPECT_LT(mNode->getScale().x, 1.1f);
+}
+
+TEST_F(AnimationSystemTest, RotationMatchesSlerp)
+{
+	quat a = glm::angleAxis(0.0f, vec3(0, 0, 1));
+	quat b = glm::angleAxis(2.5f, glm::normalize(vec3(1, 1, 0)));
+	mSystem->addRotationChannel(mNode, { 0.0f, 1.0f }, { a, b });
+
+	for (int i = 0; i <= 10; ++i) {
+		float t = i / 10.0f;
+		mSystem->evaluate(t);
+
+		quat expected = glm::slerp(a, b, t);
+		quat actual = mNode->getRotation();
+		EXPECT_NEAR(std::fabs(glm::dot(expected, actual)), 1.0f, 1e-3f);
+	}
+}
+
+TEST_F(AnimationSystemTest, Looping)
+{
+	AnimationSystem::ChannelId id = mSystem->addPositionChannel(mNode, { 0.0f, 2.0f }, { vec3(0), vec3(0, 0, 4) });
+	mSystem->setLooping(id);
+
+	mSystem->update(1.0);
+	EXPECT_NEAR(mNode->getPosition().z, 2.0f, 1e-5f);
+
+	mSystem->update(2.5);
+	EXPECT_NEAR(mNode->getPosition().z, 3.0f, 1e-5f);
+	EXPECT_FLOAT_EQ(mSystem->getTime(), 3.5f);
+}
+
+TEST_F(AnimationSystemTest, Node2d)
+{
+	Node2dRef node = Node2d::create("flat");
+	mSystem->addPositionChannel(node, { 0.0f, 1.0f }, { vec2(0), vec2(100, 50) });
+	mSystem->addRotationChannel(node, { 0.0f, 1.0f }, { 0.0f, 1.0f });
+
+	mSystem->evaluate(0.5f);
+	EXPECT_NEAR(node->getPosition().x, 50.0f, 1e-4f);
+	EXPECT_NEAR(node->getPosition().y, 25.0f, 1e-4f);
+	EXPECT_NEAR(node->getRotation(), 0.5f, 1e-5f);
+}
+
+TEST_F(AnimationSystemTest, DisabledAndExpired)
+{
+	AnimationSystem::ChannelId id = mSystem->addPositionChannel(mNode, { 0.0f, 1.0f }, { vec3(0), vec3(1) });
+	mSystem->setEnabled(id, false);
+	mNode->setPosition(vec3(7));
+	mSystem->evaluate(0.5f);
+	EXPECT_FLOAT_EQ(mNode->getPosition().x, 7.0f);
+
+	mSystem->setEnabled(id);
+	mNode.reset();
+	mSystem->evaluate(0.5f);
+	EXPECT_EQ(mSystem->getChannelCount(), 1u);
+}
+
+TEST_F(AnimationSystemTest, PauseAndExpireWithinBatch)
+{
+	std::vector<Node3dRef> nodes;
+	std::vector<AnimationSystem::ChannelId> ids;
+	for (int i = 0; i < 6; ++i) {
+		nodes.push_back(Node3d::create("node"));
+		ids.push_back(mSystem->addPositionChannel(nodes.back(), { 0.0f, 1.0f }, { vec3(0), vec3(float(i + 1)) }));
+	}
+
+	// the channels that stay in the batch keep driving their own node
+	mSystem->setEnabled(ids[1], false);
+	nodes[3].reset();
+	mSystem->evaluate(0.5f);
+	mSystem->setEnabled(ids[1]);
+	mSystem->evaluate(0.25f);
+
+	for (int i = 0; i < 6; ++i) {
+		if (nodes[i]) EXPECT_NEAR(nodes[i]->getPosition().x, (i + 1) * 0.25f, 1e-5f);
+	}
+	EXPECT_EQ(mSystem->getChannelCount(), 6u);
+}
+
+TEST_F(AnimationSystemTest, ManyChannels)
+{
+	std::vector<Node3dRef> nodes;
+	for (int i = 0; i < 50000; ++i) {
+		Node3dRef node = Node3d::create("node");
+		mSystem->addPositionChannel(node, { 0.0f, 1.0f }, { vec3(0), vec3(float(i)) });
+		mSystem->addRotationChannel(node, { 0.0f, 1.0f }, { quat(), glm::angleAxis(1.0f, vec3(0, 1, 0)) });
+		nodes.push_back(node);
+	}
+
+	for (int frame = 0; frame < 10; ++frame) mSystem->update(1.0 / 60.0);
+
+	float t = mSystem->getTime();
+	EXPECT_NEAR(nodes[12345]->getPosition().x, 12345.0f * t, 1e-2f);
+	EXPECT_NEAR(nodes.back()->getPosition().y, 49999.0f * t, 1e-1f);
+}
+
+TEST_F(AnimationSystemTest, ManyChannelsAcrossKeys)
+{
+	const int NODES = 50000;
+	const int KEYS = 8;
+
+	// the nodes live in a scene, so the journal counts the nodes that were written
+	SceneContextRef context = SceneContext::create();
+	Node3dRef root = Node3d::create("root");
+	context->setRoot(root);
+	context->getJournal().setEnabled();
+
+	std::vector<Node3dRef> nodes;
+	std::vector<AnimationSystem::ChannelId> ids;
+	std::vector<float> times;
+	for (int k = 0; k < KEYS; ++k) times.push_back(float(k));
+	for (int i = 0; i < NODES; ++i) {
+		std::vector<vec3> values;
+		for (int k = 0; k < KEYS; ++k) values.push_back(vec3(float(i + k), float(k * k), 0));
+		nodes.push_back(Node3d::create("node"));
+		root->addChild(nodes.back());
+		ids.push_back(mSystem->addPositionChannel(nodes.back(), times, values));
+	}
+	EXPECT_EQ(mSystem->getChannelCount(), size_t(NODES));
+
+	// every tenth channel is paused and leaves its node alone
+	for (int i = 0; i < NODES; i += 10) {
+		mSystem->setEnabled(ids[i], false);
+		nodes[i]->setPosition(vec3(-1));
+	}
+
+	// steps of different sizes cross one or several keys per frame and hold the last key at the end
+	const float steps[] = { 0.25f, 0.5f, 1.0f, 0.125f, 2.5f, 1.75f, 3.0f };
+	float time = 0;
+	for (float step : steps) {
+		time += step;
+		context->getJournal().clear();
+		mSystem->evaluate(time);
+
+		EXPECT_EQ(context->getJournal().size(), size_t(NODES - NODES / 10));
+
+		float clamped = std::min(time, float(KEYS - 1));
+		int k = std::min(int(clamped), KEYS - 2);
+		float u = clamped - float(k);
+		float y = float(k * k) + (float((k + 1) * (k + 1)) - float(k * k)) * u;
+		int mismatches = 0;
+		for (int i = 0; i < NODES; ++i) {
+			vec3 expected = (i % 10 == 0)? vec3(-1): vec3(float(i) + clamped, y, 0);
+			if (glm::distance(nodes[i]->getPosition(), expected) > 1e-2f) ++mismatches;
+		}
+		EXPECT_EQ(mismatches, 0) << "at time " << time;
+	}
+}
+
+CINDER_APP_GTEST( AnimationSystemTest, RendererGl )
@@ -0,0 +1,149 @@
+#include "CinderGTest.h"
+
+#include "Node2d.h"
+#include "SceneContext.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	class CountingNode : public Node2d {
+	public:
+		CountingNode() : Node2d("counting"), mAdded(0), mRemoved(0) {}
+
+		virtual void addedToScene() { ++mAdded; }
+		virtual void removedFromScene() { ++mRemoved; }
+
+		int		mAdded;
+		int		mRemoved;
+	};
+
+	uint32_t findChanges(const ChangeJournal& journal, uint64_t id)
+	{
+		uint32_t changes = 0;
+		const std::vector<ChangeJournal::Record>& records = journal.getRecords();
+		for (auto itr = records.begin(); itr != records.end(); ++itr) {
+			if (itr->mId == id) changes |= itr->mChanges;
+		}
+		return changes;
+	}
+}
+
+class ChangeJournalTest : public testing::Test {
+public:
+	ChangeJournalTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mContext = SceneContext::create();
+		mRoot = Node2d::create("root");
+		mContext->setRoot(mRoot);
+		mContext->getJournal().setEnabled();
+	}
+
+	void TearDown()
+	{
+	}
+
+	SceneContextRef		mContext;
+	Node2dRef			mRoot;
+};
+
+TEST_F(ChangeJournalTest, Disabled)
+{
+	mContext->getJournal().setEnabled(false);
+	mRoot->setPosition(vec2(1, 2));
+	mRoot->addChild(Node2d::create("child"));
+	EXPECT_TRUE(mContext->getJournal().empty());
+}
+
+TEST_F(ChangeJournalTest, Structure)
+{
+	Node2dRef child = Node2d::create("child");
+	Node2dRef grandchild = Node2d::create("grandchild");
+	child->addChild(grandchild);
+
+	mRoot->addChild(child);
+
+	const ChangeJournal& journal = mContext->getJournal();
+	EXPECT_EQ(journal.size(), 3u);
+	EXPECT_EQ(findChanges(journal, mRoot->getId()), uint32_t(ChangeJournal::CHANGE_CHILDREN));
+	EXPECT_EQ(findChanges(journal, child->getId()), uint32_t(ChangeJournal::CHANGE_ADDED));
+	EXPECT_EQ(findChanges(journal, grandchild->getId()), uint32_t(ChangeJournal::CHANGE_ADDED));
+
+	// removed nodes lose their pointer, they may be destroyed before the journal is read
+	mContext->getJournal().clear();
+	mRoot->removeChild(child);
+	EXPECT_EQ(findChanges(journal, child->getId()), uint32_t(ChangeJournal::CHANGE_REMOVED));
+	for (auto itr = journal.getRecords().begin(); itr != journal.getRecords().end(); ++itr) {
+		if (itr->mChanges & ChangeJournal::CHANGE_REMOVED) EXPECT_EQ(itr->mNode, nullptr);
+	}
+}
+
+TEST_F(ChangeJournalTest, MergedTransforms)
+{
+	for (int i = 0; i < 1000; ++i) {
+		mRoot->setPosition(vec2(float(i), 0));
+		mRoot->setRotation(0.001f * i);
+	}
+
+	const ChangeJournal& journal = mContext->getJournal();
+	ASSERT_EQ(journal.size(), 1u);
+	EXPECT_EQ(journal.getRecords()[0].mNode, mRoot.get());
+	EXPECT_EQ(journal.getRecords()[0].mChanges, uint32_t(ChangeJournal::CHANGE_TRANSFORM));
+
+	mRoot->setActive(false);
+	EXPECT_EQ(journal.size(), 1u);
+	EXPECT_TRUE(journal.getRecords()[0].mChanges & ChangeJournal::CHANGE_ACTIVE);
+
+	// the next frame starts over
+	mContext->getJournal().clear();
+	mRoot->setPosition(vec2(0, 0));
+	EXPECT_EQ(journal.size(), 1u);
+}
+
+TEST_F(ChangeJournalTest, Reparent)
+{
+	Node2dRef a = Node2d::create("a");
+	Node2dRef b = Node2d::create("b");
+	Node2dRef child = Node2d::create("child");
+	mRoot->addChild(a);
+	mRoot->addChild(b);
+	a->addChild(child);
+	mContext->getJournal().clear();
+
+	// moving between parents leaves and enters again, in that order
+	b->addChild(child);
+
+	const std::vector<ChangeJournal::Record>& records = mContext->getJournal().getRecords();
+	int removed = -1, added = -1;
+	for (size_t i = 0; i < records.size(); ++i) {
+		if (records[i].mId != child->getId()) continue;
+		if (records[i].mChanges & ChangeJournal::CHANGE_REMOVED) removed = int(i);
+		if (records[i].mChanges & ChangeJournal::CHANGE_ADDED) added = int(i);
+	}
+	EXPECT_GE(removed, 0);
+	EXPECT_GT(added, removed);
+	EXPECT_EQ(records[added].mNode, child.get());
+}
+
+TEST_F(ChangeJournalTest, AddedToSceneOnce)
+{
+	std::shared_ptr<CountingNode> node(new CountingNode());
+
+	mRoot->addChild(node);
+	EXPECT_EQ(node->mAdded, 1);
+
+	mRoot->removeChild(node);
+	EXPECT_EQ(node->mRemoved, 1);
+	EXPECT_EQ(node->mAdded, 1);
+}
+
+CINDER_APP_GTEST( ChangeJournalTest, RendererGl )
@@ -0,0 +1,318 @@
+#include <cfloat>
+#include <cmath>
+
+#include "CinderGTest.h"
+
+#include "CompactMesh.h"
+#include "NodeMesh.h"
+#include "RenderBackend.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	//! the nearest hit of a ray on a TriMesh, FLT_MAX if none, computed without quantization
+	float intersectReference(const TriMesh& mesh, const Ray& ray)
+	{
+		const vec3* positions = mesh.getPositions<3>();
+		const std::vector<uint32_t>& indices = mesh.getIndices();
+		float nearest = FLT_MAX;
+		for (size_t i = 0; i < indices.size(); i += 3) {
+			vec3 v0 = positions[indices[i]];
+			vec3 e1 = positions[indices[i + 1]] - v0;
+			vec3 e2 = positions[indices[i + 2]] - v0;
+			vec3 p = glm::cross(ray.getDirection(), e2);
+			float det = glm::dot(e1, p);
+			if (det == 0.0f) continue;
+			vec3 s = ray.getOrigin() - v0;
+			float u = glm::dot(s, p) / det;
+			vec3 q = glm::cross(s, e1);
+			float v = glm::dot(ray.getDirection(), q) / det;
+			float t = glm::dot(e2, q) / det;
+			if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && t > 0.0f) nearest = std::min(nearest, t);
+		}
+		return nearest;
+	}
+}
+
+class CompactMeshTest : public testing::Test {
+public:
+	CompactMeshTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		// a uv sphere of radius 2 around (1, 2, 3) with normals and texture coordinates
+		const int RINGS = 32;
+		const int SEGMENTS = 64;
+		const float PI = 3.14159265f;
+
+		mSphere = TriMesh(TriMesh::Format().positions(3).normals().texCoords0(2));
+		for (int ring = 0; ring <= RINGS; ++ring) {
+			float theta = PI * ring / RINGS;
+			for (int segment = 0; segment <= SEGMENTS; ++segment) {
+				float phi = 2.0f * PI * segment / SEGMENTS;
+				vec3 normal(sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi));
+				mSphere.appendPosition(vec3(1.0f, 2.0f, 3.0f) + normal * 2.0f);
+				mSphere.appendNormal(normal);
+				mSphere.appendTexCoord0(vec2(float(segment) / SEGMENTS, float(ring) / RINGS));
+			}
+		}
+		for (int ring = 0; ring < RINGS; ++ring) {
+			for (int segment = 0; segment < SEGMENTS; ++segment) {
+				uint32_t a = ring * (SEGMENTS + 1) + segment;
+				uint32_t b = a + SEGMENTS + 1;
+				mSphere.appendTriangle(a, b, a + 1);
+				mSphere.appendTriangle(a + 1, b, b + 1);
+			}
+		}
+	}
+
+	void TearDown()
+	{
+	}
+
+	TriMesh		mSphere;
+};
+
+TEST_F(CompactMeshTest, RestoresMeshWithinQuantizationError)
+{
+	CompactMeshRef compact = CompactMesh::create(mSphere);
+	ASSERT_EQ(mSphere.getNumVertices(), compact->getNumVertices());
+	ASSERT_EQ(mSphere.getNumIndices(), compact->getNumIndices());
+	EXPECT_TRUE(compact->hasNormals());
+	EXPECT_TRUE(compact->hasTexCoords0());
+	EXPECT_TRUE(compact->hasShortIndices());
+
+	// the bounds are kept exactly
+	AxisAlignedBox bounds = mSphere.calcBoundingBox();
+	EXPECT_EQ(bounds.getMin(), compact->getBounds().getMin());
+	EXPECT_EQ(bounds.getMax(), compact->getBounds().getMax());
+
+	TriMesh decoded;
+	compact->decode(decoded);
+	ASSERT_EQ(mSphere.getNumVertices(), decoded.getNumVertices());
+	EXPECT_EQ(mSphere.getIndices(), decoded.getIndices());
+
+	vec3 tolerance = compact->getPositionStep() * 0.5f + vec3(1e-5f);
+	const vec3* positions = mSphere.getPositions<3>();
+	const vec3* decoded_positions = decoded.getPositions<3>();
+	const vec2* texcoords = mSphere.getTexCoords0<2>();
+	const vec2* decoded_texcoords = decoded.getTexCoords0<2>();
+	float min_dot = 1.0f;
+	for (size_t i = 0; i < mSphere.getNumVertices(); ++i) {
+		vec3 error = glm::abs(positions[i] - decoded_positions[i]);
+		EXPECT_LE(error.x, tolerance.x);
+		EXPECT_LE(error.y, tolerance.y);
+		EXPECT_LE(error.z, tolerance.z);
+
+		min_dot = std::min(min_dot, glm::dot(mSphere.getNormals()[i], decoded.getNormals()[i]));
+
+		// half floats keep 11 significant bits
+		EXPECT_NEAR(texcoords[i].x, decoded_texcoords[i].x, 1.0f / 2048.0f);
+		EXPECT_NEAR(texcoords[i].y, decoded_texcoords[i].y, 1.0f / 2048.0f);
+	}
+	// the normals are less than a degree off
+	EXPECT_GT(min_dot, cosf(1.0f * 3.14159265f / 180.0f));
+}
+
+TEST_F(CompactMeshTest, TakesLessMemory)
+{
+	CompactMeshRef compact = CompactMesh::create(mSphere);
+	size_t original = CompactMesh::calcMemorySize(mSphere);
+	size_t compacted = compact->getMemorySize();
+
+	// 12 instead of 32 bytes per vertex and 2 instead of 4 per index
+	EXPECT_EQ(mSphere.getNumVertices() * 32 + mSphere.getNumIndices() * 4, original);
+	EXPECT_EQ(mSphere.getNumVertices() * 12 + mSphere.getNumIndices() * 2, compacted);
+	EXPECT_GT(double(original) / double(compacted), 2.3);
+}
+
+TEST_F(CompactMeshTest, WidensIndicesOfLargeMeshes)
+{
+	// a strip of 70000 vertices needs 32 bit indices
+	TriMesh strip(TriMesh::Format().positions(3));
+	for (uint32_t i = 0; i < 70000; ++i) strip.appendPosition(vec3(float(i), float(i % 2), 0.0f));
+	for (uint32_t i = 0; i + 2 < 70000; i += 2) strip.appendTriangle(i, i + 1, i + 2);
+
+	CompactMeshRef compact = CompactMesh::create(strip);
+	EXPECT_FALSE(compact->hasShortIndices());
+	EXPECT_FALSE(compact->hasNormals());
+	EXPECT_FALSE(compact->hasTexCoords0());
+	EXPECT_EQ(69998u, compact->getIndex(compact->getNumIndices() - 1));
+
+	TriMesh decoded;
+	compact->decode(decoded);
+	EXPECT_EQ(strip.getIndices(), decoded.getIndices());
+
+	// and 65536 vertices still fit in 16 bits
+	TriMesh small(TriMesh::Format().positions(3));
+	for (uint32_t i = 0; i < 0x10000; ++i) small.appendPosition(vec3(float(i), 0.0f, 0.0f));
+	small.appendTriangle(0, 1, 0xffff);
+	compact = CompactMesh::create(small);
+	EXPECT_TRUE(compact->hasShortIndices());
+	EXPECT_EQ(0xffffu, compact->getIndex(2));
+}
+
+TEST_F(CompactMeshTest, DecodesPositionsInBlocks)
+{
+	CompactMeshRef compact = CompactMesh::create(mSphere);
+
+	// ranges that start and end off the blocks of four match the single decodes
+	std::vector<vec3> positions(compact->getNumVertices());
+	for (size_t first = 0; first < 5; ++first) {
+		for (size_t count = 0; count < 11; ++count) {
+			compact->decodePositions(first, count, positions.data());
+			for (size_t i = 0; i < count; ++i) {
+				vec3 expected = compact->getPosition(first + i);
+				EXPECT_NEAR(expected.x, positions[i].x, 1e-6f);
+				EXPECT_NEAR(expected.y, positions[i].y, 1e-6f);
+				EXPECT_NEAR(expected.z, positions[i].z, 1e-6f);
+			}
+		}
+	}
+}
+
+TEST_F(CompactMeshTest, CalculatesTransformedBounds)
+{
+	CompactMeshRef compact = CompactMesh::create(mSphere);
+
+	mat4 transform(1.0f);
+	transform = glm::translate(transform, vec3(10.0f, -5.0f, 0.0f));
+	transform = glm::rotate(transform, 0.7f, glm::normalize(vec3(1.0f, 1.0f, 0.0f)));
+	transform = glm::scale(transform, vec3(2.0f, 1.0f, 0.5f));
+
+	std::vector<vec3> positions(compact->getNumVertices());
+	compact->decodePositions(0, positions.size(), positions.data());
+	vec3 min(FLT_MAX), max(-FLT_MAX);
+	for (size_t i = 0; i < positions.size(); ++i) {
+		vec3 p = vec3(transform * vec4(positions[i], 1.0f));
+		min = glm::min(min, p);
+		max = glm::max(max, p);
+	}
+
+	AxisAlignedBox bounds = compact->calcBounds(transform);
+	for (int axis = 0; axis < 3; ++axis) {
+		EXPECT_NEAR(min[axis], bounds.getMin()[axis], 1e-4f);
+		EXPECT_NEAR(max[axis], bounds.getMax()[axis], 1e-4f);
+	}
+
+	// tighter than the transformed box
+	AxisAlignedBox loose = compact->getBounds().transformed(transform);
+	EXPECT_LT(bounds.getSize().x, loose.getSize().x);
+
+	// the identity keeps the bounds
+	bounds = compact->calcBounds(mat4(1.0f));
+	for (int axis = 0; axis < 3; ++axis) {
+		EXPECT_NEAR(compact->getBounds().getMin()[axis], bounds.getMin()[axis], 1e-5f);
+		EXPECT_NEAR(compact->getBounds().getMax()[axis], bounds.getMax()[axis], 1e-5f);
+	}
+}
+
+TEST_F(CompactMeshTest, IntersectsRays)
+{
+	CompactMeshRef compact = CompactMesh::create(mSphere);
+
+	// rays from all around the sphere hit it where the exact mesh is hit
+	const vec3 center(1.0f, 2.0f, 3.0f);
+	int hits = 0;
+	for (int i = 0; i < 64; ++i) {
+		float angle = 0.1f * i;
+		vec3 origin = center + vec3(cosf(angle) * 10.0f, sinf(angle * 0.5f) * 3.0f, sinf(angle) * 10.0f);
+		vec3 target = center + vec3(0.0f, 0.3f * cosf(angle * 3.0f), 0.0f);
+		Ray ray(origin, glm::normalize(target - origin));
+
+		float expected = intersectReference(mSphere, ray);
+		float distance = 0.0f;
+		ASSERT_EQ(expected != FLT_MAX, compact->intersect(ray, &distance));
+		if (expected != FLT_MAX) {
+			EXPECT_NEAR(expected, distance, 1e-3f);
+			++hits;
+		}
+	}
+	EXPECT_EQ(64, hits);
+
+	// rays that pass by, point away or start beyond the far side miss
+	EXPECT_FALSE(compact->intersect(Ray(center + vec3(0.0f, 0.0f, 10.0f), vec3(0.0f, 1.0f, 0.0f))));
+	EXPECT_FALSE(compact->intersect(Ray(center + vec3(0.0f, 0.0f, 10.0f), vec3(0.0f, 0.0f, 1.0f))));
+	EXPECT_FALSE(compact->intersect(Ray(center + vec3(3.0f, 0.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f))));
+
+	// from the inside the far wall is hit
+	float distance = 0.0f;
+	EXPECT_TRUE(compact->intersect(Ray(center, vec3(0.0f, 0.0f, -1.0f)), &distance));
+	EXPECT_NEAR(2.0f, distance, 0.01f);
+
+	// a flat mesh has an axis of zero extent
+	TriMesh quad(TriMesh::Format().positions(3));
+	quad.appendPosition(vec3(0.0f, 0.0f, 1.0f));
+	quad.appendPosition(vec3(1.0f, 0.0f, 1.0f));
+	quad.appendPosition(vec3(1.0f, 1.0f, 1.0f));
+	quad.appendPosition(vec3(0.0f, 1.0f, 1.0f));
+	quad.appendTriangle(0, 1, 2);
+	quad.appendTriangle(0, 2, 3);
+	compact = CompactMesh::create(quad);
+	EXPECT_TRUE(compact->intersect(Ray(vec3(0.25f, 0.75f, 5.0f), vec3(0.0f, 0.0f, -1.0f)), &distance));
+	EXPECT_FLOAT_EQ(4.0f, distance);
+	EXPECT_FALSE(compact->intersect(Ray(vec3(1.25f, 0.75f, 5.0f), vec3(0.0f, 0.0f, -1.0f))));
+}
+
+TEST_F(CompactMeshTest, ConvertsHalfFloats)
+{
+	EXPECT_EQ(0x0000, CompactMesh::encodeHalf(0.0f));
+	EXPECT_EQ(0x8000, CompactMesh::encodeHalf(-0.0f));
+	EXPECT_EQ(0x3c00, CompactMesh::encodeHalf(1.0f));
+	EXPECT_EQ(0xc000, CompactMesh::encodeHalf(-2.0f));
+	EXPECT_EQ(0x3555, CompactMesh::encodeHalf(1.0f / 3.0f));
+	EXPECT_EQ(0x7bff, CompactMesh::encodeHalf(65504.0f));
+	EXPECT_EQ(0x7c00, CompactMesh::encodeHalf(65520.0f));
+	EXPECT_EQ(0x7c00, CompactMesh::encodeHalf(INFINITY));
+	EXPECT_EQ(0x0001, CompactMesh::encodeHalf(ldexpf(1.0f, -24)));
+	EXPECT_EQ(0x0000, CompactMesh::encodeHalf(ldexpf(1.0f, -26)));
+	// ties round to the even mantissa
+	EXPECT_EQ(0x3c00, CompactMesh::encodeHalf(1.0f + ldexpf(1.0f, -11)));
+	EXPECT_EQ(0x3c02, CompactMesh::encodeHalf(1.0f + 3.0f * ldexpf(1.0f, -11)));
+
+	for (uint32_t half = 0; half < 0x10000; ++half) {
+		if ((half & 0x7c00) == 0x7c00 && (half & 0x3ff)) continue;	// NaN
+		EXPECT_EQ(half, CompactMesh::encodeHalf(CompactMesh::decodeHalf(uint16_t(half))));
+	}
+}
+
+TEST_F(CompactMeshTest, CompactsNodeMeshes)
+{
+	NodeMeshRef node( new NodeMesh(mSphere) );
+	AxisAlignedBox bounds = node->getMeshBounds();
+
+	node->compact();
+	ASSERT_TRUE(node->getCompactMesh() != nullptr);
+	EXPECT_EQ(0u, node->getMesh().getNumVertices());
+	EXPECT_EQ(bounds.getMin(), node->getMeshBounds().getMin());
+	EXPECT_EQ(bounds.getMax(), node->getMeshBounds().getMax());
+
+	float distance = 0.0f;
+	EXPECT_TRUE(node->intersect(Ray(vec3(1.0f, 2.0f, 13.0f), vec3(0.0f, 0.0f, -1.0f)), &distance));
+	EXPECT_NEAR(8.0f, distance, 0.01f);
+
+	// the compact mesh is drawn as is
+	RenderBackendRecorderRef recorder = RenderBackendRecorder::create();
+	node->draw(*recorder);
+	EXPECT_EQ(0u, recorder->getCommandCount(RenderCommand::DRAW_MESH));
+	ASSERT_EQ(1u, recorder->getCommandCount(RenderCommand::DRAW_COMPACT_MESH));
+	EXPECT_EQ(node->getCompactMesh().get(), recorder->getCommands().back().mResource);
+
+	// a new mesh replaces the compact one, a placeholder leaves it alone
+	node->setMesh(mSphere);
+	EXPECT_TRUE(node->getCompactMesh() == nullptr);
+	node->setPlaceholder(bounds);
+	node->compact();
+	EXPECT_TRUE(node->getCompactMesh() == nullptr);
+	EXPECT_FALSE(node->intersect(Ray(vec3(1.0f, 2.0f, 13.0f), vec3(0.0f, 0.0f, -1.0f))));
+}
+
+CINDER_APP_GTEST( CompactMeshTest, RendererGl )
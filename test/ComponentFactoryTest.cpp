@@ -0,0 +1,184 @@
+#include <vector>
+
+#include "CinderGTest.h"
+
+#include "ComponentFactory.h"
+#include "Node3d.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	struct Velocity {
+		Velocity(float speed = 0) : mSpeed(speed), mDistance(0) {}
+		void update(double elapsed) { mDistance += mSpeed * static_cast<float>(elapsed); }
+
+		float mSpeed;
+		float mDistance;
+	};
+
+	struct Counter {
+		Counter() : mCount(0) {}
+		void update(double elapsed) { ++mCount; }
+
+		int mCount;
+	};
+
+	class CountingComponent : public ComponentBase {
+	public:
+		CountingComponent(const std::string& name) : ComponentBase(name), mCount(0) {}
+		virtual void update(double elapsed) { ++mCount; }
+
+		int mCount;
+	};
+}
+
+class ComponentFactoryTest : public testing::Test {
+public:
+	ComponentFactoryTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mFactory = ComponentFactoryRef( new ComponentFactory() );
+	}
+
+	void TearDown()
+	{
+	}
+
+protected:
+
+	ComponentFactoryRef mFactory;
+};
+
+TEST_F( ComponentFactoryTest, EntityIdTest )
+{
+	Node3dRef a = Node3d::create("a");
+	Node3dRef b = Node3d::create("b");
+	EXPECT_NE( a->getId(), b->getId() );
+}
+
+TEST_F( ComponentFactoryTest, AttachDetachTest )
+{
+	Node3dRef node = Node3d::create("node");
+	Node3dRef other = Node3d::create("other");
+
+	Velocity* velocity = mFactory->attach<Velocity>(node->getId(), 2.0f);
+	ASSERT_NE( nullptr, velocity );
+	EXPECT_FLOAT_EQ( 2.0f, velocity->mSpeed );
+	EXPECT_EQ( nullptr, mFactory->get<Velocity>(other->getId()) );
+	EXPECT_EQ( nullptr, mFactory->get<Counter>(node->getId()) );
+
+	// attaching again replaces the component
+	mFactory->attach<Velocity>(node->getId(), 3.0f);
+	EXPECT_EQ( 1u, mFactory->getPool<Velocity>().size() );
+	EXPECT_FLOAT_EQ( 3.0f, mFactory->get<Velocity>(node->getId())->mSpeed );
+
+	mFactory->attach<Counter>(node->getId());
+	mFactory->detachAll(node->getId());
+	EXPECT_EQ( nullptr, mFactory->get<Velocity>(node->getId()) );
+	EXPECT_EQ( nullptr, mFactory->get<Counter>(node->getId()) );
+	EXPECT_FALSE( mFactory->detach<Velocity>(node->getId()) );
+}
+
+TEST_F( ComponentFactoryTest, SwapRemoveTest )
+{
+	for (uint64_t entity = 0; entity < 5; ++entity) {
+		mFactory->attach<Velocity>(entity, static_cast<float>(entity));
+	}
+
+	// the last component fills the gap, the other entities still find theirs
+	EXPECT_TRUE( mFactory->detach<Velocity>(1) );
+	const ComponentPool<Velocity>& pool = mFactory->getPool<Velocity>();
+	ASSERT_EQ( 4u, pool.size() );
+	EXPECT_EQ( 4u, pool.getEntities()[1] );
+	for (uint64_t entity = 0; entity < 5; ++entity) {
+		if (entity == 1) continue;
+		ASSERT_NE( nullptr, mFactory->get<Velocity>(entity) );
+		EXPECT_FLOAT_EQ( static_cast<float>(entity), mFactory->get<Velocity>(entity)->mSpeed );
+	}
+}
+
+TEST_F( ComponentFactoryTest, UpdateManyTest )
+{
+	const uint64_t count = 100000;
+	for (uint64_t entity = 0; entity < count; ++entity) {
+		mFactory->attach<Velocity>(entity * 3, 1.0f);
+		if (entity % 2) mFactory->attach<Counter>(entity * 3);
+	}
+
+	mFactory->update(0.5);
+	mFactory->update(0.5);
+
+	EXPECT_EQ( count, mFactory->getPool<Velocity>().size() );
+	for (auto itr = mFactory->getPool<Velocity>().begin(); itr != mFactory->getPool<Velocity>().end(); ++itr) {
+		ASSERT_FLOAT_EQ( 1.0f, itr->mDistance );
+	}
+	EXPECT_EQ( count / 2, mFactory->getPool<Counter>().size() );
+	EXPECT_EQ( 2, mFactory->get<Counter>(3)->mCount );
+}
+
+TEST_F( ComponentFactoryTest, HandleTest )
+{
+	ComponentHandle a = mFactory->instantiate<CountingComponent>("a");
+	ComponentHandle b = mFactory->instantiate("b");
+	ASSERT_TRUE( mFactory->isValid(a) );
+	ASSERT_TRUE( mFactory->isValid(b) );
+	EXPECT_NE( nullptr, mFactory->getComponent<CountingComponent>(a) );
+	EXPECT_EQ( nullptr, mFactory->getComponent<CountingComponent>(b) );
+
+	mFactory->update(0.1);
+	EXPECT_EQ( 1, mFactory->getComponent<CountingComponent>(a)->mCount );
+
+	// destroyed handles are stale, even after their slot is reused
+	std::string name = mFactory->getComponent(a)->getName();
+	EXPECT_TRUE( mFactory->destroyComponent(a) );
+	EXPECT_FALSE( mFactory->destroyComponent(a) );
+	ComponentHandle c = mFactory->instantiate("c");
+	EXPECT_EQ( a.mIndex, c.mIndex );
+	EXPECT_FALSE( mFactory->isValid(a) );
+	EXPECT_EQ( nullptr, mFactory->getComponent(a) );
+	EXPECT_TRUE( mFactory->getComponentByName(name).isNull() );
+
+	// the moved component is still found through its handle
+	EXPECT_EQ( 2u, mFactory->getComponentCount() );
+	EXPECT_EQ( b, mFactory->getComponentByName(mFactory->getComponent(b)->getName()) );
+	EXPECT_EQ( c, mFactory->getComponentByName(mFactory->getComponent(c)->getName()) );
+
+	mFactory->clearComponents();
+	EXPECT_EQ( 0u, mFactory->getComponentCount() );
+	EXPECT_FALSE( mFactory->isValid(b) );
+}
+
+TEST_F( ComponentFactoryTest, ChurnTest )
+{
+	std::vector<ComponentHandle> handles;
+	for (int round = 0; round < 10; ++round) {
+		for (int i = 0; i < 1000; ++i) {
+			handles.push_back(mFactory->instantiate("churn"));
+		}
+		// destroy every other component
+		std::vector<ComponentHandle> alive;
+		for (size_t i = 0; i < handles.size(); ++i) {
+			if (i % 2) alive.push_back(handles[i]);
+			else EXPECT_TRUE( mFactory->destroyComponent(handles[i]) );
+		}
+		handles.swap(alive);
+	}
+
+	EXPECT_EQ( handles.size(), mFactory->getComponentCount() );
+	for (auto itr = handles.begin(); itr != handles.end(); ++itr) {
+		ASSERT_TRUE( mFactory->isValid(*itr) );
+		ComponentBase* comp = mFactory->getComponent(*itr);
+		EXPECT_EQ( *itr, mFactory->getComponentByName(comp->getName()) );
+	}
+}
+
+CINDER_APP_GTEST( ComponentFactoryTest, RendererGl )
@@ -0,0 +1,188 @@
+#include <vector>
+
+#include "cinder/Rect.h"
+#include "cinder/Shape2d.h"
+
+#include "CinderGTest.h"
+
+#include "DamageTracker.h"
+#include "Node2d.h"
+#include "NodeShape2d.h"
+#include "RenderBackend.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+class DamageTrackerTest : public testing::Test {
+public:
+	DamageTrackerTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mDamage = DamageTracker::create(4);
+		mRecorder = RenderBackendRecorder::create();
+
+		// a 10x10 square
+		mSquare.moveTo(vec2(0, 0));
+		mSquare.lineTo(vec2(10, 0));
+		mSquare.lineTo(vec2(10, 10));
+		mSquare.lineTo(vec2(0, 10));
+		mSquare.close();
+
+		mRoot = Node2d::create("root");
+		mLeft = NodeShape2dRef( new NodeShape2d(mSquare, "left") );
+		mRight = NodeShape2dRef( new NodeShape2d(mSquare, "right") );
+		mLeft->setPosition(0, 0);
+		mRight->setPosition(100, 0);
+		mRoot->addChild(mLeft);
+		mRoot->addChild(mRight);
+
+		// the first frame damages everything, start from a clean state
+		mRoot->deepTransform();
+		mRoot->deepCollectDamage(*mDamage);
+		mDamage->clear();
+	}
+
+	void TearDown()
+	{
+	}
+
+protected:
+	//! transforms the scene and collects the damage of a frame
+	void nextFrame()
+	{
+		mDamage->clear();
+		mRoot->deepTransform();
+		mRoot->deepCollectDamage(*mDamage);
+	}
+
+	DamageTrackerRef mDamage;
+	RenderBackendRecorderRef mRecorder;
+	Shape2d mSquare;
+	Node2dRef mRoot;
+	NodeShape2dRef mLeft;
+	NodeShape2dRef mRight;
+};
+
+TEST_F( DamageTrackerTest, MergeOverlappingTest )
+{
+	DamageTracker damage(4);
+	damage.add(Rectf(0, 0, 10, 10));
+	damage.add(Rectf(5, 5, 15, 15));
+	damage.add(Rectf(100, 100, 110, 110));
+	damage.add(Rectf(0, 0, 0, 10));
+
+	ASSERT_EQ( 2u, damage.getRects().size() );
+	EXPECT_EQ( Rectf(0, 0, 15, 15), damage.getRects()[0] );
+	EXPECT_EQ( Rectf(100, 100, 110, 110), damage.getRects()[1] );
+
+	// touching edges are not an overlap
+	EXPECT_FALSE( damage.intersects(Rectf(15, 0, 20, 5)) );
+	EXPECT_TRUE( damage.intersects(Rectf(14, 0, 20, 5)) );
+}
+
+TEST_F( DamageTrackerTest, MaxRectsTest )
+{
+	DamageTracker damage(3);
+	for (int i = 0; i < 10; ++i) {
+		float x = static_cast<float>(i * 20);
+		damage.add(Rectf(x, 0, x + 10, 10));
+	}
+
+	EXPECT_LE( damage.getRects().size(), 3u );
+	EXPECT_EQ( Rectf(0, 0, 190, 10), damage.getBounds() );
+
+	// the original regions are still covered
+	for (int i = 0; i < 10; ++i) {
+		float x = static_cast<float>(i * 20);
+		EXPECT_TRUE( damage.intersects(Rectf(x + 1, 1, x + 9, 9)) );
+	}
+}
+
+TEST_F( DamageTrackerTest, StaticSceneTest )
+{
+	nextFrame();
+	EXPECT_TRUE( mDamage->isEmpty() );
+
+	mRoot->deepDraw(*mRecorder, *mDamage);
+	EXPECT_EQ( 0, mRecorder->getCommandCount(RenderCommand::DRAW_SHAPE) );
+}
+
+TEST_F( DamageTrackerTest, TransformDamageTest )
+{
+	mLeft->setPosition(20, 0);
+	nextFrame();
+
+	// both the old and the new region are damaged
+	ASSERT_FALSE( mDamage->isEmpty() );
+	EXPECT_TRUE( mDamage->intersects(Rectf(1, 1, 9, 9)) );
+	EXPECT_TRUE( mDamage->intersects(Rectf(21, 1, 29, 9)) );
+	EXPECT_FALSE( mDamage->intersects(mRight->getDamageRect()) );
+
+	// only the moved node is redrawn
+	mRoot->deepDraw(*mRecorder, *mDamage);
+	EXPECT_EQ( 1, mRecorder->getCommandCount(RenderCommand::DRAW_SHAPE) );
+
+	nextFrame();
+	EXPECT_TRUE( mDamage->isEmpty() );
+}
+
+TEST_F( DamageTrackerTest, ParentTransformDamageTest )
+{
+	mRoot->setPosition(0, 50);
+	nextFrame();
+
+	EXPECT_TRUE( mDamage->intersects(Rectf(1, 51, 9, 59)) );
+	EXPECT_TRUE( mDamage->intersects(Rectf(101, 51, 109, 59)) );
+}
+
+TEST_F( DamageTrackerTest, ContentDamageTest )
+{
+	mRight->setFillColor(ColorA(1, 0, 0, 1));
+	nextFrame();
+
+	ASSERT_EQ( 1u, mDamage->getRects().size() );
+	EXPECT_EQ( Rectf(100, 0, 110, 10), mDamage->getRects()[0] );
+
+	// assigning the same color again is not a change
+	mRight->setFillColor(ColorA(1, 0, 0, 1));
+	nextFrame();
+	EXPECT_TRUE( mDamage->isEmpty() );
+}
+
+TEST_F( DamageTrackerTest, ActivationDamageTest )
+{
+	mRoot->setActive(false);
+	nextFrame();
+	EXPECT_TRUE( mDamage->intersects(Rectf(1, 1, 9, 9)) );
+	EXPECT_TRUE( mDamage->intersects(Rectf(101, 1, 109, 9)) );
+
+	mRoot->setActive(true);
+	nextFrame();
+	EXPECT_TRUE( mDamage->intersects(Rectf(1, 1, 9, 9)) );
+	EXPECT_TRUE( mDamage->intersects(Rectf(101, 1, 109, 9)) );
+}
+
+TEST_F( DamageTrackerTest, AddRemoveDamageTest )
+{
+	mRoot->removeChild(mRight);
+	nextFrame();
+
+	ASSERT_EQ( 1u, mDamage->getRects().size() );
+	EXPECT_EQ( Rectf(100, 0, 110, 10), mDamage->getRects()[0] );
+
+	mRoot->addChild(mRight);
+	nextFrame();
+
+	ASSERT_EQ( 1u, mDamage->getRects().size() );
+	EXPECT_EQ( Rectf(100, 0, 110, 10), mDamage->getRects()[0] );
+}
+
+CINDER_APP_GTEST( DamageTrackerTest, RendererGl )
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "cinder/Matrix.h"
+
+#include "CinderGTest.h"
+
+#include "DepthSort.h"
+#include "Node3d.h"
+#include "SceneSnapshot.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+class DepthSortTest : public testing::Test {
+public:
+	DepthSortTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mSorter = DepthSorter::create();
+	}
+
+	void TearDown()
+	{
+	}
+
+protected:
+
+	DepthSorterRef mSorter;
+};
+
+TEST_F( DepthSortTest, SortableKeyTest )
+{
+	float values[] = { -1000.0f, -2.5f, -1.0f, -0.0f, 0.0f, 0.001f, 1.0f, 2.5f, 1000.0f };
+	for (size_t i = 1; i < sizeof(values) / sizeof(float); ++i) {
+		EXPECT_LE( DepthSorter::toSortableKey(values[i - 1]), DepthSorter::toSortableKey(values[i]) );
+	}
+}
+
+TEST_F( DepthSortTest, RadixSortTest )
+{
+	std::srand(1234);
+	std::vector<uint32_t> keys(100000);
+	for (size_t i = 0; i < keys.size(); ++i) {
+		keys[i] = (static_cast<uint32_t>(std::rand()) << 16) ^ static_cast<uint32_t>(std::rand());
+	}
+	std::vector<uint32_t> input = keys;
+
+	std::vector<uint32_t> order, key_scratch, order_scratch;
+	DepthSorter::radixSort(keys, order, key_scratch, order_scratch);
+
+	ASSERT_EQ( input.size(), order.size() );
+	for (size_t i = 1; i < order.size(); ++i) {
+		EXPECT_LE( input[order[i - 1]], input[order[i]] );
+	}
+}
+
+TEST_F( DepthSortTest, StableOrderTest )
+{
+	// equal depths keep their input order in both directions
+	std::vector<vec3> positions;
+	for (int i = 0; i < 8; ++i) {
+		positions.push_back(vec3(static_cast<float>(i), 0, (i % 2)? -5.0f: -10.0f));
+	}
+
+	const std::vector<uint32_t>& front = mSorter->sort(mat4(), positions.data(), positions.size(), DepthSorter::FRONT_TO_BACK);
+	uint32_t expected_front[] = { 1, 3, 5, 7, 0, 2, 4, 6 };
+	for (size_t i = 0; i < front.size(); ++i) {
+		EXPECT_EQ( expected_front[i], front[i] );
+	}
+
+	const std::vector<uint32_t>& back = mSorter->sort(mat4(), positions.data(), positions.size(), DepthSorter::BACK_TO_FRONT);
+	uint32_t expected_back[] = { 0, 2, 4, 6, 1, 3, 5, 7 };
+	for (size_t i = 0; i < back.size(); ++i) {
+		EXPECT_EQ( expected_back[i], back[i] );
+	}
+}
+
+TEST_F( DepthSortTest, ViewTransformTest )
+{
+	// moving the camera behind the items reverses the order
+	std::vector<vec3> positions;
+	positions.push_back(vec3(0, 0, -1.0f));
+	positions.push_back(vec3(0, 0, -3.0f));
+	positions.push_back(vec3(0, 0, -2.0f));
+
+	std::vector<uint32_t> order = mSorter->sort(mat4(), positions.data(), positions.size(), DepthSorter::FRONT_TO_BACK);
+	EXPECT_EQ( 0u, order[0] );
+	EXPECT_EQ( 2u, order[1] );
+	EXPECT_EQ( 1u, order[2] );
+
+	mat4 view = glm::rotate(mat4(), static_cast<float>(M_PI), vec3(0, 1, 0));
+	order = mSorter->sort(view, positions.data(), positions.size(), DepthSorter::FRONT_TO_BACK);
+	EXPECT_EQ( 1u, order[0] );
+	EXPECT_EQ( 2u, order[1] );
+	EXPECT_EQ( 0u, order[2] );
+}
+
+TEST_F( DepthSortTest, SnapshotTest )
+{
+	Node3dRef root = Node3d::create("root");
+	Node3dRef near_node = Node3d::create("near");
+	Node3dRef far_node = Node3d::create("far");
+	Node3dRef hidden = Node3d::create("hidden");
+	root->setPosition(0, 0, 0);
+	near_node->setPosition(0, 0, -3.0f);
+	far_node->setPosition(0, 0, -10.0f);
+	hidden->setPosition(0, 0, -5.0f);
+	hidden->setActive(false);
+	root->addChild(near_node);
+	root->addChild(far_node);
+	root->addChild(hidden);
+	root->deepTransform(mat4());
+
+	SceneSnapshot snapshot;
+	snapshot.capture(*root, 0);
+
+	const std::vector<uint32_t>& order = mSorter->sort(mat4(), snapshot, DepthSorter::BACK_TO_FRONT);
+	ASSERT_EQ( 3u, order.size() );
+	EXPECT_EQ( far_node.get(), snapshot.getItems()[order[0]].mNode );
+	EXPECT_EQ( near_node.get(), snapshot.getItems()[order[1]].mNode );
+	EXPECT_EQ( root.get(), snapshot.getItems()[order[2]].mNode );
+}
+
+CINDER_APP_GTEST( DepthSortTest, RendererGl )
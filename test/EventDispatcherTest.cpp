@@ -0,0 +1,352 @@
+#include <algorithm>
+#include <vector>
+
+#include "CinderGTest.h"
+
+#include "EventDispatcher.h"
+#include "SceneContext.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	struct Delivery {
+		NodeBase*				mNode;
+		PointerEvent::Type		mType;
+		PointerEvent::Phase		mPhase;
+	};
+
+	class Button : public Node2d {
+	public:
+		Button(const std::string& name, std::vector<Delivery>& log) : Node2d(name), mLog(log), mConsume(false), mConsumePhase(PointerEvent::PHASE_TARGET)
+		{
+			setInteractive();
+		}
+
+		virtual bool onPointerEvent(const PointerEvent& event)
+		{
+			Delivery delivery = { this, event.mType, event.mPhase };
+			mLog.push_back(delivery);
+			return mConsume && event.mPhase == mConsumePhase;
+		}
+
+		std::vector<Delivery>&	mLog;
+		bool					mConsume;
+		PointerEvent::Phase		mConsumePhase;
+	};
+	typedef std::shared_ptr<Button> ButtonRef;
+}
+
+class EventDispatcherTest : public testing::Test {
+public:
+	EventDispatcherTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		// root covers the window, panel is offset, the button sits inside the panel
+		mRoot.reset(new Button("root", mLog));
+		mRoot->setSize(vec2(800, 600));
+		mPanel.reset(new Button("panel", mLog));
+		mPanel->setPosition(100, 100);
+		mPanel->setSize(vec2(300, 300));
+		mButton.reset(new Button("button", mLog));
+		mButton->setPosition(50, 50);
+		mButton->setSize(vec2(100, 40));
+
+		mRoot->addChild(mPanel);
+		mPanel->addChild(mButton);
+		mRoot->deepTransform();
+
+		mDispatcher = EventDispatcher::create(mRoot);
+	}
+
+	void TearDown()
+	{
+	}
+
+	std::vector<Delivery>	mLog;
+	ButtonRef				mRoot;
+	ButtonRef				mPanel;
+	ButtonRef				mButton;
+	EventDispatcherRef		mDispatcher;
+};
+
+TEST_F(EventDispatcherTest, HitTest)
+{
+	EXPECT_EQ(mDispatcher->hitTest(vec2(160, 160)), mButton);
+	EXPECT_EQ(mDispatcher->hitTest(vec2(120, 120)), mPanel);
+	EXPECT_EQ(mDispatcher->hitTest(vec2(10, 10)), mRoot);
+	EXPECT_EQ(mDispatcher->hitTest(vec2(900, 10)), Node2dRef());
+
+	// inactive subtrees are invisible to the pointer
+	mPanel->setActive(false);
+	mDispatcher->invalidate();
+	EXPECT_EQ(mDispatcher->hitTest(vec2(160, 160)), mRoot);
+}
+
+TEST_F(EventDispatcherTest, CaptureAndBubble)
+{
+	mRoot->mConsume = true;
+	mRoot->mConsumePhase = PointerEvent::PHASE_BUBBLE;
+
+	EXPECT_EQ(mDispatcher->dispatch(PointerEvent::POINTER_MOVE, vec2(160, 160)), mRoot);
+
+	// the button also got entered, only look at the move
+	mLog.erase(std::remove_if(mLog.begin(), mLog.end(), [](const Delivery& d) { return d.mType != PointerEvent::POINTER_MOVE; }), mLog.end());
+	ASSERT_EQ(mLog.size(), 5u);
+	EXPECT_EQ(mLog[0].mNode, mRoot.get());
+	EXPECT_EQ(mLog[0].mPhase, PointerEvent::PHASE_CAPTURE);
+	EXPECT_EQ(mLog[1].mNode, mPanel.get());
+	EXPECT_EQ(mLog[1].mPhase, PointerEvent::PHASE_CAPTURE);
+	EXPECT_EQ(mLog[2].mNode, mButton.get());
+	EXPECT_EQ(mLog[2].mPhase, PointerEvent::PHASE_TARGET);
+	EXPECT_EQ(mLog[3].mNode, mPanel.get());
+	EXPECT_EQ(mLog[3].mPhase, PointerEvent::PHASE_BUBBLE);
+	EXPECT_EQ(mLog[4].mNode, mRoot.get());
+	EXPECT_EQ(mLog[4].mPhase, PointerEvent::PHASE_BUBBLE);
+
+	// the first consumer stops delivery
+	mLog.clear();
+	mPanel->mConsume = true;
+	mPanel->mConsumePhase = PointerEvent::PHASE_CAPTURE;
+	EXPECT_EQ(mDispatcher->dispatch(PointerEvent::POINTER_MOVE, vec2(160, 160)), mPanel);
+	EXPECT_EQ(mLog.size(), 2u);
+}
+
+TEST_F(EventDispatcherTest, DragCapture)
+{
+	mButton->mConsume = true;
+
+	EXPECT_EQ(mDispatcher->dispatch(PointerEvent::POINTER_DOWN, vec2(160, 160)), mButton);
+	EXPECT_EQ(mDispatcher->getCapture(), mButton);
+
+	// the drag leaves the button but still goes to it only
+	mLog.clear();
+	EXPECT_EQ(mDispatcher->dispatch(PointerEvent::POINTER_DRAG, vec2(700, 500)), mButton);
+	ASSERT_EQ(mLog.size(), 1u);
+	EXPECT_EQ(mLog[0].mNode, mButton.get());
+
+	mDispatcher->dispatch(PointerEvent::POINTER_UP, vec2(700, 500));
+	EXPECT_EQ(mDispatcher->getCapture(), NodeRef());
+}
+
+TEST_F(EventDispatcherTest, ManyNodes)
+{
+	// a grid of 10000 buttons, each hit test only visits a logarithmic number of bounds
+	Node2dRef grid = Node2d::create("grid");
+	mRoot->addChild(grid);
+	for (int y = 0; y < 100; ++y) {
+		for (int x = 0; x < 100; ++x) {
+			ButtonRef cell(new Button("cell", mLog));
+			cell->setPosition(x * 10.0f, y * 10.0f);
+			cell->setSize(vec2(9, 9));
+			grid->addChild(cell);
+		}
+	}
+	mRoot->deepTransform();
+	mDispatcher->invalidate();
+
+	Node2dRef hit = mDispatcher->hitTest(vec2(555, 333));
+	ASSERT_TRUE(hit);
+	EXPECT_EQ(hit->getPosition(), vec2(550, 330));
+	EXPECT_EQ(mDispatcher->getItemCount(), 10003u);
+	EXPECT_LT(mDispatcher->getLastTestCount(), 200u);
+}
+
+TEST_F(EventDispatcherTest, CoalescedMoves)
+{
+	// several moves within a frame are delivered once, at the latest position
+	mDispatcher->post(PointerEvent::POINTER_MOVE, vec2(10, 10));
+	mDispatcher->post(PointerEvent::POINTER_MOVE, vec2(120, 120));
+	mDispatcher->post(PointerEvent::POINTER_MOVE, vec2(160, 160));
+	EXPECT_TRUE(mLog.empty());
+
+	mDispatcher->update();
+	EXPECT_EQ(mDispatcher->getHover(), mButton);
+	EXPECT_EQ(mDispatcher->getHitTestCount(), 1u);
+
+	size_t moves = 0;
+	for (auto itr = mLog.begin(); itr != mLog.end(); ++itr) {
+		if (itr->mType == PointerEvent::POINTER_MOVE && itr->mPhase == PointerEvent::PHASE_TARGET) {
+			EXPECT_EQ(itr->mNode, mButton.get());
+			++moves;
+		}
+	}
+	EXPECT_EQ(moves, 1u);
+
+	// a press delivers the pending motion first
+	mLog.clear();
+	mDispatcher->post(PointerEvent::POINTER_MOVE, vec2(120, 120));
+	mDispatcher->post(PointerEvent::POINTER_DOWN, vec2(120, 120));
+	ASSERT_FALSE(mLog.empty());
+	EXPECT_EQ(mLog.front().mType, PointerEvent::POINTER_LEAVE);
+	EXPECT_EQ(mLog.back().mType, PointerEvent::POINTER_DOWN);
+}
+
+TEST_F(EventDispatcherTest, EnterLeave)
+{
+	mDispatcher->dispatch(PointerEvent::POINTER_MOVE, vec2(160, 160));
+	ASSERT_FALSE(mLog.empty());
+	EXPECT_EQ(mLog.front().mNode, mButton.get());
+	EXPECT_EQ(mLog.front().mType, PointerEvent::POINTER_ENTER);
+
+	mLog.clear();
+	mDispatcher->dispatch(PointerEvent::POINTER_MOVE, vec2(120, 120));
+	ASSERT_GE(mLog.size(), 2u);
+	EXPECT_EQ(mLog[0].mNode, mButton.get());
+	EXPECT_EQ(mLog[0].mType, PointerEvent::POINTER_LEAVE);
+	EXPECT_EQ(mLog[1].mNode, mPanel.get());
+	EXPECT_EQ(mLog[1].mType, PointerEvent::POINTER_ENTER);
+}
+
+TEST_F(EventDispatcherTest, CachedHover)
+{
+	mDispatcher->dispatch(PointerEvent::POINTER_MOVE, vec2(160, 160));
+	EXPECT_EQ(mDispatcher->getHitTestCount(), 1u);
+
+	// same position, same scene: no new hit test
+	mDispatcher->dispatch(PointerEvent::POINTER_DOWN, vec2(160, 160));
+	mDispatcher->update();
+	EXPECT_EQ(mDispatcher->getHitTestCount(), 1u);
+
+	// the button moves away under the still pointer
+	mLog.clear();
+	mButton->setPosition(200, 200);
+	mRoot->deepTransform();
+	mDispatcher->invalidate();
+	mDispatcher->update();
+	EXPECT_EQ(mDispatcher->getHitTestCount(), 2u);
+	EXPECT_EQ(mDispatcher->getHover(), mPanel);
+	ASSERT_EQ(mLog.size(), 2u);
+	EXPECT_EQ(mLog[0].mType, PointerEvent::POINTER_LEAVE);
+	EXPECT_EQ(mLog[1].mType, PointerEvent::POINTER_ENTER);
+}
+
+TEST_F(EventDispatcherTest, FollowsJournal)
+{
+	SceneContextRef context = SceneContext::create();
+	context->setRoot(mRoot);
+
+	// the first update enables the journal, the scene is not known before
+	mDispatcher->update();
+	EXPECT_TRUE(context->getJournal().isEnabled());
+	EXPECT_EQ(mDispatcher->hitTest(vec2(160, 160)), mButton);
+	EXPECT_EQ(mDispatcher->getRebuildCount(), 1u);
+	context->getJournal().clear();
+
+	// moved nodes only refit the hierarchy
+	mPanel->setPosition(400, 100);
+	mRoot->deepTransform();
+	mDispatcher->update();
+	context->getJournal().clear();
+	EXPECT_EQ(mDispatcher->hitTest(vec2(160, 160)), mRoot);
+	EXPECT_EQ(mDispatcher->hitTest(vec2(460, 160)), mButton);
+	EXPECT_EQ(mDispatcher->getRebuildCount(), 1u);
+
+	// resized nodes too
+	mButton->setSize(vec2(200, 40));
+	mRoot->deepTransform();
+	mDispatcher->update();
+	context->getJournal().clear();
+	EXPECT_EQ(mDispatcher->hitTest(vec2(600, 160)), mButton);
+	EXPECT_EQ(mDispatcher->getRebuildCount(), 1u);
+
+	// structural changes rebuild it
+	ButtonRef added(new Button("added", mLog));
+	added->setPosition(10, 500);
+	added->setSize(vec2(50, 50));
+	mRoot->addChild(added);
+	mRoot->deepTransform();
+	mDispatcher->update();
+	context->getJournal().clear();
+	EXPECT_EQ(mDispatcher->hitTest(vec2(20, 520)), added);
+	EXPECT_EQ(mDispatcher->getRebuildCount(), 2u);
+
+	mButton->setInteractive(false);
+	mDispatcher->update();
+	context->getJournal().clear();
+	EXPECT_EQ(mDispatcher->hitTest(vec2(460, 160)), mPanel);
+	EXPECT_EQ(mDispatcher->getRebuildCount(), 3u);
+
+	mPanel->setActive(false);
+	mDispatcher->update();
+	context->getJournal().clear();
+	EXPECT_EQ(mDispatcher->hitTest(vec2(460, 160)), mRoot);
+	EXPECT_EQ(mDispatcher->getRebuildCount(), 4u);
+
+	// without changes the hierarchy is kept
+	mDispatcher->update();
+	EXPECT_EQ(mDispatcher->hitTest(vec2(20, 520)), added);
+	EXPECT_EQ(mDispatcher->getRebuildCount(), 4u);
+}
+
+TEST_F(EventDispatcherTest, FollowsInterpolation)
+{
+	SceneContextRef context = SceneContext::create();
+	context->setRoot(mRoot);
+	mDispatcher->update();
+	context->getJournal().clear();
+
+	// a simulation step moves the panel, the frame shows the previous state
+	mRoot->deepSaveTransform();
+	mPanel->setPosition(400, 100);
+	mRoot->deepTransformInterpolated(mat3(1), 0.0f);
+	mDispatcher->update();
+	context->getJournal().clear();
+	EXPECT_EQ(mDispatcher->hitTest(vec2(160, 160)), mButton);
+
+	// the next frames blend towards the current state without calling any setter
+	mRoot->deepTransformInterpolated(mat3(1), 0.5f);
+	EXPECT_FALSE(context->getJournal().empty());
+	mDispatcher->update();
+	context->getJournal().clear();
+	EXPECT_EQ(mDispatcher->hitTest(vec2(310, 160)), mButton);
+	EXPECT_EQ(mDispatcher->hitTest(vec2(160, 160)), mRoot);
+
+	mRoot->deepTransformInterpolated(mat3(1), 1.0f);
+	mDispatcher->update();
+	context->getJournal().clear();
+	EXPECT_EQ(mDispatcher->hitTest(vec2(460, 160)), mButton);
+	EXPECT_EQ(mDispatcher->getRebuildCount(), 1u);
+
+	// nothing moves, nothing is journaled
+	mRoot->deepTransformInterpolated(mat3(1), 1.0f);
+	EXPECT_TRUE(context->getJournal().empty());
+}
+
+TEST_F(EventDispatcherTest, JournaledHover)
+{
+	SceneContextRef context = SceneContext::create();
+	context->setRoot(mRoot);
+	mDispatcher->update();
+	context->getJournal().clear();
+
+	mDispatcher->dispatch(PointerEvent::POINTER_MOVE, vec2(160, 160));
+	EXPECT_EQ(mDispatcher->getHover(), mButton);
+	EXPECT_EQ(mDispatcher->getHitTestCount(), 1u);
+
+	// the button moves away under the still pointer, the journal tells the dispatcher
+	mLog.clear();
+	mButton->setPosition(200, 200);
+	mRoot->deepTransform();
+	mDispatcher->update();
+	context->getJournal().clear();
+	EXPECT_EQ(mDispatcher->getHitTestCount(), 2u);
+	EXPECT_EQ(mDispatcher->getHover(), mPanel);
+	ASSERT_EQ(mLog.size(), 2u);
+	EXPECT_EQ(mLog[0].mType, PointerEvent::POINTER_LEAVE);
+	EXPECT_EQ(mLog[1].mType, PointerEvent::POINTER_ENTER);
+
+	// nothing changed, nothing is tested again
+	mDispatcher->update();
+	EXPECT_EQ(mDispatcher->getHitTestCount(), 2u);
+}
+
+CINDER_APP_GTEST( EventDispatcherTest, RendererGl )
@@ -0,0 +1,114 @@
+#include "CinderGTest.h"
+
+#include "FixedTimestep.h"
+#include "Node2d.h"
+#include "Node3d.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	class MovingNode : public Node3d {
+	public:
+		MovingNode() : Node3d("moving"), mUpdates(0), mLastElapsed(0) {}
+
+		virtual void update(double elapsed)
+		{
+			++mUpdates;
+			mLastElapsed = elapsed;
+			setPosition(getPosition() + vec3(1, 0, 0));
+		}
+
+		int		mUpdates;
+		double	mLastElapsed;
+	};
+}
+
+class FixedTimestepTest : public testing::Test {
+public:
+	FixedTimestepTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mClock = FixedTimestep::create(0.01, 4);
+		mNode.reset(new MovingNode());
+	}
+
+	void TearDown()
+	{
+	}
+
+	FixedTimestepRef			mClock;
+	std::shared_ptr<MovingNode>	mNode;
+};
+
+TEST_F(FixedTimestepTest, Accumulates)
+{
+	EXPECT_EQ(mClock->advance(0.004), 0u);
+	EXPECT_NEAR(mClock->getAlpha(), 0.4f, 1e-5f);
+
+	EXPECT_EQ(mClock->advance(0.017), 2u);
+	EXPECT_NEAR(mClock->getAlpha(), 0.1f, 1e-5f);
+	EXPECT_EQ(mClock->getStepCount(), 2u);
+}
+
+TEST_F(FixedTimestepTest, CatchUpLimit)
+{
+	// a 1 second spike runs at most 4 steps and drops the rest
+	EXPECT_EQ(mClock->update(*mNode, 1.005), 4u);
+	EXPECT_EQ(mNode->mUpdates, 4);
+	EXPECT_DOUBLE_EQ(mNode->mLastElapsed, 0.01);
+	EXPECT_NEAR(mClock->getDroppedTime(), 0.96, 1e-9);
+	EXPECT_NEAR(mClock->getAlpha(), 0.5f, 1e-4f);
+
+	// back to normal frames afterwards
+	EXPECT_EQ(mClock->update(*mNode, 0.01), 1u);
+}
+
+TEST_F(FixedTimestepTest, Interpolation)
+{
+	Node3dRef child = Node3d::create("child");
+	child->setPosition(vec3(0, 1, 0));
+	mNode->addChild(child);
+
+	// one step moves the node from x = 0 to x = 1
+	mClock->update(*mNode, 0.015);
+	EXPECT_FLOAT_EQ(mNode->getPosition().x, 1.0f);
+
+	mNode->deepTransformInterpolated(mat4(1), mClock->getAlpha());
+	vec4 world = child->getWorldTransform() * vec4(0, 0, 0, 1);
+	EXPECT_NEAR(world.x, 0.5f, 1e-4f);
+	EXPECT_NEAR(world.y, 1.0f, 1e-4f);
+
+	// the local transformation keeps the simulated state
+	EXPECT_FLOAT_EQ(mNode->getTransform()[3].x, 1.0f);
+
+	mNode->deepTransformInterpolated(mat4(1), 1.0f);
+	EXPECT_FLOAT_EQ(mNode->getWorldTransform()[3].x, 1.0f);
+}
+
+TEST_F(FixedTimestepTest, Interpolation2d)
+{
+	Node2dRef node = Node2d::create("flat");
+	node->setPosition(vec2(10, 0));
+	node->deepSaveTransform();
+	node->setPosition(vec2(20, 0));
+
+	node->deepTransformInterpolated(mat3(1), 0.25f);
+	EXPECT_NEAR(node->getWorldTransform()[2].x, 12.5f, 1e-4f);
+
+	// nodes that never saved a state are presented as they are
+	Node2dRef fresh = Node2d::create("fresh");
+	fresh->setPosition(vec2(5, 5));
+	fresh->deepTransformInterpolated(mat3(1), 0.25f);
+	EXPECT_NEAR(fresh->getWorldTransform()[2].x, 5.0f, 1e-4f);
+}
+
+CINDER_APP_GTEST( FixedTimestepTest, RendererGl )
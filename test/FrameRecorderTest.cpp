@@ -0,0 +1,218 @@
+#include <sstream>
+#include <string>
+
+#include "CinderGTest.h"
+
+#include "FrameRecorder.h"
+#include "Node2d.h"
+#include "Node3d.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+class FrameRecorderTest : public testing::Test {
+public:
+	FrameRecorderTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		// a window sized root with a row of interactive panels
+		mRoot = Node2d::create("root");
+		mRoot->setSize(vec2(640.0f, 480.0f));
+		mRoot->setInteractive();
+		for (int i = 0; i < 4; ++i) {
+			Node2dRef panel = Node2d::create("panel");
+			panel->setPosition(float(i) * 160.0f, 0.0f);
+			panel->setSize(vec2(150.0f, 100.0f));
+			panel->setInteractive();
+			mRoot->addChild(panel);
+		}
+
+		mContext = SceneContext::create();
+		mContext->setRoot(mRoot);
+	}
+
+	void TearDown()
+	{
+		mContext->setRoot(NodeRef());
+	}
+
+	//! records a number of frames that move, add and remove panels and receive pointer input
+	void record(FrameRecorder& recorder, int frames)
+	{
+		for (int frame = 0; frame < frames; ++frame) {
+			if (frame % 3 == 0) {
+				Node2dRef panel = std::static_pointer_cast<Node2d>(mRoot->getChildren()[frame % mRoot->getChildCount()]);
+				panel->setPosition(panel->getPosition() + vec2(1.0f, 2.0f));
+			}
+			if (frame % 10 == 4) mRoot->addChild(Node2d::create("added"));
+			if (frame % 10 == 9) mRoot->getChildren().back()->removeFromParent();
+			if (frame % 2 == 0) recorder.recordEvent(PointerEvent::POINTER_MOVE, vec2(float(frame * 10), 50.0f));
+
+			ASSERT_TRUE(recorder.endFrame(1.0 / 60.0));
+			mContext->getJournal().clear();
+		}
+	}
+
+	Node2dRef			mRoot;
+	SceneContextRef		mContext;
+};
+
+TEST_F(FrameRecorderTest, ReplaysRecordedFrames)
+{
+	std::stringstream stream;
+	FrameRecorder recorder(*mContext);
+	ASSERT_TRUE(recorder.begin(stream));
+	record(recorder, 60);
+	ASSERT_TRUE(recorder.end());
+	EXPECT_EQ(60u, recorder.getFrameCount());
+	EXPECT_EQ(uint64_t(stream.str().size()), recorder.getByteCount());
+
+	FrameReplayer replayer;
+	ASSERT_TRUE(replayer.open(stream));
+	EXPECT_EQ(60u, replayer.run());
+	EXPECT_TRUE(replayer.isComplete());
+	EXPECT_FALSE(replayer.step());
+
+	// the replica ends up like the recorded scene
+	Node2dRef replica = std::dynamic_pointer_cast<Node2d>(replayer.getRoot());
+	ASSERT_TRUE(replica != nullptr);
+	ASSERT_EQ(mRoot->getChildCount(), replica->getChildCount());
+	for (size_t i = 0; i < mRoot->getChildCount(); ++i) {
+		Node2dRef source = std::static_pointer_cast<Node2d>(mRoot->getChildren()[i]);
+		Node2dRef copy = std::static_pointer_cast<Node2d>(replica->getChildren()[i]);
+		EXPECT_EQ(source->getName(), copy->getName());
+		EXPECT_EQ(source->getPosition(), copy->getPosition());
+		// deepTransform ran on the replica
+		EXPECT_EQ(copy->getPosition(), vec2(copy->getWorldTransform()[2]));
+	}
+
+	// every frame was measured, and frames that changed nothing carried no delta
+	const std::vector<FrameReplayer::FrameTiming>& timings = replayer.getTimings();
+	ASSERT_EQ(60u, timings.size());
+	EXPECT_EQ(5u, timings[0].mNodeCount);
+	EXPECT_GT(timings[0].mDeltaSize, 0u);
+	EXPECT_EQ(0u, timings[1].mDeltaSize);
+	EXPECT_EQ(1u, timings[2].mEventCount);
+	EXPECT_EQ(0u, timings[3].mEventCount);
+	EXPECT_EQ(6u, timings[4].mNodeCount);
+	EXPECT_EQ(5u, timings[9].mNodeCount);
+	for (size_t i = 0; i < timings.size(); ++i) {
+		EXPECT_EQ(uint32_t(i), timings[i].mFrame);
+		for (int phase = 0; phase < FrameReplayer::PHASE_COUNT; ++phase) EXPECT_GE(timings[i].mMicroseconds[phase], 0.0);
+	}
+
+	// the recorded events were hit tested against the replica
+	EXPECT_EQ(30u, replayer.getDispatcher().getHitTestCount());
+}
+
+TEST_F(FrameRecorderTest, ReplaysDeterministically)
+{
+	std::stringstream stream;
+	FrameRecorder recorder(*mContext);
+	ASSERT_TRUE(recorder.begin(stream));
+	record(recorder, 30);
+	recorder.end();
+	const std::string recording = stream.str();
+
+	// the same recording gives the same replica and the same work per frame
+	FrameReplayer first;
+	FrameReplayer second;
+	std::istringstream first_stream(recording);
+	std::istringstream second_stream(recording);
+	ASSERT_TRUE(first.open(first_stream));
+	ASSERT_TRUE(second.open(second_stream));
+	EXPECT_EQ(30u, first.run());
+	EXPECT_EQ(30u, second.run());
+
+	for (size_t i = 0; i < 30; ++i) {
+		EXPECT_EQ(first.getTimings()[i].mNodeCount, second.getTimings()[i].mNodeCount);
+		EXPECT_EQ(first.getTimings()[i].mDeltaSize, second.getTimings()[i].mDeltaSize);
+	}
+
+	NodeBase::Iter first_iter = first.getRoot()->getIter();
+	NodeBase::Iter second_iter = second.getRoot()->getIter();
+	while (first_iter.hasNext() && second_iter.hasNext()) {
+		Node2dRef a = first_iter.next<Node2d>();
+		Node2dRef b = second_iter.next<Node2d>();
+		EXPECT_EQ(a->getPosition(), b->getPosition());
+	}
+	EXPECT_EQ(first_iter.hasNext(), second_iter.hasNext());
+}
+
+TEST_F(FrameRecorderTest, StopsAtCorruptFrames)
+{
+	std::stringstream stream;
+	FrameRecorder recorder(*mContext);
+	ASSERT_TRUE(recorder.begin(stream));
+	record(recorder, 10);
+	recorder.end();
+	const std::string recording = stream.str();
+
+	// a truncated recording replays the complete frames, then reports the error
+	for (size_t size = sizeof(FrameFileHeader); size < recording.size(); size += 7) {
+		std::istringstream truncated(recording.substr(0, size));
+		FrameReplayer replayer;
+		ASSERT_TRUE(replayer.open(truncated));
+		EXPECT_LT(replayer.run(), 10u);
+	}
+
+	std::istringstream empty("");
+	FrameReplayer replayer;
+	EXPECT_FALSE(replayer.open(empty));
+
+	std::string corrupt = recording;
+	corrupt[0] = 'X';
+	std::istringstream bad_magic(corrupt);
+	EXPECT_FALSE(replayer.open(bad_magic));
+
+	// a huge size does not allocate more than the data that is there
+	corrupt = recording;
+	FrameRecord record;
+	std::memcpy(&record, corrupt.data() + sizeof(FrameFileHeader), sizeof(record));
+	record.mDeltaSize = 0xfffffff0;
+	std::memcpy(&corrupt[sizeof(FrameFileHeader)], &record, sizeof(record));
+	std::istringstream huge(corrupt);
+	ASSERT_TRUE(replayer.open(huge));
+	EXPECT_FALSE(replayer.step());
+	EXPECT_FALSE(replayer.isComplete());
+}
+
+TEST_F(FrameRecorderTest, ReplaysThreeDimensionalScenes)
+{
+	Node3dRef root = Node3d::create("root");
+	Node3dRef child = Node3d::create("child");
+	child->setPosition(1.0f, 2.0f, 3.0f);
+	root->addChild(child);
+	mContext->setRoot(root);
+
+	std::stringstream stream;
+	FrameRecorder recorder(*mContext);
+	ASSERT_TRUE(recorder.begin(stream));
+	recorder.recordEvent(PointerEvent::POINTER_DOWN, vec2(1.0f, 2.0f), 1);
+	ASSERT_TRUE(recorder.endFrame(0.5));
+	mContext->getJournal().clear();
+
+	child->setPosition(4.0f, 5.0f, 6.0f);
+	ASSERT_TRUE(recorder.endFrame(0.5));
+	recorder.end();
+
+	FrameReplayer replayer;
+	ASSERT_TRUE(replayer.open(stream));
+	EXPECT_EQ(2u, replayer.run());
+	EXPECT_TRUE(replayer.isComplete());
+
+	// deepTransform ran on the replica
+	Node3dRef replica = std::dynamic_pointer_cast<Node3d>(replayer.getRoot()->getChildren()[0]);
+	ASSERT_TRUE(replica != nullptr);
+	EXPECT_EQ(vec3(4.0f, 5.0f, 6.0f), vec3(replica->getWorldTransform()[3]));
+}
+
+CINDER_APP_GTEST( FrameRecorderTest, RendererGl )
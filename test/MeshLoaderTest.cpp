@@ -0,0 +1,275 @@
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "CinderGTest.h"
+
+#include "MeshLoader.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	const char* QUAD_OBJ =
+		"# a quad and a triangle sharing an edge\n"
+		"o quad\n"
+		"v 0 0 0\n"
+		"v 1 0 0\n"
+		"v 1 1 0\n"
+		"v 0 1 0\n"
+		"vt 0 0\n"
+		"vt 1 0\n"
+		"vt 1 1\n"
+		"vn 0 0 1\n"
+		"usemtl none\n"
+		"f 1/1/1 2/2/1 3/3/1 4/1/1\n"
+		"v 2 1 -1\n"
+		"f -4/-2/-1 -1/-1/-1 -3/-1/-1 # relative indices\n";
+
+	//! blocks the worker of a pool until released, to simulate a slow disk
+	class Gate {
+	public:
+		Gate() : mIsOpen(false) {}
+
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mOpened.wait(lock, [this]() { return mIsOpen; });
+		}
+
+		void open()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mIsOpen = true;
+			mOpened.notify_all();
+		}
+
+	protected:
+		std::mutex				mMutex;
+		std::condition_variable	mOpened;
+		bool					mIsOpen;
+	};
+}
+
+class MeshLoaderTest : public testing::Test {
+public:
+	MeshLoaderTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mObjPath = "MeshLoaderTest.obj";
+		mBinaryPath = "MeshLoaderTest.mesh";
+
+		std::ofstream obj(mObjPath.c_str(), std::ios::binary);
+		obj << QUAD_OBJ;
+
+		std::istringstream stream(QUAD_OBJ);
+		ASSERT_TRUE(MeshLoader::decodeObj(stream, mMesh));
+
+		std::vector<uint8_t> data;
+		MeshLoader::encodeBinary(mMesh, data);
+		std::ofstream binary(mBinaryPath.c_str(), std::ios::binary);
+		binary.write(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+
+	void TearDown()
+	{
+		std::remove(mObjPath.c_str());
+		std::remove(mBinaryPath.c_str());
+	}
+
+	//! syncs until no load is pending, returns false after a second
+	static bool syncAll(MeshLoader& loader)
+	{
+		for (int i = 0; i < 1000; ++i) {
+			loader.sync();
+			if (loader.getPendingCount() == 0) return true;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return false;
+	}
+
+	std::string	mObjPath;
+	std::string	mBinaryPath;
+	TriMesh		mMesh;
+};
+
+TEST_F(MeshLoaderTest, DecodesObj)
+{
+	// distinct index combinations become vertices, polygons become fans
+	EXPECT_EQ(5u, mMesh.getNumVertices());
+	ASSERT_EQ(9u, mMesh.getIndices().size());
+	EXPECT_TRUE(mMesh.hasNormals());
+	EXPECT_TRUE(mMesh.hasTexCoords0());
+
+	const uint32_t expected[] = { 0, 1, 2, 0, 2, 3, 1, 4, 2 };
+	for (size_t i = 0; i < 9; ++i) EXPECT_EQ(expected[i], mMesh.getIndices()[i]) << i;
+
+	const vec3* positions = mMesh.getPositions<3>();
+	EXPECT_EQ(vec3(2.0f, 1.0f, -1.0f), positions[4]);
+	EXPECT_EQ(vec3(0.0f, 0.0f, 1.0f), mMesh.getNormals()[4]);
+	EXPECT_EQ(vec2(1.0f, 1.0f), mMesh.getTexCoords0<2>()[2]);
+
+	// faces without normals or texture coordinates are completed with zeros
+	std::istringstream plain("v 0 0 0\nv 1 0 0\nv 0 1 0\nvn 0 0 1\nf 1 2 3\nf 1//1 2//1 3//1\n");
+	TriMesh mesh;
+	ASSERT_TRUE(MeshLoader::decodeObj(plain, mesh));
+	EXPECT_EQ(6u, mesh.getNumVertices());
+	EXPECT_TRUE(mesh.hasNormals());
+	EXPECT_FALSE(mesh.hasTexCoords0());
+	EXPECT_EQ(vec3(0.0f), mesh.getNormals()[0]);
+}
+
+TEST_F(MeshLoaderTest, RejectsMalformedMeshes)
+{
+	const char* documents[] = {
+		"v 0 0\n",
+		"v 0 0 0\nv 1 0 0\nf 1 2\n",
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 4\n",
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 0\n",
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2 -4\n",
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1/1 2 3\n",
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1// 2 3\n",
+		"v 0 0 0\nv 1 0 0\nv 0 1 0\nf 1 2x 3\n"
+	};
+	for (size_t i = 0; i < sizeof(documents) / sizeof(documents[0]); ++i) {
+		std::istringstream stream(documents[i]);
+		TriMesh mesh;
+		EXPECT_FALSE(MeshLoader::decodeObj(stream, mesh)) << documents[i];
+	}
+
+	std::vector<uint8_t> data;
+	MeshLoader::encodeBinary(mMesh, data);
+
+	TriMesh mesh;
+	ASSERT_TRUE(MeshLoader::decodeBinary(data.data(), data.size(), mesh));
+	for (size_t size = 0; size < data.size(); ++size) {
+		EXPECT_FALSE(MeshLoader::decodeBinary(data.data(), size, mesh)) << size;
+	}
+
+	// an index past the vertices
+	std::vector<uint8_t> corrupt = data;
+	corrupt[corrupt.size() - 4] = 6;
+	EXPECT_FALSE(MeshLoader::decodeBinary(corrupt.data(), corrupt.size(), mesh));
+
+	// a newer version
+	corrupt = data;
+	corrupt[4] = MeshFileHeader::VERSION + 1;
+	EXPECT_FALSE(MeshLoader::decodeBinary(corrupt.data(), corrupt.size(), mesh));
+}
+
+TEST_F(MeshLoaderTest, RoundTripsBinary)
+{
+	std::vector<uint8_t> data;
+	MeshLoader::encodeBinary(mMesh, data);
+
+	MeshFileHeader header;
+	std::memcpy(&header, data.data(), sizeof(header));
+	EXPECT_EQ(MeshFileHeader::MAGIC, header.mMagic);
+	EXPECT_EQ(MeshFileHeader::ATTRIBUTE_NORMALS | MeshFileHeader::ATTRIBUTE_TEXCOORDS, header.mAttributes);
+	EXPECT_EQ(-1.0f, header.mMin[2]);
+	EXPECT_EQ(2.0f, header.mMax[0]);
+
+	TriMesh mesh;
+	ASSERT_TRUE(MeshLoader::decodeBinary(data.data(), data.size(), mesh));
+	ASSERT_EQ(mMesh.getNumVertices(), mesh.getNumVertices());
+	EXPECT_EQ(mMesh.getIndices(), mesh.getIndices());
+	EXPECT_EQ(mMesh.getNormals(), mesh.getNormals());
+	for (size_t i = 0; i < mesh.getNumVertices(); ++i) {
+		EXPECT_EQ(mMesh.getPositions<3>()[i], mesh.getPositions<3>()[i]);
+		EXPECT_EQ(mMesh.getTexCoords0<2>()[i], mesh.getTexCoords0<2>()[i]);
+	}
+}
+
+TEST_F(MeshLoaderTest, SwapsMeshesInAtSync)
+{
+	ThreadPoolRef pool = ThreadPool::create(1);
+	MeshLoader loader(pool);
+
+	// the worker is busy, so nothing can complete until the gate opens
+	Gate gate;
+	pool->submit([&gate]() { gate.wait(); });
+
+	std::vector<std::pair<NodeMeshRef, bool>> completed;
+	MeshLoader::Callback callback = [&completed](const NodeMeshRef& node, bool loaded) { completed.push_back(std::make_pair(node, loaded)); };
+
+	const AxisAlignedBox placeholder(vec3(-1.0f), vec3(1.0f));
+	NodeMeshRef obj = loader.load(mObjPath, placeholder, MeshLoader::FORMAT_AUTO, callback);
+	NodeMeshRef binary = loader.load(mBinaryPath, placeholder, MeshLoader::FORMAT_AUTO, callback);
+	NodeMeshRef missing = loader.load("MeshLoaderTest.missing.mesh", placeholder, MeshLoader::FORMAT_AUTO, callback);
+
+	EXPECT_TRUE(obj->isLoading());
+	EXPECT_EQ(0u, obj->getMesh().getNumVertices());
+	EXPECT_EQ(vec3(-1.0f), obj->getMeshBounds().getMin());
+	EXPECT_EQ(vec3(1.0f), obj->getMeshBounds().getMax());
+	EXPECT_EQ(0u, loader.sync());
+	EXPECT_EQ(3u, loader.getPendingCount());
+
+	gate.open();
+	ASSERT_TRUE(syncAll(loader));
+	ASSERT_EQ(3u, completed.size());
+	EXPECT_EQ(1u, loader.getFailedCount());
+
+	EXPECT_FALSE(obj->isLoading());
+	EXPECT_EQ(5u, obj->getMesh().getNumVertices());
+	EXPECT_EQ(vec3(0.0f, 0.0f, -1.0f), obj->getMeshBounds().getMin());
+	EXPECT_EQ(vec3(2.0f, 1.0f, 0.0f), obj->getMeshBounds().getMax());
+
+	EXPECT_FALSE(binary->isLoading());
+	EXPECT_EQ(mMesh.getIndices(), binary->getMesh().getIndices());
+
+	// a failed load keeps the placeholder
+	EXPECT_TRUE(missing->isLoading());
+	EXPECT_EQ(vec3(1.0f), missing->getMeshBounds().getMax());
+	EXPECT_TRUE(completed[2].first == missing);
+	EXPECT_FALSE(completed[2].second);
+
+	// reloading keeps the current mesh until the new one arrives
+	loader.load(binary, mObjPath);
+	EXPECT_FALSE(binary->isLoading());
+	EXPECT_EQ(5u, binary->getMesh().getNumVertices());
+	ASSERT_TRUE(syncAll(loader));
+	EXPECT_EQ(5u, binary->getMesh().getNumVertices());
+}
+
+TEST_F(MeshLoaderTest, SkipsReleasedNodesAndLoaders)
+{
+	ThreadPoolRef pool = ThreadPool::create(1);
+	Gate gate;
+	pool->submit([&gate]() { gate.wait(); });
+
+	int called = 0;
+	MeshLoader::Callback callback = [&called](const NodeMeshRef& node, bool loaded) { ++called; };
+
+	MeshLoader loader(pool);
+	NodeMeshRef released = loader.load(mObjPath, AxisAlignedBox(), MeshLoader::FORMAT_OBJ, callback);
+	NodeMeshRef kept = loader.load(mObjPath, AxisAlignedBox(), MeshLoader::FORMAT_OBJ, callback);
+	released.reset();
+
+	{
+		// the results of a destroyed loader go nowhere
+		MeshLoader gone(pool);
+		gone.load(kept, mObjPath, MeshLoader::FORMAT_OBJ, callback);
+	}
+
+	gate.open();
+	ASSERT_TRUE(syncAll(loader));
+	pool->waitIdle();
+	EXPECT_EQ(1, called);
+	EXPECT_EQ(0u, loader.getFailedCount());
+	EXPECT_FALSE(kept->isLoading());
+}
+
+CINDER_APP_GTEST( MeshLoaderTest, RendererGl )
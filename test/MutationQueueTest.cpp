@@ -0,0 +1,154 @@
+#include <thread>
+#include <vector>
+
+#include "CinderGTest.h"
+
+#include "MpscQueue.hpp"
+#include "Node3d.h"
+#include "SceneContext.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	//! removes itself and adds a sibling while the context iterates the update list
+	class RestlessNode : public Node3d {
+	public:
+		RestlessNode() : Node3d("restless") { setUpdateEnabled(); }
+
+		virtual void update(double elapsed)
+		{
+			MutationQueue& mutations = getContext()->getMutations();
+			mutations.attach(getParent(), Node3d::create("sibling"));
+			mutations.detach(shared_from_base<NodeBase>());
+		}
+	};
+}
+
+class MutationQueueTest : public testing::Test {
+public:
+	MutationQueueTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mContext = SceneContext::create();
+		mRoot = Node3d::create("root");
+		mContext->setRoot(mRoot);
+	}
+
+	void TearDown()
+	{
+	}
+
+	SceneContextRef		mContext;
+	Node3dRef			mRoot;
+};
+
+TEST_F(MutationQueueTest, MpscOrder)
+{
+	MpscQueue<int> queue;
+	int value = 0;
+	EXPECT_FALSE(queue.pop(value));
+
+	for (int i = 0; i < 10; ++i) queue.push(i);
+	for (int i = 0; i < 10; ++i) {
+		ASSERT_TRUE(queue.pop(value));
+		EXPECT_EQ(value, i);
+	}
+	EXPECT_FALSE(queue.pop(value));
+	EXPECT_TRUE(queue.empty());
+}
+
+TEST_F(MutationQueueTest, DeferredUntilSync)
+{
+	Node3dRef child = Node3d::create("child");
+	mContext->getMutations().attach(mRoot, child);
+	EXPECT_EQ(mRoot->getChildCount(), 0u);
+	EXPECT_EQ(mContext->getMutations().getPendingCount(), 1u);
+
+	EXPECT_EQ(mContext->sync(), 1u);
+	EXPECT_TRUE(mRoot->hasChild(child));
+
+	mContext->getMutations().detach(child);
+	mContext->sync();
+	EXPECT_FALSE(child->hasParent());
+}
+
+TEST_F(MutationQueueTest, EditsDuringUpdate)
+{
+	mRoot->addChild(NodeRef(new RestlessNode()));
+
+	mContext->update(0.1);
+
+	ASSERT_EQ(mRoot->getChildCount(), 1u);
+	EXPECT_EQ(std::dynamic_pointer_cast<RestlessNode>(mRoot->getChildren().front()), nullptr);
+	EXPECT_EQ(mContext->getUpdateCount(), 0u);
+}
+
+TEST_F(MutationQueueTest, Reorder)
+{
+	Node3dRef a = Node3d::create("a");
+	Node3dRef b = Node3d::create("b");
+	mRoot->addChild(a);
+	mRoot->addChild(b);
+
+	mContext->getMutations().moveToTop(a);
+	mContext->sync();
+	EXPECT_TRUE(a->isOnTop());
+
+	mContext->getMutations().moveToBottom(a);
+	mContext->sync();
+	EXPECT_TRUE(a->isOnBottom());
+}
+
+TEST_F(MutationQueueTest, Destroy)
+{
+	Node3dRef child = Node3d::create("child");
+	Node3dWeakRef grandchild = Node3d::create("grandchild");
+	child->addChild(grandchild.lock());
+	mRoot->addChild(child);
+
+	mContext->getMutations().destroy(child);
+	Node3dWeakRef weak = child;
+	child.reset();
+	mContext->sync();
+
+	EXPECT_TRUE(weak.expired());
+	EXPECT_TRUE(grandchild.expired());
+	EXPECT_EQ(mRoot->getChildCount(), 0u);
+}
+
+TEST_F(MutationQueueTest, Producers)
+{
+	// loader threads build subtrees on their own and splice them in with a single edit
+	const int kThreads = 4;
+	const int kSubtrees = 250;
+
+	std::vector<std::thread> threads;
+	for (int t = 0; t < kThreads; ++t) {
+		threads.push_back(std::thread([this]() {
+			for (int i = 0; i < kSubtrees; ++i) {
+				Node3dRef subtree = Node3d::create("subtree");
+				subtree->addChild(Node3d::create("leaf"));
+				mContext->getMutations().attach(mRoot, subtree);
+			}
+		}));
+	}
+
+	// the main thread keeps syncing while the producers run
+	size_t applied = 0;
+	while (applied < kThreads * kSubtrees) applied += mContext->sync();
+	for (auto itr = threads.begin(); itr != threads.end(); ++itr) itr->join();
+
+	EXPECT_EQ(mRoot->getChildCount(), size_t(kThreads * kSubtrees));
+	EXPECT_EQ(mContext->getMutations().getPendingCount(), 0u);
+}
+
+CINDER_APP_GTEST( MutationQueueTest, RendererGl )
@@ -0,0 +1,189 @@
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "cinder/Matrix.h"
+#include "cinder/Shape2d.h"
+
+#include "CinderGTest.h"
+
+#include "CompactMesh.h"
+#include "Node2d.h"
+#include "Node3d.h"
+#include "NodeShape2d.h"
+#include "RenderBackend.h"
+#include "RenderBackendGl.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+class RenderBackendTest : public testing::Test {
+public:
+	RenderBackendTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mRecorder = RenderBackendRecorder::create();
+		mNull = RenderBackendNull::create();
+	}
+
+	void TearDown()
+	{
+	}
+
+protected:
+
+	//! builds a tree where every node has the given number of children
+	static Node3dRef buildTree(uint32_t children, uint32_t depth)
+	{
+		Node3dRef root = Node3d::create("root");
+		if (depth == 0) return root;
+
+		for (uint32_t i = 0; i < children; ++i) {
+			Node3dRef child = buildTree(children, depth - 1);
+			child->setPosition(static_cast<float>(i), 0, 0);
+			root->addChild(child);
+		}
+
+		return root;
+	}
+
+	RenderBackendRecorderRef mRecorder;
+	RenderBackendNullRef mNull;
+};
+
+TEST_F( RenderBackendTest, BalancedTraversalTest )
+{
+	// 1 + 4 + 16 + 64 nodes
+	Node3dRef root = buildTree(4, 3);
+	root->deepTransform();
+
+	mRecorder->beginFrame();
+	root->deepDraw(*mRecorder);
+	mRecorder->endFrame();
+
+	EXPECT_EQ(mRecorder->getCommandCount(RenderCommand::PUSH_MODEL_MATRIX), 85);
+	EXPECT_EQ(mRecorder->getCommandCount(RenderCommand::POP_MODEL_MATRIX), 85);
+	EXPECT_EQ(mRecorder->getStackDepth(), 0);
+	EXPECT_EQ(mRecorder->getMaxStackDepth(), 1) << "World transforms must not be nested on the matrix stack.";
+	EXPECT_EQ(mRecorder->getCommands().front().mType, RenderCommand::BEGIN_FRAME);
+	EXPECT_EQ(mRecorder->getCommands().back().mType, RenderCommand::END_FRAME);
+
+	mRecorder->clear();
+	EXPECT_TRUE(mRecorder->getCommands().empty());
+
+	EXPECT_NO_THROW(root->deepDraw(*mNull));
+}
+
+TEST_F( RenderBackendTest, InactiveSubtreeTest )
+{
+	Node3dRef root = buildTree(2, 2);
+	Node3dRef hidden = std::dynamic_pointer_cast<Node3d>(root->getChildren().front());
+	hidden->setActive(false);
+	root->deepTransform();
+
+	root->deepDraw(*mRecorder);
+
+	// the inactive node and its two children are skipped
+	EXPECT_EQ(mRecorder->getCommandCount(RenderCommand::PUSH_MODEL_MATRIX), 4);
+}
+
+TEST_F( RenderBackendTest, ShapeCommandTest )
+{
+	Shape2d shape;
+	shape.moveTo(vec2(0, 0));
+	shape.lineTo(vec2(10, 0));
+	shape.lineTo(vec2(10, 10));
+	shape.close();
+
+	Node2dRef root = Node2d::create("root");
+	NodeShape2dRef node(new NodeShape2d(shape));
+	node->setFillColor(ColorA(0, 0, 1, 1));
+	root->addChild(node);
+	root->deepTransform();
+
+	root->deepDraw(*mRecorder);
+
+	EXPECT_EQ(mRecorder->getCommandCount(RenderCommand::DRAW_SOLID_SHAPE), 1);
+	EXPECT_EQ(mRecorder->getCommandCount(RenderCommand::DRAW_SHAPE), 1);
+	EXPECT_EQ(mRecorder->getCommandCount(RenderCommand::SET_COLOR), 2);
+
+	const std::vector<RenderCommand>& commands = mRecorder->getCommands();
+	auto itr = std::find_if(commands.begin(), commands.end(), [](const RenderCommand& cmd) {
+		return cmd.mType == RenderCommand::SET_COLOR;
+	});
+	ASSERT_NE(itr, commands.end());
+	EXPECT_EQ(itr->mColor, ColorA(0, 0, 1, 1));
+
+	// colors are only set within the model matrix scope of a node, other commands carry the default
+	int depth = 0;
+	for (const RenderCommand& command : commands) {
+		if (command.mType == RenderCommand::PUSH_MODEL_MATRIX) ++depth;
+		else if (command.mType == RenderCommand::POP_MODEL_MATRIX) --depth;
+		else if (command.mType == RenderCommand::SET_COLOR) EXPECT_GT(depth, 0);
+		if (command.mType != RenderCommand::SET_COLOR) EXPECT_EQ(command.mColor, ColorA::white());
+	}
+}
+
+TEST_F( RenderBackendTest, MeshCommandTest )
+{
+	TriMesh mesh(TriMesh::Format().positions(3));
+	mesh.appendPosition(vec3(0, 0, 0));
+	mesh.appendPosition(vec3(1, 0, 0));
+	mesh.appendPosition(vec3(0, 1, 0));
+	mesh.appendTriangle(0, 1, 2);
+	CompactMeshRef compact = CompactMesh::create(mesh);
+
+	mRecorder->drawMesh(mesh);
+	mRecorder->drawMesh(*compact);
+
+	// the type tells which kind of mesh the resource points to
+	const std::vector<RenderCommand>& commands = mRecorder->getCommands();
+	ASSERT_EQ(commands.size(), 2u);
+	EXPECT_EQ(commands[0].mType, RenderCommand::DRAW_MESH);
+	EXPECT_EQ(commands[0].mResource, &mesh);
+	EXPECT_EQ(commands[1].mType, RenderCommand::DRAW_COMPACT_MESH);
+	EXPECT_EQ(static_cast<const CompactMesh*>(commands[1].mResource)->getId(), compact->getId());
+	EXPECT_EQ(mRecorder->getCommandCount(RenderCommand::DRAW_MESH), 1);
+	EXPECT_EQ(mRecorder->getCommandCount(RenderCommand::DRAW_COMPACT_MESH), 1);
+}
+
+TEST_F( RenderBackendTest, CompactMeshCacheTest )
+{
+	TriMesh mesh(TriMesh::Format().positions(3));
+	mesh.appendPosition(vec3(0, 0, 0));
+	mesh.appendPosition(vec3(1, 0, 0));
+	mesh.appendPosition(vec3(0, 1, 0));
+	mesh.appendTriangle(0, 1, 2);
+	CompactMeshRef first = CompactMesh::create(mesh);
+	CompactMeshRef second = CompactMesh::create(mesh);
+	EXPECT_NE(first->getId(), second->getId());
+
+	// a mesh is uploaded once, however often it is drawn
+	RenderBackendGlRef backend = RenderBackendGl::create();
+	for (int frame = 0; frame < 3; ++frame) {
+		backend->beginFrame();
+		backend->drawMesh(*first);
+		backend->drawMesh(*first);
+		if (frame == 0) backend->drawMesh(*second);
+		backend->endFrame();
+	}
+	EXPECT_EQ(backend->getCachedMeshCount(), 2u);
+
+	// meshes that are no longer drawn are released after a while
+	for (int frame = 0; frame < 200; ++frame) {
+		backend->beginFrame();
+		backend->drawMesh(*first);
+		backend->endFrame();
+	}
+	EXPECT_EQ(backend->getCachedMeshCount(), 1u);
+}
+
+CINDER_APP_GTEST( RenderBackendTest, RendererGl )
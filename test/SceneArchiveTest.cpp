@@ -0,0 +1,205 @@
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+#include "CinderGTest.h"
+
+#include "Node3d.h"
+#include "SceneArchive.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+class SceneArchiveTest : public testing::Test {
+public:
+	SceneArchiveTest() : testing::Test() {
+	}
+
+	/**
+	 * Writes the scene
+	 *
+	 *   root
+	 *     shown        (active)
+	 *       leaf
+	 *     hidden       (inactive)
+	 *       inner
+	 *         deep
+	 *       muted      (inactive)
+	 *         buried
+	 */
+	void SetUp()
+	{
+		Node3dRef root = Node3d::create("root");
+		Node3dRef shown = Node3d::create("shown");
+		Node3dRef hidden = Node3d::create("hidden", false);
+		Node3dRef inner = Node3d::create("inner");
+		Node3dRef muted = Node3d::create("muted", false);
+		root->addChild(shown);
+		shown->addChild(Node3d::create("leaf"));
+		root->addChild(hidden);
+		hidden->addChild(inner);
+		inner->addChild(Node3d::create("deep"));
+		hidden->addChild(muted);
+		muted->addChild(Node3d::create("buried"));
+
+		mNames.clear();
+		collectNames(*root);
+
+		SceneWriter writer;
+		ASSERT_TRUE(writer.write(*root, mBuffer));
+	}
+
+	void TearDown()
+	{
+	}
+
+	//! appends the names of a node and its descendants in the order of the node table
+	void collectNames(const NodeBase& node)
+	{
+		mNames.push_back(node.getName());
+		for (auto itr = node.getChildren().begin(); itr != node.getChildren().end(); ++itr) collectNames(**itr);
+	}
+
+	//! returns the index of the node that was created with a name
+	uint32_t indexOf(const std::string& name) const
+	{
+		for (size_t i = 0; i < mNames.size(); ++i) {
+			if (mNames[i].compare(0, name.size() + 1, name + "_") == 0) return static_cast<uint32_t>(i);
+		}
+		return SceneArchive::INVALID_INDEX;
+	}
+
+	std::vector<std::string>	mNames;		//!< the names of the nodes in depth-first order
+	std::vector<uint8_t>		mBuffer;	//!< the scene file
+};
+
+TEST_F(SceneArchiveTest, MaterializesTheActivePart)
+{
+	SceneArchiveRef archive = SceneArchive::create(mBuffer);
+	ASSERT_TRUE(archive != nullptr);
+	EXPECT_EQ(8u, archive->getNodeCount());
+	EXPECT_EQ(0u, archive->getMaterializedCount());
+
+	NodeRef root = archive->getRoot();
+	ASSERT_TRUE(root != nullptr);
+	EXPECT_EQ(mNames[0], root->getName());
+
+	// root, shown, leaf and the collapsed hidden node
+	EXPECT_EQ(4u, archive->getMaterializedCount());
+	EXPECT_TRUE(archive->isCollapsed(indexOf("hidden")));
+	EXPECT_FALSE(archive->isMaterialized(indexOf("inner")));
+	EXPECT_EQ(2u, root->getChildCount());
+	EXPECT_EQ(0u, root->getChildren()[1]->getChildCount());
+
+	EXPECT_EQ(root, archive->getRoot());
+}
+
+TEST_F(SceneArchiveTest, AddressesNodesByIndexAndName)
+{
+	SceneArchiveRef archive = SceneArchive::create(mBuffer);
+	ASSERT_TRUE(archive != nullptr);
+
+	uint32_t deep = indexOf("deep");
+	EXPECT_EQ(deep, archive->findIndex(mNames[deep]));
+	EXPECT_EQ(SceneArchive::INVALID_INDEX, archive->findIndex("missing"));
+	EXPECT_EQ(mNames[deep], archive->getName(deep));
+	EXPECT_EQ(0u, archive->getMaterializedCount());
+
+	// expands hidden, but not muted beneath it
+	NodeRef node = archive->getNode(deep);
+	ASSERT_TRUE(node != nullptr);
+	EXPECT_EQ(mNames[deep], node->getName());
+	EXPECT_EQ(mNames[indexOf("inner")], node->getParent()->getName());
+	EXPECT_TRUE(archive->isCollapsed(indexOf("muted")));
+	EXPECT_FALSE(archive->isMaterialized(indexOf("buried")));
+
+	NodeRef buried = archive->findNode(mNames[indexOf("buried")]);
+	ASSERT_TRUE(buried != nullptr);
+	EXPECT_EQ(8u, archive->getMaterializedCount());
+
+	// the nodes hang in the tree of the root
+	NodeRef root = archive->getRoot();
+	NodeRef ancestor = buried;
+	while (ancestor->getParent()) ancestor = ancestor->getParent();
+	EXPECT_EQ(root, ancestor);
+}
+
+TEST_F(SceneArchiveTest, ExpandsActivatedNodes)
+{
+	SceneArchiveRef archive = SceneArchive::create(mBuffer);
+	ASSERT_TRUE(archive != nullptr);
+
+	NodeRef root = archive->getRoot();
+	EXPECT_EQ(0u, archive->sync());
+
+	NodeRef hidden = archive->getNode(indexOf("hidden"));
+	ASSERT_TRUE(hidden != nullptr);
+	hidden->setActive();
+	EXPECT_EQ(1u, archive->sync());
+	EXPECT_EQ(2u, hidden->getChildCount());
+	EXPECT_EQ(mNames[indexOf("inner")], hidden->getChildren()[0]->getName());
+	EXPECT_EQ(mNames[indexOf("muted")], hidden->getChildren()[1]->getName());
+	EXPECT_TRUE(archive->isCollapsed(indexOf("muted")));
+	EXPECT_EQ(0u, archive->sync());
+}
+
+TEST_F(SceneArchiveTest, ForgetsDestroyedNodes)
+{
+	SceneArchiveRef archive = SceneArchive::create(mBuffer);
+	ASSERT_TRUE(archive != nullptr);
+
+	NodeRef root = archive->getRoot();
+	root->removeChildren();
+
+	// the file still describes them, but they are not created again
+	EXPECT_TRUE(archive->getNode(indexOf("hidden")) == nullptr);
+	EXPECT_TRUE(archive->getNode(indexOf("deep")) == nullptr);
+	EXPECT_EQ(0u, archive->sync());
+	EXPECT_EQ(root, archive->getNode(0));
+}
+
+TEST_F(SceneArchiveTest, MapsFiles)
+{
+	const std::string path = "SceneArchiveTest.scnb";
+	{
+		std::ofstream stream(path.c_str(), std::ios::binary);
+		stream.write(reinterpret_cast<const char*>(mBuffer.data()), mBuffer.size());
+	}
+
+	SceneArchiveRef archive = SceneArchive::open(path);
+	ASSERT_TRUE(archive != nullptr);
+	NodeRef node = archive->findNode(mNames[indexOf("buried")]);
+	archive.reset();
+
+	// the nodes outlive the mapping
+	ASSERT_TRUE(node != nullptr);
+	EXPECT_EQ(mNames[indexOf("buried")], node->getName());
+
+	std::remove(path.c_str());
+	EXPECT_TRUE(SceneArchive::open(path) == nullptr);
+}
+
+TEST_F(SceneArchiveTest, RejectsInconsistentSubtrees)
+{
+	SceneFileHeader header;
+	memcpy(&header, mBuffer.data(), sizeof(header));
+
+	// a subtree that claims the sibling after it
+	std::vector<uint8_t> corrupt = mBuffer;
+	uint32_t size = 2;
+	memcpy(corrupt.data() + header.mNodeOffset + indexOf("shown") * header.mRecordSize + offsetof(SceneNodeRecord, mSubtreeSize), &size, sizeof(size));
+	EXPECT_TRUE(SceneArchive::create(corrupt) == nullptr);
+
+	corrupt.resize(corrupt.size() - 1);
+	EXPECT_TRUE(SceneArchive::create(corrupt) == nullptr);
+	EXPECT_TRUE(SceneArchive::create(std::vector<uint8_t>()) == nullptr);
+}
+
+CINDER_APP_GTEST( SceneArchiveTest, RendererGl )
@@ -0,0 +1,161 @@
+#include <vector>
+
+#include "CinderGTest.h"
+
+#include "Node3d.h"
+#include "SceneContext.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	class AnimatedNode : public Node3d {
+	public:
+		AnimatedNode(const std::string& name = "animated") : Node3d(name), mUpdates(0), mRemoveOnUpdate(false)
+		{
+			setUpdateEnabled();
+		}
+
+		virtual void update(double elapsed)
+		{
+			++mUpdates;
+			if (mRemoveOnUpdate) removeFromParent();
+		}
+
+		int		mUpdates;
+		bool	mRemoveOnUpdate;
+	};
+}
+
+class SceneContextTest : public testing::Test {
+public:
+	SceneContextTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mContext = SceneContext::create();
+		mRoot = Node3d::create("root");
+		mContext->setRoot(mRoot);
+	}
+
+	void TearDown()
+	{
+	}
+
+protected:
+
+	SceneContextRef mContext;
+	Node3dRef mRoot;
+};
+
+TEST_F( SceneContextTest, PropagationTest )
+{
+	Node3dRef parent = Node3d::create("parent");
+	Node3dRef child = Node3d::create("child");
+	parent->addChild(child);
+	EXPECT_EQ( nullptr, child->getContext() );
+
+	mRoot->addChild(parent);
+	EXPECT_EQ( mContext.get(), parent->getContext() );
+	EXPECT_EQ( mContext.get(), child->getContext() );
+
+	mRoot->removeChild(parent);
+	EXPECT_EQ( nullptr, parent->getContext() );
+	EXPECT_EQ( nullptr, child->getContext() );
+}
+
+TEST_F( SceneContextTest, RegistrationTest )
+{
+	std::shared_ptr<AnimatedNode> a(new AnimatedNode());
+	std::shared_ptr<AnimatedNode> b(new AnimatedNode());
+	Node3dRef group = Node3d::create("group");
+	group->addChild(b);
+	EXPECT_EQ( 0u, mContext->getUpdateCount() );
+
+	mRoot->addChild(a);
+	mRoot->addChild(group);
+	EXPECT_EQ( 2u, mContext->getUpdateCount() );
+
+	mContext->update(0.1);
+	EXPECT_EQ( 1, a->mUpdates );
+	EXPECT_EQ( 1, b->mUpdates );
+
+	// leaving the scene, disabling updates or being destroyed unregisters
+	mRoot->removeChild(group);
+	EXPECT_EQ( 1u, mContext->getUpdateCount() );
+	a->setUpdateEnabled(false);
+	EXPECT_EQ( 0u, mContext->getUpdateCount() );
+	a->setUpdateEnabled(true);
+	mRoot->addChild(group);
+	EXPECT_EQ( 2u, mContext->getUpdateCount() );
+	group.reset();
+	mRoot->removeChildren();
+	b.reset();
+	EXPECT_EQ( 0u, mContext->getUpdateCount() );
+}
+
+TEST_F( SceneContextTest, RemoveDuringUpdateTest )
+{
+	std::vector<std::shared_ptr<AnimatedNode>> nodes;
+	for (int i = 0; i < 10; ++i) {
+		nodes.push_back(std::shared_ptr<AnimatedNode>(new AnimatedNode()));
+		nodes.back()->mRemoveOnUpdate = (i % 3 == 0);
+		mRoot->addChild(nodes.back());
+	}
+
+	mContext->update(0.1);
+	for (auto itr = nodes.begin(); itr != nodes.end(); ++itr) {
+		EXPECT_EQ( 1, (*itr)->mUpdates );
+	}
+	EXPECT_EQ( 6u, mContext->getUpdateCount() );
+
+	mContext->update(0.1);
+	for (size_t i = 0; i < nodes.size(); ++i) {
+		EXPECT_EQ( (i % 3 == 0)? 1: 2, nodes[i]->mUpdates );
+	}
+}
+
+TEST_F( SceneContextTest, SparseUpdateTest )
+{
+	// 100k nodes of which 2k are animated, only those are visited
+	std::vector<AnimatedNode*> animated;
+	for (int group = 0; group < 100; ++group) {
+		Node3dRef parent = Node3d::create("group");
+		for (int i = 0; i < 1000; ++i) {
+			if (i % 50 == 0) {
+				std::shared_ptr<AnimatedNode> node(new AnimatedNode());
+				animated.push_back(node.get());
+				parent->addChild(node);
+			}
+			else {
+				parent->addChild(Node3d::create("static"));
+			}
+		}
+		mRoot->addChild(parent);
+	}
+
+	EXPECT_EQ( 2000u, mContext->getUpdateCount() );
+	mContext->update(0.1);
+	for (auto itr = animated.begin(); itr != animated.end(); ++itr) {
+		ASSERT_EQ( 1, (*itr)->mUpdates );
+	}
+}
+
+TEST_F( SceneContextTest, ContextDestructionTest )
+{
+	std::shared_ptr<AnimatedNode> node(new AnimatedNode());
+	mRoot->addChild(node);
+	mContext.reset();
+
+	EXPECT_EQ( nullptr, mRoot->getContext() );
+	EXPECT_EQ( nullptr, node->getContext() );
+}
+
+CINDER_APP_GTEST( SceneContextTest, RendererGl )
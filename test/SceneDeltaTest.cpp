@@ -0,0 +1,396 @@
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "CinderGTest.h"
+
+#include "Node2d.h"
+#include "Node3d.h"
+#include "NodeShape2d.h"
+#include "SceneDelta.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	//! stands in for a pipe between processes, a byte stream carrying length prefixed messages
+	class Pipe {
+	public:
+		Pipe() : mClosed(false) {}
+
+		void write(const std::vector<uint8_t>& message)
+		{
+			uint32_t size = static_cast<uint32_t>(message.size());
+			const uint8_t* prefix = reinterpret_cast<const uint8_t*>(&size);
+
+			std::lock_guard<std::mutex> lock(mMutex);
+			mBytes.insert(mBytes.end(), prefix, prefix + sizeof(size));
+			mBytes.insert(mBytes.end(), message.begin(), message.end());
+			mCondition.notify_one();
+		}
+
+		void close()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mClosed = true;
+			mCondition.notify_one();
+		}
+
+		//! waits for the next message, returns false once the pipe was closed and drained
+		bool read(std::vector<uint8_t>& message)
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			uint32_t size = 0;
+			mCondition.wait(lock, [&]() {
+				if (mBytes.size() < sizeof(size)) return mClosed;
+				std::copy(mBytes.begin(), mBytes.begin() + sizeof(size), reinterpret_cast<uint8_t*>(&size));
+				return mBytes.size() >= sizeof(size) + size;
+			});
+			if (mBytes.size() < sizeof(size)) return false;
+
+			message.assign(mBytes.begin() + sizeof(size), mBytes.begin() + sizeof(size) + size);
+			mBytes.erase(mBytes.begin(), mBytes.begin() + sizeof(size) + size);
+			return true;
+		}
+
+	protected:
+		std::mutex				mMutex;
+		std::condition_variable	mCondition;
+		std::deque<uint8_t>		mBytes;
+		bool					mClosed;
+	};
+}
+
+class SceneDeltaTest : public testing::Test {
+public:
+	SceneDeltaTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mContext = SceneContext::create();
+		mRoot = Node3d::create("root");
+		for (int i = 0; i < 4; ++i) {
+			Node3dRef child = Node3d::create("child");
+			child->setPosition(float(i), 0.0f, 0.0f);
+			mRoot->addChild(child);
+			child->addChild(Node2d::create("leaf"));
+		}
+		mContext->setRoot(mRoot);
+	}
+
+	void TearDown()
+	{
+		mContext->setRoot(NodeRef());
+	}
+
+	//! returns the number of entries of a delta
+	static uint32_t getEntryCount(const std::vector<uint8_t>& delta)
+	{
+		SceneDeltaHeader header;
+		memcpy(&header, delta.data(), sizeof(header));
+		return header.mEntryCount;
+	}
+
+	//! compares a replica with the nodes it was encoded from
+	static void expectReplica(const NodeBase& source, const NodeBase& replica, float tolerance)
+	{
+		EXPECT_EQ(source.getName(), replica.getName());
+		EXPECT_EQ(source.isActive(), replica.isActive());
+		EXPECT_EQ(source.isInteractive(), replica.isInteractive());
+
+		if (const Node3d* node = dynamic_cast<const Node3d*>(&source)) {
+			const Node3d* copy = dynamic_cast<const Node3d*>(&replica);
+			ASSERT_TRUE(copy != nullptr);
+			EXPECT_NEAR(0.0f, glm::length(node->getPosition() - copy->getPosition()), tolerance);
+			EXPECT_NEAR(0.0f, glm::length(node->getSize() - copy->getSize()), tolerance);
+			EXPECT_GT(std::abs(glm::dot(node->getRotation(), copy->getRotation())), 0.9999f);
+		}
+		if (const Node2d* node = dynamic_cast<const Node2d*>(&source)) {
+			const Node2d* copy = dynamic_cast<const Node2d*>(&replica);
+			ASSERT_TRUE(copy != nullptr);
+			EXPECT_NEAR(0.0f, glm::length(node->getPosition() - copy->getPosition()), tolerance);
+			EXPECT_NEAR(node->getRotation(), copy->getRotation(), 0.001f);
+		}
+
+		ASSERT_EQ(source.getChildCount(), replica.getChildCount());
+		for (size_t i = 0; i < source.getChildCount(); ++i) {
+			expectReplica(*source.getChildren()[i], *replica.getChildren()[i], tolerance);
+		}
+	}
+
+	SceneContextRef		mContext;
+	Node3dRef			mRoot;
+};
+
+TEST_F(SceneDeltaTest, SnapshotsTheWholeScene)
+{
+	SceneDeltaEncoder encoder(*mContext);
+	EXPECT_EQ(1u, encoder.getVersion());
+	EXPECT_EQ(9u, encoder.getTrackedCount());
+
+	std::vector<uint8_t> delta;
+	ASSERT_TRUE(encoder.encode(0, delta));
+	EXPECT_EQ(9u, getEntryCount(delta));
+
+	SceneDeltaApplier applier;
+	ASSERT_TRUE(applier.apply(delta));
+	EXPECT_EQ(1u, applier.getVersion());
+	EXPECT_EQ(9u, applier.getNodeCount());
+	ASSERT_TRUE(applier.getRoot() != nullptr);
+	expectReplica(*mRoot, *applier.getRoot(), encoder.getStep());
+	EXPECT_EQ(applier.getRoot(), applier.findNode(mRoot->getId()));
+
+	// nothing changed, nothing to send
+	EXPECT_EQ(1u, encoder.capture());
+	ASSERT_TRUE(encoder.encode(1, delta));
+	EXPECT_EQ(0u, getEntryCount(delta));
+}
+
+TEST_F(SceneDeltaTest, EncodesOnlyChangedNodes)
+{
+	SceneDeltaEncoder encoder(*mContext);
+	SceneDeltaApplier applier;
+	std::vector<uint8_t> delta;
+	ASSERT_TRUE(encoder.encode(0, delta));
+	ASSERT_TRUE(applier.apply(delta));
+	mContext->getJournal().clear();
+
+	Node3dRef moved = std::static_pointer_cast<Node3d>(mRoot->getChildren()[2]);
+	moved->setPosition(5.0f, 6.0f, 7.0f);
+	moved->setRotation(quat(0.5f, 0.5f, 0.5f, 0.5f));
+	Node2dRef hidden = std::static_pointer_cast<Node2d>(mRoot->getChildren()[0]->getChildren()[0]);
+	hidden->setActive(false);
+	EXPECT_EQ(2u, encoder.capture());
+	mContext->getJournal().clear();
+
+	ASSERT_TRUE(encoder.encode(1, delta));
+	EXPECT_EQ(2u, getEntryCount(delta));
+	ASSERT_TRUE(applier.apply(delta));
+	EXPECT_EQ(2u, applier.getVersion());
+	expectReplica(*mRoot, *applier.getRoot(), encoder.getStep());
+
+	// a replica that missed a version gets the union of the changes
+	hidden->setInteractive();
+	EXPECT_EQ(3u, encoder.capture());
+	mContext->getJournal().clear();
+
+	SceneDeltaApplier late;
+	ASSERT_TRUE(encoder.encode(0, delta));
+	ASSERT_TRUE(late.apply(delta));
+	ASSERT_TRUE(encoder.encode(2, delta));
+	EXPECT_EQ(1u, getEntryCount(delta));
+	ASSERT_TRUE(applier.apply(delta));
+	expectReplica(*mRoot, *applier.getRoot(), encoder.getStep());
+	expectReplica(*mRoot, *late.getRoot(), encoder.getStep());
+}
+
+TEST_F(SceneDeltaTest, ReplicatesStructuralChanges)
+{
+	SceneDeltaEncoder encoder(*mContext);
+	SceneDeltaApplier applier;
+	std::vector<uint8_t> delta;
+	ASSERT_TRUE(encoder.encode(0, delta));
+	ASSERT_TRUE(applier.apply(delta));
+
+	NodeRef first = mRoot->getChildren()[0];
+	NodeRef second = mRoot->getChildren()[1];
+	NodeRef leaf = first->getChildren()[0];
+
+	// reparent, reorder, add and remove within one frame
+	second->addChild(leaf);
+	mRoot->removeChild(mRoot->getChildren()[2]);
+	mRoot->moveToBottom(mRoot->getChildren()[2]);
+	Node3dRef added = Node3d::create("added");
+	added->setSize(vec3(1.0f, 2.0f, 3.0f));
+	first->addChild(added);
+
+	Shape2d shape;
+	shape.moveTo(vec2(0, 0));
+	shape.lineTo(vec2(10, 0));
+	shape.lineTo(vec2(0, 10));
+	shape.close();
+	NodeShape2dRef outline( new NodeShape2d(shape) );
+	added->addChild(outline);
+
+	encoder.capture();
+	mContext->getJournal().clear();
+	ASSERT_TRUE(encoder.encode(1, delta));
+	ASSERT_TRUE(applier.apply(delta));
+	expectReplica(*mRoot, *applier.getRoot(), encoder.getStep());
+
+	// the removed child and its leaf are gone, the shape arrived with its payload
+	EXPECT_EQ(9u, applier.getNodeCount());
+	NodeShape2dRef copy = std::dynamic_pointer_cast<NodeShape2d>(applier.findNode(outline->getId()));
+	ASSERT_TRUE(copy != nullptr);
+	EXPECT_EQ(shape.getContours()[0].getPoints(), copy->getShape().getContours()[0].getPoints());
+
+	// contents changed in place
+	outline->setStrokeColor(ColorA(0.0f, 1.0f, 0.0f, 1.0f));
+	uint32_t version = encoder.capture();
+	mContext->getJournal().clear();
+	ASSERT_TRUE(encoder.encode(2, delta));
+	EXPECT_EQ(1u, getEntryCount(delta));
+	ASSERT_TRUE(applier.apply(delta));
+	EXPECT_TRUE(copy->getStrokeColor() == ColorA(0.0f, 1.0f, 0.0f, 1.0f));
+
+	// a removed node that comes back is sent as a new node
+	first->removeFromParent();
+	encoder.capture();
+	mContext->getJournal().clear();
+	mRoot->addChild(first);
+	encoder.capture();
+	mContext->getJournal().clear();
+	ASSERT_TRUE(encoder.encode(version, delta));
+	ASSERT_TRUE(applier.apply(delta));
+	expectReplica(*mRoot, *applier.getRoot(), encoder.getStep());
+
+	// the replica follows a new root
+	Node2dRef other = Node2d::create("other");
+	mContext->setRoot(other);
+	encoder.capture();
+	mContext->getJournal().clear();
+	ASSERT_TRUE(encoder.encode(applier.getVersion(), delta));
+	ASSERT_TRUE(applier.apply(delta));
+	ASSERT_TRUE(applier.getRoot() != nullptr);
+	EXPECT_EQ(1u, applier.getNodeCount());
+	expectReplica(*other, *applier.getRoot(), encoder.getStep());
+}
+
+TEST_F(SceneDeltaTest, QuantizesTransforms)
+{
+	SceneDeltaEncoder encoder(*mContext);
+	encoder.setStep(0.01f);
+
+	Node3dRef node = std::static_pointer_cast<Node3d>(mRoot->getChildren()[0]);
+	node->setPosition(1.234567f, -1000.005f, 0.0f);
+	node->setRotation(glm::angleAxis(2.5f, glm::normalize(vec3(1.0f, -2.0f, 0.5f))));
+	node->setScale(vec3(0.333f));
+	Node2dRef leaf = std::static_pointer_cast<Node2d>(node->getChildren()[0]);
+	leaf->setRotation(-7.5f);
+	leaf->setPivot(3.0f, 4.0f);
+	encoder.capture();
+	mContext->getJournal().clear();
+
+	std::vector<uint8_t> delta;
+	ASSERT_TRUE(encoder.encode(0, delta));
+	SceneDeltaApplier applier;
+	ASSERT_TRUE(applier.apply(delta));
+	expectReplica(*mRoot, *applier.getRoot(), 0.01f);
+
+	Node3dRef copy = std::static_pointer_cast<Node3d>(applier.findNode(node->getId()));
+	EXPECT_NEAR(0.333f, copy->getScale().x, 0.005f);
+	EXPECT_NE(node->getPosition(), copy->getPosition());
+
+	// untouched rotations stay exact
+	EXPECT_EQ(quat(1.0f, 0.0f, 0.0f, 0.0f), std::static_pointer_cast<Node3d>(applier.getRoot())->getRotation());
+
+	Node2dRef copy_leaf = std::static_pointer_cast<Node2d>(applier.findNode(leaf->getId()));
+	EXPECT_NEAR(-7.5f, copy_leaf->getRotation(), 0.0001f);
+	EXPECT_EQ(vec2(3.0f, 4.0f), copy_leaf->getPivot());
+}
+
+TEST_F(SceneDeltaTest, RejectsGapsAndMalformedDeltas)
+{
+	SceneDeltaEncoder encoder(*mContext);
+	std::vector<uint8_t> snapshot;
+	ASSERT_TRUE(encoder.encode(0, snapshot));
+
+	mRoot->getChildren()[0]->removeFromParent();
+	encoder.capture();
+	mContext->getJournal().clear();
+	std::vector<uint8_t> delta;
+	ASSERT_TRUE(encoder.encode(1, delta));
+
+	// the replica is at version 0 and misses the snapshot
+	SceneDeltaApplier applier;
+	EXPECT_FALSE(applier.apply(delta));
+	EXPECT_EQ(0u, applier.getNodeCount());
+
+	// every truncation is caught and leaves the replica untouched
+	for (size_t size = 0; size < snapshot.size(); ++size) {
+		EXPECT_FALSE(applier.apply(snapshot.data(), size)) << size;
+		EXPECT_EQ(0u, applier.getNodeCount());
+	}
+
+	// a child of the root that refers to a node nobody created
+	std::vector<uint8_t> corrupt = snapshot;
+	uint64_t id = mRoot->getChildren()[1]->getId();
+	const uint8_t* pattern = reinterpret_cast<const uint8_t*>(&id);
+	auto child = std::search(corrupt.begin(), corrupt.end(), pattern, pattern + sizeof(id));
+	ASSERT_TRUE(child != corrupt.end());
+	id = 0x123456789ull;
+	std::copy(pattern, pattern + sizeof(id), child);
+	EXPECT_FALSE(applier.apply(corrupt));
+	EXPECT_EQ(0u, applier.getNodeCount());
+
+	ASSERT_TRUE(applier.apply(snapshot));
+	ASSERT_TRUE(applier.apply(delta));
+	EXPECT_EQ(7u, applier.getNodeCount());
+
+	// versions that were forgotten can not be encoded from anymore
+	encoder.forget(2);
+	EXPECT_EQ(7u, encoder.getTrackedCount());
+	EXPECT_FALSE(encoder.encode(1, delta));
+	EXPECT_FALSE(encoder.encode(3, delta));
+	EXPECT_TRUE(encoder.encode(2, delta));
+	EXPECT_TRUE(encoder.encode(0, delta));
+}
+
+TEST_F(SceneDeltaTest, ReplicatesThroughAPipe)
+{
+	Pipe pipe;
+	SceneDeltaApplier applier;
+	uint32_t applied = 0;
+
+	// the replica lives on another thread, as it would in another process
+	std::thread replica([&]() {
+		std::vector<uint8_t> message;
+		while (pipe.read(message)) {
+			if (applier.apply(message)) ++applied;
+		}
+	});
+
+	SceneDeltaEncoder encoder(*mContext);
+	std::vector<uint8_t> delta;
+	ASSERT_TRUE(encoder.encode(0, delta));
+	pipe.write(delta);
+
+	uint32_t sent = encoder.getVersion();
+	size_t total = 0;
+	for (int frame = 0; frame < 100; ++frame) {
+		NodeRef child = mRoot->getChildren()[frame % 4];
+		std::static_pointer_cast<Node3d>(child)->setPosition(float(frame), 1.0f, 2.0f);
+		if (frame % 10 == 0) child->addChild(Node2d::create("spawned"));
+		if (frame % 10 == 5 && child->hasChildren()) child->getChildren()[0]->removeFromParent();
+
+		encoder.capture();
+		mContext->getJournal().clear();
+
+		ASSERT_TRUE(encoder.encode(sent, delta));
+		pipe.write(delta);
+		sent = encoder.getVersion();
+		total += delta.size();
+		encoder.forget(sent);
+	}
+
+	pipe.close();
+	replica.join();
+
+	EXPECT_EQ(101u, applied);
+	EXPECT_EQ(sent, applier.getVersion());
+	expectReplica(*mRoot, *applier.getRoot(), encoder.getStep());
+	EXPECT_LT(total, 100u * 200u);
+}
+
+CINDER_APP_GTEST( SceneDeltaTest, RendererGl )
@@ -0,0 +1,451 @@
+#include <cstddef>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CinderGTest.h"
+
+#include "Node2d.h"
+#include "Node3d.h"
+#include "NodeShape2d.h"
+#include "SceneFormat.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	//! node type that is only known to the registry of a test
+	class CounterNode : public Node2d {
+	public:
+		CounterNode() : Node2d("counter"), mCount(0) {}
+
+		virtual void serialize(BinaryWriter& writer) const { writer.write(mCount); }
+		virtual bool deserialize(BinaryReader& reader) { return reader.read(mCount); }
+
+		int32_t	mCount;
+	};
+}
+
+class SceneFormatTest : public testing::Test {
+public:
+	SceneFormatTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+	}
+
+	void TearDown()
+	{
+	}
+
+	//! returns a copy of a record of a file
+	static SceneNodeRecord getRecord(const std::vector<uint8_t>& buffer, uint32_t index)
+	{
+		SceneFileHeader header;
+		memcpy(&header, buffer.data(), sizeof(header));
+
+		SceneNodeRecord record;
+		memcpy(&record, buffer.data() + header.mNodeOffset + index * header.mRecordSize, sizeof(record));
+		return record;
+	}
+
+	//! returns a copy of an entry of the chunk index of a file
+	static SceneChunkRecord getChunk(const std::vector<uint8_t>& buffer, uint32_t index)
+	{
+		SceneFileHeader header;
+		memcpy(&header, buffer.data(), sizeof(header));
+
+		SceneChunkRecord chunk;
+		memcpy(&chunk, buffer.data() + header.mChunkOffset + index * sizeof(SceneChunkRecord), sizeof(chunk));
+		return chunk;
+	}
+
+	//! overwrites an entry of the chunk index of a file
+	static void setChunk(std::vector<uint8_t>& buffer, uint32_t index, const SceneChunkRecord& chunk)
+	{
+		SceneFileHeader header;
+		memcpy(&header, buffer.data(), sizeof(header));
+		memcpy(buffer.data() + header.mChunkOffset + index * sizeof(SceneChunkRecord), &chunk, sizeof(chunk));
+	}
+
+	//! returns a tree of irregular shape made of groups and shapes, with names, transformations and payloads
+	static Node2dRef createIrregularScene(uint32_t count)
+	{
+		Shape2d shape;
+		shape.moveTo(vec2(0, 0));
+		shape.lineTo(vec2(10, 0));
+		shape.lineTo(vec2(0, 10));
+		shape.close();
+
+		std::vector<Node2dRef> nodes;
+		nodes.push_back(Node2d::create("root"));
+		for (uint32_t i = 1; i < count; ++i) {
+			Node2dRef node;
+			if (i % 5 == 0) node.reset( new NodeShape2d(shape) );
+			else node = Node2d::create("group", i % 11 != 0);
+			node->setName("node" + std::to_string(i));
+			node->setPosition(float(i), float(i % 17));
+			node->setRotation(0.01f * i);
+
+			// mostly recent parents, so there are deep chains as well as wide levels
+			uint32_t parent = (i % 3 == 0)? (i * 2654435761u) % i: i - 1 - (i * 40503u) % std::min(i, 4u);
+			nodes[parent]->addChild(node);
+			nodes.push_back(node);
+		}
+		return nodes[0];
+	}
+};
+
+TEST_F(SceneFormatTest, RoundTripsHierarchyAndTransforms)
+{
+	Node2dRef root = Node2d::create("root");
+	Node2dRef a = Node2d::create("a");
+	Node2dRef b = Node2d::create("b", false);
+	Node2dRef c = Node2d::create("c");
+	root->addChild(a);
+	root->addChild(b);
+	a->addChild(c);
+
+	a->setPosition(1.0f, 2.0f);
+	a->setRotation(4.0f);
+	a->setScale(vec2(2.0f, 3.0f));
+	a->setPivot(0.5f, 0.25f);
+	a->setSize(vec2(10.0f, 20.0f));
+	c->setInteractive();
+
+	std::vector<uint8_t> buffer;
+	SceneWriter writer;
+	ASSERT_TRUE(writer.write(*root, buffer));
+
+	// depth-first order, the subtree sizes cover the descendants
+	EXPECT_EQ(3u, getRecord(buffer, 0).mSubtreeSize);
+	EXPECT_EQ(1u, getRecord(buffer, 1).mSubtreeSize);
+	EXPECT_EQ(0u, getRecord(buffer, 2).mSubtreeSize);
+	EXPECT_EQ(0u, getRecord(buffer, 3).mParent);
+
+	SceneReader reader;
+	Node2dRef loaded = std::dynamic_pointer_cast<Node2d>(reader.read(buffer));
+	ASSERT_TRUE(loaded != nullptr);
+	EXPECT_EQ(root->getName(), loaded->getName());
+	ASSERT_EQ(2u, loaded->getChildCount());
+
+	Node2dRef loaded_a = std::dynamic_pointer_cast<Node2d>(loaded->getChildren()[0]);
+	Node2dRef loaded_b = std::dynamic_pointer_cast<Node2d>(loaded->getChildren()[1]);
+	ASSERT_TRUE(loaded_a && loaded_b);
+	EXPECT_EQ(a->getName(), loaded_a->getName());
+	EXPECT_EQ(b->getName(), loaded_b->getName());
+	EXPECT_FALSE(loaded_b->isActive());
+	EXPECT_TRUE(loaded_a->isActive());
+
+	EXPECT_EQ(vec2(1.0f, 2.0f), loaded_a->getPosition());
+	EXPECT_EQ(4.0f, loaded_a->getRotation());
+	EXPECT_EQ(vec2(2.0f, 3.0f), loaded_a->getScale());
+	EXPECT_EQ(vec2(0.5f, 0.25f), loaded_a->getPivot());
+	EXPECT_EQ(vec2(10.0f, 20.0f), loaded_a->getSize());
+
+	ASSERT_EQ(1u, loaded_a->getChildCount());
+	EXPECT_TRUE(loaded_a->getChildren()[0]->isInteractive());
+	EXPECT_EQ(loaded_a, loaded_a->getChildren()[0]->getParent());
+}
+
+TEST_F(SceneFormatTest, RoundTripsNode3dAndShapes)
+{
+	Node3dRef root = Node3d::create("root");
+	root->setPosition(1.0f, 2.0f, 3.0f);
+	root->setRotation(quat(0.5f, 0.5f, 0.5f, 0.5f));
+	root->setScale(2.0f);
+
+	Shape2d shape;
+	shape.moveTo(vec2(0, 0));
+	shape.lineTo(vec2(10, 0));
+	shape.quadTo(vec2(10, 10), vec2(0, 10));
+	shape.close();
+
+	NodeShape2dRef node( new NodeShape2d(shape) );
+	node->setStrokeColor(ColorA(0.0f, 0.0f, 1.0f, 0.5f));
+	root->addChild(node);
+
+	std::stringstream stream;
+	SceneWriter writer;
+	ASSERT_TRUE(writer.write(*root, stream));
+
+	SceneReader reader;
+	Node3dRef loaded = std::dynamic_pointer_cast<Node3d>(reader.read(stream));
+	ASSERT_TRUE(loaded != nullptr);
+	EXPECT_EQ(vec3(1.0f, 2.0f, 3.0f), loaded->getPosition());
+	EXPECT_EQ(quat(0.5f, 0.5f, 0.5f, 0.5f), loaded->getRotation());
+	EXPECT_EQ(vec3(2.0f), loaded->getScale());
+
+	ASSERT_EQ(1u, loaded->getChildCount());
+	NodeShape2dRef loaded_shape = std::dynamic_pointer_cast<NodeShape2d>(loaded->getChildren()[0]);
+	ASSERT_TRUE(loaded_shape != nullptr);
+	EXPECT_TRUE(loaded_shape->getStrokeColor() == ColorA(0.0f, 0.0f, 1.0f, 0.5f));
+
+	const std::vector<Path2d>& contours = loaded_shape->getShape().getContours();
+	ASSERT_EQ(1u, contours.size());
+	EXPECT_EQ(shape.getContours()[0].getPoints(), contours[0].getPoints());
+	EXPECT_EQ(shape.getContours()[0].getSegments(), contours[0].getSegments());
+}
+
+TEST_F(SceneFormatTest, UsesTheTypesOfTheRegistry)
+{
+	Node2dRef root = Node2d::create("root");
+	std::shared_ptr<CounterNode> counter( new CounterNode() );
+	counter->mCount = 42;
+	root->addChild(counter);
+
+	// the default registry does not know the type
+	std::vector<uint8_t> buffer;
+	SceneWriter default_writer;
+	EXPECT_FALSE(default_writer.write(*root, buffer));
+
+	SceneTypeRegistry registry;
+	EXPECT_TRUE(registry.registerType<Node2d>(SceneTypeRegistry::TYPE_NODE2D, "Node2d", []() -> NodeRef { return Node2d::create(); }));
+	EXPECT_TRUE(registry.registerType<CounterNode>(SceneTypeRegistry::FIRST_USER_TYPE, "CounterNode", []() -> NodeRef { return NodeRef( new CounterNode() ); }));
+	EXPECT_FALSE(registry.registerType<CounterNode>(SceneTypeRegistry::FIRST_USER_TYPE + 1, "Other", []() -> NodeRef { return NodeRef( new CounterNode() ); }));
+
+	SceneWriter writer(registry);
+	ASSERT_TRUE(writer.write(*root, buffer));
+
+	SceneReader default_reader;
+	EXPECT_TRUE(default_reader.read(buffer) == nullptr);
+
+	SceneReader reader(registry);
+	NodeRef loaded = reader.read(buffer);
+	ASSERT_TRUE(loaded != nullptr);
+	ASSERT_EQ(1u, loaded->getChildCount());
+	std::shared_ptr<CounterNode> loaded_counter = std::dynamic_pointer_cast<CounterNode>(loaded->getChildren()[0]);
+	ASSERT_TRUE(loaded_counter != nullptr);
+	EXPECT_EQ(42, loaded_counter->mCount);
+}
+
+TEST_F(SceneFormatTest, RejectsMalformedFiles)
+{
+	Node2dRef root = Node2d::create("root");
+	root->addChild(Node2d::create("child"));
+	root->addChild( NodeShape2dRef( new NodeShape2d() ) );
+
+	std::vector<uint8_t> buffer;
+	SceneWriter writer;
+	ASSERT_TRUE(writer.write(*root, buffer));
+
+	SceneReader reader;
+	ASSERT_TRUE(reader.read(buffer) != nullptr);
+	EXPECT_TRUE(reader.read(nullptr, 0) == nullptr);
+
+	// every truncation is caught
+	for (size_t size = 0; size < buffer.size(); ++size) {
+		EXPECT_TRUE(reader.read(buffer.data(), size) == nullptr) << size;
+	}
+
+	SceneFileHeader header;
+	memcpy(&header, buffer.data(), sizeof(header));
+
+	std::vector<uint8_t> corrupt = buffer;
+	corrupt[0] ^= 0xff;
+	EXPECT_TRUE(reader.read(corrupt) == nullptr);
+
+	// a child that refers to itself as its parent
+	corrupt = buffer;
+	uint32_t parent = 1;
+	memcpy(corrupt.data() + header.mNodeOffset + header.mRecordSize + offsetof(SceneNodeRecord, mParent), &parent, sizeof(parent));
+	EXPECT_TRUE(reader.read(corrupt) == nullptr);
+
+	// a name outside of the string table
+	corrupt = buffer;
+	uint32_t name_size = header.mStringSize + 1;
+	memcpy(corrupt.data() + header.mNodeOffset + offsetof(SceneNodeRecord, mNameSize), &name_size, sizeof(name_size));
+	EXPECT_TRUE(reader.read(corrupt) == nullptr);
+
+	// a shape payload cut short
+	corrupt = buffer;
+	uint32_t payload_size = 4;
+	memcpy(corrupt.data() + header.mNodeOffset + 2 * header.mRecordSize + offsetof(SceneNodeRecord, mPayloadSize), &payload_size, sizeof(payload_size));
+	EXPECT_TRUE(reader.read(corrupt) == nullptr);
+}
+
+TEST_F(SceneFormatTest, LoadsLargeScenes)
+{
+	// a wide level under the root and deep chains beneath it
+	const uint32_t count = 200000;
+	Node3dRef root = Node3d::create("root");
+	Node3dRef parent = root;
+	for (uint32_t i = 1; i < count; ++i) {
+		Node3dRef node = Node3d::create();
+		node->setPosition(float(i), 0.0f, 0.0f);
+		if (i % 100 == 1) parent = root;
+		parent->addChild(node);
+		parent = node;
+	}
+
+	std::vector<uint8_t> buffer;
+	SceneWriter writer;
+	ASSERT_TRUE(writer.write(*root, buffer));
+	EXPECT_EQ(count - 1, getRecord(buffer, 0).mSubtreeSize);
+
+	SceneReader reader;
+	NodeRef loaded = reader.read(buffer);
+	ASSERT_TRUE(loaded != nullptr);
+	EXPECT_EQ(2000u, loaded->getChildCount());
+
+	uint32_t loaded_count = 0;
+	double sum = 0.0;
+	NodeBase::Iter iter = loaded->getIter();
+	while (iter.hasNext()) {
+		Node3dRef node = iter.next<Node3d>();
+		sum += node->getPosition().x;
+		++loaded_count;
+	}
+	EXPECT_EQ(count, loaded_count);
+	EXPECT_DOUBLE_EQ(double(count) * double(count - 1) / 2.0, sum);
+}
+
+TEST_F(SceneFormatTest, DecodesChunksInParallel)
+{
+	const uint32_t count = 5000;
+	Node2dRef root = createIrregularScene(count);
+
+	SceneWriter writer;
+	writer.setChunkSize(0);
+	std::vector<uint8_t> expected;
+	ASSERT_TRUE(writer.write(*root, expected));
+
+	ThreadPoolRef pool = ThreadPool::create(4);
+	const uint32_t chunk_sizes[] = { 1, 7, 64, 1000, SceneWriter::DEFAULT_CHUNK_SIZE };
+	for (uint32_t chunk_size : chunk_sizes) {
+		std::vector<uint8_t> buffer;
+		writer.setChunkSize(chunk_size);
+		ASSERT_TRUE(writer.write(*root, buffer));
+
+		// the chunks follow each other and count the records whose parent precedes them
+		SceneFileHeader header;
+		memcpy(&header, buffer.data(), sizeof(header));
+		ASSERT_EQ((count + chunk_size - 1) / chunk_size, header.mChunkCount);
+		for (uint32_t c = 0; c < header.mChunkCount; ++c) {
+			SceneChunkRecord chunk = getChunk(buffer, c);
+			EXPECT_EQ(c * chunk_size, chunk.mFirstNode);
+			uint32_t roots = 0;
+			for (uint32_t i = chunk.mFirstNode; i < chunk.mFirstNode + chunk.mNodeCount; ++i) {
+				if (i == 0 || getRecord(buffer, i).mParent < chunk.mFirstNode) ++roots;
+			}
+			EXPECT_EQ(roots, chunk.mRootCount);
+		}
+
+		// serial and parallel reads give the same scene, which is written exactly like the original
+		SceneReader serial_reader;
+		SceneReader parallel_reader(SceneTypeRegistry::getDefault(), pool);
+		for (SceneReader* reader : { &serial_reader, &parallel_reader }) {
+			NodeRef loaded = reader->read(buffer);
+			ASSERT_TRUE(loaded != nullptr) << chunk_size;
+
+			std::vector<uint8_t> written;
+			writer.setChunkSize(0);
+			ASSERT_TRUE(writer.write(*loaded, written));
+			EXPECT_TRUE(expected == written) << chunk_size;
+
+			// every node but the root has its parent set
+			NodeBase::Iter iter = loaded->getIter();
+			iter.next();
+			while (iter.hasNext()) {
+				NodeRef node = iter.next();
+				ASSERT_TRUE(node->getParent() != nullptr);
+			}
+		}
+	}
+}
+
+TEST_F(SceneFormatTest, ReadsFilesWithoutChunkIndex)
+{
+	Node2dRef root = createIrregularScene(100);
+
+	SceneWriter writer;
+	writer.setChunkSize(0);
+	std::vector<uint8_t> buffer;
+	ASSERT_TRUE(writer.write(*root, buffer));
+
+	SceneFileHeader header;
+	memcpy(&header, buffer.data(), sizeof(header));
+	EXPECT_EQ(0u, header.mChunkCount);
+
+	// version 1 had no chunk index, the fields that follow its header are ignored
+	uint16_t version = 1;
+	uint32_t garbage = 0xffffffff;
+	memcpy(buffer.data() + offsetof(SceneFileHeader, mVersion), &version, sizeof(version));
+	memcpy(buffer.data() + offsetof(SceneFileHeader, mChunkOffset), &garbage, sizeof(garbage));
+	memcpy(buffer.data() + offsetof(SceneFileHeader, mChunkCount), &garbage, sizeof(garbage));
+
+	SceneReader reader(SceneTypeRegistry::getDefault(), ThreadPool::create(2));
+	NodeRef loaded = reader.read(buffer);
+	ASSERT_TRUE(loaded != nullptr);
+
+	std::vector<uint8_t> expected;
+	std::vector<uint8_t> written;
+	ASSERT_TRUE(writer.write(*root, expected));
+	ASSERT_TRUE(writer.write(*loaded, written));
+	EXPECT_TRUE(expected == written);
+}
+
+TEST_F(SceneFormatTest, RejectsMalformedChunkIndex)
+{
+	Node2dRef root = createIrregularScene(300);
+
+	SceneWriter writer;
+	writer.setChunkSize(50);
+	std::vector<uint8_t> buffer;
+	ASSERT_TRUE(writer.write(*root, buffer));
+
+	SceneReader reader(SceneTypeRegistry::getDefault(), ThreadPool::create(2));
+	ASSERT_TRUE(reader.read(buffer) != nullptr);
+
+	// a gap between two chunks
+	std::vector<uint8_t> corrupt = buffer;
+	SceneChunkRecord chunk = getChunk(buffer, 2);
+	chunk.mFirstNode += 1;
+	setChunk(corrupt, 2, chunk);
+	EXPECT_TRUE(reader.read(corrupt) == nullptr);
+
+	// chunks that do not hold every record
+	corrupt = buffer;
+	chunk = getChunk(buffer, 5);
+	chunk.mNodeCount -= 1;
+	setChunk(corrupt, 5, chunk);
+	EXPECT_TRUE(reader.read(corrupt) == nullptr);
+
+	// a wrong number of roots
+	for (int delta : { -1, 1 }) {
+		corrupt = buffer;
+		chunk = getChunk(buffer, 3);
+		chunk.mRootCount += delta;
+		setChunk(corrupt, 3, chunk);
+		EXPECT_TRUE(reader.read(corrupt) == nullptr) << delta;
+	}
+
+	// names and payloads outside of the ranges of their chunk
+	corrupt = buffer;
+	chunk = getChunk(buffer, 1);
+	chunk.mStringSize -= 1;
+	setChunk(corrupt, 1, chunk);
+	EXPECT_TRUE(reader.read(corrupt) == nullptr);
+
+	corrupt = buffer;
+	chunk = getChunk(buffer, 1);
+	chunk.mPayloadOffset += 4;
+	setChunk(corrupt, 1, chunk);
+	EXPECT_TRUE(reader.read(corrupt) == nullptr);
+
+	// an index beyond the end of the file
+	corrupt = buffer;
+	uint32_t chunk_count = 0x10000000;
+	memcpy(corrupt.data() + offsetof(SceneFileHeader, mChunkCount), &chunk_count, sizeof(chunk_count));
+	EXPECT_TRUE(reader.read(corrupt) == nullptr);
+}
+
+CINDER_APP_GTEST( SceneFormatTest, RendererGl )
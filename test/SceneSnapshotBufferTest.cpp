@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "cinder/Matrix.h"
+#include "cinder/Shape2d.h"
+#include "cinder/TriMesh.h"
+
+#include "CinderGTest.h"
+
+#include "Node2d.h"
+#include "Node3d.h"
+#include "NodeMesh.h"
+#include "NodeShape2d.h"
+#include "RenderBackend.h"
+#include "SceneSnapshot.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+class SceneSnapshotBufferTest : public testing::Test {
+public:
+	SceneSnapshotBufferTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mBuffer = SceneSnapshotBuffer::create();
+
+		mSquare.moveTo(vec2(0, 0));
+		mSquare.lineTo(vec2(10, 0));
+		mSquare.lineTo(vec2(10, 10));
+		mSquare.close();
+
+		mTriangle = TriMesh(TriMesh::Format().positions(3));
+		mTriangle.appendPosition(vec3(0, 0, 0));
+		mTriangle.appendPosition(vec3(1, 0, 0));
+		mTriangle.appendPosition(vec3(0, 1, 0));
+		mTriangle.appendTriangle(0, 1, 2);
+	}
+
+	void TearDown()
+	{
+	}
+
+protected:
+
+	//! captures the given root into the write buffer and publishes it
+	void publish(const Node2d& root, uint64_t frame)
+	{
+		mBuffer->getWriteBuffer().capture(root, frame);
+		mBuffer->publish();
+	}
+
+	SceneSnapshotBufferRef mBuffer;
+	Shape2d mSquare;
+	TriMesh mTriangle;
+};
+
+TEST_F( SceneSnapshotBufferTest, AcquireBeforePublishTest )
+{
+	EXPECT_FALSE(mBuffer->hasPending());
+	EXPECT_TRUE(mBuffer->acquire() == nullptr);
+}
+
+TEST_F( SceneSnapshotBufferTest, PublishAcquireTest )
+{
+	Node2dRef root = Node2d::create("root");
+	root->deepTransform();
+
+	publish(*root, 1);
+	EXPECT_TRUE(mBuffer->hasPending());
+
+	const SceneSnapshot* snapshot = mBuffer->acquire();
+	ASSERT_TRUE(snapshot != nullptr);
+	EXPECT_FALSE(mBuffer->hasPending());
+	EXPECT_EQ(1u, snapshot->getFrame());
+	EXPECT_EQ(1u, snapshot->size());
+	EXPECT_EQ(root.get(), snapshot->getItems()[0].mNode);
+
+	// nothing new was published, the reader keeps its snapshot
+	EXPECT_EQ(snapshot, mBuffer->acquire());
+	EXPECT_EQ(1u, mBuffer->acquire()->getFrame());
+}
+
+TEST_F( SceneSnapshotBufferTest, LatestWinsTest )
+{
+	Node2dRef root = Node2d::create("root");
+	root->deepTransform();
+
+	publish(*root, 1);
+	EXPECT_EQ(1u, mBuffer->acquire()->getFrame());
+
+	// the reader skips frames it was too slow to draw
+	publish(*root, 2);
+	publish(*root, 3);
+
+	const SceneSnapshot* snapshot = mBuffer->acquire();
+	ASSERT_TRUE(snapshot != nullptr);
+	EXPECT_EQ(3u, snapshot->getFrame());
+}
+
+TEST_F( SceneSnapshotBufferTest, WriterNeverWritesReadBufferTest )
+{
+	Node2dRef root = Node2d::create("root");
+	root->deepTransform();
+
+	std::vector<const SceneSnapshot*> buffers;
+	for (uint64_t frame = 1; frame <= 12; ++frame) {
+		publish(*root, frame);
+		const SceneSnapshot* snapshot = mBuffer->acquire();
+		ASSERT_TRUE(snapshot != nullptr);
+		EXPECT_EQ(frame, snapshot->getFrame());
+		EXPECT_NE(snapshot, &mBuffer->getWriteBuffer());
+		if (std::find(buffers.begin(), buffers.end(), snapshot) == buffers.end()) buffers.push_back(snapshot);
+	}
+
+	// the three buffers take turns
+	EXPECT_EQ(3u, buffers.size());
+}
+
+TEST_F( SceneSnapshotBufferTest, ShapePayloadTest )
+{
+	Node2dRef root = Node2d::create("root");
+	NodeShape2dRef shape(new NodeShape2d(mSquare));
+	shape->setFillColor(ColorA(0, 0, 1, 1));
+	shape->setStrokeColor(ColorA(0, 1, 0, 1));
+	root->addChild(shape);
+	root->deepTransform();
+
+	publish(*root, 1);
+	const SceneSnapshot* snapshot = mBuffer->acquire();
+	ASSERT_EQ(2u, snapshot->size());
+
+	// plain nodes carry no draw data
+	const SnapshotItem& empty = snapshot->getItems()[0];
+	EXPECT_FALSE(empty.mShape || empty.mMesh || empty.mCompactMesh);
+
+	const SnapshotItem& item = snapshot->getItems()[1];
+	ASSERT_TRUE(item.mShape != nullptr);
+	EXPECT_EQ(ColorA(0, 0, 1, 1), item.mColor);
+	EXPECT_EQ(ColorA(0, 1, 0, 1), item.mStrokeColor);
+	EXPECT_EQ(mSquare.getNumContours(), item.mShape->getNumContours());
+
+	// the shape is shared between frames until it is replaced
+	std::shared_ptr<const Shape2d> first = item.mShape;
+	publish(*root, 2);
+	EXPECT_EQ(first, mBuffer->acquire()->getItems()[1].mShape);
+
+	shape->setShape(mSquare);
+	publish(*root, 3);
+	EXPECT_NE(first, mBuffer->acquire()->getItems()[1].mShape);
+
+	// the render thread may still hold the old copy
+	EXPECT_EQ(mSquare.getNumContours(), first->getNumContours());
+}
+
+TEST_F( SceneSnapshotBufferTest, MeshPayloadTest )
+{
+	Node3dRef root = Node3d::create("root");
+	NodeMeshRef mesh(new NodeMesh(mTriangle));
+	mesh->setMeshColor(ColorA(1, 0, 0, 1));
+	NodeMeshRef hidden(new NodeMesh(mTriangle, "hidden", false));
+	root->addChild(mesh);
+	root->addChild(hidden);
+	root->deepTransform();
+
+	SceneSnapshot snapshot;
+	snapshot.capture(*root, 1);
+	ASSERT_EQ(3u, snapshot.size());
+
+	const SnapshotItem& item = snapshot.getItems()[1];
+	ASSERT_TRUE(item.mMesh != nullptr);
+	EXPECT_TRUE(item.mCompactMesh == nullptr);
+	EXPECT_EQ(ColorA(1, 0, 0, 1), item.mColor);
+	EXPECT_EQ(1u, item.mMesh->getNumTriangles());
+
+	// hidden nodes are not drawn, so they carry no draw data
+	EXPECT_FALSE(snapshot.getItems()[2].mIsVisible);
+	EXPECT_TRUE(snapshot.getItems()[2].mMesh == nullptr);
+
+	std::shared_ptr<const TriMesh> first = item.mMesh;
+	snapshot.capture(*root, 2);
+	EXPECT_EQ(first, snapshot.getItems()[1].mMesh);
+
+	mesh->setMesh(mTriangle);
+	snapshot.capture(*root, 3);
+	EXPECT_NE(first, snapshot.getItems()[1].mMesh);
+
+	// a compacted mesh is handed over as is
+	mesh->compact();
+	snapshot.capture(*root, 4);
+	EXPECT_TRUE(snapshot.getItems()[1].mMesh == nullptr);
+	EXPECT_EQ(mesh->getCompactMesh(), snapshot.getItems()[1].mCompactMesh);
+}
+
+TEST_F( SceneSnapshotBufferTest, DrawSnapshotTest )
+{
+	Node2dRef root = Node2d::create("root");
+	NodeShape2dRef shape(new NodeShape2d(mSquare));
+	shape->setFillColor(ColorA(0, 0, 1, 1));
+	shape->setPosition(vec2(5, 6));
+	root->addChild(shape);
+	root->deepTransform();
+
+	// drawing the snapshot issues the same commands as drawing the nodes
+	RenderBackendRecorderRef direct = RenderBackendRecorder::create();
+	root->deepDraw(*direct);
+
+	publish(*root, 1);
+	RenderBackendRecorderRef recorder = RenderBackendRecorder::create();
+	recorder->drawSnapshot(*mBuffer->acquire());
+
+	EXPECT_EQ(direct->getCommandCount(RenderCommand::DRAW_SOLID_SHAPE), recorder->getCommandCount(RenderCommand::DRAW_SOLID_SHAPE));
+	EXPECT_EQ(direct->getCommandCount(RenderCommand::DRAW_SHAPE), recorder->getCommandCount(RenderCommand::DRAW_SHAPE));
+	EXPECT_EQ(direct->getCommandCount(RenderCommand::SET_COLOR), recorder->getCommandCount(RenderCommand::SET_COLOR));
+	EXPECT_EQ(1, recorder->getCommandCount(RenderCommand::PUSH_MODEL_MATRIX));
+	EXPECT_EQ(0, recorder->getStackDepth());
+
+	const std::vector<RenderCommand>& commands = recorder->getCommands();
+	ASSERT_EQ(RenderCommand::PUSH_MODEL_MATRIX, commands[0].mType);
+	EXPECT_EQ(vec4(5, 6, 0, 1), commands[0].mTransform[3]);
+	ASSERT_EQ(RenderCommand::SET_COLOR, commands[1].mType);
+	EXPECT_EQ(ColorA(0, 0, 1, 1), commands[1].mColor);
+}
+
+TEST_F( SceneSnapshotBufferTest, ProducerConsumerTest )
+{
+	static const uint64_t FRAMES = 2000;
+
+	Node2dRef root = Node2d::create("root");
+	NodeShape2dRef shape(new NodeShape2d(mSquare));
+	root->addChild(shape);
+
+	std::atomic<bool> done(false);
+	std::thread producer([&]() {
+		for (uint64_t frame = 1; frame <= FRAMES; ++frame) {
+			root->setPosition(vec2(static_cast<float>(frame), 0));
+			if (frame % 100 == 0) shape->setShape(mSquare);
+			root->deepTransform();
+			publish(*root, frame);
+		}
+		done.store(true, std::memory_order_release);
+	});
+
+	// the consumer only reads the snapshots, never the nodes
+	uint64_t last = 0;
+	size_t acquired = 0;
+	bool failed = false;
+	for (;;) {
+		bool finished = done.load(std::memory_order_acquire);
+		const SceneSnapshot* snapshot = mBuffer->acquire();
+		if (snapshot && snapshot->getFrame() != last) {
+			const std::vector<SnapshotItem>& items = snapshot->getItems();
+			failed |= snapshot->getFrame() < last;
+			failed |= items.size() != 2
+				|| items[0].mWorldTransform[3][0] != static_cast<float>(snapshot->getFrame())
+				|| !items[1].mShape || items[1].mShape->getNumContours() != 1;
+			last = snapshot->getFrame();
+			++acquired;
+		}
+		if (finished && !mBuffer->hasPending()) break;
+		std::this_thread::yield();
+	}
+	producer.join();
+
+	EXPECT_FALSE(failed);
+	EXPECT_GT(acquired, 0u);
+	EXPECT_EQ(FRAMES, last);
+}
+
+CINDER_APP_GTEST( SceneSnapshotBufferTest, RendererGl )
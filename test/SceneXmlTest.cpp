@@ -0,0 +1,193 @@
+#include <sstream>
+#include <string>
+
+#include "CinderGTest.h"
+
+#include "Node2d.h"
+#include "Node3d.h"
+#include "NodeShape2d.h"
+#include "SceneXml.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+class SceneXmlTest : public testing::Test {
+public:
+	SceneXmlTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+	}
+
+	void TearDown()
+	{
+	}
+
+	//! reads a scene from a document held in a string
+	static NodeRef read(const std::string& document)
+	{
+		std::istringstream stream(document);
+		XmlSceneReader reader;
+		return reader.read(stream);
+	}
+};
+
+TEST_F(SceneXmlTest, RoundTripsHierarchyAndTransforms)
+{
+	Node3dRef root = Node3d::create("root");
+	root->setPosition(1.0f, 2.0f, 3.0f);
+	root->setRotation(quat(0.5f, 0.5f, 0.5f, 0.5f));
+	root->setScale(vec3(0.1f, 2.0f, 3.0f));
+
+	Node2dRef panel = Node2d::create("<\"panel\" & 'more'>\n", false);
+	panel->setPosition(-1.5f, 1e-7f);
+	panel->setRotation(0.3f);
+	panel->setPivot(0.5f, 0.25f);
+	panel->setSize(vec2(10.0f, 20.0f));
+	panel->setInteractive();
+	root->addChild(panel);
+
+	Shape2d shape;
+	shape.moveTo(vec2(0, 0));
+	shape.lineTo(vec2(10, 0));
+	shape.quadTo(vec2(10, 10), vec2(0, 10));
+	shape.close();
+
+	NodeShape2dRef node( new NodeShape2d(shape) );
+	node->setStrokeColor(ColorA(1.0f, 0.0f, 0.0f, 0.5f));
+	panel->addChild(node);
+	root->addChild(Node3d::create("last"));
+
+	std::stringstream stream;
+	XmlSceneWriter writer;
+	ASSERT_TRUE(writer.write(*root, stream));
+
+	XmlSceneReader reader;
+	Node3dRef loaded = std::dynamic_pointer_cast<Node3d>(reader.read(stream));
+	ASSERT_TRUE(loaded != nullptr);
+	EXPECT_EQ(root->getName(), loaded->getName());
+	EXPECT_EQ(vec3(1.0f, 2.0f, 3.0f), loaded->getPosition());
+	EXPECT_EQ(quat(0.5f, 0.5f, 0.5f, 0.5f), loaded->getRotation());
+	EXPECT_EQ(vec3(0.1f, 2.0f, 3.0f), loaded->getScale());
+	ASSERT_EQ(2u, loaded->getChildCount());
+	EXPECT_EQ("last", loaded->getChildren()[1]->getName().substr(0, 4));
+
+	Node2dRef loaded_panel = std::dynamic_pointer_cast<Node2d>(loaded->getChildren()[0]);
+	ASSERT_TRUE(loaded_panel != nullptr);
+	EXPECT_EQ(panel->getName(), loaded_panel->getName());
+	EXPECT_FALSE(loaded_panel->isActive());
+	EXPECT_TRUE(loaded_panel->isInteractive());
+	EXPECT_EQ(vec2(-1.5f, 1e-7f), loaded_panel->getPosition());
+	EXPECT_EQ(0.3f, loaded_panel->getRotation());
+	EXPECT_EQ(vec2(0.5f, 0.25f), loaded_panel->getPivot());
+	EXPECT_EQ(vec2(10.0f, 20.0f), loaded_panel->getSize());
+
+	ASSERT_EQ(1u, loaded_panel->getChildCount());
+	NodeShape2dRef loaded_shape = std::dynamic_pointer_cast<NodeShape2d>(loaded_panel->getChildren()[0]);
+	ASSERT_TRUE(loaded_shape != nullptr);
+	EXPECT_TRUE(loaded_shape->getStrokeColor() == ColorA(1.0f, 0.0f, 0.0f, 0.5f));
+	ASSERT_EQ(1u, loaded_shape->getShape().getContours().size());
+	EXPECT_EQ(shape.getContours()[0].getPoints(), loaded_shape->getShape().getContours()[0].getPoints());
+}
+
+TEST_F(SceneXmlTest, ReadsHandWrittenDocuments)
+{
+	NodeRef root = read(
+		"<?xml version=\"1.0\"?>\n"
+		"<!DOCTYPE scene [ <!ELEMENT scene ANY> ]>\n"
+		"<!-- a comment -- with dashes --->\n"
+		"<scene>\n"
+		"\t<Node2d name='root &amp; &#x41;&#66;' position=' 3  4 ' color=\"ignored\">\n"
+		"\t\t<![CDATA[ <Node2d/> ]]> text is skipped\n"
+		"\t\t<Node3d name=\"child\" active=\"false\" size=\"1 2 3\" />\n"
+		"\t</Node2d >\n"
+		"</scene>\n");
+
+	Node2dRef node = std::dynamic_pointer_cast<Node2d>(root);
+	ASSERT_TRUE(node != nullptr);
+	EXPECT_EQ("root & AB", node->getName());
+	EXPECT_EQ(vec2(3.0f, 4.0f), node->getPosition());
+	EXPECT_EQ(vec2(1.0f), node->getScale());
+	EXPECT_TRUE(node->isActive());
+
+	ASSERT_EQ(1u, node->getChildCount());
+	Node3dRef child = std::dynamic_pointer_cast<Node3d>(node->getChildren()[0]);
+	ASSERT_TRUE(child != nullptr);
+	EXPECT_FALSE(child->isActive());
+	EXPECT_EQ(vec3(1.0f, 2.0f, 3.0f), child->getSize());
+}
+
+TEST_F(SceneXmlTest, RejectsMalformedDocuments)
+{
+	const std::string document = "<scene><Node2d name=\"a\"><Node2d name=\"b\"/></Node2d></scene>";
+	ASSERT_TRUE(read(document) != nullptr);
+
+	// every truncation is caught
+	for (size_t size = 0; size < document.size(); ++size) {
+		EXPECT_TRUE(read(document.substr(0, size)) == nullptr) << size;
+	}
+
+	EXPECT_TRUE(read("<scene><Node2d></Node3d></scene>") == nullptr);
+	EXPECT_TRUE(read("<scene><Unknown/></scene>") == nullptr);
+	EXPECT_TRUE(read("<scene><Node2d/><Node2d/></scene>") == nullptr);
+	EXPECT_TRUE(read("<scene><Node2d/></scene><scene/>") == nullptr);
+	EXPECT_TRUE(read("<scene version=\"2\"><Node2d/></scene>") == nullptr);
+	EXPECT_TRUE(read("<scene><Node2d position=\"1\"/></scene>") == nullptr);
+	EXPECT_TRUE(read("<scene><Node2d position=\"1 2 3\"/></scene>") == nullptr);
+	EXPECT_TRUE(read("<scene><Node2d name=\"a\" name=\"b\"/></scene>") == nullptr);
+	EXPECT_TRUE(read("<scene><Node2d name=\"&unknown;\"/></scene>") == nullptr);
+	EXPECT_TRUE(read("<scene><NodeShape2d payload=\"!!!!\"/></scene>") == nullptr);
+	EXPECT_TRUE(read("<scene><NodeShape2d payload=\"AAAA\"/></scene>") == nullptr);
+	EXPECT_TRUE(read("<scene></scene>") == nullptr);
+
+	// the token limit bounds the memory taken by a single attribute
+	std::istringstream stream("<scene><Node2d name=\"" + std::string(100, 'a') + "\"/></scene>");
+	XmlSceneReader reader;
+	reader.setMaxTokenSize(64);
+	EXPECT_TRUE(reader.read(stream) == nullptr);
+	EXPECT_EQ(1u, reader.getErrorLine());
+}
+
+TEST_F(SceneXmlTest, StreamsLargeScenes)
+{
+	// a wide level under the root and deep chains beneath it
+	const uint32_t count = 200000;
+	Node3dRef root = Node3d::create("root");
+	Node3dRef parent = root;
+	for (uint32_t i = 1; i < count; ++i) {
+		Node3dRef node = Node3d::create();
+		node->setPosition(float(i), 0.0f, 0.0f);
+		if (i % 100 == 1) parent = root;
+		parent->addChild(node);
+		parent = node;
+	}
+
+	std::stringstream stream;
+	XmlSceneWriter writer;
+	ASSERT_TRUE(writer.write(*root, stream));
+
+	XmlSceneReader reader;
+	NodeRef loaded = reader.read(stream);
+	ASSERT_TRUE(loaded != nullptr);
+	EXPECT_EQ(2000u, loaded->getChildCount());
+
+	uint32_t loaded_count = 0;
+	double sum = 0.0;
+	NodeBase::Iter iter = loaded->getIter();
+	while (iter.hasNext()) {
+		Node3dRef node = iter.next<Node3d>();
+		sum += node->getPosition().x;
+		++loaded_count;
+	}
+	EXPECT_EQ(count, loaded_count);
+	EXPECT_DOUBLE_EQ(double(count) * double(count - 1) / 2.0, sum);
+}
+
+CINDER_APP_GTEST( SceneXmlTest, RendererGl )
@@ -0,0 +1,361 @@
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "CinderGTest.h"
+
+#include "SceneFormat.h"
+#include "StreamingManager.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	//! blocks the worker of a pool until released, to simulate a slow disk
+	class Gate {
+	public:
+		Gate() : mIsOpen(false) {}
+
+		void wait()
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mOpened.wait(lock, [this]() { return mIsOpen; });
+		}
+
+		void open()
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mIsOpen = true;
+			mOpened.notify_all();
+		}
+
+	protected:
+		std::mutex				mMutex;
+		std::condition_variable	mOpened;
+		bool					mIsOpen;
+	};
+}
+
+class StreamingManagerTest : public testing::Test {
+public:
+	StreamingManagerTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		// three regions of 10 units along the x axis, 100 units apart
+		mRoot = Node3d::create("world");
+		for (int i = 0; i < 3; ++i) {
+			std::ostringstream path;
+			path << "StreamingManagerTest" << i << ".scene";
+			mPaths.push_back(path.str());
+
+			Node3dRef region = Node3d::create(path.str());
+			region->addChild(Node3d::create("house"));
+			region->addChild(Node3d::create("tree"));
+			ASSERT_TRUE(SceneWriter().write(*region, path.str()));
+
+			vec3 min(i * 100.0f, 0.0f, 0.0f);
+			StreamingProxy3dRef proxy = StreamingProxy3d::create(path.str(), AxisAlignedBox(min, min + vec3(10.0f)));
+			mRoot->addChild(proxy);
+			mProxies.push_back(proxy);
+		}
+
+		mPool = ThreadPool::create(1);
+		mManager = StreamingManager::create(mPool);
+		mManager->setLoadDistance(50.0f);
+		mManager->setUnloadDistance(80.0f);
+		for (size_t i = 0; i < mProxies.size(); ++i) mManager->add(mProxies[i]);
+	}
+
+	void TearDown()
+	{
+		mPool->waitIdle();
+		for (size_t i = 0; i < mPaths.size(); ++i) std::remove(mPaths[i].c_str());
+	}
+
+	//! updates the manager until the loads for a position of the viewer are done
+	void settle(const vec3& viewer)
+	{
+		for (int i = 0; i < 8; ++i) {
+			mRoot->deepTransform();
+			mManager->update(viewer);
+			mPool->waitIdle();
+		}
+	}
+
+	//! adds a file to be removed by TearDown
+	const std::string& addPath(const std::string& path)
+	{
+		mPaths.push_back(path);
+		return mPaths.back();
+	}
+
+	Node3dRef							mRoot;
+	std::vector<StreamingProxy3dRef>	mProxies;
+	std::vector<std::string>			mPaths;
+	ThreadPoolRef						mPool;
+	StreamingManagerRef					mManager;
+};
+
+TEST_F(StreamingManagerTest, LoadsNearbyRegions)
+{
+	EXPECT_EQ(3u, mManager->getProxyCount());
+
+	settle(vec3(5.0f));
+	EXPECT_EQ(StreamingManager::STATE_LOADED, mManager->getState(*mProxies[0]));
+	EXPECT_EQ(StreamingManager::STATE_UNLOADED, mManager->getState(*mProxies[1]));
+	EXPECT_EQ(StreamingManager::STATE_UNLOADED, mManager->getState(*mProxies[2]));
+	EXPECT_EQ(0u, mManager->getPendingCount());
+
+	ASSERT_TRUE(mProxies[0]->isLoaded());
+	EXPECT_EQ(0u, mProxies[0]->getContent()->getName().find(mPaths[0]));
+	EXPECT_EQ(2u, mProxies[0]->getContent()->getChildren().size());
+	EXPECT_EQ(mProxies[0], mProxies[0]->getContent()->getParent());
+	EXPECT_FALSE(mProxies[1]->isLoaded());
+
+	// a proxy of unknown size counts as the size of its file
+	std::vector<uint8_t> file;
+	ASSERT_TRUE(SceneWriter().write(*mProxies[0]->getContent(), file));
+	EXPECT_EQ(file.size(), mManager->getResidentSize());
+	EXPECT_EQ(1u, mManager->getLoadedCount());
+	EXPECT_EQ(1u, mManager->getLoadCount());
+}
+
+TEST_F(StreamingManagerTest, KeepsRegionsUntilTheUnloadDistance)
+{
+	settle(vec3(5.0f));
+	ASSERT_TRUE(mProxies[0]->isLoaded());
+
+	// between the load and the unload distance of both regions
+	settle(vec3(75.0f, 5.0f, 5.0f));
+	EXPECT_TRUE(mProxies[0]->isLoaded());
+	EXPECT_TRUE(mProxies[1]->isLoaded());
+
+	settle(vec3(60.0f, 5.0f, 5.0f));
+	EXPECT_TRUE(mProxies[0]->isLoaded());
+	EXPECT_TRUE(mProxies[1]->isLoaded());
+	EXPECT_EQ(2u, mManager->getLoadCount());
+	EXPECT_EQ(0u, mManager->getUnloadCount());
+
+	settle(vec3(95.0f, 5.0f, 5.0f));
+	EXPECT_FALSE(mProxies[0]->isLoaded());
+	EXPECT_TRUE(mProxies[1]->isLoaded());
+	EXPECT_EQ(StreamingManager::STATE_UNLOADED, mManager->getState(*mProxies[0]));
+	EXPECT_EQ(1u, mManager->getUnloadCount());
+	EXPECT_EQ(1u, mManager->getLoadedCount());
+
+	// the regions follow the world transformation of their proxies
+	mProxies[2]->setPosition(-200.0f, 0.0f, 0.0f);
+	settle(vec3(5.0f));
+	EXPECT_TRUE(mProxies[0]->isLoaded());
+	EXPECT_FALSE(mProxies[1]->isLoaded());
+	EXPECT_TRUE(mProxies[2]->isLoaded());
+}
+
+TEST_F(StreamingManagerTest, LoadsNearestRegionsWithinBudget)
+{
+	for (size_t i = 0; i < mProxies.size(); ++i) mProxies[i]->setMemorySize(1000);
+	mManager->setLoadDistance(1000.0f);
+	mManager->setUnloadDistance(1000.0f);
+	mManager->setMemoryBudget(2500);
+
+	settle(vec3(205.0f, 5.0f, 5.0f));
+	EXPECT_FALSE(mProxies[0]->isLoaded());
+	EXPECT_TRUE(mProxies[1]->isLoaded());
+	EXPECT_TRUE(mProxies[2]->isLoaded());
+	EXPECT_EQ(2000u, mManager->getResidentSize());
+
+	// the priority divides the distance, the farthest region gives way
+	mProxies[0]->setPriority(100.0f);
+	settle(vec3(205.0f, 5.0f, 5.0f));
+	EXPECT_TRUE(mProxies[0]->isLoaded());
+	EXPECT_FALSE(mProxies[1]->isLoaded());
+	EXPECT_TRUE(mProxies[2]->isLoaded());
+	EXPECT_EQ(2000u, mManager->getResidentSize());
+
+	mManager->setMemoryBudget(1000);
+	settle(vec3(205.0f, 5.0f, 5.0f));
+	EXPECT_EQ(1u, mManager->getLoadedCount());
+	EXPECT_TRUE(mProxies[2]->isLoaded());
+	EXPECT_EQ(1000u, mManager->getResidentSize());
+}
+
+TEST_F(StreamingManagerTest, LimitsPendingLoads)
+{
+	Gate gate;
+	mPool->submit([&gate]() { gate.wait(); });
+
+	mManager->setLoadDistance(1000.0f);
+	mManager->setUnloadDistance(1000.0f);
+	mManager->setMaxPendingLoads(2);
+	mRoot->deepTransform();
+	mManager->update(vec3(5.0f));
+	EXPECT_EQ(2u, mManager->getPendingCount());
+	EXPECT_EQ(StreamingManager::STATE_LOADING, mManager->getState(*mProxies[0]));
+	EXPECT_EQ(StreamingManager::STATE_LOADING, mManager->getState(*mProxies[1]));
+	EXPECT_EQ(StreamingManager::STATE_UNLOADED, mManager->getState(*mProxies[2]));
+
+	gate.open();
+	settle(vec3(5.0f));
+	EXPECT_EQ(3u, mManager->getLoadedCount());
+	EXPECT_EQ(0u, mManager->getPendingCount());
+}
+
+TEST_F(StreamingManagerTest, DropsCancelledLoads)
+{
+	Gate gate;
+	mPool->submit([&gate]() { gate.wait(); });
+
+	mManager->setLoadDistance(150.0f);
+	mManager->setUnloadDistance(150.0f);
+	mRoot->deepTransform();
+	mManager->update(vec3(5.0f));
+	ASSERT_EQ(StreamingManager::STATE_LOADING, mManager->getState(*mProxies[0]));
+	ASSERT_EQ(StreamingManager::STATE_LOADING, mManager->getState(*mProxies[1]));
+
+	// one proxy is destroyed, the other one moves out of reach while its file is read
+	mRoot->removeChild(mProxies[1]);
+	mProxies[1].reset();
+	mManager->update(vec3(500.0f));
+	EXPECT_EQ(StreamingManager::STATE_UNLOADED, mManager->getState(*mProxies[0]));
+	EXPECT_EQ(2u, mManager->getProxyCount());
+
+	gate.open();
+	mPool->waitIdle();
+	mManager->update(vec3(500.0f));
+	EXPECT_FALSE(mProxies[0]->isLoaded());
+	EXPECT_EQ(0u, mManager->getPendingCount());
+	EXPECT_EQ(0u, mManager->getLoadCount());
+	EXPECT_EQ(0u, mManager->getResidentSize());
+
+	// a load that was cancelled and started again attaches the content once
+	Gate second_gate;
+	mPool->submit([&second_gate]() { second_gate.wait(); });
+	mManager->update(vec3(5.0f));
+	mManager->update(vec3(500.0f));
+	mManager->update(vec3(5.0f));
+	EXPECT_EQ(2u, mManager->getPendingCount());
+	second_gate.open();
+	settle(vec3(5.0f));
+	EXPECT_TRUE(mProxies[0]->isLoaded());
+	EXPECT_EQ(1u, mManager->getLoadCount());
+}
+
+TEST_F(StreamingManagerTest, DoesNotRetryFailedLoads)
+{
+	mProxies[0]->setPath("StreamingManagerTest.missing");
+	mProxies[1]->setPath(addPath("StreamingManagerTest.malformed"));
+	FILE* file = fopen(mProxies[1]->getPath().c_str(), "wb");
+	ASSERT_TRUE(file != nullptr);
+	fputs("not a scene", file);
+	fclose(file);
+
+	mManager->setLoadDistance(150.0f);
+	mManager->setUnloadDistance(150.0f);
+	settle(vec3(5.0f));
+	EXPECT_EQ(StreamingManager::STATE_FAILED, mManager->getState(*mProxies[0]));
+	EXPECT_EQ(StreamingManager::STATE_FAILED, mManager->getState(*mProxies[1]));
+	EXPECT_EQ(2u, mManager->getFailedCount());
+
+	settle(vec3(5.0f));
+	EXPECT_EQ(2u, mManager->getFailedCount());
+	EXPECT_EQ(0u, mManager->getResidentSize());
+
+	// registering a proxy again gives it another chance
+	mProxies[0]->setPath(mPaths[0]);
+	mManager->remove(mProxies[0]);
+	mManager->add(mProxies[0]);
+	settle(vec3(5.0f));
+	EXPECT_TRUE(mProxies[0]->isLoaded());
+}
+
+TEST_F(StreamingManagerTest, StreamsNestedWorlds)
+{
+	// the last region holds a proxy of the first one, placed right behind it
+	Node3dRef outer = Node3d::create("outer");
+	StreamingProxy3dRef inner = StreamingProxy3d::create(mPaths[0], AxisAlignedBox(vec3(0.0f), vec3(10.0f)), "inner");
+	inner->setPosition(220.0f, 0.0f, 0.0f);
+	outer->addChild(inner);
+	ASSERT_TRUE(SceneWriter().write(*outer, addPath("StreamingManagerTest.outer.scene")));
+	mProxies[2]->setPath(mPaths.back());
+
+	settle(vec3(215.0f, 5.0f, 5.0f));
+	EXPECT_TRUE(mProxies[2]->isLoaded());
+	EXPECT_EQ(4u, mManager->getProxyCount());
+	EXPECT_EQ(2u, mManager->getLoadedCount());
+
+	StreamingProxy3dRef loaded = std::dynamic_pointer_cast<StreamingProxy3d>(mProxies[2]->getContent()->getChildren().front());
+	ASSERT_TRUE(loaded != nullptr);
+	ASSERT_TRUE(loaded->isLoaded());
+	EXPECT_EQ(0u, loaded->getContent()->getName().find(mPaths[0]));
+
+	// releasing the outer region destroys the nested proxy while it is registered
+	loaded.reset();
+	mManager->update(vec3(5.0f));
+	EXPECT_FALSE(mProxies[2]->isLoaded());
+	EXPECT_EQ(3u, mManager->getProxyCount());
+
+	settle(vec3(5.0f));
+	EXPECT_EQ(3u, mManager->getProxyCount());
+	EXPECT_EQ(1u, mManager->getLoadedCount());
+	EXPECT_TRUE(mProxies[0]->isLoaded());
+}
+
+TEST_F(StreamingManagerTest, UnregistersNestedProxies)
+{
+	Node3dRef outer = Node3d::create("outer");
+	StreamingProxy3dRef inner = StreamingProxy3d::create(mPaths[0], AxisAlignedBox(vec3(0.0f), vec3(10.0f)), "inner");
+	inner->setPosition(220.0f, 0.0f, 0.0f);
+	outer->addChild(inner);
+	ASSERT_TRUE(SceneWriter().write(*outer, addPath("StreamingManagerTest.outer.scene")));
+	mProxies[2]->setPath(mPaths.back());
+
+	settle(vec3(215.0f, 5.0f, 5.0f));
+	StreamingProxy3dRef loaded = std::dynamic_pointer_cast<StreamingProxy3d>(mProxies[2]->getContent()->getChildren().front());
+	ASSERT_TRUE(loaded != nullptr);
+	ASSERT_TRUE(loaded->isLoaded());
+	uint64_t resident = mManager->getResidentSize();
+
+	// a nested proxy that outlives the content of its parent leaves the manager with its own content released
+	mManager->update(vec3(5.0f));
+	EXPECT_FALSE(mProxies[2]->isLoaded());
+	EXPECT_FALSE(loaded->isLoaded());
+	EXPECT_EQ(3u, mManager->getProxyCount());
+	EXPECT_EQ(StreamingManager::STATE_UNLOADED, mManager->getState(*loaded));
+	EXPECT_LT(mManager->getResidentSize(), resident);
+}
+
+TEST_F(StreamingManagerTest, SavesProxies)
+{
+	StreamingProxy3dRef proxy = StreamingProxy3d::create("region.scene", AxisAlignedBox(vec3(-1.0f, -2.0f, -3.0f), vec3(4.0f, 5.0f, 6.0f)), "proxy");
+	proxy->setPriority(2.5f);
+	proxy->setMemorySize(0x123456789ull);
+
+	std::vector<uint8_t> file;
+	ASSERT_TRUE(SceneWriter().write(*proxy, file));
+	StreamingProxy3dRef copy = std::dynamic_pointer_cast<StreamingProxy3d>(SceneReader().read(file));
+	ASSERT_TRUE(copy != nullptr);
+	EXPECT_EQ(proxy->getName(), copy->getName());
+	EXPECT_EQ("region.scene", copy->getPath());
+	EXPECT_EQ(vec3(-1.0f, -2.0f, -3.0f), copy->getRegion().getMin());
+	EXPECT_EQ(vec3(4.0f, 5.0f, 6.0f), copy->getRegion().getMax());
+	EXPECT_EQ(2.5f, copy->getPriority());
+	EXPECT_EQ(0x123456789ull, copy->getMemorySize());
+	EXPECT_FALSE(copy->isLoaded());
+
+	copy->deepTransform();
+	EXPECT_FLOAT_EQ(0.0f, copy->calcDistance(vec3(0.0f)));
+	EXPECT_FLOAT_EQ(5.0f, copy->calcDistance(vec3(9.0f, 0.0f, 0.0f)));
+}
+
+CINDER_APP_GTEST( StreamingManagerTest, RendererGl )
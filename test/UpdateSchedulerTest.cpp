@@ -0,0 +1,165 @@
+#include <atomic>
+#include <vector>
+
+#include "CinderGTest.h"
+
+#include "Node3d.h"
+#include "ThreadPool.h"
+#include "UpdateScheduler.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	//! accumulates a value that depends on its parent, only touches its own subtree
+	class LocalNode : public Node3d {
+	public:
+		LocalNode(const std::string& name) : Node3d(name), mValue(0), mUpdates(0) {}
+
+		virtual void update(double elapsed)
+		{
+			const LocalNode* parent = dynamic_cast<const LocalNode*>(mParent.lock().get());
+			mValue = mValue * 0.5 + elapsed + (parent? parent->mValue: 0.0);
+			++mUpdates;
+		}
+
+		virtual UpdateScope getUpdateScope() const { return UPDATE_SUBTREE; }
+
+		double	mValue;
+		int		mUpdates;
+	};
+
+	//! reads and writes shared state, so it has to run in tree order
+	class GlobalNode : public Node3d {
+	public:
+		GlobalNode(const std::string& name, std::vector<double>& log, const std::vector<LocalNode*>& watched)
+		:	Node3d(name), mLog(log), mWatched(watched) {}
+
+		virtual void update(double elapsed)
+		{
+			double sum = 0;
+			for (auto itr = mWatched.begin(); itr != mWatched.end(); ++itr) sum += (*itr)->mValue;
+			mLog.push_back(sum);
+		}
+
+		std::vector<double>&			mLog;
+		const std::vector<LocalNode*>&	mWatched;
+	};
+}
+
+class UpdateSchedulerTest : public testing::Test {
+public:
+	UpdateSchedulerTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mPool = ThreadPool::create(4);
+	}
+
+	void TearDown()
+	{
+	}
+
+protected:
+	//! builds a tree of local subtrees separated by global nodes that observe them
+	Node3dRef buildScene(std::vector<double>& log, std::vector<LocalNode*>& locals)
+	{
+		Node3dRef root = Node3d::create("root");
+		for (int group = 0; group < 8; ++group) {
+			for (int branch = 0; branch < 4; ++branch) {
+				std::shared_ptr<LocalNode> subtree(new LocalNode("subtree"));
+				locals.push_back(subtree.get());
+				for (int i = 0; i < 50; ++i) {
+					std::shared_ptr<LocalNode> leaf(new LocalNode("leaf"));
+					locals.push_back(leaf.get());
+					subtree->addChild(leaf);
+				}
+				root->addChild(subtree);
+			}
+			root->addChild(Node3dRef(new GlobalNode("global", log, locals)));
+		}
+
+		return root;
+	}
+
+	ThreadPoolRef mPool;
+};
+
+TEST_F( UpdateSchedulerTest, ParallelForTest )
+{
+	std::vector<int> values(10000, 0);
+	mPool->parallelFor(values.size(), [&values](size_t i) { values[i] = static_cast<int>(i) * 2; });
+
+	for (size_t i = 0; i < values.size(); ++i) {
+		ASSERT_EQ( static_cast<int>(i) * 2, values[i] );
+	}
+
+	// nested calls from a worker do not deadlock
+	std::atomic<int> total(0);
+	mPool->parallelFor(8, [this, &total](size_t i) {
+		mPool->parallelFor(8, [&total](size_t j) { ++total; });
+	});
+	EXPECT_EQ( 64, total.load() );
+}
+
+TEST_F( UpdateSchedulerTest, DeterministicTest )
+{
+	std::vector<double> serial_log, parallel_log;
+	std::vector<LocalNode*> serial_locals, parallel_locals;
+	Node3dRef serial_root = buildScene(serial_log, serial_locals);
+	Node3dRef parallel_root = buildScene(parallel_log, parallel_locals);
+
+	UpdateSchedulerRef scheduler = UpdateScheduler::create(mPool);
+	scheduler->setMinBatchSize(0);
+	for (int frame = 0; frame < 10; ++frame) {
+		serial_root->deepUpdate(1.0 / 60.0);
+		scheduler->deepUpdate(*parallel_root, 1.0 / 60.0);
+	}
+
+	// the global nodes observed exactly the same state
+	ASSERT_EQ( serial_log.size(), parallel_log.size() );
+	for (size_t i = 0; i < serial_log.size(); ++i) {
+		EXPECT_EQ( serial_log[i], parallel_log[i] );
+	}
+
+	ASSERT_EQ( serial_locals.size(), parallel_locals.size() );
+	for (size_t i = 0; i < serial_locals.size(); ++i) {
+		EXPECT_EQ( serial_locals[i]->mValue, parallel_locals[i]->mValue );
+		EXPECT_EQ( 10, parallel_locals[i]->mUpdates );
+	}
+
+	// the root and the global nodes are barriers, everything else ran in 8 batches
+	EXPECT_EQ( 9u, scheduler->getSerialNodeCount() );
+	EXPECT_EQ( parallel_locals.size(), scheduler->getParallelNodeCount() );
+	EXPECT_EQ( 8u, scheduler->getBatchCount() );
+}
+
+TEST_F( UpdateSchedulerTest, SerialFallbackTest )
+{
+	// a serial node inside a subtree makes its ancestors barriers as well
+	std::vector<double> log;
+	std::vector<LocalNode*> locals;
+	std::shared_ptr<LocalNode> parent(new LocalNode("parent"));
+	std::shared_ptr<LocalNode> child(new LocalNode("child"));
+	locals.push_back(parent.get());
+	locals.push_back(child.get());
+	parent->addChild(child);
+	child->addChild(Node3dRef(new GlobalNode("global", log, locals)));
+
+	UpdateScheduler scheduler(mPool);
+	scheduler.deepUpdate(*parent, 1.0);
+
+	EXPECT_EQ( 3u, scheduler.getSerialNodeCount() );
+	EXPECT_EQ( 0u, scheduler.getParallelNodeCount() );
+	ASSERT_EQ( 1u, log.size() );
+	EXPECT_DOUBLE_EQ( parent->mValue + child->mValue, log[0] );
+}
+
+CINDER_APP_GTEST( UpdateSchedulerTest, RendererGl )
@@ -0,0 +1,162 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "CinderGTest.h"
+
+#include "Node3d.h"
+#include "SceneContext.h"
+#include "WorkQueue.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+namespace {
+	void sleepMicroseconds(int us)
+	{
+		std::this_thread::sleep_for(std::chrono::microseconds(us));
+	}
+}
+
+class WorkQueueTest : public testing::Test {
+public:
+	WorkQueueTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mQueue = WorkQueue::create(1000.0);
+	}
+
+	void TearDown()
+	{
+	}
+
+	WorkQueueRef		mQueue;
+	std::vector<int>	mOrder;
+};
+
+TEST_F(WorkQueueTest, PriorityOrder)
+{
+	mQueue->submit([this]() { mOrder.push_back(0); }, WorkQueue::PRIORITY_LOW);
+	mQueue->submit([this]() { mOrder.push_back(1); }, WorkQueue::PRIORITY_NORMAL);
+	mQueue->submit([this]() { mOrder.push_back(2); }, WorkQueue::PRIORITY_HIGH);
+	mQueue->submit([this]() { mOrder.push_back(3); }, WorkQueue::PRIORITY_HIGH);
+
+	EXPECT_EQ(mQueue->drain(), 4u);
+	EXPECT_EQ(mOrder, std::vector<int>({ 2, 3, 1, 0 }));
+	EXPECT_EQ(mQueue->getStats().mJobsPending, 0u);
+}
+
+TEST_F(WorkQueueTest, Budget)
+{
+	for (int i = 0; i < 20; ++i) mQueue->submit([]() { sleepMicroseconds(300); });
+
+	// each drain stops after the budget is spent, but always makes progress
+	size_t frames = 0;
+	while (mQueue->getPendingCount() > 0) {
+		size_t run = mQueue->drain();
+		EXPECT_GE(run, 1u);
+		EXPECT_LE(run, 4u);
+		++frames;
+	}
+	EXPECT_GE(frames, 5u);
+
+	// a single job longer than the budget still runs
+	mQueue->submit([]() { sleepMicroseconds(1500); });
+	EXPECT_EQ(mQueue->drain(), 1u);
+	EXPECT_GE(mQueue->getStats().mLongestJob, 1500.0);
+}
+
+TEST_F(WorkQueueTest, Aging)
+{
+	mQueue->setBudget(0);
+	mQueue->setAgingPeriod(2);
+
+	mQueue->submit([this]() { mOrder.push_back(0); }, WorkQueue::PRIORITY_LOW);
+
+	// a steady stream of high priority work, one job runs per frame
+	for (int frame = 0; frame < 8 && mOrder.size() < 8; ++frame) {
+		mQueue->submit([this]() { mOrder.push_back(1); }, WorkQueue::PRIORITY_HIGH);
+		mQueue->submit([this]() { mOrder.push_back(1); }, WorkQueue::PRIORITY_HIGH);
+		mQueue->drain();
+	}
+
+	// the low priority job moved up and ran before the high priority backlog was cleared
+	EXPECT_NE(std::find(mOrder.begin(), mOrder.end(), 0), mOrder.end());
+	EXPECT_GT(mQueue->getPendingCount(), 0u);
+}
+
+TEST_F(WorkQueueTest, AgingBehindPromotedJob)
+{
+	mQueue->setBudget(0);
+	mQueue->setAgingPeriod(4);
+
+	// the low priority job is older than the normal one, so it is sorted in front of it once promoted
+	mQueue->submit([this]() { mOrder.push_back(0); }, WorkQueue::PRIORITY_LOW);
+
+	std::vector<size_t> promoted;
+	for (int frame = 0; frame < 8; ++frame) {
+		if (frame == 2) mQueue->submit([this]() { mOrder.push_back(1); }, WorkQueue::PRIORITY_NORMAL);
+		mQueue->submit([this]() { mOrder.push_back(2); }, WorkQueue::PRIORITY_HIGH);
+		mQueue->submit([this]() { mOrder.push_back(2); }, WorkQueue::PRIORITY_HIGH);
+		mQueue->drain();
+		promoted.push_back(mQueue->getStats().mJobsPromoted);
+	}
+
+	// the normal job ages on time although a younger entry of its level is in front of it,
+	// and like the low priority job it runs as soon as it reaches the top
+	EXPECT_EQ(promoted, std::vector<size_t>({ 0, 0, 0, 1, 0, 1, 0, 1 }));
+	EXPECT_EQ(mOrder, std::vector<int>({ 2, 2, 2, 2, 2, 1, 2, 0 }));
+	EXPECT_EQ(mQueue->getPendingCount(), 10u);
+}
+
+TEST_F(WorkQueueTest, Cancel)
+{
+	WorkQueue::JobId a = mQueue->submit([this]() { mOrder.push_back(0); });
+	WorkQueue::JobId b = mQueue->submit([this]() { mOrder.push_back(1); });
+
+	EXPECT_TRUE(mQueue->cancel(a));
+	EXPECT_FALSE(mQueue->cancel(a));
+	EXPECT_EQ(mQueue->getPendingCount(), 1u);
+
+	mQueue->flush();
+	EXPECT_EQ(mOrder, std::vector<int>({ 1 }));
+	EXPECT_FALSE(mQueue->cancel(b));
+}
+
+TEST_F(WorkQueueTest, NodeDefer)
+{
+	SceneContextRef context = SceneContext::create();
+	Node3dRef root = Node3d::create("root");
+	Node3dRef child = Node3d::create("child");
+
+	// without a context the job runs immediately
+	int runs = 0;
+	EXPECT_EQ(child->defer([&runs]() { ++runs; }), WorkQueue::INVALID_JOB);
+	EXPECT_EQ(runs, 1);
+
+	context->setRoot(root);
+	root->addChild(child);
+	EXPECT_NE(child->defer([&runs]() { ++runs; }), WorkQueue::INVALID_JOB);
+	EXPECT_NE(child->defer([&runs]() { ++runs; }), WorkQueue::INVALID_JOB);
+	EXPECT_EQ(runs, 1);
+
+	context->getWorkQueue().drain();
+	EXPECT_EQ(runs, 3);
+
+	// jobs of destroyed nodes are skipped
+	child->defer([&runs]() { ++runs; });
+	root->removeChild(child);
+	child.reset();
+	context->getWorkQueue().drain();
+	EXPECT_EQ(runs, 3);
+}
+
+CINDER_APP_GTEST( WorkQueueTest, RendererGl )
@@ -0,0 +1,180 @@
+#include <vector>
+
+#include "cinder/Matrix.h"
+
+#include "CinderGTest.h"
+
+#include "Node3d.h"
+#include "WorldMatrixBuffer.h"
+
+using namespace ci;
+using namespace scene;
+
+///////////////////////////////////////////////////////////////////////////
+//
+// TODO:
+//
+///////////////////////////////////////////////////////////////////////////
+
+class WorldMatrixBufferTest : public testing::Test {
+public:
+	WorldMatrixBufferTest() : testing::Test() {
+	}
+
+	void SetUp()
+	{
+		mBuffer = WorldMatrixBuffer::create();
+	}
+
+	void TearDown()
+	{
+	}
+
+protected:
+	static void expectMatrixEq(const mat4& lhs, const mat4& rhs)
+	{
+		for (int col = 0; col < 4; ++col) {
+			for (int row = 0; row < 4; ++row) {
+				EXPECT_FLOAT_EQ( lhs[col][row], rhs[col][row] );
+			}
+		}
+	}
+
+	WorldMatrixBufferRef mBuffer;
+};
+
+TEST_F( WorldMatrixBufferTest, LayoutTest )
+{
+	EXPECT_EQ( 48u, WorldMatrixBuffer::getStride() );
+	EXPECT_EQ( 16u, alignof(PackedMatrix34) );
+
+	mat4 world = glm::translate(mat4(1), vec3(1, 2, 3)) * glm::scale(mat4(1), vec3(4, 5, 6));
+	PackedMatrix34 packed;
+	WorldMatrixBuffer::pack(world, packed);
+
+	// the translation ends up in the last column of each row
+	EXPECT_FLOAT_EQ( 4.0f, packed.mRows[0][0] );
+	EXPECT_FLOAT_EQ( 1.0f, packed.mRows[0][3] );
+	EXPECT_FLOAT_EQ( 2.0f, packed.mRows[1][3] );
+	EXPECT_FLOAT_EQ( 3.0f, packed.mRows[2][3] );
+
+	expectMatrixEq( world, WorldMatrixBuffer::unpack(packed) );
+}
+
+TEST_F( WorldMatrixBufferTest, AllocateReleaseTest )
+{
+	uint32_t a = mBuffer->allocate();
+	uint32_t b = mBuffer->allocate();
+	uint32_t c = mBuffer->allocate();
+	EXPECT_EQ( 0u, a );
+	EXPECT_EQ( 1u, b );
+	EXPECT_EQ( 2u, c );
+
+	mBuffer->release(b);
+	EXPECT_EQ( 2u, mBuffer->getAllocatedCount() );
+
+	// released slots are reused before the buffer grows
+	EXPECT_EQ( b, mBuffer->allocate() );
+	EXPECT_EQ( 3u, mBuffer->size() );
+}
+
+TEST_F( WorldMatrixBufferTest, DoubleReleaseTest )
+{
+	uint32_t a = mBuffer->allocate();
+	uint32_t b = mBuffer->allocate();
+	EXPECT_TRUE( mBuffer->isAllocated(a) );
+
+	// releasing a slot twice or a slot that never existed changes nothing
+	mBuffer->release(a);
+	mBuffer->release(a);
+	mBuffer->release(WorldMatrixBuffer::INVALID_INDEX);
+	EXPECT_FALSE( mBuffer->isAllocated(a) );
+	EXPECT_TRUE( mBuffer->isAllocated(b) );
+	EXPECT_EQ( 1u, mBuffer->getAllocatedCount() );
+
+	// so the slot is handed out once
+	uint32_t c = mBuffer->allocate();
+	uint32_t d = mBuffer->allocate();
+	EXPECT_EQ( a, c );
+	EXPECT_NE( c, d );
+	EXPECT_NE( b, d );
+	EXPECT_EQ( 3u, mBuffer->getAllocatedCount() );
+}
+
+TEST_F( WorldMatrixBufferTest, DirtyRangeTest )
+{
+	for (int i = 0; i < 10; ++i) mBuffer->allocate();
+	mBuffer->clearDirty();
+	EXPECT_TRUE( mBuffer->getDirtyRanges().empty() );
+
+	mBuffer->set(7, mat4(2));
+	mBuffer->set(2, mat4(2));
+	mBuffer->set(3, mat4(2));
+	mBuffer->set(5, mat4(2));
+	mBuffer->set(3, mat4(3));
+
+	const std::vector<MatrixRange>& ranges = mBuffer->getDirtyRanges();
+	ASSERT_EQ( 3u, ranges.size() );
+	EXPECT_EQ( 2u, ranges[0].mBegin );
+	EXPECT_EQ( 4u, ranges[0].mEnd );
+	EXPECT_EQ( 5u, ranges[1].mBegin );
+	EXPECT_EQ( 6u, ranges[1].mEnd );
+	EXPECT_EQ( 7u, ranges[2].mBegin );
+	EXPECT_EQ( 8u, ranges[2].mEnd );
+
+	// a single clean slot between ranges is cheaper to upload than a separate call
+	const std::vector<MatrixRange>& merged = mBuffer->getDirtyRanges(1);
+	ASSERT_EQ( 1u, merged.size() );
+	EXPECT_EQ( 2u, merged[0].mBegin );
+	EXPECT_EQ( 8u, merged[0].mEnd );
+
+	mBuffer->clearDirty();
+	EXPECT_FALSE( mBuffer->isDirty(3) );
+	EXPECT_TRUE( mBuffer->getDirtyRanges().empty() );
+}
+
+TEST_F( WorldMatrixBufferTest, NodeMirrorTest )
+{
+	Node3dRef root = Node3d::create("root");
+	Node3dRef child = Node3d::create("child");
+	Node3dRef grandchild = Node3d::create("grandchild");
+	root->addChild(child);
+	child->addChild(grandchild);
+	root->setPosition(1, 0, 0);
+	child->setPosition(0, 2, 0);
+	grandchild->setScale(2);
+
+	root->deepTransform(mat4(1), mBuffer);
+	EXPECT_EQ( 3u, mBuffer->getAllocatedCount() );
+	expectMatrixEq( root->getWorldTransform(), mBuffer->get(root->getMatrixIndex()) );
+	expectMatrixEq( child->getWorldTransform(), mBuffer->get(child->getMatrixIndex()) );
+	expectMatrixEq( grandchild->getWorldTransform(), mBuffer->get(grandchild->getMatrixIndex()) );
+	mBuffer->clearDirty();
+
+	// nothing changed, nothing to upload
+	root->deepTransform(mat4(1), mBuffer);
+	EXPECT_TRUE( mBuffer->getDirtyRanges().empty() );
+
+	// moving the child touches the child and the grandchild only
+	child->setPosition(0, 3, 0);
+	root->deepTransform(mat4(1), mBuffer);
+	const std::vector<MatrixRange>& ranges = mBuffer->getDirtyRanges();
+	ASSERT_EQ( 1u, ranges.size() );
+	EXPECT_EQ( 2u, ranges[0].size() );
+	EXPECT_FALSE( mBuffer->isDirty(root->getMatrixIndex()) );
+	expectMatrixEq( grandchild->getWorldTransform(), mBuffer->get(grandchild->getMatrixIndex()) );
+	mBuffer->clearDirty();
+
+	// transforming without the buffer is caught up on the next buffered pass
+	child->setPosition(0, 4, 0);
+	root->deepTransform(mat4(1));
+	root->deepTransform(mat4(1), mBuffer);
+	expectMatrixEq( child->getWorldTransform(), mBuffer->get(child->getMatrixIndex()) );
+
+	// destroyed nodes give their slot back
+	child->removeChild(grandchild);
+	grandchild.reset();
+	EXPECT_EQ( 2u, mBuffer->getAllocatedCount() );
+}
+
+CINDER_APP_GTEST( WorldMatrixBufferTest, RendererGl )